@@ -0,0 +1,62 @@
+# Used to quickly run benchmark under RSpec as part of the usual test suite, to validate it didn't bitrot
+VALIDATE_BENCHMARK_MODE = ENV["VALIDATE_BENCHMARK"] == "true"
+
+return unless __FILE__ == $PROGRAM_NAME || VALIDATE_BENCHMARK_MODE
+
+require_relative "benchmarks_helper"
+
+# Measures how fast durations can be recorded into a DDSketch, one point at a time vs in bulk, plus the cost of
+# merging and encoding the resulting sketches.
+#
+# Each add report records POINTS_PER_REPORT points, so points/sec is the reported i/s times POINTS_PER_REPORT.
+#
+# Usage:
+#   bundle exec ruby benchmarks/core_ddsketch.rb
+class CoreDDSketchBenchmark
+  POINTS_PER_REPORT = 1_000_000
+
+  def run_benchmark
+    require "datadog/core/ddsketch"
+
+    unless Datadog::Core::DDSketch.supported?
+      puts "WARNING: DDSketch not available: #{Datadog::Core::LIBDATADOG_API_FAILURE}"
+      puts "Skipping DDSketch benchmark."
+      return
+    end
+
+    points_count = VALIDATE_BENCHMARK_MODE ? 1_000 : POINTS_PER_REPORT
+    # Span durations in nanoseconds, from 1µs to ~10s
+    random = Random.new(42)
+    points = Array.new(points_count) { (10**random.rand(3.0..10.0)).to_i }
+    filled = Datadog::Core::DDSketch.new.add_all(points)
+
+    Benchmark.ips do |x|
+      benchmark_time = VALIDATE_BENCHMARK_MODE ? {time: 0.01, warmup: 0} : {time: 10, warmup: 2}
+      x.config(**benchmark_time)
+
+      x.report("#{points_count} points - add") do
+        sketch = Datadog::Core::DDSketch.new
+        points.each { |point| sketch.add(point) }
+      end
+
+      x.report("#{points_count} points - add_all") do
+        Datadog::Core::DDSketch.new.add_all(points)
+      end
+
+      x.report("merge") do
+        Datadog::Core::DDSketch.new.merge(filled)
+      end
+
+      x.report("encode(reset: false)") do
+        filled.encode(reset: false)
+      end
+
+      x.save! "#{File.basename(__FILE__, ".rb")}-results.json" unless VALIDATE_BENCHMARK_MODE
+      x.compare!
+    end
+  end
+end
+
+puts "Current pid is #{Process.pid}"
+
+CoreDDSketchBenchmark.new.run_benchmark
@@ -217,6 +217,39 @@ class DISnapshotBenchmark
     puts "Received #{@received_snapshot_count} snapshots, #{@received_snapshot_bytes} bytes total"
   end
 
+  # Compares the serialization of the value captured by the enriched
+  # probes above by the native serializer and by the Ruby one.
+  def run_serializer_benchmark
+    settings = Datadog.configuration
+    redactor = Datadog::DI::Redactor.new(settings)
+    native_serializer = Datadog::DI::Serializer.new(settings, redactor)
+    ruby_serializer = Datadog::DI::Serializer.new(settings, redactor)
+    # Serializes in Ruby only, as when the C extension is not available
+    ruby_serializer.define_singleton_method(:native_serializer) { nil }
+
+    value = Datadog.configuration
+
+    Benchmark.ips do |x|
+      benchmark_time = VALIDATE_BENCHMARK_MODE ? {time: 0.01, warmup: 0} : {time: 10, warmup: 2}
+      x.config(
+        **benchmark_time,
+      )
+
+      x.report("serialize snapshot - Ruby") do
+        ruby_serializer.serialize_value(value)
+      end
+
+      if defined?(Datadog::DI::NativeSerializer)
+        x.report("serialize snapshot - native") do
+          native_serializer.serialize_value(value)
+        end
+      end
+
+      x.save! "di-snapshot-results.json" unless VALIDATE_BENCHMARK_MODE
+      x.compare!
+    end
+  end
+
   private
 
   def probe_manager
@@ -249,4 +282,5 @@ puts "Current pid is #{Process.pid}"
 
 DISnapshotBenchmark.new.instance_exec do
   run_benchmark
+  run_serializer_benchmark
 end
@@ -14,6 +14,10 @@ require "datadog/open_feature/hooks/flag_eval_evp_hook"
 #   2. the background aggregation `record` (flatten -> prune -> canonical key -> two-tier bucket),
 #      which the single writer thread pays off the eval path.
 #
+# It also measures the native evaluation itself (Core::FeatureFlags::Configuration), for a request
+# evaluating NATIVE_FLAGS_PER_REQUEST flags against the same user context, with the context given as
+# a Hash (converted by every call) or as an EvaluationContext built once per request.
+#
 # The design goal is that the eval thread only pays (1); (2) is amortized on the worker. These
 # numbers quantify both so regressions in either are visible. The profiles mirror the Go
 # OpenFeature EVP benchmark suite so Ruby also covers the team's >=2,500 flag scale target.
@@ -31,6 +35,9 @@ class OpenFeatureFlagevaluationBenchmark
   HookDetails = Struct.new(:variant, :reason, :error_code, :flag_metadata)
   BenchmarkProfile = Struct.new(:name, :num_flags, :num_users, :num_fields)
 
+  NATIVE_FLAGS_PER_REQUEST = 25
+  NATIVE_CONTEXT_FIELDS = 10
+
   SCALE_PROFILE_NAME = "scale/2500flags_500users_20fields"
   BENCHMARK_PROFILES = [
     BenchmarkProfile.new("typical/100flags_50users_10fields", 100, 50, 10),
@@ -154,6 +161,83 @@ class OpenFeatureFlagevaluationBenchmark
     end
   end
 
+  # Native evaluation of NATIVE_FLAGS_PER_REQUEST flags against one request's context. Each sample is a
+  # whole request, so the time per evaluation is printed as well.
+  def benchmark_native_evaluation
+    require "datadog/core/feature_flags"
+
+    if Datadog::Core::LIBDATADOG_API_FAILURE
+      puts "WARNING: libdatadog_api not available: #{Datadog::Core::LIBDATADOG_API_FAILURE}"
+      puts "Skipping native evaluation benchmark."
+      return
+    end
+
+    flag_keys = Array.new(NATIVE_FLAGS_PER_REQUEST) { |i| "bench-flag-#{i}" }
+    configuration = Datadog::Core::FeatureFlags::Configuration.new(native_flags_json(flag_keys))
+    context_hash = make_benchmark_attrs(NATIVE_CONTEXT_FIELDS).merge("targeting_key" => "bench-user-1")
+    evaluations = "#{NATIVE_FLAGS_PER_REQUEST} evaluations/sample"
+
+    report = Benchmark.ips do |x|
+      x.config(**benchmark_time)
+
+      x.report("native#get_assignment/Hash context (#{evaluations})") do
+        flag_keys.each { |flag_key| configuration.get_assignment(flag_key, :boolean, context_hash) }
+      end
+
+      x.report("native#get_assignment/EvaluationContext (#{evaluations})") do
+        context = Datadog::Core::FeatureFlags::EvaluationContext.new(context_hash)
+        flag_keys.each { |flag_key| configuration.get_assignment(flag_key, :boolean, context) }
+      end
+
+      x.report("native#get_assignments/EvaluationContext (#{evaluations})") do
+        context = Datadog::Core::FeatureFlags::EvaluationContext.new(context_hash)
+        configuration.get_assignments(flag_keys, :boolean, context)
+      end
+
+      x.save!(benchmark_results_file("native-evaluation")) unless VALIDATE_BENCHMARK_MODE
+      x.compare!
+    end
+
+    return if VALIDATE_BENCHMARK_MODE
+
+    report.entries.each do |entry|
+      puts format("%-70s %8.0f ns/evaluation", entry.label, 1e9 / (entry.ips * NATIVE_FLAGS_PER_REQUEST))
+    end
+  end
+
+  # Boolean flags, each matching on one of the context fields
+  def native_flags_json(flag_keys)
+    flags = flag_keys.each_with_object({}) do |flag_key, flags_by_key|
+      flags_by_key[flag_key] = {
+        "key" => flag_key,
+        "enabled" => true,
+        "variationType" => "BOOLEAN",
+        "variations" => {
+          "on" => {"key" => "on", "value" => true},
+          "off" => {"key" => "off", "value" => false},
+        },
+        "allocations" => [
+          {
+            "key" => "#{flag_key}-allocation",
+            "rules" => [
+              {"conditions" => [{"attribute" => "field1", "operator" => "ONE_OF", "value" => ["value"]}]},
+            ],
+            "splits" => [{"variationKey" => "on", "shards" => []}],
+            "doLog" => true,
+          },
+        ],
+      }
+    end
+
+    JSON.generate(
+      "id" => "1",
+      "createdAt" => "2024-04-17T19:40:53.716Z",
+      "format" => "SERVER",
+      "environment" => {"name" => "Benchmark"},
+      "flags" => flags,
+    )
+  end
+
   # Threaded worker hot path at the >=2,500-flag scale profile. This is Ruby's closest analogue
   # to Go's RunParallel benchmark: persistent workers avoid per-sample thread creation while
   # still exercising the synchronized aggregator under concurrent producers.
@@ -225,4 +309,5 @@ OpenFeatureFlagevaluationBenchmark.new.instance_exec do
   run_benchmark { benchmark_hook_finally }
   run_benchmark { benchmark_aggregator_record }
   run_benchmark { benchmark_aggregator_record_parallel_scale }
+  run_benchmark { benchmark_native_evaluation }
 end
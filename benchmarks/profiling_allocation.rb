@@ -26,7 +26,7 @@ end
 
 class ProfilerAllocationBenchmark
   def run_benchmark
-    Benchmark.ips do |x|
+    baseline_report = Benchmark.ips do |x|
       benchmark_time = VALIDATE_BENCHMARK_MODE ? {time: 0.01, warmup: 0} : {time: 10, warmup: 2}
       x.config(
         **benchmark_time,
@@ -50,7 +50,7 @@ class ProfilerAllocationBenchmark
 
     3.times { GC.start }
 
-    Benchmark.ips do |x|
+    profiling_report = Benchmark.ips do |x|
       benchmark_time = VALIDATE_BENCHMARK_MODE ? {time: 0.01, warmup: 0} : {time: 10, warmup: 2}
       x.config(
         **benchmark_time,
@@ -61,6 +61,23 @@ class ProfilerAllocationBenchmark
       x.save! "#{File.basename(__FILE__, ".rb")}-results.json" unless VALIDATE_BENCHMARK_MODE
       x.compare!
     end
+
+    report_ns_per_allocation(baseline_report, profiling_report)
+  end
+
+  # Each benchmark iteration does a single allocation, so we can directly translate iterations per second into the
+  # cost of each allocation, and thus into how much allocation profiling adds to it.
+  def report_ns_per_allocation(baseline_report, profiling_report)
+    baseline_ns = 1_000_000_000.0 / baseline_report.entries.first.ips
+    profiling_ns = 1_000_000_000.0 / profiling_report.entries.first.ips
+
+    puts format(
+      "ns per allocation: profiling off %.2f, profiling on %.2f (+%.2f ns, %.1f%% overhead)",
+      baseline_ns,
+      profiling_ns,
+      profiling_ns - baseline_ns,
+      (profiling_ns / baseline_ns - 1) * 100,
+    )
   end
 end
 
@@ -0,0 +1,76 @@
+# Used to quickly run benchmark under RSpec as part of the usual test suite, to validate it didn't bitrot
+VALIDATE_BENCHMARK_MODE = ENV["VALIDATE_BENCHMARK"] == "true"
+
+return unless __FILE__ == $PROGRAM_NAME || VALIDATE_BENCHMARK_MODE
+
+require_relative "benchmarks_helper"
+
+# Measures how fast the native trace transport converts Ruby spans into
+# libdatadog spans, for spans carrying an increasing number of meta and
+# metrics entries. No payload is sent.
+#
+# Each report converts a chunk of SPANS_PER_CHUNK spans, so spans/sec is the
+# reported i/s times SPANS_PER_CHUNK.
+#
+# Usage:
+#   bundle exec ruby benchmarks/tracing_span_conversion.rb
+class TracingSpanConversionBenchmark
+  SPANS_PER_CHUNK = 100
+  TAG_COUNTS = [10, 50, 100].freeze
+
+  def run_benchmark
+    require "datadog/tracing/transport/native"
+
+    unless Datadog::Tracing::Transport::Native.supported?
+      puts "WARNING: Native transport not available: #{Datadog::Tracing::Transport::Native::UNSUPPORTED_REASON}"
+      puts "Skipping span conversion benchmark."
+      return
+    end
+
+    chunk_class = Datadog::Tracing::Transport::Native::TraceChunk
+    spans_by_tag_count = TAG_COUNTS.map { |tag_count| [tag_count, build_spans(tag_count)] }
+
+    Benchmark.ips do |x|
+      benchmark_time = VALIDATE_BENCHMARK_MODE ? {time: 0.01, warmup: 0} : {time: 10, warmup: 2}
+      x.config(**benchmark_time)
+
+      spans_by_tag_count.each do |tag_count, spans|
+        x.report("convert #{SPANS_PER_CHUNK} spans - #{tag_count} tags each") do
+          chunk_class._native_from_spans(spans)
+        end
+      end
+
+      x.save! "#{File.basename(__FILE__, ".rb")}-results.json" unless VALIDATE_BENCHMARK_MODE
+      x.compare!
+    end
+  end
+
+  private
+
+  # Splits +tag_count+ between meta (string) and metrics (numeric) entries, about 4 to 1, like typical
+  # integration spans.
+  def build_spans(tag_count)
+    metrics_count = tag_count / 5
+    meta_count = tag_count - metrics_count
+    trace_id = rand(1 << 62)
+
+    SPANS_PER_CHUNK.times.map do |i|
+      Datadog::Tracing::Span.new(
+        "benchmark.op",
+        service: "benchmark-svc",
+        resource: "GET /bench/#{i}",
+        type: "web",
+        id: rand(1 << 62),
+        parent_id: (i == 0) ? 0 : rand(1 << 62),
+        trace_id: trace_id,
+      ).tap do |span|
+        meta_count.times { |n| span.set_tag("benchmark.meta.#{n}", "value-#{n}-#{i}") }
+        metrics_count.times { |n| span.set_metric("benchmark.metric.#{n}", n * 1.5) }
+      end
+    end
+  end
+end
+
+puts "Current pid is #{Process.pid}"
+
+TracingSpanConversionBenchmark.new.run_benchmark
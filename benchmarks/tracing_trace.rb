@@ -78,6 +78,40 @@ class TracingTraceBenchmark
     end
   end
 
+  # Compares creating traces (and propagating them with the Datadog style, which carries the high order part of
+  # 128-bit trace ids in the `_dd.p.tid` tag) with 128-bit trace id generation enabled and disabled.
+  def benchmark_trace_id_128_bit
+    ::Datadog::Tracing::Writer.prepend(NoopWriter)
+    Datadog.configure { |c| c.tracing.propagation_style = ["datadog"] }
+
+    Benchmark.ips do |x|
+      x.config(**benchmark_time)
+
+      [true, false].each do |enabled|
+        label = enabled ? "128-bit" : "64-bit"
+
+        x.report("10 span trace - #{label} trace ids") do
+          Datadog.configuration.tracing.trace_id_128_bit_generation_enabled = enabled
+          Datadog::Tracing.trace("op.name") do
+            9.times { Datadog::Tracing.trace("op.name") {} }
+          end
+        end
+
+        x.report("trace + propagation - #{label} trace ids") do
+          Datadog.configuration.tracing.trace_id_128_bit_generation_enabled = enabled
+          Datadog::Tracing.trace("op.name") do |_span, trace|
+            env = {}
+            Datadog::Tracing::Contrib::HTTP.inject(trace.to_digest, env)
+            raise unless Datadog::Tracing::Contrib::HTTP.extract(env)
+          end
+        end
+      end
+
+      x.save! "#{File.basename(__FILE__, ".rb")}-results.json" unless VALIDATE_BENCHMARK_MODE
+      x.compare!
+    end
+  end
+
   def benchmark_to_digest
     Datadog::Tracing.trace("op.name") do |span, trace|
       Benchmark.ips do |x|
@@ -194,6 +228,7 @@ end
 TracingTraceBenchmark.new.instance_exec do
   run_benchmark { benchmark_no_writer }
   run_benchmark { benchmark_no_network }
+  run_benchmark { benchmark_trace_id_128_bit }
   run_benchmark { benchmark_to_digest }
   run_benchmark { benchmark_log_correlation }
   run_benchmark { benchmark_continue_trace }
@@ -20,11 +20,13 @@ class TracingTransportBenchmark
     Datadog.logger.level = Logger::FATAL
     @mock_agent = MockAgent.new
     @traces = build_traces
+    @traces_with_events = build_traces(with_events: true)
   end
 
   def run_benchmark
     http_transport = build_http_transport
     native_transport = build_native_transport
+    eager_native_transport = native_transport && build_native_transport(eager_conversion: true)
 
     Benchmark.ips do |x|
       benchmark_time = VALIDATE_BENCHMARK_MODE ? {time: 0.01, warmup: 0} : {time: 12, warmup: 2}
@@ -40,16 +42,65 @@ class TracingTransportBenchmark
         end
       end
 
+      if eager_native_transport
+        # Includes the per-trace conversion that would otherwise happen on the application threads, so that the
+        # total cost can be compared with the lazy mode above. See #report_flush_stall for the writer thread only.
+        x.report("prepare_trace + send_traces - Native (eager conversion)") do
+          @traces.each { |trace| eager_native_transport.prepare_trace(trace) }
+          eager_native_transport.send_traces(@traces)
+        end
+      end
+
+      # Spans carrying span events and span links, which the native transport encodes in C and the HTTP
+      # transport via SpanEvent#to_hash / SpanLink#to_hash and msgpack.
+      x.report("send_traces with span events and links - HTTP") do
+        http_transport.send_traces(@traces_with_events)
+      end
+
+      if native_transport
+        x.report("send_traces with span events and links - Native") do
+          native_transport.send_traces(@traces_with_events)
+        end
+      end
+
       x.save! "#{File.basename(__FILE__, ".rb")}-results.json" unless VALIDATE_BENCHMARK_MODE
       x.compare!
     end
+
+    report_flush_stall(native_transport, eager_native_transport) if native_transport && eager_native_transport
   ensure
     @mock_agent.stop
   end
 
   private
 
-  def build_traces(count: 10, spans_per_trace: 5)
+  # Reports how long the writer thread spends in `send_traces` for one flush, which is the time during which it
+  # holds the GVL converting spans (plus the send itself), with and without eager conversion.
+  def report_flush_stall(native_transport, eager_native_transport)
+    iterations = VALIDATE_BENCHMARK_MODE ? 1 : 200
+
+    lazy_ns = iterations.times.sum do
+      elapsed_ns { native_transport.send_traces(@traces) }
+    end
+    eager_ns = 0
+    prepare_ns = iterations.times.sum do
+      prepare_elapsed_ns = elapsed_ns { @traces.each { |trace| eager_native_transport.prepare_trace(trace) } }
+      eager_ns += elapsed_ns { eager_native_transport.send_traces(@traces) }
+      prepare_elapsed_ns
+    end
+
+    puts "send_traces per flush of #{@traces.size} traces (writer thread): " \
+      "lazy=#{(lazy_ns / iterations / 1000.0).round(1)}us eager=#{(eager_ns / iterations / 1000.0).round(1)}us " \
+      "(prepare_trace per trace: #{(prepare_ns / iterations / @traces.size / 1000.0).round(1)}us)"
+  end
+
+  def elapsed_ns
+    start = Process.clock_gettime(Process::CLOCK_MONOTONIC, :nanosecond)
+    yield
+    Process.clock_gettime(Process::CLOCK_MONOTONIC, :nanosecond) - start
+  end
+
+  def build_traces(count: 10, spans_per_trace: 5, with_events: false)
     count.times.map do
       trace_id = rand(1 << 62)
       spans = spans_per_trace.times.map do |i|
@@ -67,6 +118,7 @@ class TracingTransportBenchmark
           span.set_tag("http.status_code", "200")
           span.set_metric("_dd.measured", 1.0)
           span.set_metric("_sampling_priority_v1", 1.0)
+          add_events_and_links(span, i) if with_events
         end
       end
       Datadog::Tracing::TraceSegment.new(
@@ -77,6 +129,23 @@ class TracingTransportBenchmark
     end
   end
 
+  def add_events_and_links(span, index)
+    span.events << Datadog::Tracing::SpanEvent.new(
+      "exception",
+      attributes: {
+        "exception.type" => "RuntimeError",
+        "exception.message" => "benchmark error #{index}",
+        "exception.stacktrace" => caller.take(5).join("\n"),
+        "retry.count" => index,
+      },
+    )
+    span.events << Datadog::Tracing::SpanEvent.new("cache.miss", attributes: {"keys" => ["a", "b", "c"]})
+    span.links << Datadog::Tracing::SpanLink.new(
+      Datadog::Tracing::TraceDigest.new(span_id: rand(1 << 62), trace_id: rand(1 << 62), trace_sampling_priority: 1),
+      attributes: {"link.kind" => "follows_from"},
+    )
+  end
+
   def agent_settings
     @agent_settings ||= Struct.new(:url).new("http://127.0.0.1:#{@mock_agent.port}")
   end
@@ -88,7 +157,7 @@ class TracingTransportBenchmark
     )
   end
 
-  def build_native_transport
+  def build_native_transport(eager_conversion: false)
     require "datadog/tracing/transport/native"
 
     unless Datadog::Tracing::Transport::Native.supported?
@@ -100,6 +169,7 @@ class TracingTransportBenchmark
     Datadog::Tracing::Transport::Native::Transport.new(
       agent_settings: agent_settings,
       logger: Logger.new(File::NULL),
+      eager_conversion: eager_conversion,
     )
   end
 
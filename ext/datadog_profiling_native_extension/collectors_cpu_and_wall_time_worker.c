@@ -85,6 +85,12 @@
 // (Datadog-only link) for research backing the choice of this value.
 unsigned int MAX_ALLOC_WEIGHT = 10000;
 
+// Number of buckets in the "Waiting for GVL" duration histogram, see `gvl_waiting_histogram_bucket_for` for the layout.
+#define GVL_WAITING_HISTOGRAM_BUCKETS 24
+// Upper bound on how many allocations a thread skips on the fast path before going through the full sampling logic
+// again (which includes reading the clock and checking if the sampler needs readjusting).
+#define ALLOCATION_SKIP_BATCH_MAX 256
+
 #ifndef NO_POSTPONED_TRIGGER
   // Used to call the rb_postponed_job_trigger from Ruby 3.3+. These get initialized in
   // `collectors_cpu_and_wall_time_worker_init` below and always get reused after that.
@@ -103,6 +109,7 @@ typedef struct {
   bool dynamic_sampling_rate_enabled;
   bool allocation_profiling_enabled;
   bool allocation_counting_enabled;
+  bool allocation_poisson_sampling_enabled;
   bool gvl_profiling_enabled;
   bool skip_idle_samples_for_testing;
   bool sighandler_sampling_enabled;
@@ -124,6 +131,9 @@ typedef struct {
   const char *failure_exception_during_operation;
   // Used by `_native_stop` to flag the worker thread to start (see comment on `_native_sampling_loop`)
   VALUE stop_thread;
+  // Set by the first simulated signal delivery, so that idle samples only get skipped once there was one. Written with
+  // the GVL, read by the sampling trigger loop.
+  atomic_bool idle_sample_taken;
 
   // Others
 
@@ -148,6 +158,9 @@ typedef struct {
     unsigned int trigger_sample_extra_sleep;
     // How many times we tried to simulate signal delivery
     unsigned int trigger_simulated_signal_delivery_attempts;
+    // How many times we skipped simulating signal delivery because the process was idle and nothing changed since
+    // the last sample
+    unsigned int trigger_idle_sample_skipped;
     // How many times we actually simulated signal delivery
     unsigned int simulated_signal_delivery;
     // How many times we actually called rb_postponed_job_register_one from the signal handler
@@ -197,6 +210,12 @@ typedef struct {
     struct vm_metrics {
       // Total time spent waiting for the GVL
       uint64_t gvl_waiting_time_ns_total;
+      // Log2-bucketed histogram of individual "Waiting for GVL" durations. Total time alone tells us that the process
+      // is GVL-bound; the distribution tells us if it's many short waits or a few long ones.
+      //
+      // This is only written from on_gvl_event RESUMED, which always runs on the thread that just acquired the GVL, so
+      // there's a single writer at any point in time and no atomics/locks are needed.
+      uint64_t gvl_waiting_time_ns_histogram[GVL_WAITING_HISTOGRAM_BUCKETS];
     } vm_metrics;
   } stats;
 } cpu_and_wall_time_worker_state;
@@ -210,6 +229,7 @@ static VALUE stop(VALUE self_instance, VALUE optional_exception, const char *opt
 static void stop_state(cpu_and_wall_time_worker_state *state, VALUE optional_exception, const char *optional_operation_name);
 static void handle_sampling_signal(DDTRACE_UNUSED int _signal, DDTRACE_UNUSED siginfo_t *_info, DDTRACE_UNUSED void *_ucontext);
 static void *run_sampling_trigger_loop(void *state_ptr);
+static bool is_idle_and_unchanged_since_last_idle_sample(cpu_and_wall_time_worker_state *state);
 static void interrupt_sampling_trigger_loop(void *state_ptr);
 static void sample_from_postponed_job(DDTRACE_UNUSED void *_unused);
 static VALUE rescued_sample_from_postponed_job(VALUE self_instance);
@@ -257,7 +277,9 @@ static VALUE _native_resume_signals(DDTRACE_UNUSED VALUE self);
   static void after_gvl_running_from_postponed_job(DDTRACE_UNUSED void *_unused);
   static VALUE rescued_after_gvl_running_from_postponed_job(VALUE self_instance);
   static VALUE handle_sampling_failure_rescued_after_gvl_running_from_postponed_job(VALUE self_instance, VALUE exception);
+  static inline uint8_t gvl_waiting_histogram_bucket_for(long waiting_for_gvl_duration_ns);
 #endif
+static VALUE gvl_waiting_histogram_as_ruby_array(cpu_and_wall_time_worker_state *state);
 static VALUE _native_gvl_profiling_hook_active(DDTRACE_UNUSED VALUE self, VALUE instance);
 static VALUE handle_sampling_failure_rescued_sample_from_postponed_job(VALUE self_instance, VALUE exception);
 static VALUE handle_sampling_failure_thread_context_collector_sample_after_gc(VALUE self_instance, VALUE exception);
@@ -314,6 +336,21 @@ static global_stats_t global_stats;
 // API documented in profiling.rb .
 __thread uint64_t allocation_count = 0;
 
+// Used to implement the fast path in on_newobj_event: each thread gets handed a batch of allocations it can skip
+// without even looking at the sampler (see `discrete_dynamic_sampler_events_until_next_sample`), and only reports
+// them back to the sampler in bulk once the batch runs out.
+//
+// The generation is used to discard batches handed out by a previous profiler run (e.g. before a fork, or by a
+// previous profiler instance).
+typedef struct {
+  uint32_t generation;
+  uint32_t events_to_skip;
+  uint32_t events_skipped;
+} allocation_skip_batch;
+
+__thread allocation_skip_batch allocation_skip = {0};
+static uint32_t allocation_skip_generation = 1;
+
 void collectors_cpu_and_wall_time_worker_init(VALUE profiling_module) {
   rb_global_variable(&active_sampler_instance);
 
@@ -404,6 +441,7 @@ static VALUE _native_new(VALUE klass) {
   state->dynamic_sampling_rate_enabled = true;
   state->allocation_profiling_enabled = false;
   state->allocation_counting_enabled = false;
+  state->allocation_poisson_sampling_enabled = false;
   state->gvl_profiling_enabled = false;
   state->skip_idle_samples_for_testing = false;
   state->sighandler_sampling_enabled = false;
@@ -415,6 +453,7 @@ static VALUE _native_new(VALUE klass) {
   state->gc_tracepoint = Qnil;
 
   atomic_init(&state->should_run, false);
+  atomic_init(&state->idle_sample_taken, false);
   state->failure_exception = Qnil;
   state->failure_exception_during_operation = NULL;
   state->stop_thread = Qnil;
@@ -449,6 +488,7 @@ static VALUE _native_initialize(int argc, VALUE *argv, DDTRACE_UNUSED VALUE _sel
   VALUE dynamic_sampling_rate_overhead_target_percentage = rb_hash_fetch(options, ID2SYM(rb_intern("dynamic_sampling_rate_overhead_target_percentage")));
   VALUE allocation_profiling_enabled = rb_hash_fetch(options, ID2SYM(rb_intern("allocation_profiling_enabled")));
   VALUE allocation_counting_enabled = rb_hash_fetch(options, ID2SYM(rb_intern("allocation_counting_enabled")));
+  VALUE allocation_poisson_sampling_enabled = rb_hash_fetch(options, ID2SYM(rb_intern("allocation_poisson_sampling_enabled")));
   VALUE gvl_profiling_enabled = rb_hash_fetch(options, ID2SYM(rb_intern("gvl_profiling_enabled")));
   VALUE skip_idle_samples_for_testing = rb_hash_fetch(options, ID2SYM(rb_intern("skip_idle_samples_for_testing")));
   VALUE sighandler_sampling_enabled = rb_hash_fetch(options, ID2SYM(rb_intern("sighandler_sampling_enabled")));
@@ -460,6 +500,7 @@ static VALUE _native_initialize(int argc, VALUE *argv, DDTRACE_UNUSED VALUE _sel
   ENFORCE_TYPE(dynamic_sampling_rate_overhead_target_percentage, T_FLOAT);
   ENFORCE_BOOLEAN(allocation_profiling_enabled);
   ENFORCE_BOOLEAN(allocation_counting_enabled);
+  ENFORCE_BOOLEAN(allocation_poisson_sampling_enabled);
   ENFORCE_BOOLEAN(gvl_profiling_enabled);
   ENFORCE_BOOLEAN(skip_idle_samples_for_testing)
   ENFORCE_BOOLEAN(sighandler_sampling_enabled)
@@ -473,6 +514,7 @@ static VALUE _native_initialize(int argc, VALUE *argv, DDTRACE_UNUSED VALUE _sel
   state->dynamic_sampling_rate_enabled = (dynamic_sampling_rate_enabled == Qtrue);
   state->allocation_profiling_enabled = (allocation_profiling_enabled == Qtrue);
   state->allocation_counting_enabled = (allocation_counting_enabled == Qtrue);
+  state->allocation_poisson_sampling_enabled = (allocation_poisson_sampling_enabled == Qtrue);
   state->gvl_profiling_enabled = (gvl_profiling_enabled == Qtrue);
   state->skip_idle_samples_for_testing = (skip_idle_samples_for_testing == Qtrue);
   state->sighandler_sampling_enabled = (sighandler_sampling_enabled == Qtrue);
@@ -487,6 +529,9 @@ static VALUE _native_initialize(int argc, VALUE *argv, DDTRACE_UNUSED VALUE _sel
     dynamic_sampling_rate_set_overhead_target_percentage(&state->cpu_dynamic_sampling_rate, total_overhead_target_percentage / 2);
     long now = monotonic_wall_time_now_ns(RAISE_ON_FAILURE);
     discrete_dynamic_sampler_set_overhead_target_percentage(&state->allocation_sampler, total_overhead_target_percentage / 2, now);
+    if (state->allocation_poisson_sampling_enabled) {
+      discrete_dynamic_sampler_enable_poisson_byte_sampling(&state->allocation_sampler, now);
+    }
   }
 
   state->thread_context_collector_instance = enforce_thread_context_collector_instance(thread_context_collector_instance);
@@ -545,6 +590,9 @@ static VALUE _native_sampling_loop(DDTRACE_UNUSED VALUE _self, VALUE instance) {
   dynamic_sampling_rate_reset(&state->cpu_dynamic_sampling_rate);
   long now = monotonic_wall_time_now_ns(RAISE_ON_FAILURE);
   discrete_dynamic_sampler_reset(&state->allocation_sampler, now);
+  atomic_store(&state->idle_sample_taken, false);
+  // Invalidate any allocation skip batches that threads may still be holding on to
+  allocation_skip_generation++;
 
   // Reset per-thread state, if any. This ensures there's no leftover state from a previous profiler run that would
   // affect or be included in samples taken by this profiler about to run.
@@ -758,6 +806,18 @@ static void handle_sampling_signal(DDTRACE_UNUSED int _signal, DDTRACE_UNUSED si
   #endif
 }
 
+// Runs without the global vm lock. Note that this only gets called when no thread is holding the GVL.
+static bool is_idle_and_unchanged_since_last_idle_sample(cpu_and_wall_time_worker_state *state) {
+  #ifndef NO_GVL_INSTRUMENTATION
+    if (!state->gvl_profiling_enabled) return false;
+
+    return atomic_load(&state->idle_sample_taken) && !thread_context_collector_gvl_released_since_idle_sample();
+  #else
+    (void) state;
+    return false;
+  #endif
+}
+
 // The actual sampling trigger loop always runs **without** the global vm lock.
 static void *run_sampling_trigger_loop(void *state_ptr) {
   cpu_and_wall_time_worker_state *state = (cpu_and_wall_time_worker_state *) state_ptr;
@@ -793,6 +853,13 @@ static void *run_sampling_trigger_loop(void *state_ptr) {
         if (state->skip_idle_samples_for_testing) {
           // This was added to make sure our tests don't accidentally pass due to idle samples. Specifically, if we
           // comment out the thread interruption code inside `if (owner.valid)` above, our tests should not pass!
+        } else if (is_idle_and_unchanged_since_last_idle_sample(state)) {
+          // No thread released the GVL since we last requested an idle sample, so every thread is still suspended
+          // with the same stack. An idle sample would skip every thread (see `skip_sample` in the ThreadContext
+          // collector), so we don't bother waking anyone up: the wall-time they spend suspended keeps accumulating,
+          // and gets recorded in bulk on their next sample, or when the profile gets serialized.
+          thread_context_collector_on_idle_sample_skipped();
+          state->stats.trigger_idle_sample_skipped++;
         } else {
           // If no thread owns the Global VM Lock, the application is probably idle at the moment. We still want to sample
           // so we "ask a friend" (the IdleSamplingHelper component) to grab the GVL and simulate getting a SIGPROF.
@@ -1179,6 +1246,7 @@ static VALUE _native_stats(DDTRACE_UNUSED VALUE self, VALUE instance) {
     ID2SYM(rb_intern("trigger_sample_attempts")),                    /* => */ UINT2NUM(state->stats.trigger_sample_attempts),
     ID2SYM(rb_intern("trigger_sample_extra_sleep")),                 /* => */ UINT2NUM(state->stats.trigger_sample_extra_sleep),
     ID2SYM(rb_intern("trigger_simulated_signal_delivery_attempts")), /* => */ UINT2NUM(state->stats.trigger_simulated_signal_delivery_attempts),
+    ID2SYM(rb_intern("trigger_idle_sample_skipped")),        /* => */ UINT2NUM(state->stats.trigger_idle_sample_skipped),
     ID2SYM(rb_intern("simulated_signal_delivery")),                  /* => */ UINT2NUM(state->stats.simulated_signal_delivery),
     ID2SYM(rb_intern("signal_handler_enqueued_sample")),             /* => */ UINT2NUM(state->stats.signal_handler_enqueued_sample),
     ID2SYM(rb_intern("signal_handler_prepared_sample")),             /* => */ UINT2NUM(state->stats.signal_handler_prepared_sample),
@@ -1213,6 +1281,7 @@ static VALUE _native_stats(DDTRACE_UNUSED VALUE self, VALUE instance) {
     ID2SYM(rb_intern("gvl_sampling_time_ns_total")), /* => */ RUBY_NUM_OR_NIL(state->stats.gvl_sampling_time_ns_total, > 0, ULL2NUM),
     ID2SYM(rb_intern("gvl_sampling_time_ns_avg")),   /* => */ RUBY_AVG_OR_NIL(state->stats.gvl_sampling_time_ns_total, state->stats.after_gvl_running),
     ID2SYM(rb_intern("gvl_waiting_time_ns_total")),  /* => */ state->gvl_profiling_enabled ? ULL2NUM(state->stats.vm_metrics.gvl_waiting_time_ns_total) : Qnil,
+    ID2SYM(rb_intern("gvl_waiting_time_ns_histogram")), /* => */ state->gvl_profiling_enabled ? gvl_waiting_histogram_as_ruby_array(state) : Qnil,
   };
   for (long unsigned int i = 0; i < VALUE_COUNT(arguments); i += 2) rb_hash_aset(stats_as_hash, arguments[i], arguments[i+1]);
 
@@ -1221,6 +1290,16 @@ static VALUE _native_stats(DDTRACE_UNUSED VALUE self, VALUE instance) {
   return stats_as_hash;
 }
 
+// Bucket N covers waits in [1024 << (N - 1), 1024 << N) ns, except for bucket 0 (waits < 1024 ns) and the last bucket,
+// which is open-ended. The Ruby side (see Profiling::Exporter) relies on this layout to derive percentiles.
+static VALUE gvl_waiting_histogram_as_ruby_array(cpu_and_wall_time_worker_state *state) {
+  VALUE result = rb_ary_new_capa(GVL_WAITING_HISTOGRAM_BUCKETS);
+  for (int i = 0; i < GVL_WAITING_HISTOGRAM_BUCKETS; i++) {
+    rb_ary_push(result, ULL2NUM(state->stats.vm_metrics.gvl_waiting_time_ns_histogram[i]));
+  }
+  return result;
+}
+
 static VALUE _native_stats_reset_not_thread_safe(DDTRACE_UNUSED VALUE self, VALUE instance) {
   cpu_and_wall_time_worker_state *state;
   TypedData_Get_Struct(instance, cpu_and_wall_time_worker_state, &cpu_and_wall_time_worker_typed_data, state);
@@ -1237,6 +1316,12 @@ void *simulate_sampling_signal_delivery(DDTRACE_UNUSED void *_unused) {
 
   state->stats.simulated_signal_delivery++;
 
+  #ifndef NO_GVL_INSTRUMENTATION
+    // Because we do this BEFORE sampling, any thread releasing the GVL after the sample observed it flags it again.
+    thread_context_collector_on_idle_sample();
+    atomic_store(&state->idle_sample_taken, true);
+  #endif
+
   // `handle_sampling_signal` does a few things extra on top of `sample_from_postponed_job` so that's why we don't shortcut here
   handle_sampling_signal(0, NULL, NULL);
 
@@ -1312,7 +1397,9 @@ static VALUE _native_allocation_count(DDTRACE_UNUSED VALUE self) {
 // 2. should_sample == true -> sample
 //
 // On big applications, path 1. is the hottest, since we don't sample every object. So it's quite important for it to
-// be as fast as possible.
+// be as fast as possible. That's why, when path 1. is taken, we also figure out how many of the next allocations are
+// guaranteed to take path 1. as well, and let the current thread skip those with just a thread-local countdown
+// (see `allocation_skip_batch`).
 //
 // NOTE: You may be wondering why we don't use any of the arguments to this function. It turns out it's possible to just
 // call `rb_tracearg_from_tracepoint(anything)` anywhere during this function or its callees to get the data, so that's
@@ -1333,6 +1420,24 @@ static void on_newobj_event(DDTRACE_UNUSED VALUE unused1, DDTRACE_UNUSED void *u
     }
   }
 
+  // Hottest path: This thread was handed a batch of allocations that are known to not get sampled, so skip them
+  // without doing any other work.
+  if (RB_LIKELY(allocation_skip.events_to_skip > 0 && allocation_skip.generation == allocation_skip_generation)) {
+    allocation_skip.events_to_skip--;
+    allocation_skip.events_skipped++;
+    return;
+  }
+
+  // Report any allocations skipped in the fast path back to the sampler, so they're included in the weight of the
+  // next sample.
+  if (allocation_skip.events_skipped > 0) {
+    if (allocation_skip.generation == allocation_skip_generation) {
+      discrete_dynamic_sampler_skipped_events(&state->allocation_sampler, allocation_skip.events_skipped);
+      state->stats.allocation_skipped += allocation_skip.events_skipped;
+    }
+    allocation_skip.events_skipped = 0;
+  }
+
   // In rare cases, we may actually be allocating an object as part of profiler sampling. We don't want to recursively
   // sample, so we just return early
   if (state->during_sample) {
@@ -1359,8 +1464,17 @@ static void on_newobj_event(DDTRACE_UNUSED VALUE unused1, DDTRACE_UNUSED void *u
     return;
   }
 
+  // When using Poisson byte sampling, the sampling decision depends on how big the object being allocated is.
+  // At this point the object isn't initialized yet, so the best we can get is the size of its heap slot (any extra
+  // memory it ends up needing gets malloc'd later).
+  bool should_sample = state->allocation_poisson_sampling_enabled ?
+    discrete_dynamic_sampler_should_sample_bytes(
+      &state->allocation_sampler, ruby_obj_slot_size(rb_tracearg_object(rb_tracearg_from_tracepoint(Qnil)))
+    ) :
+    discrete_dynamic_sampler_should_sample(&state->allocation_sampler);
+
   // Hot path: Dynamic sampling rate is usually enabled and the sampling decision is usually false
-  if (RB_LIKELY(state->dynamic_sampling_rate_enabled && !discrete_dynamic_sampler_should_sample(&state->allocation_sampler))) {
+  if (RB_LIKELY(state->dynamic_sampling_rate_enabled && !should_sample)) {
     state->stats.allocation_skipped++;
 
     coarse_instant now = monotonic_coarse_wall_time_now_ns();
@@ -1376,6 +1490,15 @@ static void on_newobj_event(DDTRACE_UNUSED VALUE unused1, DDTRACE_UNUSED void *u
       );
     }
 
+    // Hand out the next batch of allocations this thread can skip. Keeping batches small bounds how stale they get
+    // after a readjustment, and how much the sampler undercounts allocations while they're still outstanding.
+    unsigned long events_to_skip = discrete_dynamic_sampler_events_until_next_sample(&state->allocation_sampler);
+    allocation_skip = (allocation_skip_batch) {
+      .generation = allocation_skip_generation,
+      .events_to_skip = events_to_skip > ALLOCATION_SKIP_BATCH_MAX ? ALLOCATION_SKIP_BATCH_MAX : (uint32_t) events_to_skip,
+      .events_skipped = 0,
+    };
+
     return;
   }
 
@@ -1453,11 +1576,14 @@ static VALUE rescued_sample_allocation(VALUE arg) {
   rb_trace_arg_t *data = rb_tracearg_from_tracepoint(Qnil);
   VALUE new_object = rb_tracearg_object(data);
 
-  unsigned long allocations_since_last_sample = state->dynamic_sampling_rate_enabled ?
-    // if we're doing dynamic sampling, ask the sampler how many events since last sample
-    discrete_dynamic_sampler_events_since_last_sample(&state->allocation_sampler) :
-    // if we aren't, then we're sampling every event
-    1;
+  unsigned long allocations_since_last_sample =
+    // if we aren't doing dynamic sampling, then we're sampling every event
+    !state->dynamic_sampling_rate_enabled ? 1 :
+    // with Poisson byte sampling, the weight depends on the probability of an object of this size getting picked
+    state->allocation_poisson_sampling_enabled ?
+      discrete_dynamic_sampler_poisson_weight(&state->allocation_sampler, ruby_obj_slot_size(new_object)) :
+    // otherwise, ask the sampler how many events since last sample
+    discrete_dynamic_sampler_events_since_last_sample(&state->allocation_sampler);
 
   // To control bias from sampling, we clamp the maximum weight attributed to a single allocation sample. This avoids
   // assigning a very large number to a sample, if for instance the dynamic sampling mechanism chose a really big interval.
@@ -1569,6 +1695,7 @@ static VALUE _native_resume_signals(DDTRACE_UNUSED VALUE self) {
 
       if (result.waiting_for_gvl_duration_ns > 0) {
         state->stats.vm_metrics.gvl_waiting_time_ns_total += (uint64_t) result.waiting_for_gvl_duration_ns;
+        state->stats.vm_metrics.gvl_waiting_time_ns_histogram[gvl_waiting_histogram_bucket_for(result.waiting_for_gvl_duration_ns)]++;
       }
 
       if (result.action == ON_GVL_RUNNING_SAMPLE) {
@@ -1626,6 +1753,16 @@ static VALUE _native_resume_signals(DDTRACE_UNUSED VALUE self) {
     return Qnil;
   }
 
+  // Log2 buckets over (approximate) microseconds: cheap to compute (a shift and a clz) and precise enough to tell apart
+  // "lots of sub-millisecond handoffs" from "threads starving for tens of milliseconds".
+  static inline uint8_t gvl_waiting_histogram_bucket_for(long waiting_for_gvl_duration_ns) {
+    uint64_t duration_us = ((uint64_t) waiting_for_gvl_duration_ns) >> 10;
+    if (duration_us == 0) return 0;
+
+    int bucket = 64 - __builtin_clzll(duration_us);
+    return bucket < GVL_WAITING_HISTOGRAM_BUCKETS ? bucket : GVL_WAITING_HISTOGRAM_BUCKETS - 1;
+  }
+
   static VALUE _native_gvl_profiling_hook_active(DDTRACE_UNUSED VALUE self, VALUE instance) {
     cpu_and_wall_time_worker_state *state;
     TypedData_Get_Struct(instance, cpu_and_wall_time_worker_state, &cpu_and_wall_time_worker_typed_data, state);
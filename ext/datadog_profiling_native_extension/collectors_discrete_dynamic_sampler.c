@@ -22,6 +22,7 @@
 
 static void maybe_readjust(discrete_dynamic_sampler *sampler, long now_ns);
 static inline bool should_readjust(discrete_dynamic_sampler *sampler, coarse_instant now);
+static long draw_poisson_interval_bytes(discrete_dynamic_sampler *sampler);
 
 void discrete_dynamic_sampler_init(discrete_dynamic_sampler *sampler, const char *debug_name, long now_ns) {
   sampler->debug_name = debug_name;
@@ -31,9 +32,15 @@ void discrete_dynamic_sampler_init(discrete_dynamic_sampler *sampler, const char
 void discrete_dynamic_sampler_reset(discrete_dynamic_sampler *sampler, long now_ns) {
   const char *debug_name = sampler->debug_name;
   double target_overhead = sampler->target_overhead;
+  bool poisson_byte_sampling = sampler->poisson_byte_sampling;
+  // We keep the random state across resets, and only seed it the first time around. The seed doesn't need to be
+  // particularly good; it just needs to not be the same across processes (e.g. after forking) most of the time.
+  uint64_t random_state = sampler->random_state != 0 ? sampler->random_state : ((uint64_t) now_ns ^ (uintptr_t) sampler) | 1;
   (*sampler) = (discrete_dynamic_sampler) {
     .debug_name = debug_name,
     .target_overhead = target_overhead,
+    .poisson_byte_sampling = poisson_byte_sampling,
+    .random_state = random_state,
     // Act as if a reset is a readjustment (it kinda is!) and wait for a full adjustment window
     // to compute stats. Otherwise, we'd readjust on the next event that comes and thus be operating
     // with very incomplete information
@@ -46,9 +53,16 @@ void discrete_dynamic_sampler_reset(discrete_dynamic_sampler *sampler, long now_
     // real readjustment has some notion of how heavy sampling is. Therefore, we'll make it so that
     // the next event is automatically sampled by artificially locating it in the interval threshold.
     .events_since_last_sample = BASE_SAMPLING_INTERVAL - 1,
+    // Same as above, for Poisson byte sampling: any event will bring this to <= 0.
+    .bytes_until_next_sample = 0,
   };
 }
 
+void discrete_dynamic_sampler_enable_poisson_byte_sampling(discrete_dynamic_sampler *sampler, long now_ns) {
+  sampler->poisson_byte_sampling = true;
+  discrete_dynamic_sampler_reset(sampler, now_ns);
+}
+
 void discrete_dynamic_sampler_set_overhead_target_percentage(discrete_dynamic_sampler *sampler, double target_overhead, long now_ns) {
   if (target_overhead <= 0 || target_overhead > 100) {
     raise_error(rb_eArgError, "Target overhead must be a double between ]0,100] was %f", target_overhead);
@@ -81,6 +95,7 @@ long discrete_dynamic_sampler_after_sample(discrete_dynamic_sampler *sampler, lo
   sampler->samples_since_last_readjustment++;
   sampler->sampling_time_since_last_readjustment_ns += last_sampling_time_ns;
   sampler->events_since_last_sample = 0;
+  if (sampler->poisson_byte_sampling) sampler->bytes_until_next_sample = draw_poisson_interval_bytes(sampler);
 
   // check if we should readjust our sampler after this sample
   maybe_readjust(sampler, now_ns);
@@ -96,6 +111,55 @@ unsigned long discrete_dynamic_sampler_events_since_last_sample(discrete_dynamic
   return sampler->events_since_last_sample;
 }
 
+unsigned long discrete_dynamic_sampler_events_until_next_sample(discrete_dynamic_sampler *sampler) {
+  if (sampler->poisson_byte_sampling) return 0;
+  if (sampler->sampling_interval == 0) return ULONG_MAX; // Sampling is disabled until the next readjustment
+
+  // The event that brings events_since_last_sample to sampling_interval is the one that gets sampled
+  return sampler->events_since_last_sample + 1 < sampler->sampling_interval ?
+    sampler->sampling_interval - sampler->events_since_last_sample - 1 : 0;
+}
+
+void discrete_dynamic_sampler_skipped_events(discrete_dynamic_sampler *sampler, unsigned long events) {
+  sampler->events_since_last_sample += events;
+  sampler->events_since_last_readjustment += events;
+}
+
+// With byte intervals drawn from an exponential distribution with mean M, an event of size S gets sampled with
+// probability P = 1 - e^(-S/M) (e.g. if at least one "byte sample point" lands inside of it). Thus, each sampled
+// event stands for 1/P events of the same size.
+unsigned long discrete_dynamic_sampler_poisson_weight(discrete_dynamic_sampler *sampler, size_t event_bytes) {
+  if (sampler->sampling_interval_bytes <= 0 || event_bytes == 0) return 1;
+
+  double sampling_probability = -expm1(-((double) event_bytes) / sampler->sampling_interval_bytes);
+  if (sampling_probability <= 0) return 1;
+
+  double weight = round(1.0 / sampling_probability);
+  return weight < 1 ? 1 : (weight > UINT32_MAX ? UINT32_MAX : (unsigned long) weight);
+}
+
+// Draws the distance in bytes to the next sample from an exponential distribution with mean sampling_interval_bytes.
+//
+// Using exponentially-distributed intervals turns the samples into a Poisson process over the allocated bytes:
+// the process is memoryless, so unlike systematic sampling it can't "lock on" to periodic allocation patterns, and
+// it's fine to redraw an interval at any point (e.g. when readjusting) without introducing bias.
+static long draw_poisson_interval_bytes(discrete_dynamic_sampler *sampler) {
+  if (sampler->sampling_interval_bytes <= 0) return 0; // No data yet, sample every event
+
+  // xorshift64* -- we only need something fast with decent statistical properties, not a cryptographic RNG
+  uint64_t x = sampler->random_state;
+  x ^= x >> 12;
+  x ^= x << 25;
+  x ^= x >> 27;
+  sampler->random_state = x;
+
+  // Uniform double in ]0, 1], built from the top 53 bits
+  double uniform = ((double) (((x * 0x2545F4914F6CDD1DULL) >> 11) + 1)) / 9007199254740992.0;
+  double interval = -log(uniform) * sampler->sampling_interval_bytes;
+
+  return interval > (double) INT32_MAX * 1024 ? (long) INT32_MAX * 1024 : (long) interval;
+}
+
 // NOTE: See header for an explanation of when this should get used
 bool discrete_dynamic_sampler_skipped_sample(discrete_dynamic_sampler *sampler, coarse_instant now) {
   return should_readjust(sampler, now);
@@ -263,6 +327,22 @@ void discrete_dynamic_sampler_readjust(discrete_dynamic_sampler *sampler, long n
   // such high sampling intervals.
   sampler->sampling_interval = sampling_interval > UINT32_MAX ? 0 : sampling_interval;
 
+  if (sampler->poisson_byte_sampling) {
+    // The probability/interval math above is all done in events. We keep that, and translate the interval into
+    // bytes using the average event size we've been observing, so that we keep the same average number of samples
+    // (and thus the same overhead).
+    if (sampler->events_since_last_readjustment > 0) {
+      sampler->bytes_per_event = ewma_adj_window(
+        (double) sampler->bytes_since_last_readjustment / sampler->events_since_last_readjustment,
+        sampler->bytes_per_event,
+        this_window_time_ns,
+        first_readjustment
+      );
+    }
+    sampler->sampling_interval_bytes = sampler->sampling_interval * sampler->bytes_per_event;
+    sampler->bytes_until_next_sample = draw_poisson_interval_bytes(sampler);
+  }
+
   #ifdef DD_DEBUG
     double allocs_in_60s = sampler->events_per_ns * 1e9 * 60;
     double samples_in_60s = allocs_in_60s * sampler->sampling_probability;
@@ -298,6 +378,7 @@ void discrete_dynamic_sampler_readjust(discrete_dynamic_sampler *sampler, long n
   #endif
 
   sampler->events_since_last_readjustment = 0;
+  sampler->bytes_since_last_readjustment = 0;
   sampler->samples_since_last_readjustment = 0;
   sampler->sampling_time_since_last_readjustment_ns = 0;
   sampler->last_readjust_time_ns = now_ns;
@@ -319,6 +400,12 @@ VALUE discrete_dynamic_sampler_state_snapshot(discrete_dynamic_sampler *sampler)
   };
   VALUE hash = rb_hash_new();
   for (long unsigned int i = 0; i < VALUE_COUNT(arguments); i += 2) rb_hash_aset(hash, arguments[i], arguments[i+1]);
+
+  if (sampler->poisson_byte_sampling) {
+    rb_hash_aset(hash, ID2SYM(rb_intern("bytes_per_event")), DBL2NUM(sampler->bytes_per_event));
+    rb_hash_aset(hash, ID2SYM(rb_intern("sampling_interval_bytes")), DBL2NUM(sampler->sampling_interval_bytes));
+  }
+
   return hash;
 }
 
@@ -330,6 +417,11 @@ static VALUE _native_initialize(VALUE self, VALUE now);
 static VALUE _native_reset(VALUE self, VALUE now);
 static VALUE _native_set_overhead_target_percentage(VALUE self, VALUE target_overhead, VALUE now);
 static VALUE _native_should_sample(VALUE self, VALUE now);
+static VALUE _native_enable_poisson_byte_sampling(VALUE self, VALUE now);
+static VALUE _native_should_sample_bytes(VALUE self, VALUE event_bytes, VALUE now);
+static VALUE _native_poisson_weight(VALUE self, VALUE event_bytes);
+static VALUE _native_events_until_next_sample(VALUE self);
+static VALUE _native_skipped_events(VALUE self, VALUE events);
 static VALUE _native_after_sample(VALUE self, VALUE now);
 static VALUE _native_state_snapshot(VALUE self);
 
@@ -351,6 +443,11 @@ void collectors_discrete_dynamic_sampler_init(VALUE profiling_module) {
   rb_define_method(sampler_class, "_native_reset", _native_reset, 1);
   rb_define_method(sampler_class, "_native_set_overhead_target_percentage", _native_set_overhead_target_percentage, 2);
   rb_define_method(sampler_class, "_native_should_sample", _native_should_sample, 1);
+  rb_define_method(sampler_class, "_native_enable_poisson_byte_sampling", _native_enable_poisson_byte_sampling, 1);
+  rb_define_method(sampler_class, "_native_should_sample_bytes", _native_should_sample_bytes, 2);
+  rb_define_method(sampler_class, "_native_poisson_weight", _native_poisson_weight, 1);
+  rb_define_method(sampler_class, "_native_events_until_next_sample", _native_events_until_next_sample, 0);
+  rb_define_method(sampler_class, "_native_skipped_events", _native_skipped_events, 1);
   rb_define_method(sampler_class, "_native_after_sample", _native_after_sample, 1);
   rb_define_method(sampler_class, "_native_state_snapshot", _native_state_snapshot, 0);
 }
@@ -430,6 +527,61 @@ VALUE _native_should_sample(VALUE self, VALUE now_ns) {
   }
 }
 
+static VALUE _native_enable_poisson_byte_sampling(VALUE self, VALUE now_ns) {
+  ENFORCE_TYPE(now_ns, T_FIXNUM);
+
+  sampler_state *state;
+  TypedData_Get_Struct(self, sampler_state, &sampler_typed_data, state);
+
+  discrete_dynamic_sampler_enable_poisson_byte_sampling(&state->sampler, NUM2LONG(now_ns));
+
+  return Qnil;
+}
+
+static VALUE _native_should_sample_bytes(VALUE self, VALUE event_bytes, VALUE now_ns) {
+  ENFORCE_TYPE(event_bytes, T_FIXNUM);
+  ENFORCE_TYPE(now_ns, T_FIXNUM);
+
+  sampler_state *state;
+  TypedData_Get_Struct(self, sampler_state, &sampler_typed_data, state);
+
+  if (discrete_dynamic_sampler_should_sample_bytes(&state->sampler, NUM2SIZET(event_bytes))) {
+    discrete_dynamic_sampler_before_sample(&state->sampler, NUM2LONG(now_ns));
+    return Qtrue;
+  } else {
+    bool needs_readjust = discrete_dynamic_sampler_skipped_sample(&state->sampler, to_coarse_instant(NUM2LONG(now_ns)));
+    if (needs_readjust) discrete_dynamic_sampler_readjust(&state->sampler, NUM2LONG(now_ns));
+    return Qfalse;
+  }
+}
+
+static VALUE _native_poisson_weight(VALUE self, VALUE event_bytes) {
+  ENFORCE_TYPE(event_bytes, T_FIXNUM);
+
+  sampler_state *state;
+  TypedData_Get_Struct(self, sampler_state, &sampler_typed_data, state);
+
+  return ULONG2NUM(discrete_dynamic_sampler_poisson_weight(&state->sampler, NUM2SIZET(event_bytes)));
+}
+
+static VALUE _native_events_until_next_sample(VALUE self) {
+  sampler_state *state;
+  TypedData_Get_Struct(self, sampler_state, &sampler_typed_data, state);
+
+  return ULONG2NUM(discrete_dynamic_sampler_events_until_next_sample(&state->sampler));
+}
+
+static VALUE _native_skipped_events(VALUE self, VALUE events) {
+  ENFORCE_TYPE(events, T_FIXNUM);
+
+  sampler_state *state;
+  TypedData_Get_Struct(self, sampler_state, &sampler_typed_data, state);
+
+  discrete_dynamic_sampler_skipped_events(&state->sampler, NUM2ULONG(events));
+
+  return Qnil;
+}
+
 VALUE _native_after_sample(VALUE self, VALUE now_ns) {
   ENFORCE_TYPE(now_ns, T_FIXNUM);
 
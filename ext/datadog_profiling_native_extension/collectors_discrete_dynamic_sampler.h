@@ -16,6 +16,11 @@
 //       every event and is thus, in theory, susceptible to some pattern
 //       biases. In practice, the dynamic readjustment of sampling interval
 //       and randomized starting point should help with avoiding heavy biases.
+//
+//       Alternatively, the sampler can be switched to "Poisson byte sampling" (see
+//       `discrete_dynamic_sampler_enable_poisson_byte_sampling`). In this mode every event has a size in bytes, and
+//       the distance between samples is drawn from an exponential distribution over bytes, so that the chance of an
+//       event being sampled is proportional to its size and not to its position in the event stream.
 typedef struct {
   // --- Config ---
   // Name of this sampler for debug logs.
@@ -23,6 +28,8 @@ typedef struct {
   // Value in the range ]0, 100] representing the % of time we're willing to dedicate
   // to sampling.
   double target_overhead;
+  // Are we sampling based on randomized byte intervals, rather than systematic event intervals?
+  bool poisson_byte_sampling;
 
   // -- Reference State ---
   // Moving average of how many events per ns we saw over the recent past.
@@ -60,6 +67,19 @@ typedef struct {
   // try and mitigate observed overshooting of max sampling time.
   double target_overhead_adjustment;
 
+  // -- Poisson Byte Sampling State --
+  // Only used when poisson_byte_sampling is enabled.
+  // Moving average of the size of each event, used to translate sampling_interval (events) into bytes.
+  double bytes_per_event;
+  // Mean of the exponential distribution the byte intervals are drawn from (sampling_interval * bytes_per_event).
+  double sampling_interval_bytes;
+  // Countdown to the next sample. An event that brings it to <= 0 gets sampled.
+  long bytes_until_next_sample;
+  // How many bytes have we seen since the last readjustment.
+  unsigned long bytes_since_last_readjustment;
+  // State for the (non-cryptographic) random number generator used to draw intervals.
+  uint64_t random_state;
+
   // -- Interesting stats --
   unsigned long sampling_time_clamps;
 } discrete_dynamic_sampler;
@@ -76,6 +96,10 @@ void discrete_dynamic_sampler_reset(discrete_dynamic_sampler *sampler, long now_
 //        to be in the range ]0.0, 100.0].
 void discrete_dynamic_sampler_set_overhead_target_percentage(discrete_dynamic_sampler *sampler, double target_overhead, long now_ns);
 
+// Switches the sampler to Poisson byte sampling, resetting it in the process.
+// Events MUST then be reported via `discrete_dynamic_sampler_should_sample_bytes`.
+void discrete_dynamic_sampler_enable_poisson_byte_sampling(discrete_dynamic_sampler *sampler, long now_ns);
+
 // Make a sampling decision.
 //
 // @return True if the event associated with this decision should be sampled, false
@@ -99,6 +123,26 @@ void discrete_dynamic_sampler_set_overhead_target_percentage(discrete_dynamic_sa
 __attribute__((warn_unused_result))
 bool discrete_dynamic_sampler_should_sample(discrete_dynamic_sampler *sampler);
 
+// Same as `discrete_dynamic_sampler_should_sample`, but for samplers with Poisson byte sampling enabled.
+// The same before_sample/skipped_sample/readjust contract applies.
+//
+// @param event_bytes Size of this event. Doesn't need to be exact, but it needs to be cheap to compute since it's
+//        needed for every event, including the ones that don't get sampled.
+__attribute__((warn_unused_result))
+static inline bool discrete_dynamic_sampler_should_sample_bytes(discrete_dynamic_sampler *sampler, size_t event_bytes) {
+  sampler->events_since_last_sample++;
+  sampler->events_since_last_readjustment++;
+  sampler->bytes_since_last_readjustment += event_bytes;
+  sampler->bytes_until_next_sample -= (long) event_bytes;
+
+  return sampler->sampling_interval > 0 && sampler->bytes_until_next_sample <= 0;
+}
+
+// How many events a sampled event of `event_bytes` size represents (e.g. its weight) when using Poisson byte
+// sampling. Unlike `discrete_dynamic_sampler_events_since_last_sample`, this is an unbiased estimate that does not
+// depend on how many (or how big) the events that were skipped were.
+unsigned long discrete_dynamic_sampler_poisson_weight(discrete_dynamic_sampler *sampler, size_t event_bytes);
+
 // Signal the start of a sampling operation.
 // MUST be called after `discrete_dynamic_sampler_should_sample` returns `true`.
 void discrete_dynamic_sampler_before_sample(discrete_dynamic_sampler *sampler, long now_ns);
@@ -125,6 +169,18 @@ double discrete_dynamic_sampler_probability(discrete_dynamic_sampler *sampler);
 // Retrieve the current number of events seen since last sample.
 unsigned long discrete_dynamic_sampler_events_since_last_sample(discrete_dynamic_sampler *sampler);
 
+// How many of the upcoming events are guaranteed to not get sampled with the current sampling interval.
+// Callers can skip these without calling `discrete_dynamic_sampler_should_sample`, as long as they later report them
+// via `discrete_dynamic_sampler_skipped_events`.
+//
+// NOTE: Not applicable when Poisson byte sampling is enabled (returns 0), since the decision depends on each event.
+unsigned long discrete_dynamic_sampler_events_until_next_sample(discrete_dynamic_sampler *sampler);
+
+// Report a batch of events that were skipped without calling `discrete_dynamic_sampler_should_sample`. They get
+// accounted for exactly as if `discrete_dynamic_sampler_should_sample` had returned `false` for each of them, and
+// will be included in the weight of the next sample.
+void discrete_dynamic_sampler_skipped_events(discrete_dynamic_sampler *sampler, unsigned long events);
+
 // Return a Ruby hash containing a snapshot of this sampler's interesting state at calling time.
 // WARN: This allocates in the Ruby VM and therefore should not be called without the
 //       VM lock or during GC.
@@ -26,6 +26,7 @@ static VALUE oldgen_sym;
 static VALUE shady_sym;
 static VALUE force_sym;
 static VALUE oldmalloc_sym;
+static VALUE total_freed_pages_sym;
 
 static ddog_CharSlice major_gc_reason_pretty(VALUE major_gc_reason);
 static ddog_CharSlice gc_cause_pretty(VALUE gc_cause);
@@ -35,6 +36,7 @@ void gc_profiling_init(void) {
   // This function lazy-interns a few constants, which may trigger allocations. Since we want to call it during GC as
   // well, when allocations are not allowed, we call it once here so that the constants get defined ahead of time.
   rb_gc_latest_gc_info(rb_hash_new());
+  rb_gc_stat(rb_hash_new());
 
   // Used to query and look up the results of GC information
   state_sym     = ID2SYM(rb_intern_const("state"));
@@ -53,6 +55,7 @@ void gc_profiling_init(void) {
   shady_sym     = ID2SYM(rb_intern_const("shady"));
   force_sym     = ID2SYM(rb_intern_const("force"));
   oldmalloc_sym = ID2SYM(rb_intern_const("oldmalloc"));
+  total_freed_pages_sym = ID2SYM(rb_intern_const("total_freed_pages"));
   state_sym     = ID2SYM(rb_intern_const("state"));
   none_sym      = ID2SYM(rb_intern_const("none"));
 }
@@ -61,7 +64,25 @@ bool gc_profiling_has_major_gc_finished(void) {
   return rb_gc_latest_gc_info(state_sym) == none_sym && rb_gc_latest_gc_info(major_by_sym) != Qnil;
 }
 
+// Safety: Can be called during GC, as it does not allocate.
+void gc_profiling_capture_info(gc_profiling_info *info) {
+  info->major_by = rb_gc_latest_gc_info(major_by_sym);
+  info->gc_by = rb_gc_latest_gc_info(gc_by_sym);
+  info->state = rb_gc_latest_gc_info(state_sym);
+}
+
+// Safety: Can be called during GC, as it does not allocate.
+size_t gc_profiling_total_freed_pages(void) {
+  return rb_gc_stat(total_freed_pages_sym);
+}
+
 uint8_t gc_profiling_set_metadata(ddog_prof_Label *labels, int labels_length) {
+  gc_profiling_info info;
+  gc_profiling_capture_info(&info);
+  return gc_profiling_set_metadata_from(&info, labels, labels_length);
+}
+
+uint8_t gc_profiling_set_metadata_from(gc_profiling_info *info, ddog_prof_Label *labels, int labels_length) {
   uint8_t max_label_count =
     1 + // thread id
     1 + // thread name
@@ -72,7 +93,7 @@ uint8_t gc_profiling_set_metadata(ddog_prof_Label *labels, int labels_length) {
     1;  // gc type
 
   if (max_label_count > labels_length) {
-    raise_error(rb_eArgError, "BUG: gc_profiling_set_metadata invalid labels_length (%d) < max_label_count (%d)", labels_length, max_label_count);
+    raise_error(rb_eArgError, "BUG: gc_profiling_set_metadata_from invalid labels_length (%d) < max_label_count (%d)", labels_length, max_label_count);
   }
 
   uint8_t label_pos = 0;
@@ -101,7 +122,7 @@ uint8_t gc_profiling_set_metadata(ddog_prof_Label *labels, int labels_length) {
     .num = 0, // Workaround, same as above
   };
 
-  VALUE major_by = rb_gc_latest_gc_info(major_by_sym);
+  VALUE major_by = info->major_by;
   if (major_by != Qnil) {
     labels[label_pos++] = (ddog_prof_Label) {
       .key = DDOG_CHARSLICE_C("gc reason"),
@@ -111,16 +132,16 @@ uint8_t gc_profiling_set_metadata(ddog_prof_Label *labels, int labels_length) {
 
   labels[label_pos++] = (ddog_prof_Label) {
     .key = DDOG_CHARSLICE_C("gc cause"),
-    .str = gc_cause_pretty(rb_gc_latest_gc_info(gc_by_sym)),
+    .str = gc_cause_pretty(info->gc_by),
   };
 
   labels[label_pos++] = (ddog_prof_Label) {
     .key = DDOG_CHARSLICE_C("gc type"),
-    .str = gc_type_pretty(major_by, rb_gc_latest_gc_info(state_sym)),
+    .str = gc_type_pretty(major_by, info->state),
   };
 
   if (label_pos > max_label_count) {
-    raise_error(rb_eRuntimeError, "BUG: gc_profiling_set_metadata unexpected label_pos (%d) > max_label_count (%d)", label_pos, max_label_count);
+    raise_error(rb_eRuntimeError, "BUG: gc_profiling_set_metadata_from unexpected label_pos (%d) > max_label_count (%d)", label_pos, max_label_count);
   }
 
   return label_pos;
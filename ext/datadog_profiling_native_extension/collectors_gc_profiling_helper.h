@@ -1,5 +1,16 @@
 #pragma once
 
+// Snapshot of the GC information used to label GC samples. Holds only interned symbols (or nil), so it's safe to keep
+// around without marking.
+typedef struct {
+  VALUE major_by;
+  VALUE gc_by;
+  VALUE state;
+} gc_profiling_info;
+
 void gc_profiling_init(void);
 bool gc_profiling_has_major_gc_finished(void);
+void gc_profiling_capture_info(gc_profiling_info *info);
+size_t gc_profiling_total_freed_pages(void);
 uint8_t gc_profiling_set_metadata(ddog_prof_Label *labels, int labels_length);
+uint8_t gc_profiling_set_metadata_from(gc_profiling_info *info, ddog_prof_Label *labels, int labels_length);
@@ -1,5 +1,6 @@
 #include <ruby.h>
 #include <ruby/debug.h>
+#include <stdatomic.h>
 
 #include "datadog_ruby_common.h"
 #include "collectors_thread_context.h"
@@ -69,14 +70,28 @@
 // separate `thread_context_collector_sample_after_gc` because (as documented in more detail below),
 // `sample_after_gc` could trigger memory allocation in rare occasions (usually exceptions), which is actually not
 // allowed to happen during Ruby's garbage collection start/finish hooks.
+//
+// ### GC timeline events (experimental, opt-in via `gc_timeline_events_enabled`)
+//
+// The coalescing described above means the timeline only shows one "Garbage Collection" event per flush, which hides
+// how long each individual GC step took. When GC timeline events are enabled, `on_gc_finish` additionally records each
+// GC step that took at least GC_TIMELINE_EVENT_MIN_WALL_TIME_NS (or that finished a major GC) into a fixed-size ring
+// buffer (`state->gc_timeline`) that's allocated together with the collector, so recording never allocates.
+// These events are then exported as timeline-only samples during `thread_context_collector_on_serialize`. In this mode,
+// the coalesced sample recorded by `sample_after_gc` keeps its cpu/wall-time (for the flamegraph) but leaves the
+// timeline to the individual events. If the buffer fills up between flushes, the oldest events get overwritten.
 // ---
 
 #define THREAD_ID_LIMIT_CHARS 44 // Why 44? "#{2**64} (#{2**64})".size + 1 for \0
 #define THREAD_INVOKE_LOCATION_LIMIT_CHARS 512
 #define MISSING_TRACER_CONTEXT_KEY 0
 #define TIME_BETWEEN_GC_EVENTS_NS MILLIS_AS_NS(10)
+#define GC_TIMELINE_EVENTS_CAPACITY 512
+#define GC_TIMELINE_EVENT_MIN_WALL_TIME_NS MICROS_AS_NS(100)
 #define GVL_SUSPENDED ((uint64_t)1)
 #define GVL_RUNNING ((uint64_t)0)
+#define GVL_WAITING_ENDPOINTS_MAX 32
+#define GVL_WAITING_ENDPOINT_LIMIT_CHARS 128
 
 #define MAX(a, b) ((a) < (b) ? (b) : (a))
 
@@ -119,9 +134,28 @@ static uint16_t latest_max_frames = 400;
 // Global tracepoint for RUBY_EVENT_THREAD_BEGIN. Created and enabled once when the first ThreadContext collector is initialized.
 static VALUE thread_begin_tracepoint = Qnil;
 
+// Set when any (non-profiler-internal) thread releases the GVL, and cleared right before the CpuAndWallTimeWorker
+// takes an idle sample. While it stays cleared, no thread ran since the last idle sample, so every thread is still
+// suspended with the same stack, which the CpuAndWallTimeWorker uses to avoid waking up Ruby just to take samples
+// that would end up being skipped anyway (see `skip_sample`). Acquiring the GVL does not need to set it: a thread
+// that acquired it either still holds it (and then the process is not idle) or released it since.
+//
+// This gets updated without the GVL, from whatever thread the GVL event is about, hence the atomic.
+static atomic_bool gvl_released_since_idle_sample = true;
+// Set when the CpuAndWallTimeWorker skipped an idle sample, until the next `thread_context_collector_on_serialize`
+static atomic_bool idle_samples_skipped_since_serialize = false;
+
 typedef enum { OTEL_CONTEXT_ENABLED_FALSE, OTEL_CONTEXT_ENABLED_ONLY, OTEL_CONTEXT_ENABLED_BOTH } otel_context_enabled;
 typedef enum { OTEL_CONTEXT_SOURCE_UNKNOWN, OTEL_CONTEXT_SOURCE_FIBER_IVAR, OTEL_CONTEXT_SOURCE_FIBER_LOCAL } otel_context_source;
 
+// A single GC step, as recorded by on_gc_finish when GC timeline events are enabled
+typedef struct {
+  long wall_time_at_finish_ns;
+  long wall_time_elapsed_ns;
+  size_t pages_freed;
+  gc_profiling_info info;
+} gc_timeline_event;
+
 // Contains state for a single ThreadContext instance
 typedef struct {
   // Note: Places in this file that usually need to be changed when this struct is changed are tagged with
@@ -173,6 +207,19 @@ typedef struct {
     // (no GVL) since its previous sample, so its Ruby stack cannot have changed.
     unsigned int inactive_thread_samples_skipped;
     unsigned int profiler_thread_samples_skipped;
+    // "Waiting for GVL" time, attributed to the endpoint of the request each thread was serving.
+    // See attribute_gvl_waiting_time for details.
+    struct {
+      char endpoint[GVL_WAITING_ENDPOINT_LIMIT_CHARS];
+      uint8_t endpoint_len;
+      uint64_t waiting_time_ns;
+    } gvl_waiting_by_endpoint[GVL_WAITING_ENDPOINTS_MAX];
+    uint8_t gvl_waiting_endpoints_count;
+    // "Waiting for GVL" time for threads outside of a request, or once the endpoint table above is full
+    uint64_t gvl_waiting_time_ns_unattributed;
+    // How many GC timeline events got recorded into the profile, and how many got overwritten before being recorded
+    unsigned int gc_timeline_events;
+    unsigned int gc_timeline_events_dropped;
   } stats;
 
   struct {
@@ -182,6 +229,14 @@ typedef struct {
     long wall_time_at_previous_gc_ns; // Will be INVALID_TIME unless there's accumulated time above
     long wall_time_at_last_flushed_gc_event_ns; // Starts at 0 and then will always be valid
   } gc_tracking;
+
+  // Ring buffer of GC steps, see "GC timeline events" at the top of this file
+  struct {
+    bool enabled;
+    uint16_t oldest_position;
+    uint16_t count;
+    gc_timeline_event events[GC_TIMELINE_EVENTS_CAPACITY];
+  } gc_timeline;
 } thread_context_collector_state;
 
 // Tracks per-thread state.
@@ -268,12 +323,17 @@ struct per_thread_context {
   // the Profiling::Scheduler thread on the other hand does a lot of different
   // things using a mix of Ruby and native code, so that one isn't considered internal.
   bool is_profiler_internal_thread;
+  // Sum of all "Waiting for GVL" periods (including the ones below waiting_for_gvl_threshold_ns) since the thread was
+  // last sampled. Set by on_gvl_running and consumed by attribute_gvl_waiting_time, both of which run with the GVL.
+  long gvl_waiting_time_ns_to_attribute;
 
   struct {
     // Both of these fields are set by on_gc_start and kept until on_gc_finish is called.
     // Outside of this window, they will be INVALID_TIME.
     long cpu_time_at_start_ns;
     long wall_time_at_start_ns;
+    // Only set when GC timeline events are enabled
+    size_t total_freed_pages_at_start;
   } gc_tracking;
 };
 
@@ -327,7 +387,16 @@ static void initialize_context(VALUE thread, per_thread_context *thread_context)
 static VALUE _native_inspect(VALUE self, VALUE collector_instance);
 static VALUE per_thread_context_to_ruby_hash(per_thread_context *thread_context);
 static VALUE stats_to_ruby_hash(thread_context_collector_state *state, VALUE hash);
+static void record_gc_timeline_event(
+  thread_context_collector_state *state,
+  per_thread_context *thread_context,
+  long wall_time_at_finish_ns,
+  long wall_time_elapsed_ns
+);
+static void flush_gc_timeline_events(thread_context_collector_state *state);
 static VALUE gc_tracking_as_ruby_hash(thread_context_collector_state *state);
+static void attribute_gvl_waiting_time(thread_context_collector_state *state, per_thread_context *thread_context, trace_identifiers *trace_identifiers_result);
+static VALUE gvl_waiting_by_endpoint_as_ruby_hash(thread_context_collector_state *state);
 static VALUE _native_per_thread_context(VALUE self, VALUE collector_instance);
 static long update_cpu_time_since_previous_sample(per_thread_context *thread_context, long current_cpu_time_ns);
 static long update_wall_time_since_previous_sample(per_thread_context *thread_context, long current_wall_time_ns);
@@ -386,6 +455,7 @@ static VALUE _native_mark_thread_as_profiler_internal(DDTRACE_UNUSED VALUE self,
 static VALUE _native_remove_per_thread_context_for(DDTRACE_UNUSED VALUE self, VALUE thread);
 static VALUE _native_global_reset_per_thread_context(DDTRACE_UNUSED VALUE self, VALUE collector_instance);
 static bool skip_sample(thread_context_collector_state *state, per_thread_context *thread_context, bool is_gvl_waiting_state, bool force_sample);
+static inline bool is_suspended_since_last_sample(per_thread_context *thread_context, uint64_t gvl_state_change_count);
 static void on_thread_begin_event(VALUE tracepoint_data, DDTRACE_UNUSED void *unused);
 
 void collectors_thread_context_init(VALUE profiling_module) {
@@ -595,6 +665,7 @@ static VALUE _native_initialize(int argc, VALUE *argv, DDTRACE_UNUSED VALUE _sel
   VALUE otel_context_enabled = rb_hash_fetch(options, ID2SYM(rb_intern("otel_context_enabled")));
   VALUE native_filenames_enabled = rb_hash_fetch(options, ID2SYM(rb_intern("native_filenames_enabled")));
   VALUE show_classes = rb_hash_fetch(options, ID2SYM(rb_intern("show_classes")));
+  VALUE gc_timeline_events_enabled = rb_hash_fetch(options, ID2SYM(rb_intern("gc_timeline_events_enabled")));
   VALUE overhead_filename = rb_hash_fetch(options, ID2SYM(rb_intern("overhead_filename")));
 
   ENFORCE_TYPE(max_frames, T_FIXNUM);
@@ -602,6 +673,7 @@ static VALUE _native_initialize(int argc, VALUE *argv, DDTRACE_UNUSED VALUE _sel
   ENFORCE_TYPE(waiting_for_gvl_threshold_ns, T_FIXNUM);
   ENFORCE_BOOLEAN(native_filenames_enabled);
   ENFORCE_BOOLEAN(show_classes);
+  ENFORCE_BOOLEAN(gc_timeline_events_enabled);
   ENFORCE_TYPE(overhead_filename, T_STRING);
 
   uint16_t max_frame_int = sampling_buffer_check_max_frames(NUM2INT(max_frames));
@@ -616,6 +688,7 @@ static VALUE _native_initialize(int argc, VALUE *argv, DDTRACE_UNUSED VALUE _sel
   state->endpoint_collection_enabled = (endpoint_collection_enabled == Qtrue);
   state->native_filenames_enabled = (native_filenames_enabled == Qtrue);
   state->show_classes = (show_classes == Qtrue);
+  state->gc_timeline.enabled = (gc_timeline_events_enabled == Qtrue);
   state->overhead_filename = overhead_filename;
   if (otel_context_enabled == Qfalse || otel_context_enabled == Qnil) {
     state->otel_context_enabled = OTEL_CONTEXT_ENABLED_FALSE;
@@ -829,6 +902,13 @@ static void update_metrics_and_sample(
   );
 }
 
+// True when the thread does not have the GVL and did not acquire it since the previous sample, e.g. its Ruby-level
+// stack has not changed.
+static inline bool is_suspended_since_last_sample(per_thread_context *thread_context, uint64_t gvl_state_change_count) {
+  return (gvl_state_change_count & GVL_SUSPENDED) &&
+    gvl_state_change_count == thread_context->gvl_state_change_count_at_previous_sample;
+}
+
 static bool skip_sample(thread_context_collector_state *state, per_thread_context *thread_context, bool is_gvl_waiting_state, bool force_sample) {
   if (!force_sample && thread_context->is_profiler_internal_thread) {
     state->stats.profiler_thread_samples_skipped++;
@@ -847,8 +927,7 @@ static bool skip_sample(thread_context_collector_state *state, per_thread_contex
   // TODO: we could probably also skip while "Waiting for GVL"
   if (!is_gvl_waiting_state &&
       !force_sample &&
-      (gvl_state_change_count & GVL_SUSPENDED) &&
-      gvl_state_change_count == thread_context->gvl_state_change_count_at_previous_sample) {
+      is_suspended_since_last_sample(thread_context, gvl_state_change_count)) {
     state->stats.inactive_thread_samples_skipped++;
     thread_context->was_skipped_at_last_sample = true;
     return true; // Do NOT update wall_time_at_previous_sample_ns or cpu_time_at_previous_sample_ns
@@ -888,6 +967,10 @@ void thread_context_collector_on_gc_start(VALUE self_instance) {
   // Here we record the wall-time first and in on_gc_finish we record it second to try to avoid having wall-time be slightly < cpu-time
   thread_context->gc_tracking.wall_time_at_start_ns = monotonic_wall_time_now_ns(DO_NOT_RAISE_ON_FAILURE);
   thread_context->gc_tracking.cpu_time_at_start_ns = cpu_time_now_ns(thread_context);
+
+  if (state->gc_timeline.enabled) {
+    thread_context->gc_tracking.total_freed_pages_at_start = gc_profiling_total_freed_pages();
+  }
 }
 
 // This function gets called when Ruby has finished running the Garbage Collector on the current thread.
@@ -950,6 +1033,10 @@ bool thread_context_collector_on_gc_finish(VALUE self_instance) {
   state->gc_tracking.accumulated_wall_time_ns += gc_wall_time_elapsed_ns;
   state->gc_tracking.wall_time_at_previous_gc_ns = wall_time_at_finish_ns;
 
+  if (state->gc_timeline.enabled) {
+    record_gc_timeline_event(state, thread_context, wall_time_at_finish_ns, gc_wall_time_elapsed_ns);
+  }
+
   // Update cpu-time accounting so it doesn't include the cpu-time spent in GC during the next sample.
   // We don't do the same for wall-time, because GC is just like any other reason a thread didn't make
   // progress -- time always goes forward regardless of the thread making progress on what it wanted.
@@ -992,8 +1079,13 @@ VALUE thread_context_collector_sample_after_gc(VALUE self_instance) {
 
   ddog_prof_Slice_Label slice_labels = {.ptr = labels, .len = label_pos};
 
+  // When GC timeline events are enabled, each GC step already shows up in the timeline on its own (see
+  // flush_gc_timeline_events), so this sample is only used for the flamegraph.
+  bool include_in_timeline = !state->gc_timeline.enabled;
+
   // The end_timestamp_ns is treated specially by libdatadog and that's why it's not added as a ddog_prof_Label
-  int64_t end_timestamp_ns = monotonic_to_system_epoch_ns(&state->time_converter_state, state->gc_tracking.wall_time_at_previous_gc_ns);
+  int64_t end_timestamp_ns = include_in_timeline ?
+    monotonic_to_system_epoch_ns(&state->time_converter_state, state->gc_tracking.wall_time_at_previous_gc_ns) : 0;
 
   record_placeholder_stack(
     state->recorder_instance,
@@ -1006,7 +1098,7 @@ VALUE thread_context_collector_sample_after_gc(VALUE self_instance) {
       .cpu_time_ns = state->gc_tracking.accumulated_cpu_time_ns,
       .cpu_or_wall_samples = 1,
       .wall_time_ns = state->gc_tracking.accumulated_wall_time_ns,
-      .timeline_wall_time_ns = state->gc_tracking.accumulated_wall_time_ns,
+      .timeline_wall_time_ns = include_in_timeline ? state->gc_tracking.accumulated_wall_time_ns : 0,
     },
     (sample_labels) {.labels = slice_labels, .state_label = NULL, .end_timestamp_ns = end_timestamp_ns},
     DDOG_CHARSLICE_C("Garbage Collection")
@@ -1081,6 +1173,10 @@ static void trigger_sample_for_thread(
     otel_without_ddtrace_trace_identifiers_for(state, thread_being_sampled, &trace_identifiers_result, is_safe_to_allocate_objects);
   }
 
+  if (thread_context->gvl_waiting_time_ns_to_attribute > 0) {
+    attribute_gvl_waiting_time(state, thread_context, &trace_identifiers_result);
+  }
+
   if (trace_identifiers_result.valid) {
     labels[label_pos++] = (ddog_prof_Label) {.key = DDOG_CHARSLICE_C("local root span id"), .num = trace_identifiers_result.local_root_span_id};
     labels[label_pos++] = (ddog_prof_Label) {.key = DDOG_CHARSLICE_C("span id"), .num = trace_identifiers_result.span_id};
@@ -1165,6 +1261,49 @@ static void trigger_sample_for_thread(
   );
 }
 
+// Moves the "Waiting for GVL" time accumulated by on_gvl_running for this thread into the per-endpoint table.
+//
+// Waits below waiting_for_gvl_threshold_ns never show up as samples in the profile, yet with many threads they can
+// easily add up to a big chunk of request latency. Reading the trace identifiers from on_gvl_running is not an
+// option (it runs while Ruby holds the thread scheduler lock), so instead we attribute the wait time lazily, the next
+// time the thread gets sampled: at that point we've already looked up the trace identifiers for the sample anyway.
+//
+// This means the time may get attributed to the request the thread is serving after the wait, rather than the one
+// it was serving before, but since threads get sampled at least every few milliseconds while running this is
+// accurate enough to tell which endpoints suffer from GVL contention.
+//
+// This does not allocate, and thus is safe to call from the allocation sampling path.
+static void attribute_gvl_waiting_time(thread_context_collector_state *state, per_thread_context *thread_context, trace_identifiers *trace_identifiers_result) {
+  uint64_t waiting_time_ns = thread_context->gvl_waiting_time_ns_to_attribute;
+  thread_context->gvl_waiting_time_ns_to_attribute = 0;
+
+  if (!trace_identifiers_result->valid || trace_identifiers_result->trace_endpoint == Qnil) {
+    state->stats.gvl_waiting_time_ns_unattributed += waiting_time_ns;
+    return;
+  }
+
+  ddog_CharSlice endpoint = char_slice_from_ruby_string(trace_identifiers_result->trace_endpoint);
+  uint8_t endpoint_len = endpoint.len < GVL_WAITING_ENDPOINT_LIMIT_CHARS ? endpoint.len : GVL_WAITING_ENDPOINT_LIMIT_CHARS;
+
+  for (uint8_t i = 0; i < state->stats.gvl_waiting_endpoints_count; i++) {
+    if (state->stats.gvl_waiting_by_endpoint[i].endpoint_len == endpoint_len &&
+        memcmp(state->stats.gvl_waiting_by_endpoint[i].endpoint, endpoint.ptr, endpoint_len) == 0) {
+      state->stats.gvl_waiting_by_endpoint[i].waiting_time_ns += waiting_time_ns;
+      return;
+    }
+  }
+
+  if (state->stats.gvl_waiting_endpoints_count == GVL_WAITING_ENDPOINTS_MAX) {
+    state->stats.gvl_waiting_time_ns_unattributed += waiting_time_ns;
+    return;
+  }
+
+  uint8_t new_entry = state->stats.gvl_waiting_endpoints_count++;
+  memcpy(state->stats.gvl_waiting_by_endpoint[new_entry].endpoint, endpoint.ptr, endpoint_len);
+  state->stats.gvl_waiting_by_endpoint[new_entry].endpoint_len = endpoint_len;
+  state->stats.gvl_waiting_by_endpoint[new_entry].waiting_time_ns = waiting_time_ns;
+}
+
 // This method exists only to enable testing Datadog::Profiling::Collectors::ThreadContext behavior using RSpec.
 // It SHOULD NOT be used for other purposes.
 static VALUE _native_thread_list(DDTRACE_UNUSED VALUE _self) {
@@ -1278,6 +1417,7 @@ static void initialize_context(VALUE thread, per_thread_context *thread_context)
 
   thread_context->gvl_waiting_at = 0;
   thread_context->gvl_state_change_count = 0;
+  thread_context->gvl_waiting_time_ns_to_attribute = 0;
 }
 
 // This MUST be called before profiling starts, so that a new profiler session starts from a fresh state and never
@@ -1373,6 +1513,7 @@ static VALUE per_thread_context_to_ruby_hash(per_thread_context *thread_context)
     ID2SYM(rb_intern("gvl_state_change_count_at_previous_sample")), /* => */ ULL2NUM(thread_context->gvl_state_change_count_at_previous_sample),
     ID2SYM(rb_intern("was_skipped_at_last_sample")), /* => */ thread_context->was_skipped_at_last_sample ? Qtrue : Qfalse,
     ID2SYM(rb_intern("is_profiler_internal_thread")), /* => */ thread_context->is_profiler_internal_thread ? Qtrue : Qfalse,
+    ID2SYM(rb_intern("gvl_waiting_time_ns_to_attribute")), /* => */ LONG2NUM(thread_context->gvl_waiting_time_ns_to_attribute),
   };
   for (long unsigned int i = 0; i < VALUE_COUNT(arguments); i += 2) rb_hash_aset(context_as_hash, arguments[i], arguments[i+1]);
 
@@ -1387,11 +1528,27 @@ static VALUE stats_to_ruby_hash(thread_context_collector_state *state, VALUE has
     ID2SYM(rb_intern("gc_samples_missed_due_to_missing_context")), /* => */ UINT2NUM(state->stats.gc_samples_missed_due_to_missing_context),
     ID2SYM(rb_intern("inactive_thread_samples_skipped")),          /* => */ UINT2NUM(state->stats.inactive_thread_samples_skipped),
     ID2SYM(rb_intern("profiler_thread_samples_skipped")),          /* => */ UINT2NUM(state->stats.profiler_thread_samples_skipped),
+    ID2SYM(rb_intern("gvl_waiting_time_ns_by_endpoint")),          /* => */ gvl_waiting_by_endpoint_as_ruby_hash(state),
+    ID2SYM(rb_intern("gvl_waiting_time_ns_unattributed")),         /* => */ ULL2NUM(state->stats.gvl_waiting_time_ns_unattributed),
+    ID2SYM(rb_intern("gc_timeline_events")),                       /* => */ UINT2NUM(state->stats.gc_timeline_events),
+    ID2SYM(rb_intern("gc_timeline_events_dropped")),               /* => */ UINT2NUM(state->stats.gc_timeline_events_dropped),
   };
   for (long unsigned int i = 0; i < VALUE_COUNT(arguments); i += 2) rb_hash_aset(hash, arguments[i], arguments[i+1]);
   return hash;
 }
 
+static VALUE gvl_waiting_by_endpoint_as_ruby_hash(thread_context_collector_state *state) {
+  VALUE result = rb_hash_new();
+  for (uint8_t i = 0; i < state->stats.gvl_waiting_endpoints_count; i++) {
+    rb_hash_aset(
+      result,
+      rb_str_new(state->stats.gvl_waiting_by_endpoint[i].endpoint, state->stats.gvl_waiting_by_endpoint[i].endpoint_len),
+      ULL2NUM(state->stats.gvl_waiting_by_endpoint[i].waiting_time_ns)
+    );
+  }
+  return result;
+}
+
 static VALUE gc_tracking_as_ruby_hash(thread_context_collector_state *state) {
   // Update this when modifying state struct (gc_tracking inner struct)
   VALUE result = rb_hash_new();
@@ -1634,6 +1791,8 @@ static VALUE _native_reset_after_fork(DDTRACE_UNUSED VALUE self, VALUE collector
   TypedData_Get_Struct(collector_instance, thread_context_collector_state, &thread_context_collector_typed_data, state);
 
   state->stats = (struct stats) {}; // Resets all stats back to zero
+  state->gc_timeline.oldest_position = 0;
+  state->gc_timeline.count = 0;
 
   // No need to clean-up the per-thread context because the CpuAndWallTimeWorker always cleans
   // it up unconditionally on every start/restart and that includes after a fork.
@@ -2127,11 +2286,17 @@ void thread_context_collector_profiler_internal_thread_done(VALUE self_instance)
 
 // Flushes threads whose last per-tick sample was skipped (either by the SUSPENDED-skip
 // optimization, or by is_profiler_internal_thread) so their accumulated time is recorded.
+// This also includes threads that have been suspended since their last sample but had no per-tick sample at all
+// since then (e.g. because the CpuAndWallTimeWorker skipped idle sampling, as nothing changed).
+// When idle samples were skipped, it also includes the threads that did not change their GVL state since the GVL
+// hooks were installed (e.g. they were already blocked by then), as they were not sampled either.
 // Called by the stack recorder at the start of _native_serialize (regular periodic flush).
 void thread_context_collector_on_serialize(VALUE self_instance) {
   thread_context_collector_state *state;
   TypedData_Get_Struct(self_instance, thread_context_collector_state, &thread_context_collector_typed_data, state);
 
+  bool idle_samples_skipped = atomic_exchange(&idle_samples_skipped_since_serialize, false);
+
   long current_monotonic_wall_time_ns = monotonic_wall_time_now_ns(RAISE_ON_FAILURE);
   VALUE threads = thread_list(state);
   const long thread_count = RARRAY_LEN(threads);
@@ -2140,7 +2305,12 @@ void thread_context_collector_on_serialize(VALUE self_instance) {
     VALUE thread = RARRAY_AREF(threads, i);
     per_thread_context *thread_context = get_per_thread_context(thread);
 
-    if (thread_context != NULL && (thread_context->was_skipped_at_last_sample || thread_context->is_profiler_internal_thread)) {
+    if (thread_context != NULL && (
+      thread_context->was_skipped_at_last_sample ||
+      thread_context->is_profiler_internal_thread ||
+      is_suspended_since_last_sample(thread_context, thread_context->gvl_state_change_count) ||
+      (idle_samples_skipped && thread_context->gvl_state_change_count == 0)
+    )) {
       long current_cpu_time_ns = cpu_time_now_ns(thread_context);
       // We need to force_sample=true otherwise this sample would be skipped too
       update_metrics_and_sample(
@@ -2152,12 +2322,95 @@ void thread_context_collector_on_serialize(VALUE self_instance) {
         true);
     }
   }
+
+  if (state->gc_timeline.enabled) flush_gc_timeline_events(state);
+}
+
+// Safety: Called from on_gc_finish, so the same *NO ALLOCATION* rules apply.
+static void record_gc_timeline_event(
+  thread_context_collector_state *state,
+  per_thread_context *thread_context,
+  long wall_time_at_finish_ns,
+  long wall_time_elapsed_ns
+) {
+  if (wall_time_elapsed_ns < GC_TIMELINE_EVENT_MIN_WALL_TIME_NS && !gc_profiling_has_major_gc_finished()) return;
+
+  uint16_t position;
+  if (state->gc_timeline.count < GC_TIMELINE_EVENTS_CAPACITY) {
+    position = (state->gc_timeline.oldest_position + state->gc_timeline.count) % GC_TIMELINE_EVENTS_CAPACITY;
+    state->gc_timeline.count++;
+  } else {
+    // Buffer is full: overwrite the oldest event
+    position = state->gc_timeline.oldest_position;
+    state->gc_timeline.oldest_position = (position + 1) % GC_TIMELINE_EVENTS_CAPACITY;
+    state->stats.gc_timeline_events_dropped++;
+  }
+
+  gc_timeline_event *event = &state->gc_timeline.events[position];
+  size_t total_freed_pages = gc_profiling_total_freed_pages();
+  size_t total_freed_pages_at_start = thread_context->gc_tracking.total_freed_pages_at_start;
+
+  event->wall_time_at_finish_ns = wall_time_at_finish_ns;
+  event->wall_time_elapsed_ns = wall_time_elapsed_ns;
+  event->pages_freed = total_freed_pages >= total_freed_pages_at_start ? total_freed_pages - total_freed_pages_at_start : 0;
+  gc_profiling_capture_info(&event->info);
+}
+
+static void flush_gc_timeline_events(thread_context_collector_state *state) {
+  int max_labels_needed_for_gc = 7 + 1; // gc_profiling_set_metadata_from labels + gc pages freed
+
+  while (state->gc_timeline.count > 0) {
+    // Copy the event out before recording it: recording may trigger GC, which may in turn record new events
+    gc_timeline_event event = state->gc_timeline.events[state->gc_timeline.oldest_position];
+    state->gc_timeline.oldest_position = (state->gc_timeline.oldest_position + 1) % GC_TIMELINE_EVENTS_CAPACITY;
+    state->gc_timeline.count--;
+
+    ddog_prof_Label labels[max_labels_needed_for_gc];
+    uint8_t label_pos = gc_profiling_set_metadata_from(&event.info, labels, max_labels_needed_for_gc);
+    labels[label_pos++] = (ddog_prof_Label) {.key = DDOG_CHARSLICE_C("gc pages freed"), .num = event.pages_freed};
+
+    record_placeholder_stack(
+      state->recorder_instance,
+      (sample_values) {.timeline_wall_time_ns = event.wall_time_elapsed_ns},
+      (sample_labels) {
+        .labels = (ddog_prof_Slice_Label) {.ptr = labels, .len = label_pos},
+        .state_label = NULL,
+        .end_timestamp_ns = monotonic_to_system_epoch_ns(&state->time_converter_state, event.wall_time_at_finish_ns),
+      },
+      DDOG_CHARSLICE_C("Garbage Collection")
+    );
+
+    state->stats.gc_timeline_events++;
+  }
 }
 
 void thread_context_collector_on_gvl_released(per_thread_context *thread_context) {
+  // SUSPENDED can happen multiple times in a row on Ruby 3.2 (see gvl_state_change_count), so only flag actual changes
+  if (!(thread_context->gvl_state_change_count & GVL_SUSPENDED) && !thread_context->is_profiler_internal_thread) {
+    // Only written when not set yet, so that GVL transitions don't keep bouncing this cache line between cores
+    if (!atomic_load_explicit(&gvl_released_since_idle_sample, memory_order_relaxed)) {
+      atomic_store(&gvl_released_since_idle_sample, true);
+    }
+  }
   thread_context->gvl_state_change_count |= GVL_SUSPENDED;
 }
 
+bool thread_context_collector_gvl_released_since_idle_sample(void) {
+  return atomic_load(&gvl_released_since_idle_sample);
+}
+
+// Called with the GVL, right before the CpuAndWallTimeWorker takes an idle sample
+void thread_context_collector_on_idle_sample(void) {
+  atomic_store(&gvl_released_since_idle_sample, false);
+}
+
+// Called without the GVL, when the CpuAndWallTimeWorker skips an idle sample (see `thread_context_collector_on_serialize`)
+void thread_context_collector_on_idle_sample_skipped(void) {
+  if (!atomic_load_explicit(&idle_samples_skipped_since_serialize, memory_order_relaxed)) {
+    atomic_store(&idle_samples_skipped_since_serialize, true);
+  }
+}
+
 void thread_context_collector_on_gvl_waiting(per_thread_context *thread_context) {
   long current_monotonic_wall_time_ns = monotonic_wall_time_now_ns(DO_NOT_RAISE_ON_FAILURE);
   if (current_monotonic_wall_time_ns <= 0) return;
@@ -2214,6 +2467,8 @@ static VALUE _native_on_gvl_released(DDTRACE_UNUSED VALUE self, VALUE thread) {
 
     long waiting_for_gvl_duration_ns = monotonic_wall_time_now_ns(DO_NOT_RAISE_ON_FAILURE) - gvl_waiting_at;
 
+    if (waiting_for_gvl_duration_ns > 0) thread_context->gvl_waiting_time_ns_to_attribute += waiting_for_gvl_duration_ns;
+
     bool should_sample = waiting_for_gvl_duration_ns >= state->waiting_for_gvl_threshold_ns;
 
     if (should_sample) {
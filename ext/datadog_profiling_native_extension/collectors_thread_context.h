@@ -41,4 +41,7 @@ void thread_context_collector_profiler_internal_thread_done(VALUE self_instance)
   __attribute__((warn_unused_result)) on_gvl_running_result thread_context_collector_on_gvl_running(VALUE self_instance, VALUE thread, per_thread_context *thread_context);
   VALUE thread_context_collector_sample_after_gvl_running(VALUE self_instance, VALUE current_thread, long current_monotonic_wall_time_ns);
   void thread_context_collector_on_gvl_released(per_thread_context *thread_context);
+  bool thread_context_collector_gvl_released_since_idle_sample(void);
+  void thread_context_collector_on_idle_sample(void);
+  void thread_context_collector_on_idle_sample_skipped(void);
 #endif
@@ -162,6 +162,9 @@ $defs << "-DUSE_RACTOR_INTERNAL_APIS_DIRECTLY" if RUBY_VERSION < "3.3"
 # On older Rubies, there was no GVL instrumentation API and APIs created to support it
 $defs << "-DNO_GVL_INSTRUMENTATION" if RUBY_VERSION < "3.2"
 
+# On older Rubies, there were no variable-sized heap slots and rb_gc_obj_slot_size was not available
+$defs << "-DNO_RB_GC_OBJ_SLOT_SIZE" if RUBY_VERSION < "3.3"
+
 # On older Rubies, rb_class_attached_object is not available
 $defs << "-DNO_CLASS_ATTACHED_OBJECT" if RUBY_VERSION < "3.2"
 
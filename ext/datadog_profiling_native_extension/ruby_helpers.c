@@ -151,6 +151,16 @@ size_t ruby_obj_memsize_of(VALUE obj) {
   }
 }
 
+#ifdef NO_RB_GC_OBJ_SLOT_SIZE
+  // Before variable width allocation, every object used a single RVALUE-sized slot (5 words)
+  size_t ruby_obj_slot_size(DDTRACE_UNUSED VALUE obj) { return 5 * sizeof(VALUE); }
+#else
+  // Not part of public headers but is externed from Ruby
+  size_t rb_gc_obj_slot_size(VALUE obj);
+
+  size_t ruby_obj_slot_size(VALUE obj) { return rb_gc_obj_slot_size(obj); }
+#endif
+
 #ifdef NO_RB_OBJ_INFO
   const char* safe_object_info(DDTRACE_UNUSED VALUE obj) { return "(No rb_obj_info for current Ruby)"; }
 #else
@@ -83,6 +83,10 @@ NORETURN(void private_raise_enforce_syserr(
 // object.
 size_t ruby_obj_memsize_of(VALUE obj);
 
+// Size of the heap slot used by the passed object. Unlike `ruby_obj_memsize_of`, this is cheap and safe to call
+// during the NEWOBJ event, before the object is fully initialized.
+size_t ruby_obj_slot_size(VALUE obj);
+
 // Safely inspect any ruby object. If the object responds to 'inspect',
 // return a string with the result of that call. Elsif the object responds to
 // 'to_s', return a string with the result of that call. Otherwise, return Qnil.
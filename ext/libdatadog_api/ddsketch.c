@@ -1,15 +1,50 @@
 #include <ruby.h>
+#include <math.h>
+#include <stdbool.h>
+#include <float.h>
 #include <datadog/ddsketch.h>
 
 #include "datadog_ruby_common.h"
 #include "helpers.h"
 
+// libdatadog's ddsketch only supports adding points and encoding (which consumes the sketch), so to support merging,
+// quantiles and non-destructive encoding we keep the bins on the Ruby side of the FFI and only build a libdatadog
+// sketch when encoding.
+//
+// The bins use the same logarithmic mapping as libdatadog (bin i covers [gamma^i, gamma^(i+1)), with a relative
+// accuracy of 1/129, i.e. gamma = 1 + 1/64), so replaying each bin at a value inside it lands in the same bin of the
+// encoded sketch. The index is computed the same way too, so that points right at a bin boundary also land in the
+// same bin. The specs check that encoding matches adding the points to a libdatadog sketch directly.
+#define RELATIVE_ACCURACY (1.0 / 129.0)
+#define GAMMA ((1.0 + RELATIVE_ACCURACY) / (1.0 - RELATIVE_ACCURACY))
+// Points smaller than this are counted as zeros
+#define MIN_INDEXABLE_VALUE (DBL_MIN * GAMMA)
+// When the bins would span more than this, the lowest ones get collapsed together (as the agent does)
+#define MAX_BINS 4096
+// Extra bins allocated when growing, so that a sketch doesn't reallocate for every slightly larger point
+#define GROWTH_SLACK 32
+
+typedef struct {
+  double *bins; // Dense store for bins [offset, offset + length)
+  int offset;
+  int length;
+  double zero_count;
+  double count;
+} ddsketch_t;
+
 static VALUE _native_new(VALUE klass);
 static void ddsketch_free(void *ptr);
+static size_t ddsketch_size(const void *ptr);
 static VALUE native_add(VALUE self, VALUE point);
 static VALUE native_add_with_count(VALUE self, VALUE point, VALUE count);
+static VALUE native_add_all(VALUE self, VALUE points);
+static VALUE native_merge(VALUE self, VALUE other);
+static VALUE native_quantile(VALUE self, VALUE quantile);
 static VALUE native_count(VALUE self);
-static VALUE native_encode(VALUE self);
+static VALUE _native_encode(VALUE self, VALUE reset);
+
+// Used for testing in RSpec
+static VALUE _native_encode_with_libdatadog(DDTRACE_UNUSED VALUE _self, VALUE points);
 
 void ddsketch_init(VALUE core_module) {
   VALUE ddsketch_class = rb_define_class_under(core_module, "DDSketch", rb_cObject);
@@ -17,86 +52,267 @@ void ddsketch_init(VALUE core_module) {
   rb_define_alloc_func(ddsketch_class, _native_new);
   rb_define_method(ddsketch_class, "add", native_add, 1);
   rb_define_method(ddsketch_class, "add_with_count", native_add_with_count, 2);
+  rb_define_method(ddsketch_class, "add_all", native_add_all, 1);
+  rb_define_method(ddsketch_class, "merge", native_merge, 1);
+  rb_define_method(ddsketch_class, "quantile", native_quantile, 1);
   rb_define_method(ddsketch_class, "count", native_count, 0);
-  rb_define_method(ddsketch_class, "encode", native_encode, 0);
+  rb_define_private_method(ddsketch_class, "_native_encode", _native_encode, 1);
+
+  // Used for testing in RSpec
+  VALUE testing_module = rb_define_module_under(ddsketch_class, "Testing");
+  rb_define_singleton_method(testing_module, "_native_encode_with_libdatadog", _native_encode_with_libdatadog, 1);
 }
 
-// This structure is used to define a Ruby object that stores a pointer to a ddsketch_Handle_DDSketch
+// This structure is used to define a Ruby object that stores a pointer to a ddsketch_t
 // See also https://github.com/ruby/ruby/blob/master/doc/extension.rdoc for how this works
 static const rb_data_type_t ddsketch_typed_data = {
   .wrap_struct_name = "Datadog::DDSketch",
   .function = {
     .dmark = NULL, // We don't store references to Ruby objects so we don't need to mark any of them
     .dfree = ddsketch_free,
-    .dsize = NULL, // We don't track memory usage (although it'd be cool if we did!)
+    .dsize = ddsketch_size,
     //.dcompact = NULL, // Not needed -- we don't store references to Ruby objects
   },
   .flags = RUBY_TYPED_FREE_IMMEDIATELY
 };
 
 static VALUE _native_new(VALUE klass) {
-  ddsketch_Handle_DDSketch *state = ruby_xcalloc(1, sizeof(ddsketch_Handle_DDSketch));
-
-  *state = ddog_ddsketch_new();
+  ddsketch_t *state = ruby_xcalloc(1, sizeof(ddsketch_t));
 
   return TypedData_Wrap_Struct(klass, &ddsketch_typed_data, state);
 }
 
 static void ddsketch_free(void *ptr) {
-  ddsketch_Handle_DDSketch *state = (ddsketch_Handle_DDSketch *) ptr;
-  ddog_ddsketch_drop(state);
+  ddsketch_t *state = (ddsketch_t *) ptr;
+  ruby_xfree(state->bins);
   ruby_xfree(ptr);
 }
 
+static size_t ddsketch_size(const void *ptr) {
+  const ddsketch_t *state = (const ddsketch_t *) ptr;
+  return sizeof(ddsketch_t) + (size_t) state->length * sizeof(double);
+}
+
+static ddsketch_t *get_sketch(VALUE self) {
+  ddsketch_t *state;
+  TypedData_Get_Struct(self, ddsketch_t, &ddsketch_typed_data, state);
+  return state;
+}
+
+// Same validation as libdatadog: NaN, infinite and negative points are rejected
+static bool valid_point(double point) { return point >= 0 && !isinf(point); }
+static bool valid_count(double count) { return count >= 0 && !isinf(count); }
+
+static int index_of(double point) { return (int) floor(log(point) * (1.0 / log(GAMMA))); }
+
+// Geometric middle of the bin, which is within the relative accuracy of every point in the bin
+static double value_of(int index) { return fmin(exp((index + 0.5) * log(GAMMA)), DBL_MAX); }
+
+// Reallocates the bins so that they include `index`.
+static void extend_bins(ddsketch_t *state, int index) {
+  int low = index, high = index;
+  if (state->length > 0) {
+    if (state->offset < low) low = state->offset;
+    if (state->offset + state->length - 1 > high) high = state->offset + state->length - 1;
+  }
+
+  int span = high - low + 1;
+  if (span > MAX_BINS) {
+    low = high - MAX_BINS + 1;
+  } else {
+    int slack = MAX_BINS - span < GROWTH_SLACK ? MAX_BINS - span : GROWTH_SLACK;
+    if (state->length > 0 && index < state->offset) low -= slack; else high += slack;
+  }
+
+  int length = high - low + 1;
+  double *bins = ruby_xcalloc(length, sizeof(double));
+  for (int i = 0; i < state->length; i++) {
+    int target = state->offset + i < low ? 0 : state->offset + i - low;
+    bins[target] += state->bins[i];
+  }
+
+  ruby_xfree(state->bins);
+  state->bins = bins;
+  state->offset = low;
+  state->length = length;
+}
+
+static void add_to_bin(ddsketch_t *state, int index, double count) {
+  if (index < state->offset || index >= state->offset + state->length) extend_bins(state, index);
+  // Points below the bins after collapsing are counted in the lowest bin
+  if (index < state->offset) index = state->offset;
+
+  state->bins[index - state->offset] += count;
+  state->count += count;
+}
+
+static void add_point(ddsketch_t *state, double point, double count) {
+  if (point < MIN_INDEXABLE_VALUE) {
+    state->zero_count += count;
+    state->count += count;
+  } else {
+    add_to_bin(state, index_of(point), count);
+  }
+}
+
 static VALUE native_add(VALUE self, VALUE point) {
-  ddsketch_Handle_DDSketch *state;
-  TypedData_Get_Struct(self, ddsketch_Handle_DDSketch, &ddsketch_typed_data, state);
+  ddsketch_t *state = get_sketch(self);
 
-  ddog_VoidResult result = ddog_ddsketch_add(state, NUM2DBL(point));
+  double point_value = NUM2DBL(point);
+  if (!valid_point(point_value)) raise_error(rb_eRuntimeError, "DDSketch add failed: point is invalid");
 
-  CHECK_VOID_RESULT("DDSketch add failed", result);
+  add_point(state, point_value, 1);
 
   return self;
 }
 
 static VALUE native_add_with_count(VALUE self, VALUE point, VALUE count) {
-  ddsketch_Handle_DDSketch *state;
-  TypedData_Get_Struct(self, ddsketch_Handle_DDSketch, &ddsketch_typed_data, state);
+  ddsketch_t *state = get_sketch(self);
 
-  ddog_VoidResult result = ddog_ddsketch_add_with_count(state, NUM2DBL(point), NUM2DBL(count));
+  double point_value = NUM2DBL(point);
+  double count_value = NUM2DBL(count);
+  if (!valid_point(point_value)) raise_error(rb_eRuntimeError, "DDSketch add_with_count failed: point is invalid");
+  if (!valid_count(count_value)) raise_error(rb_eRuntimeError, "DDSketch add_with_count failed: count is invalid");
 
-  CHECK_VOID_RESULT("DDSketch add_with_count failed", result);
+  add_point(state, point_value, count_value);
 
   return self;
 }
 
-static VALUE native_count(VALUE self) {
-  ddsketch_Handle_DDSketch *state;
-  TypedData_Get_Struct(self, ddsketch_Handle_DDSketch, &ddsketch_typed_data, state);
+// Adds every point of the array. The points are all validated first, so an invalid point leaves the sketch unchanged.
+static VALUE native_add_all(VALUE self, VALUE points) {
+  ddsketch_t *state = get_sketch(self);
+  ENFORCE_TYPE(points, T_ARRAY);
+
+  for (long i = 0; i < RARRAY_LEN(points); i++) {
+    if (!valid_point(NUM2DBL(RARRAY_AREF(points, i)))) {
+      raise_error(rb_eRuntimeError, "DDSketch add_all failed: point is invalid");
+    }
+  }
 
-  double count_out;
-  ddog_VoidResult result = ddog_ddsketch_count(state, &count_out);
+  for (long i = 0; i < RARRAY_LEN(points); i++) {
+    double point = NUM2DBL(RARRAY_AREF(points, i));
+    // Only possible if a custom #to_f changed the array after it was validated
+    if (!valid_point(point)) continue;
 
-  CHECK_VOID_RESULT("DDSketch count failed", result);
+    add_point(state, point, 1);
+  }
 
-  return DBL2NUM(count_out);
+  return self;
 }
 
-static VALUE native_encode(VALUE self) {
-  ddsketch_Handle_DDSketch *state;
-  TypedData_Get_Struct(self, ddsketch_Handle_DDSketch, &ddsketch_typed_data, state);
+static VALUE native_merge(VALUE self, VALUE other) {
+  ddsketch_t *state = get_sketch(self);
+  ddsketch_t *other_state = get_sketch(other);
+
+  if (state == other_state) {
+    for (int i = 0; i < state->length; i++) state->bins[i] *= 2;
+    state->zero_count *= 2;
+    state->count *= 2;
+    return self;
+  }
 
-  ddog_Vec_U8 encoded = ddog_ddsketch_encode(state);
+  state->zero_count += other_state->zero_count;
+  state->count += other_state->zero_count;
+  for (int i = 0; i < other_state->length; i++) {
+    if (other_state->bins[i] > 0) add_to_bin(state, other_state->offset + i, other_state->bins[i]);
+  }
+
+  return self;
+}
+
+static VALUE native_quantile(VALUE self, VALUE quantile) {
+  ddsketch_t *state = get_sketch(self);
+
+  double q = NUM2DBL(quantile);
+  if (!(q >= 0 && q <= 1)) raise_error(rb_eArgError, "quantile must be between 0 and 1");
+  if (state->count == 0) return Qnil;
+
+  double rank = q * (state->count - 1);
+  double seen = state->zero_count;
+  if (seen > rank) return DBL2NUM(0.0);
+
+  int last = 0;
+  for (int i = 0; i < state->length; i++) {
+    if (state->bins[i] == 0) continue;
+    last = i;
+    seen += state->bins[i];
+    if (seen > rank) return DBL2NUM(value_of(state->offset + i));
+  }
+
+  // Only reachable through floating point rounding of the counts
+  return DBL2NUM(value_of(state->offset + last));
+}
+
+static VALUE native_count(VALUE self) {
+  return DBL2NUM(get_sketch(self)->count);
+}
+
+// Encoding consumes the libdatadog sketch
+static VALUE encode_and_drop(ddsketch_Handle_DDSketch *sketch) {
+  ddog_Vec_U8 encoded = ddog_ddsketch_encode(sketch);
 
   // Copy into a Ruby string
   VALUE bytes = rb_str_new((const char *) encoded.ptr, encoded.len);
 
   ddog_Vec_U8_drop(encoded);
 
-  // The sketch is consumed by encode; to make this a bit more user-friendly for
-  // a Ruby API (since we can't "kill" the Ruby object), let's re-initialize it so
-  // it can be used again.
-  *state = ddog_ddsketch_new();
+  return bytes;
+}
+
+static VALUE _native_encode(VALUE self, VALUE reset) {
+  ddsketch_t *state = get_sketch(self);
+
+  ddsketch_Handle_DDSketch sketch = ddog_ddsketch_new();
+
+  if (state->zero_count > 0) {
+    ddog_VoidResult result = ddog_ddsketch_add_with_count(&sketch, 0.0, state->zero_count);
+    if (result.tag == DDOG_VOID_RESULT_ERR) {
+      ddog_ddsketch_drop(&sketch);
+      raise_lib_error("DDSketch encode failed", result);
+    }
+  }
+  for (int i = 0; i < state->length; i++) {
+    if (state->bins[i] == 0) continue;
+
+    ddog_VoidResult result = ddog_ddsketch_add_with_count(&sketch, value_of(state->offset + i), state->bins[i]);
+    if (result.tag == DDOG_VOID_RESULT_ERR) {
+      ddog_ddsketch_drop(&sketch);
+      raise_lib_error("DDSketch encode failed", result);
+    }
+  }
+
+  VALUE bytes = encode_and_drop(&sketch);
+
+  if (RTEST(reset)) {
+    ruby_xfree(state->bins);
+    *state = (ddsketch_t) {0};
+  }
 
   return bytes;
 }
+
+// Adds the points to a libdatadog sketch directly, rather than replaying bins like _native_encode does, so that the
+// specs can check that both encode the same sketch.
+static VALUE _native_encode_with_libdatadog(DDTRACE_UNUSED VALUE _self, VALUE points) {
+  ENFORCE_TYPE(points, T_ARRAY);
+
+  // Converted upfront, so that nothing raises while the libdatadog sketch is alive
+  long count = RARRAY_LEN(points);
+  VALUE values_buffer;
+  double *values = ALLOCV_N(double, values_buffer, count);
+  for (long i = 0; i < count; i++) values[i] = NUM2DBL(RARRAY_AREF(points, i));
+
+  ddsketch_Handle_DDSketch sketch = ddog_ddsketch_new();
+
+  for (long i = 0; i < count; i++) {
+    ddog_VoidResult result = ddog_ddsketch_add(&sketch, values[i]);
+    if (result.tag == DDOG_VOID_RESULT_ERR) {
+      ddog_ddsketch_drop(&sketch);
+      raise_lib_error("DDSketch add failed", result);
+    }
+  }
+  ALLOCV_END(values_buffer);
+
+  return encode_and_drop(&sketch);
+}
@@ -1,4 +1,5 @@
 #include <stdbool.h>
+#include <time.h>
 
 #include "datadog_ruby_common.h"
 
@@ -196,12 +197,238 @@ static VALUE iseq_type(DDTRACE_UNUSED VALUE _self, VALUE iseq_val) {
 }
 #endif
 
+#ifdef HAVE_RB_ISEQ_REALPATH
+VALUE rb_iseq_realpath(const void *iseq);
+#else
+static ID id_absolute_path;
+#endif
+
+#ifdef HAVE_RB_ISEQ_TYPE
+VALUE rb_iseq_first_lineno(const void *iseq);
+
+static VALUE sym_top;
+static VALUE sym_main;
+#endif
+
+// Returns whether the iseq is the top-level iseq of code compiled by RubyVM::InstructionSequence.compile_file
+// or .compile, rather than by require/load. CodeTracker#backfill_registry never uses those (a targeted TracePoint
+// bound to one of them never fires for the code that actually runs), so they are not worth wrapping.
+static bool compiled_top_level_iseq_p(DDTRACE_UNUSED const void *iseq) {
+#ifdef HAVE_RB_ISEQ_TYPE
+  VALUE type = rb_iseq_type(iseq);
+  return (type == sym_top || type == sym_main) && rb_iseq_first_lineno(iseq) != INT2FIX(0);
+#else
+  return false;
+#endif
+}
+
+static void add_file_iseq(VALUE iseqs_by_path, VALUE path, VALUE iseq) {
+  VALUE iseqs = rb_hash_lookup2(iseqs_by_path, path, Qnil);
+  if (NIL_P(iseqs)) {
+    iseqs = rb_ary_new();
+    rb_hash_aset(iseqs_by_path, path, iseqs);
+  }
+  rb_ary_push(iseqs, iseq);
+}
+
+#ifdef HAVE_RB_ISEQ_REALPATH
+static int ddtrace_di_file_iseqs_i(void *vstart, void *vend, size_t stride, void *data)
+{
+  VALUE *iseqs_by_path = (VALUE *)data;
+
+  VALUE v = (VALUE)vstart;
+  for (; v != (VALUE)vend; v += stride) {
+    if (!ddtrace_imemo_iseq_p(v)) continue;
+
+    // Eval'd code has no absolute path and cannot be targeted by probes; skip it before allocating a wrapper.
+    VALUE path = rb_iseq_realpath((void *) v);
+    if (NIL_P(path) || compiled_top_level_iseq_p((void *) v)) continue;
+
+    add_file_iseq(*iseqs_by_path, path, rb_iseqw_new((void *) v));
+  }
+
+  return 0;
+}
+#endif
+
+/*
+ * call-seq:
+ *   DI.file_iseqs -> Hash
+ *
+ * Returns the iseqs that correspond to loaded files, grouped by the
+ * absolute path of the file.
+ *
+ * Unlike +all_iseqs+, filtering happens during the object space walk:
+ * eval'd code (which has no absolute path) and the top-level iseqs of
+ * code compiled with RubyVM::InstructionSequence.compile_file/.compile
+ * (on Ruby 3.1+, where the iseq type is available) are skipped without
+ * allocating a RubyVM::InstructionSequence for them.
+ *
+ * The remaining iseqs are of two kinds:
+ *
+ * 1. Whole-file iseqs - +first_lineno+ of 0. Only available for a subset
+ *    of loaded files (the whole-file iseq may be garbage collected after
+ *    loading completes).
+ * 2. Per-method/block/class iseqs - +first_lineno+ > 0. Often the only
+ *    iseqs available for third-party code. Targeting a line requires
+ *    examining their +trace_points+, since +define_method+ can create
+ *    nested, non-contiguous line ranges.
+ *
+ * Files loaded after code tracking starts are added to the CodeTracker
+ * registry by its +script_compiled+ trace point, so this only needs to be
+ * called once, when tracking starts.
+ *
+ * @return [Hash<String, Array<RubyVM::InstructionSequence>>] iseqs by absolute path
+ */
+static VALUE file_iseqs(DDTRACE_UNUSED VALUE _self) {
+  VALUE iseqs_by_path = rb_hash_new();
+
+#ifdef HAVE_RB_ISEQ_REALPATH
+  rb_objspace_each_objects(ddtrace_di_file_iseqs_i, &iseqs_by_path);
+#else
+  // Without rb_iseq_realpath, the paths can only be read from the wrapped iseqs once the walk is over.
+  VALUE iseqs = all_iseqs(_self);
+  for (long i = 0; i < RARRAY_LEN(iseqs); i++) {
+    VALUE iseq = RARRAY_AREF(iseqs, i);
+    VALUE path = rb_funcall(iseq, id_absolute_path, 0);
+    if (NIL_P(path) || compiled_top_level_iseq_p(rb_iseqw_to_iseq(iseq))) continue;
+
+    add_file_iseq(iseqs_by_path, path, iseq);
+  }
+#endif
+
+  return iseqs_by_path;
+}
+
+// Token bucket state of DI::ProbeRateLimiter. Follows Core::TokenBucket: the bucket starts full, holds at most
+// `rate` tokens, and is refilled at `rate` tokens per second. A rate of zero allows nothing, a negative rate
+// allows everything.
+typedef struct {
+  double rate;
+  double tokens;
+  struct timespec last_refill;
+} probe_rate_limiter_t;
+
+static const rb_data_type_t probe_rate_limiter_typed_data = {
+  .wrap_struct_name = "Datadog::DI::ProbeRateLimiter",
+  .function = {
+    .dmark = NULL,
+    .dfree = RUBY_DEFAULT_FREE,
+    .dsize = NULL,
+  },
+  .flags = RUBY_TYPED_FREE_IMMEDIATELY
+};
+
+static VALUE _native_probe_rate_limiter_new(VALUE klass) {
+  probe_rate_limiter_t *state = ruby_xcalloc(1, sizeof(probe_rate_limiter_t));
+  return TypedData_Wrap_Struct(klass, &probe_rate_limiter_typed_data, state);
+}
+
+static probe_rate_limiter_t *get_probe_rate_limiter(VALUE self) {
+  probe_rate_limiter_t *state;
+  TypedData_Get_Struct(self, probe_rate_limiter_t, &probe_rate_limiter_typed_data, state);
+  return state;
+}
+
+/*
+ * call-seq:
+ *   DI::ProbeRateLimiter.new(rate) -> ProbeRateLimiter
+ *
+ * Creates a token bucket allowing +rate+ probe invocations per second.
+ *
+ * @param rate [Numeric] Allowance rate, in invocations per second;
+ *   zero allows nothing and a negative rate allows everything
+ */
+static VALUE probe_rate_limiter_initialize(VALUE self, VALUE rate) {
+  if (!rb_obj_is_kind_of(rate, rb_cNumeric)) {
+    rb_raise(rb_eArgError, "rate must be a number: %"PRIsVALUE, rate);
+  }
+
+  probe_rate_limiter_t *state = get_probe_rate_limiter(self);
+  state->rate = NUM2DBL(rate);
+  state->tokens = state->rate;
+  clock_gettime(CLOCK_MONOTONIC, &state->last_refill);
+  return self;
+}
+
+static void probe_rate_limiter_refill(probe_rate_limiter_t *state) {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  double elapsed = (double) (now.tv_sec - state->last_refill.tv_sec) + (now.tv_nsec - state->last_refill.tv_nsec) / 1e9;
+  state->last_refill = now;
+
+  state->tokens += state->rate * elapsed;
+  if (state->tokens > state->rate) state->tokens = state->rate;
+}
+
+/*
+ * call-seq:
+ *   probe_rate_limiter.allow? -> true | false
+ *
+ * Takes a token from the bucket, if one is available, and returns whether
+ * the probe invocation is allowed.
+ *
+ * Runs under the GVL without calling Ruby code, so method probes firing
+ * on several threads at once consume tokens consistently.
+ */
+static VALUE probe_rate_limiter_allow_p(VALUE self) {
+  probe_rate_limiter_t *state = get_probe_rate_limiter(self);
+  if (state->rate == 0) return Qfalse;
+  if (state->rate < 0) return Qtrue;
+
+  probe_rate_limiter_refill(state);
+  if (state->tokens < 1) return Qfalse;
+
+  state->tokens -= 1;
+  return Qtrue;
+}
+
+/*
+ * call-seq:
+ *   probe_rate_limiter.exhausted? -> true | false
+ *
+ * Returns whether the next +allow?+ call would deny the probe invocation,
+ * without taking a token from the bucket.
+ *
+ * The instrumenter calls this from the method probe wrapper and from the
+ * line probe trace point block, before any other DI processing is done,
+ * so that invocations of a probe over its budget skip the Ruby callbacks
+ * entirely. Invocations that pass this check take their token later,
+ * with +allow?+.
+ */
+static VALUE probe_rate_limiter_exhausted_p(VALUE self) {
+  probe_rate_limiter_t *state = get_probe_rate_limiter(self);
+  if (state->rate == 0) return Qtrue;
+  if (state->rate < 0) return Qfalse;
+
+  probe_rate_limiter_refill(state);
+  return state->tokens < 1 ? Qtrue : Qfalse;
+}
+
+/*
+ * call-seq:
+ *   probe_rate_limiter.available_tokens -> Float
+ *
+ * @return [Float] number of tokens currently in the bucket
+ */
+static VALUE probe_rate_limiter_available_tokens(VALUE self) {
+  return DBL2NUM(get_probe_rate_limiter(self)->tokens);
+}
+
 void di_init(VALUE datadog_module) {
   id_mesg = rb_intern("mesg");
   id_datadog_di_in_probe = rb_intern("datadog_di_in_probe");
+#ifndef HAVE_RB_ISEQ_REALPATH
+  id_absolute_path = rb_intern("absolute_path");
+#endif
+#ifdef HAVE_RB_ISEQ_TYPE
+  sym_top = ID2SYM(rb_intern("top"));
+  sym_main = ID2SYM(rb_intern("main"));
+#endif
 
   VALUE di_module = rb_define_module_under(datadog_module, "DI");
   rb_define_singleton_method(di_module, "all_iseqs", all_iseqs, 0);
+  rb_define_singleton_method(di_module, "file_iseqs", file_iseqs, 0);
   rb_define_singleton_method(di_module, "exception_message", exception_message, 1);
   rb_define_singleton_method(di_module, "in_probe?", in_probe_p, 0);
   rb_define_singleton_method(di_module, "enter_probe", enter_probe, 0);
@@ -210,4 +437,11 @@ void di_init(VALUE datadog_module) {
 #ifdef HAVE_RB_ISEQ_TYPE
   rb_define_singleton_method(di_module, "iseq_type", iseq_type, 1);
 #endif
+
+  VALUE probe_rate_limiter_class = rb_define_class_under(di_module, "ProbeRateLimiter", rb_cObject);
+  rb_define_alloc_func(probe_rate_limiter_class, _native_probe_rate_limiter_new);
+  rb_define_method(probe_rate_limiter_class, "initialize", probe_rate_limiter_initialize, 1);
+  rb_define_method(probe_rate_limiter_class, "allow?", probe_rate_limiter_allow_p, 0);
+  rb_define_method(probe_rate_limiter_class, "exhausted?", probe_rate_limiter_exhausted_p, 0);
+  rb_define_method(probe_rate_limiter_class, "available_tokens", probe_rate_limiter_available_tokens, 0);
 }
@@ -0,0 +1,514 @@
+#include <ruby.h>
+#include <ruby/encoding.h>
+#include <ruby/st.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "datadog_ruby_common.h"
+
+// Indexes used by DI's CodeTracker to find the code targeted by a line probe without scanning every loaded file.
+//
+// DI::PathIndex answers "which known paths end with this probe path suffix?" through a trie over path components,
+// walked from the basename up. A suffix matches (at a path component boundary) exactly the paths below the node the
+// suffix leads to, so a lookup costs as many steps as the suffix has components, regardless of how many files are
+// loaded.
+//
+// DI::LineIndex answers "which of the per-method iseqs of a file have a line probe target on this line?" through a
+// sorted array of (line, iseq) pairs built once from the iseqs' trace points.
+
+static ID id_downcase;
+static ID id_trace_points;
+static VALUE sym_line;
+static VALUE sym_return;
+static VALUE sym_b_return;
+
+// -----------------------------------------------------------------------------
+// DI::PathIndex
+// -----------------------------------------------------------------------------
+
+// A component of a path, used as a key of the children of a trie node.
+// Keys stored in the tables own their bytes (allocated right after the struct); lookups use stack instances.
+typedef struct {
+  const char *ptr;
+  long len;
+} component_t;
+
+// A path ending at a trie node. The path is kept as bytes (rather than as a Ruby string), so the index holds no
+// references to Ruby objects and needs no marking.
+typedef struct path_entry {
+  char *ptr;
+  long len;
+  int encoding_index;
+  struct path_entry *next;
+} path_entry_t;
+
+typedef struct trie_node {
+  st_table *children; // component_t * -> trie_node_t *, created on demand
+  long count; // Number of paths ending at or below this node
+  path_entry_t *paths; // Paths ending at this node
+} trie_node_t;
+
+typedef struct {
+  trie_node_t exact;
+  // Same as `exact`, but keyed by the downcased paths, for case-insensitive lookups. Entries keep the original path.
+  trie_node_t folded;
+  long size;
+} path_index_t;
+
+static int component_compare(st_data_t a, st_data_t b) {
+  const component_t *left = (const component_t *) a;
+  const component_t *right = (const component_t *) b;
+  return !(left->len == right->len && memcmp(left->ptr, right->ptr, left->len) == 0);
+}
+
+static st_index_t component_hash(st_data_t key) {
+  const component_t *component = (const component_t *) key;
+  return st_hash(component->ptr, component->len, 0);
+}
+
+static const struct st_hash_type component_hash_type = {
+  .compare = component_compare,
+  .hash = component_hash,
+};
+
+// Calls `callback` for each component of the path, from the last one to the first. Empty components are kept (e.g.
+// "/a/b" is "b", "a", ""), which makes "suffix matches at a component boundary" the same as "suffix components are
+// the last components of the path".
+#define FOR_EACH_COMPONENT_REVERSED(ptr, len, component, body) do { \
+  long end_ = (len); \
+  while (true) { \
+    long start_ = end_; \
+    while (start_ > 0 && (ptr)[start_ - 1] != '/') start_--; \
+    component_t component = {.ptr = (ptr) + start_, .len = end_ - start_}; \
+    body \
+    if (start_ == 0) break; \
+    end_ = start_ - 1; \
+  } \
+} while (0)
+
+static trie_node_t *child_of(trie_node_t *node, const component_t *component, bool create) {
+  st_data_t child;
+  if (node->children && st_lookup(node->children, (st_data_t) component, &child)) return (trie_node_t *) child;
+  if (!create) return NULL;
+
+  if (!node->children) node->children = st_init_table(&component_hash_type);
+
+  component_t *key = ruby_xmalloc(sizeof(component_t) + component->len);
+  char *bytes = (char *) (key + 1);
+  memcpy(bytes, component->ptr, component->len);
+  key->ptr = bytes;
+  key->len = component->len;
+
+  trie_node_t *new_child = ruby_xcalloc(1, sizeof(trie_node_t));
+  st_insert(node->children, (st_data_t) key, (st_data_t) new_child);
+  return new_child;
+}
+
+// Returns the node at the end of the path, or NULL if `create` is false and there's no such node.
+static trie_node_t *node_for(trie_node_t *root, const char *ptr, long len, bool create) {
+  trie_node_t *node = root;
+  FOR_EACH_COMPONENT_REVERSED(ptr, len, component, {
+    node = child_of(node, &component, create);
+    if (!node) return NULL;
+  });
+  return node;
+}
+
+static void add_count(trie_node_t *root, const char *ptr, long len, long delta) {
+  trie_node_t *node = root;
+  node->count += delta;
+  FOR_EACH_COMPONENT_REVERSED(ptr, len, component, {
+    node = child_of(node, &component, false);
+    node->count += delta;
+  });
+}
+
+static path_entry_t **find_entry(trie_node_t *node, VALUE path) {
+  path_entry_t **entry = &node->paths;
+  for (; *entry; entry = &(*entry)->next) {
+    if ((*entry)->len == RSTRING_LEN(path) && memcmp((*entry)->ptr, RSTRING_PTR(path), (*entry)->len) == 0) break;
+  }
+  return entry;
+}
+
+// Adds `path` under `key` (which is either the path itself, or its downcased version).
+static void trie_add(trie_node_t *root, VALUE key, VALUE path) {
+  trie_node_t *node = node_for(root, RSTRING_PTR(key), RSTRING_LEN(key), true);
+
+  path_entry_t *entry = ruby_xmalloc(sizeof(path_entry_t));
+  entry->len = RSTRING_LEN(path);
+  entry->ptr = ruby_xmalloc(entry->len);
+  memcpy(entry->ptr, RSTRING_PTR(path), entry->len);
+  entry->encoding_index = rb_enc_get_index(path);
+  entry->next = node->paths;
+  node->paths = entry;
+
+  add_count(root, RSTRING_PTR(key), RSTRING_LEN(key), 1);
+}
+
+static bool trie_delete(trie_node_t *root, VALUE key, VALUE path) {
+  trie_node_t *node = node_for(root, RSTRING_PTR(key), RSTRING_LEN(key), false);
+  if (!node) return false;
+
+  path_entry_t **entry = find_entry(node, path);
+  if (!*entry) return false;
+
+  path_entry_t *deleted = *entry;
+  *entry = deleted->next;
+  ruby_xfree(deleted->ptr);
+  ruby_xfree(deleted);
+
+  // Nodes left without paths are kept; they get reused if the path is added again.
+  add_count(root, RSTRING_PTR(key), RSTRING_LEN(key), -1);
+  return true;
+}
+
+static void trie_node_free_children(trie_node_t *node);
+
+static int trie_node_free_child(st_data_t key, st_data_t value, DDTRACE_UNUSED st_data_t _arg) {
+  trie_node_t *child = (trie_node_t *) value;
+  trie_node_free_children(child);
+  ruby_xfree(child);
+  ruby_xfree((void *) key);
+  return ST_CONTINUE;
+}
+
+// Frees everything below the node, and its paths, leaving it empty.
+static void trie_node_free_children(trie_node_t *node) {
+  if (node->children) {
+    st_foreach(node->children, trie_node_free_child, 0);
+    st_free_table(node->children);
+  }
+  for (path_entry_t *entry = node->paths; entry;) {
+    path_entry_t *next = entry->next;
+    ruby_xfree(entry->ptr);
+    ruby_xfree(entry);
+    entry = next;
+  }
+  *node = (trie_node_t) {0};
+}
+
+static VALUE entry_to_path(path_entry_t *entry) {
+  return rb_enc_str_new(entry->ptr, entry->len, rb_enc_from_index(entry->encoding_index));
+}
+
+#define MAX_MATCHES 2
+
+static void collect_paths_below(trie_node_t *node, VALUE matches);
+
+static int collect_paths_from_child(DDTRACE_UNUSED st_data_t _key, st_data_t value, st_data_t matches) {
+  trie_node_t *child = (trie_node_t *) value;
+  if (child->count == 0) return ST_CONTINUE;
+
+  for (path_entry_t *entry = child->paths; entry && RARRAY_LEN((VALUE) matches) < MAX_MATCHES; entry = entry->next) {
+    rb_ary_push((VALUE) matches, entry_to_path(entry));
+  }
+  collect_paths_below(child, (VALUE) matches);
+
+  return RARRAY_LEN((VALUE) matches) < MAX_MATCHES ? ST_CONTINUE : ST_STOP;
+}
+
+// Collects up to MAX_MATCHES of the paths strictly below the node
+static void collect_paths_below(trie_node_t *node, VALUE matches) {
+  if (node->children && RARRAY_LEN(matches) < MAX_MATCHES) st_foreach(node->children, collect_paths_from_child, (st_data_t) matches);
+}
+
+static const rb_data_type_t path_index_typed_data;
+
+static void path_index_free(void *ptr) {
+  path_index_t *state = (path_index_t *) ptr;
+  trie_node_free_children(&state->exact);
+  trie_node_free_children(&state->folded);
+  ruby_xfree(ptr);
+}
+
+static const rb_data_type_t path_index_typed_data = {
+  .wrap_struct_name = "Datadog::DI::PathIndex",
+  .function = {
+    .dmark = NULL, // Paths are stored as bytes, see path_entry_t
+    .dfree = path_index_free,
+    .dsize = NULL,
+  },
+  .flags = RUBY_TYPED_FREE_IMMEDIATELY
+};
+
+static VALUE _native_path_index_new(VALUE klass) {
+  path_index_t *state = ruby_xcalloc(1, sizeof(path_index_t));
+  return TypedData_Wrap_Struct(klass, &path_index_typed_data, state);
+}
+
+static path_index_t *get_path_index(VALUE self) {
+  path_index_t *state;
+  TypedData_Get_Struct(self, path_index_t, &path_index_typed_data, state);
+  return state;
+}
+
+static VALUE downcase(VALUE string) {
+  VALUE downcased = rb_funcall(string, id_downcase, 0);
+  ENFORCE_TYPE(downcased, T_STRING);
+  return downcased;
+}
+
+/*
+ * call-seq:
+ *   add(path) -> self
+ *
+ * Adds a path to the index. Adding a path that is already indexed does nothing.
+ *
+ * @param path [String]
+ */
+static VALUE path_index_add(VALUE self, VALUE path) {
+  path_index_t *state = get_path_index(self);
+  ENFORCE_TYPE(path, T_STRING);
+
+  trie_node_t *node = node_for(&state->exact, RSTRING_PTR(path), RSTRING_LEN(path), false);
+  if (node && *find_entry(node, path)) return self;
+
+  VALUE folded = downcase(path);
+
+  trie_add(&state->exact, path, path);
+  trie_add(&state->folded, folded, path);
+  state->size++;
+
+  return self;
+}
+
+/*
+ * call-seq:
+ *   delete(path) -> true | false
+ *
+ * Removes a path from the index.
+ *
+ * @param path [String]
+ * @return [Boolean] whether the path was indexed
+ */
+static VALUE path_index_delete(VALUE self, VALUE path) {
+  path_index_t *state = get_path_index(self);
+  ENFORCE_TYPE(path, T_STRING);
+
+  VALUE folded = downcase(path);
+  if (!trie_delete(&state->exact, path, path)) return Qfalse;
+
+  trie_delete(&state->folded, folded, path);
+  state->size--;
+
+  return Qtrue;
+}
+
+static VALUE path_index_clear(VALUE self) {
+  path_index_t *state = get_path_index(self);
+
+  trie_node_free_children(&state->exact);
+  trie_node_free_children(&state->folded);
+  state->size = 0;
+
+  return self;
+}
+
+static VALUE path_index_size(VALUE self) {
+  return LONG2NUM(get_path_index(self)->size);
+}
+
+/*
+ * call-seq:
+ *   match(suffix, case_insensitive) -> Array
+ *
+ * Returns the indexed paths matching the suffix, following the same rules as
+ * DI::Utils.path_matches_suffix?: an absolute suffix only matches the same
+ * path, and any other suffix matches the longer paths ending with it at a
+ * path component boundary.
+ *
+ * At most two paths are returned, which is enough to tell whether the match
+ * is ambiguous.
+ *
+ * @param suffix [String] suffix, with forward slashes as separators
+ * @param case_insensitive [Boolean]
+ * @return [Array<String>]
+ */
+static VALUE path_index_match(VALUE self, VALUE suffix, VALUE case_insensitive) {
+  path_index_t *state = get_path_index(self);
+  ENFORCE_TYPE(suffix, T_STRING);
+
+  trie_node_t *root = &state->exact;
+  if (RTEST(case_insensitive)) {
+    suffix = downcase(suffix);
+    root = &state->folded;
+  }
+
+  VALUE matches = rb_ary_new_capa(MAX_MATCHES);
+  trie_node_t *node = node_for(root, RSTRING_PTR(suffix), RSTRING_LEN(suffix), false);
+  if (!node) return matches;
+
+  if (RSTRING_LEN(suffix) > 0 && RSTRING_PTR(suffix)[0] == '/') {
+    for (path_entry_t *entry = node->paths; entry && RARRAY_LEN(matches) < MAX_MATCHES; entry = entry->next) {
+      rb_ary_push(matches, entry_to_path(entry));
+    }
+  } else {
+    collect_paths_below(node, matches);
+  }
+
+  RB_GC_GUARD(suffix);
+  return matches;
+}
+
+// -----------------------------------------------------------------------------
+// DI::LineIndex
+// -----------------------------------------------------------------------------
+
+typedef struct {
+  int line;
+  long iseq; // Index in line_index_t.iseqs
+} line_entry_t;
+
+typedef struct {
+  VALUE iseqs; // Frozen copy of the indexed iseqs
+  line_entry_t *entries; // Sorted by line, then iseq
+  long length;
+} line_index_t;
+
+static void line_index_mark(void *ptr) {
+  line_index_t *state = (line_index_t *) ptr;
+  rb_gc_mark(state->iseqs);
+}
+
+static void line_index_free(void *ptr) {
+  line_index_t *state = (line_index_t *) ptr;
+  ruby_xfree(state->entries);
+  ruby_xfree(ptr);
+}
+
+static size_t line_index_size(const void *ptr) {
+  const line_index_t *state = (const line_index_t *) ptr;
+  return sizeof(line_index_t) + state->length * sizeof(line_entry_t);
+}
+
+static const rb_data_type_t line_index_typed_data = {
+  .wrap_struct_name = "Datadog::DI::LineIndex",
+  .function = {
+    .dmark = line_index_mark,
+    .dfree = line_index_free,
+    .dsize = line_index_size,
+  },
+  .flags = RUBY_TYPED_FREE_IMMEDIATELY
+};
+
+static VALUE _native_line_index_new(VALUE klass) {
+  line_index_t *state = ruby_xcalloc(1, sizeof(line_index_t));
+  state->iseqs = Qnil;
+  return TypedData_Wrap_Struct(klass, &line_index_typed_data, state);
+}
+
+static line_index_t *get_line_index(VALUE self) {
+  line_index_t *state;
+  TypedData_Get_Struct(self, line_index_t, &line_index_typed_data, state);
+  return state;
+}
+
+static int line_entry_compare(const void *a, const void *b) {
+  const line_entry_t *left = (const line_entry_t *) a;
+  const line_entry_t *right = (const line_entry_t *) b;
+  if (left->line != right->line) return left->line < right->line ? -1 : 1;
+  if (left->iseq != right->iseq) return left->iseq < right->iseq ? -1 : 1;
+  return 0;
+}
+
+// Only the events the instrumenter subscribes to for line probes (see Instrumenter#hook_line) can be targeted.
+static bool probe_target_event_p(VALUE event) {
+  return event == sym_line || event == sym_return || event == sym_b_return;
+}
+
+/*
+ * call-seq:
+ *   DI::LineIndex.new(iseqs) -> LineIndex
+ *
+ * Indexes the lines of the given iseqs (of the same file) that a line probe
+ * can target. Each iseq's +trace_points+ are only read once, here.
+ *
+ * @param iseqs [Array<RubyVM::InstructionSequence>]
+ */
+static VALUE line_index_initialize(VALUE self, VALUE iseqs) {
+  line_index_t *state = get_line_index(self);
+  ENFORCE_TYPE(iseqs, T_ARRAY);
+  if (state->entries) rb_raise(rb_eRuntimeError, "LineIndex is already initialized");
+
+  state->iseqs = rb_ary_freeze(rb_ary_dup(iseqs));
+
+  long capacity = 0;
+  for (long i = 0; i < RARRAY_LEN(state->iseqs); i++) {
+    VALUE trace_points = rb_funcall(RARRAY_AREF(state->iseqs, i), id_trace_points, 0);
+    ENFORCE_TYPE(trace_points, T_ARRAY);
+
+    for (long j = 0; j < RARRAY_LEN(trace_points); j++) {
+      VALUE trace_point = RARRAY_AREF(trace_points, j);
+      if (!RB_TYPE_P(trace_point, T_ARRAY) || RARRAY_LEN(trace_point) < 2) continue;
+      if (!probe_target_event_p(RARRAY_AREF(trace_point, 1))) continue;
+
+      if (state->length == capacity) {
+        capacity = capacity == 0 ? 64 : capacity * 2;
+        state->entries = ruby_xrealloc2(state->entries, capacity, sizeof(line_entry_t));
+      }
+      state->entries[state->length++] = (line_entry_t) {.line = NUM2INT(RARRAY_AREF(trace_point, 0)), .iseq = i};
+    }
+  }
+
+  if (state->length > 0) qsort(state->entries, state->length, sizeof(line_entry_t), line_entry_compare);
+
+  return self;
+}
+
+/*
+ * call-seq:
+ *   iseqs_at(line) -> Array
+ *
+ * Returns the indexed iseqs that a line probe on the given line can target.
+ *
+ * @param line [Integer]
+ * @return [Array<RubyVM::InstructionSequence>]
+ */
+static VALUE line_index_iseqs_at(VALUE self, VALUE line_value) {
+  line_index_t *state = get_line_index(self);
+  int line = NUM2INT(line_value);
+
+  // Finds the first entry for the line
+  long low = 0, high = state->length;
+  while (low < high) {
+    long middle = low + (high - low) / 2;
+    if (state->entries[middle].line < line) low = middle + 1; else high = middle;
+  }
+
+  VALUE iseqs = rb_ary_new();
+  long previous_iseq = -1;
+  for (long i = low; i < state->length && state->entries[i].line == line; i++) {
+    // Entries are sorted by iseq within a line, so duplicates are next to each other
+    if (state->entries[i].iseq == previous_iseq) continue;
+
+    previous_iseq = state->entries[i].iseq;
+    rb_ary_push(iseqs, RARRAY_AREF(state->iseqs, previous_iseq));
+  }
+
+  return iseqs;
+}
+
+void di_iseq_index_init(VALUE datadog_module) {
+  id_downcase = rb_intern("downcase");
+  id_trace_points = rb_intern("trace_points");
+  sym_line = ID2SYM(rb_intern("line"));
+  sym_return = ID2SYM(rb_intern("return"));
+  sym_b_return = ID2SYM(rb_intern("b_return"));
+
+  VALUE di_module = rb_define_module_under(datadog_module, "DI");
+
+  VALUE path_index_class = rb_define_class_under(di_module, "PathIndex", rb_cObject);
+  rb_define_alloc_func(path_index_class, _native_path_index_new);
+  rb_define_method(path_index_class, "add", path_index_add, 1);
+  rb_define_method(path_index_class, "delete", path_index_delete, 1);
+  rb_define_method(path_index_class, "clear", path_index_clear, 0);
+  rb_define_method(path_index_class, "size", path_index_size, 0);
+  rb_define_method(path_index_class, "match", path_index_match, 2);
+
+  VALUE line_index_class = rb_define_class_under(di_module, "LineIndex", rb_cObject);
+  rb_define_alloc_func(line_index_class, _native_line_index_new);
+  rb_define_method(line_index_class, "initialize", line_index_initialize, 1);
+  rb_define_method(line_index_class, "iseqs_at", line_index_iseqs_at, 1);
+}
@@ -0,0 +1,627 @@
+#include <ruby.h>
+#include <ruby/encoding.h>
+#include <ruby/st.h>
+#include <stdbool.h>
+#include <string.h>
+#include <strings.h>
+
+#include "datadog_ruby_common.h"
+
+// Native implementation of DI::Serializer#serialize_value.
+//
+// It produces the same structure as the Ruby implementation (see lib/datadog/di/serializer.rb for the format and the
+// rules), but walks the captured values without going through Ruby method dispatch for every node: types are checked
+// directly, instance variables are read with rb_ivar_get, and identifier redaction is done against a native copy of
+// the redacted identifiers.
+//
+// Anything the native implementation does not handle itself is delegated to the Ruby implementation:
+// * values targeted by custom serializers (DI::Serializer.register) are serialized by Ruby, one value at a time;
+// * if serializing raises, the whole value is serialized again by Ruby, which then reports the error and produces
+//   the notSerializedReason entries exactly as it always has.
+
+// Serializing recurses once per level of depth; deeper captures are left to the Ruby implementation,
+// which does not risk overflowing the native stack.
+#define MAX_NATIVE_DEPTH 32
+
+// Identifiers longer than this, or with characters other than the ones below, are checked by DI::Redactor.
+#define MAX_NATIVE_IDENTIFIER_LENGTH 128
+
+// Named classes are cached with their name and whether they are redacted. The cache is cleared when it grows past
+// this many classes, so that it does not keep dynamically created classes alive forever.
+#define MAX_CACHED_CLASSES 4096
+
+// The rb_protect state of a raised exception. Ruby does not export it (see RUBY_TAG_RAISE in vm_core.h). Other
+// states are non-local exits (throw, break, Thread#kill, ...), for which rb_errinfo is not an exception.
+#define PROTECT_STATE_RAISE 0x6
+
+static ID id_call;
+static ID id_compare_by_identity;
+static ID id_condition;
+static ID id_iso8601;
+static ID id_match_p;
+static ID id_name;
+static ID id_redact_identifier_p;
+static ID id_redacted_identifiers;
+static ID id_redacted_type_names_regexp;
+static ID id_serialize_value_in_ruby;
+static ID id_max_capture_string_length;
+static ID id_max_capture_collection_size;
+static ID id_to_a;
+static ID id_Date;
+static ID id_SERIALIZABLE_FATAL_EXCEPTION_CLASSES;
+
+static VALUE sym_type;
+static VALUE sym_value;
+static VALUE sym_is_null;
+static VALUE sym_not_captured_reason;
+static VALUE sym_size;
+static VALUE sym_truncated;
+static VALUE sym_elements;
+static VALUE sym_entries;
+static VALUE sym_fields;
+static VALUE sym_condition;
+
+static VALUE str_unnamed_class;
+static VALUE str_redacted_type;
+static VALUE str_redacted_ident;
+static VALUE str_depth;
+static VALUE str_collection_size;
+static VALUE str_field_count;
+
+typedef struct {
+  const char *ptr;
+  long len;
+} identifier_t;
+
+typedef struct {
+  VALUE serializer; // DI::Serializer, for delegating to the Ruby implementation
+  VALUE redactor;
+  VALUE redacted_type_names_regexp;
+  VALUE classes; // Class => [name, redacted?]
+  st_table *redacted_identifiers; // identifier_t * => 1, normalized identifiers
+} native_serializer_t;
+
+// State of one serialization, i.e. of one call to #serialize
+typedef struct {
+  native_serializer_t *state;
+  VALUE value;
+  VALUE name;
+  long depth;
+  long attribute_count;
+  VALUE custom_serializers;
+  // Like the Ruby implementation, the string length and collection size limits are only read from the settings
+  // when a string or a collection is serialized; nil until then.
+  VALUE length;
+  VALUE collection_size;
+  // Object::Date, if defined; Qundef until looked up
+  VALUE date_class;
+} serialization_t;
+
+static int identifier_compare(st_data_t a, st_data_t b) {
+  const identifier_t *left = (const identifier_t *) a;
+  const identifier_t *right = (const identifier_t *) b;
+  return !(left->len == right->len && memcmp(left->ptr, right->ptr, left->len) == 0);
+}
+
+static st_index_t identifier_hash(st_data_t key) {
+  const identifier_t *identifier = (const identifier_t *) key;
+  return st_hash(identifier->ptr, identifier->len, 0);
+}
+
+static const struct st_hash_type identifier_hash_type = {
+  .compare = identifier_compare,
+  .hash = identifier_hash,
+};
+
+static int free_identifier(st_data_t key, DDTRACE_UNUSED st_data_t _value, DDTRACE_UNUSED st_data_t _arg) {
+  ruby_xfree((void *) key);
+  return ST_CONTINUE;
+}
+
+static void native_serializer_mark(void *ptr) {
+  native_serializer_t *state = (native_serializer_t *) ptr;
+  rb_gc_mark(state->serializer);
+  rb_gc_mark(state->redactor);
+  rb_gc_mark(state->redacted_type_names_regexp);
+  rb_gc_mark(state->classes);
+}
+
+static void native_serializer_free(void *ptr) {
+  native_serializer_t *state = (native_serializer_t *) ptr;
+  if (state->redacted_identifiers) {
+    st_foreach(state->redacted_identifiers, free_identifier, 0);
+    st_free_table(state->redacted_identifiers);
+  }
+  ruby_xfree(ptr);
+}
+
+static const rb_data_type_t native_serializer_typed_data = {
+  .wrap_struct_name = "Datadog::DI::NativeSerializer",
+  .function = {
+    .dmark = native_serializer_mark,
+    .dfree = native_serializer_free,
+    .dsize = NULL,
+  },
+  .flags = RUBY_TYPED_FREE_IMMEDIATELY
+};
+
+static VALUE _native_new(VALUE klass) {
+  native_serializer_t *state = ruby_xcalloc(1, sizeof(native_serializer_t));
+  state->serializer = Qnil;
+  state->redactor = Qnil;
+  state->redacted_type_names_regexp = Qnil;
+  state->classes = Qnil;
+  return TypedData_Wrap_Struct(klass, &native_serializer_typed_data, state);
+}
+
+static native_serializer_t *get_native_serializer(VALUE self) {
+  native_serializer_t *state;
+  TypedData_Get_Struct(self, native_serializer_t, &native_serializer_typed_data, state);
+  if (NIL_P(state->serializer)) rb_raise(rb_eRuntimeError, "NativeSerializer is not initialized");
+  return state;
+}
+
+/*
+ * call-seq:
+ *   DI::NativeSerializer.new(serializer, redactor) -> NativeSerializer
+ *
+ * @param serializer [DI::Serializer] The serializer values that cannot be serialized natively are delegated to
+ * @param redactor [DI::Redactor] The redaction rules; identifiers and type names are read once, here
+ */
+static VALUE native_serializer_initialize(VALUE self, VALUE serializer, VALUE redactor) {
+  native_serializer_t *state;
+  TypedData_Get_Struct(self, native_serializer_t, &native_serializer_typed_data, state);
+  if (!NIL_P(state->serializer)) rb_raise(rb_eRuntimeError, "NativeSerializer is already initialized");
+
+  VALUE identifiers = rb_funcall(rb_funcall(redactor, id_redacted_identifiers, 0), id_to_a, 0);
+  ENFORCE_TYPE(identifiers, T_ARRAY);
+  VALUE regexp = rb_funcall(redactor, id_redacted_type_names_regexp, 0);
+
+  state->redacted_identifiers = st_init_table(&identifier_hash_type);
+  for (long i = 0; i < RARRAY_LEN(identifiers); i++) {
+    VALUE identifier = RARRAY_AREF(identifiers, i);
+    ENFORCE_TYPE(identifier, T_STRING);
+
+    identifier_t *key = ruby_xmalloc(sizeof(identifier_t) + RSTRING_LEN(identifier));
+    char *bytes = (char *) (key + 1);
+    memcpy(bytes, RSTRING_PTR(identifier), RSTRING_LEN(identifier));
+    key->ptr = bytes;
+    key->len = RSTRING_LEN(identifier);
+    if (st_insert(state->redacted_identifiers, (st_data_t) key, 1)) ruby_xfree(key); // Already present
+  }
+
+  state->serializer = serializer;
+  state->redactor = redactor;
+  state->redacted_type_names_regexp = regexp;
+  state->classes = rb_funcall(rb_hash_new(), id_compare_by_identity, 0);
+
+  return self;
+}
+
+static bool identifier_char_p(char c) {
+  return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') ||
+    c == '_' || c == '-' || c == '$' || c == '@';
+}
+
+// Same as DI::Redactor#redact_identifier?. Identifiers made only of ASCII letters, digits and the characters
+// removed by Redactor#normalize (which covers variable names, instance variable names, and most hash keys) are
+// normalized and looked up here; any other identifier is checked by the redactor.
+static bool redact_identifier_p(serialization_t *serialization, VALUE name) {
+  VALUE string = Qnil;
+  if (RB_TYPE_P(name, T_STRING)) string = name;
+  else if (RB_TYPE_P(name, T_SYMBOL)) string = rb_sym2str(name);
+
+  bool native = !NIL_P(string) && RSTRING_LEN(string) <= MAX_NATIVE_IDENTIFIER_LENGTH &&
+    rb_enc_asciicompat(rb_enc_get(string));
+  for (long i = 0; native && i < RSTRING_LEN(string); i++) {
+    native = identifier_char_p(RSTRING_PTR(string)[i]);
+  }
+  if (!native) return RTEST(rb_funcall(serialization->state->redactor, id_redact_identifier_p, 1, name));
+
+  char normalized[MAX_NATIVE_IDENTIFIER_LENGTH];
+  const char *ptr = RSTRING_PTR(string);
+  long len = RSTRING_LEN(string);
+  long normalized_len = 0;
+
+  // The \Ahttp_ prefix of Rack header names is stripped before removing the punctuation
+  if (len >= 5 && strncasecmp(ptr, "http_", 5) == 0) {
+    ptr += 5;
+    len -= 5;
+  }
+  for (long i = 0; i < len; i++) {
+    char c = ptr[i];
+    if (c == '_' || c == '-' || c == '$' || c == '@') continue;
+    normalized[normalized_len++] = (c >= 'A' && c <= 'Z') ? c - 'A' + 'a' : c;
+  }
+
+  identifier_t key = {.ptr = normalized, .len = normalized_len};
+  return st_lookup(serialization->state->redacted_identifiers, (st_data_t) &key, NULL);
+}
+
+// Returns the name to report as the type of instances of the class (see DI::Serializer#class_name), and sets
+// +redacted+ to whether the instances are redacted (see DI::Redactor#redact_type?).
+static VALUE class_info(serialization_t *serialization, VALUE klass, bool *redacted) {
+  native_serializer_t *state = serialization->state;
+
+  VALUE info = rb_hash_lookup2(state->classes, klass, Qnil);
+  if (!NIL_P(info)) {
+    *redacted = RTEST(RARRAY_AREF(info, 1));
+    return RARRAY_AREF(info, 0);
+  }
+
+  VALUE name = rb_funcall(klass, id_name, 0);
+  // Classes can be nameless, they are never redacted. Not cached: they can be named later.
+  if (NIL_P(name)) {
+    *redacted = false;
+    return str_unnamed_class;
+  }
+
+  *redacted = RTEST(rb_funcall(state->redacted_type_names_regexp, id_match_p, 1, name));
+
+  if (RHASH_SIZE(state->classes) >= MAX_CACHED_CLASSES) rb_hash_clear(state->classes);
+  rb_hash_aset(state->classes, klass, rb_ary_freeze(rb_ary_new_from_args(2, name, *redacted ? Qtrue : Qfalse)));
+
+  return name;
+}
+
+// Whether one of the custom serializers (registered with DI::Serializer.register) applies to the value
+static bool custom_serializer_p(serialization_t *serialization, VALUE value) {
+  VALUE custom_serializers = serialization->custom_serializers;
+  for (long i = 0; i < RARRAY_LEN(custom_serializers); i++) {
+    VALUE entry = RARRAY_AREF(custom_serializers, i);
+    VALUE condition = RB_TYPE_P(entry, T_HASH) ? rb_hash_aref(entry, sym_condition) : Qnil;
+    if (RTEST(condition) && RTEST(rb_funcall(condition, id_call, 1, value))) return true;
+  }
+  return false;
+}
+
+static VALUE serialize_in_ruby(serialization_t *serialization, VALUE value, VALUE name, long depth) {
+  VALUE args[] = {
+    value, name, LONG2NUM(depth), LONG2NUM(serialization->attribute_count),
+    serialization->length, serialization->collection_size, Qnil,
+  };
+  return rb_funcallv(serialization->state->serializer, id_serialize_value_in_ruby, 7, args);
+}
+
+// Reads a limit from the settings (through the DI::Serializer private method of the same name)
+static long limit(serialization_t *serialization, VALUE *limit, ID setting) {
+  if (NIL_P(*limit)) *limit = rb_funcall(serialization->state->serializer, setting, 0);
+  long value = NUM2LONG(*limit);
+  // The Ruby implementation gives negative limits a meaning of their own, by way of negative indexes. Raising here
+  // hands the whole value over to it.
+  if (value < 0) rb_raise(rb_eRangeError, "negative capture limit");
+  return value;
+}
+
+static VALUE new_serialized(VALUE type) {
+  VALUE serialized = rb_hash_new();
+  rb_hash_aset(serialized, sym_type, type);
+  return serialized;
+}
+
+// See DI::Serializer#escape_binary_string
+static VALUE escape_binary_string(VALUE string) {
+  const unsigned char *ptr = (const unsigned char *) RSTRING_PTR(string);
+  long len = RSTRING_LEN(string);
+
+  VALUE result = rb_utf8_str_new(NULL, 0);
+  rb_str_resize(result, len * 4 + 3);
+  char *out = RSTRING_PTR(result);
+  long out_len = 0;
+
+  out[out_len++] = 'b';
+  out[out_len++] = '\'';
+  for (long i = 0; i < len; i++) {
+    unsigned char byte = ptr[i];
+    switch (byte) {
+      case '\t': out[out_len++] = '\\'; out[out_len++] = 't'; break;
+      case '\n': out[out_len++] = '\\'; out[out_len++] = 'n'; break;
+      case '\r': out[out_len++] = '\\'; out[out_len++] = 'r'; break;
+      case '\'': out[out_len++] = '\\'; out[out_len++] = '\''; break;
+      case '\\': out[out_len++] = '\\'; out[out_len++] = '\\'; break;
+      default:
+        if (byte >= 0x20 && byte <= 0x7E) {
+          out[out_len++] = byte;
+        } else {
+          static const char hex[] = "0123456789abcdef";
+          out[out_len++] = '\\';
+          out[out_len++] = 'x';
+          out[out_len++] = hex[byte >> 4];
+          out[out_len++] = hex[byte & 0xf];
+        }
+    }
+  }
+  out[out_len++] = '\'';
+
+  rb_str_set_len(result, out_len);
+  return result;
+}
+
+static void serialize_string(serialization_t *serialization, VALUE serialized, VALUE value) {
+  bool need_dup = false;
+  if (RB_TYPE_P(value, T_STRING)) {
+    // Strings are the only mutable values; they are duplicated (unless frozen or truncated) so that the
+    // serialized value does not change if the application modifies the string after it is captured.
+    need_dup = !OBJ_FROZEN(value);
+  } else {
+    value = rb_sym_to_s(value);
+  }
+
+  long max = limit(serialization, &serialization->length, id_max_capture_string_length);
+
+  if (ENCODING_GET(value) == rb_ascii8bit_encindex() || rb_enc_str_coderange(value) == ENC_CODERANGE_BROKEN) {
+    // Truncated before escaping, to not cut an escape sequence
+    long size = RSTRING_LEN(value);
+    if (size > max) {
+      rb_hash_aset(serialized, sym_truncated, Qtrue);
+      rb_hash_aset(serialized, sym_size, LONG2NUM(size));
+      value = rb_str_subseq(value, 0, max);
+    }
+    value = escape_binary_string(value);
+  } else {
+    long length = rb_str_strlen(value);
+    if (length > max) {
+      rb_hash_aset(serialized, sym_truncated, Qtrue);
+      rb_hash_aset(serialized, sym_size, LONG2NUM(length));
+      value = rb_str_substr(value, 0, max);
+    } else if (need_dup) {
+      value = rb_str_dup(value);
+    }
+  }
+
+  rb_hash_aset(serialized, sym_value, value);
+}
+
+static VALUE serialize(serialization_t *serialization, VALUE value, VALUE name, long depth);
+
+static void serialize_array(serialization_t *serialization, VALUE serialized, VALUE value, long depth) {
+  long max = limit(serialization, &serialization->collection_size, id_max_capture_collection_size);
+  long length = RARRAY_LEN(value);
+  if (max != 0 && length > max) {
+    rb_hash_aset(serialized, sym_not_captured_reason, str_collection_size);
+    rb_hash_aset(serialized, sym_size, LONG2NUM(length));
+    length = max;
+  }
+
+  VALUE elements = rb_ary_new_capa(length);
+  // The array may change while its elements are serialized, e.g. by a custom serializer
+  for (long i = 0; i < length && i < RARRAY_LEN(value); i++) {
+    rb_ary_push(elements, serialize(serialization, RARRAY_AREF(value, i), Qnil, depth - 1));
+  }
+  rb_hash_aset(serialized, sym_elements, elements);
+}
+
+typedef struct {
+  serialization_t *serialization;
+  VALUE serialized;
+  VALUE entries;
+  long max;
+  long depth;
+} hash_serialization_t;
+
+static int serialize_hash_entry(VALUE key, VALUE value, VALUE arg) {
+  hash_serialization_t *hash_serialization = (hash_serialization_t *) arg;
+  serialization_t *serialization = hash_serialization->serialization;
+  VALUE entries = hash_serialization->entries;
+
+  if (hash_serialization->max != 0 && RARRAY_LEN(entries) >= hash_serialization->max) {
+    rb_hash_aset(hash_serialization->serialized, sym_not_captured_reason, str_collection_size);
+    return ST_STOP;
+  }
+
+  VALUE entry = rb_ary_new_capa(2);
+  rb_ary_push(entry, serialize(serialization, key, Qnil, hash_serialization->depth - 1));
+  rb_ary_push(entry, serialize(serialization, value, key, hash_serialization->depth - 1));
+  rb_ary_push(entries, entry);
+
+  return ST_CONTINUE;
+}
+
+static void serialize_hash(serialization_t *serialization, VALUE serialized, VALUE value, long depth) {
+  hash_serialization_t hash_serialization = {
+    .serialization = serialization,
+    .serialized = serialized,
+    .entries = rb_ary_new(),
+    .max = limit(serialization, &serialization->collection_size, id_max_capture_collection_size),
+    .depth = depth,
+  };
+
+  rb_hash_foreach(value, serialize_hash_entry, (VALUE) &hash_serialization);
+
+  if (rb_hash_lookup2(serialized, sym_not_captured_reason, Qnil) != Qnil) {
+    rb_hash_aset(serialized, sym_size, LONG2NUM(RHASH_SIZE(value)));
+  }
+  rb_hash_aset(serialized, sym_entries, hash_serialization.entries);
+}
+
+static void serialize_object(serialization_t *serialization, VALUE serialized, VALUE value, long depth) {
+  // Same order as #instance_variables (which is definition order on MRI)
+  VALUE ivars = rb_obj_instance_variables(value);
+  VALUE fields = rb_hash_new();
+
+  for (long i = 0; i < RARRAY_LEN(ivars); i++) {
+    if (i >= serialization->attribute_count) {
+      rb_hash_aset(serialized, sym_not_captured_reason, str_field_count);
+      break;
+    }
+    VALUE ivar = RARRAY_AREF(ivars, i);
+    rb_hash_aset(fields, ivar, serialize(serialization, rb_ivar_get(value, SYM2ID(ivar)), ivar, depth - 1));
+  }
+
+  rb_hash_aset(serialized, sym_fields, fields);
+}
+
+static VALUE date_class(serialization_t *serialization) {
+  if (serialization->date_class == Qundef) {
+    serialization->date_class = rb_const_defined(rb_cObject, id_Date) ? rb_const_get(rb_cObject, id_Date) : Qnil;
+  }
+  return serialization->date_class;
+}
+
+static VALUE serialize(serialization_t *serialization, VALUE value, VALUE name, long depth) {
+  // BasicObject instances do not respond to #class, which the Ruby implementation relies on
+  if (!rb_obj_is_kind_of(value, rb_mKernel)) return serialize_in_ruby(serialization, value, name, depth);
+
+  bool redacted;
+  VALUE type = class_info(serialization, rb_obj_class(value), &redacted);
+
+  if (redacted) {
+    VALUE serialized = new_serialized(type);
+    rb_hash_aset(serialized, sym_not_captured_reason, str_redacted_type);
+    return serialized;
+  }
+
+  if (RTEST(name) && redact_identifier_p(serialization, name)) {
+    VALUE serialized = new_serialized(type);
+    rb_hash_aset(serialized, sym_not_captured_reason, str_redacted_ident);
+    return serialized;
+  }
+
+  if (custom_serializer_p(serialization, value)) return serialize_in_ruby(serialization, value, name, depth);
+
+  VALUE serialized = new_serialized(type);
+
+  if (NIL_P(value)) {
+    rb_hash_aset(serialized, sym_is_null, Qtrue);
+  } else if (RB_INTEGER_TYPE_P(value) || RB_FLOAT_TYPE_P(value) || value == Qtrue || value == Qfalse) {
+    rb_hash_aset(serialized, sym_value, rb_obj_as_string(value));
+  } else if (RB_TYPE_P(value, T_STRING) || RB_TYPE_P(value, T_SYMBOL)) {
+    serialize_string(serialization, serialized, value);
+  } else if (RB_TYPE_P(value, T_ARRAY) || RB_TYPE_P(value, T_HASH)) {
+    if (depth <= 0) {
+      rb_hash_aset(serialized, sym_not_captured_reason, str_depth);
+    } else if (RB_TYPE_P(value, T_ARRAY)) {
+      serialize_array(serialization, serialized, value, depth);
+    } else {
+      serialize_hash(serialization, serialized, value, depth);
+    }
+  } else if (rb_obj_is_kind_of(value, rb_cTime)) {
+    rb_hash_aset(serialized, sym_value, rb_funcall(value, id_iso8601, 0));
+  } else if (!NIL_P(date_class(serialization)) && rb_obj_is_kind_of(value, date_class(serialization))) {
+    rb_hash_aset(serialized, sym_value, rb_obj_as_string(value));
+  } else if (depth <= 0) {
+    rb_hash_aset(serialized, sym_not_captured_reason, str_depth);
+  } else {
+    serialize_object(serialization, serialized, value, depth);
+  }
+
+  return serialized;
+}
+
+static VALUE serialize_protected(VALUE arg) {
+  serialization_t *serialization = (serialization_t *) arg;
+  return serialize(serialization, serialization->value, serialization->name, serialization->depth);
+}
+
+/*
+ * call-seq:
+ *   serialize(value, name, depth, attribute_count, length, collection_size, custom_serializers) -> Hash
+ *
+ * Serializes the value like DI::Serializer#serialize_value does.
+ *
+ * @param value [Object] The value to serialize
+ * @param name [String, Symbol, nil] The name of the value, for redaction
+ * @param depth [Integer] Remaining traversal depth
+ * @param attribute_count [Integer] Maximum number of captured instance variables, per object
+ * @param length [Integer, nil] Maximum captured string length; read from the settings if nil
+ * @param collection_size [Integer, nil] Maximum captured collection size; read from the settings if nil
+ * @param custom_serializers [Array<Hash>] The custom serializers registered with DI::Serializer.register
+ * @return [Hash]
+ */
+static bool is_serializable_fatal_exception(native_serializer_t *state, VALUE exception) {
+  VALUE fatal_classes = rb_const_get(rb_obj_class(state->serializer), id_SERIALIZABLE_FATAL_EXCEPTION_CLASSES);
+  for (long i = 0; i < RARRAY_LEN(fatal_classes); i++) {
+    if (RTEST(rb_obj_is_kind_of(exception, rb_ary_entry(fatal_classes, i)))) return true;
+  }
+  return false;
+}
+
+static VALUE native_serializer_serialize(
+  VALUE self,
+  VALUE value,
+  VALUE name,
+  VALUE depth,
+  VALUE attribute_count,
+  VALUE length,
+  VALUE collection_size,
+  VALUE custom_serializers
+) {
+  ENFORCE_TYPE(custom_serializers, T_ARRAY);
+
+  serialization_t serialization = {
+    .state = get_native_serializer(self),
+    .value = value,
+    .name = name,
+    .depth = NUM2LONG(depth),
+    .attribute_count = NUM2LONG(attribute_count),
+    .custom_serializers = custom_serializers,
+    .length = length,
+    .collection_size = collection_size,
+    .date_class = Qundef,
+  };
+
+  if (serialization.depth > MAX_NATIVE_DEPTH || serialization.attribute_count < 0) {
+    return serialize_in_ruby(&serialization, value, name, serialization.depth);
+  }
+
+  int exception_state = 0;
+  VALUE serialized = rb_protect(serialize_protected, (VALUE) &serialization, &exception_state);
+  if (!exception_state) return serialized;
+
+  // Only exceptions the Ruby implementation would rescue fall back to it; non-local exits and fatal exceptions
+  // (see DI::Serializer::SERIALIZABLE_FATAL_EXCEPTION_CLASSES) keep going.
+  if (exception_state != PROTECT_STATE_RAISE || is_serializable_fatal_exception(serialization.state, rb_errinfo())) {
+    rb_jump_tag(exception_state);
+  }
+  rb_set_errinfo(Qnil);
+
+  return serialize_in_ruby(&serialization, value, name, serialization.depth);
+}
+
+static VALUE frozen_string(const char *string) {
+  VALUE result = rb_str_freeze(rb_utf8_str_new_cstr(string));
+  rb_gc_register_mark_object(result);
+  return result;
+}
+
+void di_serializer_init(VALUE datadog_module) {
+  id_call = rb_intern("call");
+  id_compare_by_identity = rb_intern("compare_by_identity");
+  id_condition = rb_intern("condition");
+  id_iso8601 = rb_intern("iso8601");
+  id_match_p = rb_intern("match?");
+  id_name = rb_intern("name");
+  id_redact_identifier_p = rb_intern("redact_identifier?");
+  id_redacted_identifiers = rb_intern("redacted_identifiers");
+  id_redacted_type_names_regexp = rb_intern("redacted_type_names_regexp");
+  id_serialize_value_in_ruby = rb_intern("serialize_value_in_ruby");
+  id_max_capture_string_length = rb_intern("max_capture_string_length");
+  id_max_capture_collection_size = rb_intern("max_capture_collection_size");
+  id_to_a = rb_intern("to_a");
+  id_Date = rb_intern("Date");
+  id_SERIALIZABLE_FATAL_EXCEPTION_CLASSES = rb_intern("SERIALIZABLE_FATAL_EXCEPTION_CLASSES");
+
+  sym_type = ID2SYM(rb_intern("type"));
+  sym_value = ID2SYM(rb_intern("value"));
+  sym_is_null = ID2SYM(rb_intern("isNull"));
+  sym_not_captured_reason = ID2SYM(rb_intern("notCapturedReason"));
+  sym_size = ID2SYM(rb_intern("size"));
+  sym_truncated = ID2SYM(rb_intern("truncated"));
+  sym_elements = ID2SYM(rb_intern("elements"));
+  sym_entries = ID2SYM(rb_intern("entries"));
+  sym_fields = ID2SYM(rb_intern("fields"));
+  sym_condition = ID2SYM(id_condition);
+
+  str_unnamed_class = frozen_string("[Unnamed class]");
+  str_redacted_type = frozen_string("redactedType");
+  str_redacted_ident = frozen_string("redactedIdent");
+  str_depth = frozen_string("depth");
+  str_collection_size = frozen_string("collectionSize");
+  str_field_count = frozen_string("fieldCount");
+
+  VALUE di_module = rb_define_module_under(datadog_module, "DI");
+  VALUE native_serializer_class = rb_define_class_under(di_module, "NativeSerializer", rb_cObject);
+  rb_define_alloc_func(native_serializer_class, _native_new);
+  rb_define_method(native_serializer_class, "initialize", native_serializer_initialize, 2);
+  rb_define_method(native_serializer_class, "serialize", native_serializer_serialize, 7);
+}
@@ -97,6 +97,8 @@ Datadog::LibdatadogExtconfHelpers.add_libdatadog_version_define
 EXTENSION_NAME = "libdatadog_api.#{RUBY_VERSION[/\d+.\d+/]}_#{RUBY_PLATFORM}".freeze
 
 have_func("rb_iseq_type")
+have_func("rb_iseq_realpath")
+have_func("rb_enc_interned_str", "ruby/encoding.h")
 
 create_makefile(EXTENSION_NAME)
 
@@ -1,6 +1,7 @@
 #include "feature_flags.h"
 
 #include <stdio.h>
+#include <ruby/encoding.h>
 #include <datadog/ffe.h>
 #include <datadog/common.h>
 
@@ -9,14 +10,36 @@
 #include <stdint.h>
 #include <string.h>
 #include <stdlib.h>
+#include <time.h>
 
 // Forward declarations
 static VALUE configuration_new(VALUE klass, VALUE json_str);
+static void configuration_mark(void *ptr);
 static void configuration_free(void *ptr);
+static size_t configuration_size(const void *ptr);
 static VALUE configuration_get_assignment(
   VALUE self, VALUE flag_key, VALUE expected_type, VALUE context);
+static VALUE configuration_get_assignments(
+  VALUE self, VALUE flag_keys, VALUE expected_type, VALUE context);
 
+static VALUE evaluation_context_new(VALUE klass, VALUE context_hash);
+static void evaluation_context_mark(void *ptr);
+static void evaluation_context_free(void *ptr);
+
+static void resolution_details_mark(void *ptr);
 static void resolution_details_free(void *ptr);
+static size_t resolution_details_size(const void *ptr);
+
+static VALUE exposure_buffer_new(VALUE klass, VALUE limit, VALUE deduplication_limit);
+static void exposure_buffer_mark(void *ptr);
+static void exposure_buffer_free(void *ptr);
+static size_t exposure_buffer_size(const void *ptr);
+static VALUE exposure_buffer_push(
+  VALUE self, VALUE flag_key, VALUE allocation_key, VALUE variant, VALUE targeting_key, VALUE attributes);
+static VALUE exposure_buffer_pop(VALUE self);
+static VALUE exposure_buffer_is_empty(VALUE self);
+static VALUE exposure_buffer_length(VALUE self);
+static VALUE exposure_buffer_close(VALUE self);
 static VALUE resolution_details_get_raw_value(VALUE self);
 static VALUE resolution_details_get_flag_type(VALUE self);
 static VALUE resolution_details_get_variant(VALUE self);
@@ -31,23 +54,142 @@ static VALUE resolution_details_get_flag_metadata(VALUE self);
 static const rb_data_type_t configuration_data_type = {
   .wrap_struct_name = "Datadog::Core::FeatureFlags::Configuration",
   .function = {
-    .dmark = NULL,
+    .dmark = configuration_mark,
     .dfree = configuration_free,
+    .dsize = configuration_size,
+  },
+  .flags = RUBY_TYPED_FREE_IMMEDIATELY,
+};
+
+static const rb_data_type_t evaluation_context_typed_data = {
+  .wrap_struct_name = "Datadog::Core::FeatureFlags::EvaluationContext",
+  .function = {
+    .dmark = evaluation_context_mark,
+    .dfree = evaluation_context_free,
     .dsize = NULL,
   },
   .flags = RUBY_TYPED_FREE_IMMEDIATELY,
 };
 
+static const rb_data_type_t exposure_buffer_typed_data = {
+  .wrap_struct_name = "Datadog::Core::FeatureFlags::ExposureBuffer",
+  .function = {
+    .dmark = exposure_buffer_mark,
+    .dfree = exposure_buffer_free,
+    .dsize = exposure_buffer_size,
+  },
+  .flags = RUBY_TYPED_FREE_IMMEDIATELY,
+};
+
 static const rb_data_type_t resolution_details_typed_data = {
   .wrap_struct_name = "Datadog::Core::FeatureFlags::ResolutionDetails",
   .function = {
-    .dmark = NULL,
+    .dmark = resolution_details_mark,
     .dfree = resolution_details_free,
-    .dsize = NULL,
+    .dsize = resolution_details_size,
   },
   .flags = RUBY_TYPED_FREE_IMMEDIATELY,
 };
 
+// The result of an evaluation. All of its fields are converted to Ruby at
+// once, after which the native handle is dropped; accesses return the same
+// objects without crossing the FFI again. Results served from the
+// evaluation cache copy the converted fields of the cached one, and get
+// their own copy of its raw_value.
+typedef struct {
+  // NULL once converted
+  ddog_ffe_Handle_ResolutionDetails handle;
+  bool converted;
+  bool do_log;
+  VALUE raw_value;
+  VALUE flag_type;
+  VALUE variant;
+  VALUE allocation_key;
+  VALUE serial_id;
+  VALUE reason;
+  VALUE error_code;
+  VALUE error_message;
+} resolution_details_t;
+
+// Evaluation results are cached per Configuration, so a new Configuration
+// (i.e. a remote configuration update) always starts with an empty cache.
+//
+// The cache is direct-mapped: each (flag key, expected type, context hash)
+// maps to one slot, and a new evaluation for a slot replaces its entry. The
+// hash only picks the slot: a hit also compares the context attributes.
+//
+// Allocations can be limited to a time window (their startAt and endAt), so
+// an evaluation also depends on the time. Each entry expires at the first of
+// these boundaries after it was evaluated (see time_boundaries_from_json).
+#define EVALUATION_CACHE_SIZE 1024
+
+typedef struct {
+  bool used;
+  uint64_t context_hash;
+  ddog_ffe_ExpectedFlagType expected_ty;
+  // Frozen copy of the flag key
+  VALUE flag_key;
+  // See context_attributes_from_hash
+  VALUE context_attributes;
+  // In milliseconds since the epoch, INT64_MAX if it never expires
+  int64_t expires_at_ms;
+  // Converted result (its handle is always NULL, its raw_value is frozen)
+  resolution_details_t details;
+} evaluation_cache_entry_t;
+
+typedef struct {
+  ddog_ffe_Handle_Configuration handle;
+  // NULL if results are not cached, see time_boundaries_from_json
+  evaluation_cache_entry_t *cache;
+  // Sorted startAt and endAt of the allocations, in milliseconds since the epoch
+  int64_t *time_boundaries;
+  long time_boundaries_count;
+} configuration_t;
+
+typedef struct {
+  ddog_ffe_Handle_EvaluationContext handle;
+  // See context_hash_from_hash
+  uint64_t hash;
+  // See context_attributes_from_hash
+  VALUE attributes;
+} evaluation_context_t;
+
+// An exposure recorded by ExposureBuffer#push, until the exposures worker
+// drains it and turns it into an event
+typedef struct {
+  int64_t timestamp_ms;
+  VALUE flag_key;
+  VALUE allocation_key;
+  VALUE variant;
+  VALUE targeting_key;
+  VALUE attributes;
+} exposure_t;
+
+// The last exposure recorded for a (flag key, targeting key)
+typedef struct {
+  // 0 when the slot is empty
+  uint64_t key_hash;
+  VALUE flag_key;
+  VALUE targeting_key;
+  VALUE allocation_key;
+  VALUE variant;
+} exposure_seen_t;
+
+typedef struct {
+  // Fixed-size ring; when full, new exposures replace the oldest ones
+  exposure_t *ring;
+  size_t capacity;
+  size_t start;
+  size_t length;
+  size_t dropped;
+  // Direct-mapped, like the evaluation cache
+  exposure_seen_t *seen;
+  size_t seen_capacity;
+  bool closed;
+} exposure_buffer_t;
+
+static resolution_details_t *converted_resolution_details(VALUE self);
+
 // Cached values to use in function later in the code.
 static VALUE feature_flags_error_class = Qnil;
 static VALUE resolution_details_class = Qnil;
@@ -59,6 +201,28 @@ static ID id_any;
 static ID id_integer;
 static ID id_float;
 
+// Frozen strings for every reason and error code, so that evaluations do not
+// allocate them. Marked with rb_gc_register_mark_object.
+static VALUE reason_static;
+static VALUE reason_default;
+static VALUE reason_targeting_match;
+static VALUE reason_split;
+static VALUE reason_disabled;
+static VALUE reason_error;
+static VALUE reason_unknown;
+static VALUE error_code_type_mismatch;
+static VALUE error_code_parse_error;
+static VALUE error_code_flag_not_found;
+static VALUE error_code_targeting_key_missing;
+static VALUE error_code_invalid_context;
+static VALUE error_code_provider_not_ready;
+static VALUE error_code_general;
+
+// Flag metadata is not read from libdatadog yet (see
+// resolution_details_get_flag_metadata), so all results share this frozen
+// empty hash.
+static VALUE empty_flag_metadata;
+
 // SAFETY: The returned borrowed string points directly to Ruby's
 // internal string buffer.
 //
@@ -84,6 +248,27 @@ static inline VALUE str_from_borrow(ddog_ffe_BorrowedStr str) {
   return rb_str_new((const char *)str.ptr, str.len);
 }
 
+// Same as str_from_borrow, but returns a frozen, deduplicated string.
+// Variants and allocation keys repeat across evaluations, so after the
+// first one this does not allocate (on Ruby 3.0+).
+static inline VALUE interned_str_from_borrow(ddog_ffe_BorrowedStr str) {
+  if (str.ptr == NULL) {
+    return Qnil;
+  }
+
+#ifdef HAVE_RB_ENC_INTERNED_STR
+  return rb_enc_interned_str((const char *)str.ptr, str.len, rb_utf8_encoding());
+#else
+  return rb_funcall(rb_utf8_str_new((const char *)str.ptr, str.len), rb_intern("-@"), 0);
+#endif
+}
+
+static VALUE static_frozen_str(const char *str) {
+  VALUE result = rb_obj_freeze(rb_utf8_str_new_cstr(str));
+  rb_gc_register_mark_object(result);
+  return result;
+}
+
 void feature_flags_init(VALUE core_module) {
   VALUE feature_flags_module = rb_define_module_under(core_module, "FeatureFlags");
 
@@ -94,6 +279,11 @@ void feature_flags_init(VALUE core_module) {
   rb_undef_alloc_func(configuration_class);
   rb_define_singleton_method(configuration_class, "new", configuration_new, 1);
   rb_define_method(configuration_class, "get_assignment", configuration_get_assignment, 3);
+  rb_define_method(configuration_class, "get_assignments", configuration_get_assignments, 3);
+
+  VALUE evaluation_context_class = rb_define_class_under(feature_flags_module, "EvaluationContext", rb_cObject);
+  rb_undef_alloc_func(evaluation_context_class);
+  rb_define_singleton_method(evaluation_context_class, "new", evaluation_context_new, 1);
 
   rb_gc_register_address(&resolution_details_class);
   resolution_details_class = rb_define_class_under(feature_flags_module, "ResolutionDetails", rb_cObject);
@@ -109,6 +299,15 @@ void feature_flags_init(VALUE core_module) {
   rb_define_method(resolution_details_class, "log?", resolution_details_get_do_log, 0);
   rb_define_method(resolution_details_class, "flag_metadata", resolution_details_get_flag_metadata, 0);
 
+  VALUE exposure_buffer_class = rb_define_class_under(feature_flags_module, "ExposureBuffer", rb_cObject);
+  rb_undef_alloc_func(exposure_buffer_class);
+  rb_define_singleton_method(exposure_buffer_class, "new", exposure_buffer_new, 2);
+  rb_define_method(exposure_buffer_class, "push", exposure_buffer_push, 5);
+  rb_define_method(exposure_buffer_class, "pop", exposure_buffer_pop, 0);
+  rb_define_method(exposure_buffer_class, "empty?", exposure_buffer_is_empty, 0);
+  rb_define_method(exposure_buffer_class, "length", exposure_buffer_length, 0);
+  rb_define_method(exposure_buffer_class, "close", exposure_buffer_close, 0);
+
   // Cache symbol IDs for expected types
   id_boolean = rb_intern_const("boolean");
   id_string = rb_intern_const("string");
@@ -117,6 +316,182 @@ void feature_flags_init(VALUE core_module) {
   id_any = rb_intern_const("any");
   id_integer = rb_intern_const("integer");
   id_float = rb_intern_const("float");
+
+  reason_static = static_frozen_str("STATIC");
+  reason_default = static_frozen_str("DEFAULT");
+  reason_targeting_match = static_frozen_str("TARGETING_MATCH");
+  reason_split = static_frozen_str("SPLIT");
+  reason_disabled = static_frozen_str("DISABLED");
+  reason_error = static_frozen_str("ERROR");
+  reason_unknown = static_frozen_str("UNKNOWN");
+  error_code_type_mismatch = static_frozen_str("TYPE_MISMATCH");
+  error_code_parse_error = static_frozen_str("PARSE_ERROR");
+  error_code_flag_not_found = static_frozen_str("FLAG_NOT_FOUND");
+  error_code_targeting_key_missing = static_frozen_str("TARGETING_KEY_MISSING");
+  error_code_invalid_context = static_frozen_str("INVALID_CONTEXT");
+  error_code_provider_not_ready = static_frozen_str("PROVIDER_NOT_READY");
+  error_code_general = static_frozen_str("GENERAL");
+
+  empty_flag_metadata = rb_obj_freeze(rb_hash_new());
+  rb_gc_register_mark_object(empty_flag_metadata);
+}
+
+static inline int64_t current_timestamp_ms(void) {
+  struct timespec now;
+  clock_gettime(CLOCK_REALTIME, &now);
+  return (int64_t)now.tv_sec * 1000 + now.tv_nsec / 1000000;
+}
+
+// Days since 1970-01-01 of a proleptic Gregorian date
+static int64_t days_from_civil(int64_t year, int month, int day) {
+  year -= month <= 2;
+  int64_t era = (year >= 0 ? year : year - 399) / 400;
+  int64_t year_of_era = year - era * 400;
+  int64_t day_of_year = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+  int64_t day_of_era = year_of_era * 365 + year_of_era / 4 - year_of_era / 100 + day_of_year;
+  return era * 146097 + day_of_era - 719468;
+}
+
+// Parses an RFC 3339 timestamp, such as "2024-04-17T19:40:53.716Z", into
+// milliseconds since the epoch. Sub-millisecond digits are truncated.
+static bool parse_timestamp_ms(const char *str, size_t len, int64_t *result) {
+  char buffer[64];
+  if (len >= sizeof(buffer)) {
+    return false;
+  }
+  memcpy(buffer, str, len);
+  buffer[len] = '\0';
+
+  int year, month, day, hour, minute, second, consumed = 0;
+  if (sscanf(buffer, "%4d-%2d-%2d%*1[Tt ]%2d:%2d:%2d%n", &year, &month, &day, &hour, &minute, &second, &consumed) != 6 ||
+      consumed == 0 || month < 1 || month > 12 || day < 1 || day > 31 || hour > 23 || minute > 59 || second > 60) {
+    return false;
+  }
+  const char *p = buffer + consumed;
+
+  int64_t milliseconds = 0;
+  if (*p == '.') {
+    p++;
+    int digits = 0;
+    for (; *p >= '0' && *p <= '9'; p++, digits++) {
+      if (digits < 3) {
+        milliseconds = milliseconds * 10 + (*p - '0');
+      }
+    }
+    if (digits == 0) {
+      return false;
+    }
+    for (; digits < 3; digits++) {
+      milliseconds *= 10;
+    }
+  }
+
+  int64_t offset_minutes = 0;
+  if (*p == 'Z' || *p == 'z') {
+    p++;
+  } else if (*p == '+' || *p == '-') {
+    int offset_hour, offset_minute, offset_consumed = 0;
+    if (sscanf(p + 1, "%2d:%2d%n", &offset_hour, &offset_minute, &offset_consumed) != 2 || offset_consumed != 5) {
+      return false;
+    }
+    offset_minutes = (*p == '-' ? -1 : 1) * (offset_hour * 60 + offset_minute);
+    p += 1 + offset_consumed;
+  } else {
+    return false;
+  }
+  if (*p != '\0') {
+    return false;
+  }
+
+  int64_t seconds = days_from_civil(year, month, day) * 86400 + hour * 3600 + minute * 60 + second - offset_minutes * 60;
+  *result = seconds * 1000 + milliseconds;
+  return true;
+}
+
+static int compare_int64(const void *a, const void *b) {
+  int64_t x = *(const int64_t *)a, y = *(const int64_t *)b;
+  return (x > y) - (x < y);
+}
+
+static inline const char *skip_json_whitespace(const char *p, const char *end) {
+  while (p < end && (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r')) {
+    p++;
+  }
+  return p;
+}
+
+// Collects the startAt and endAt of every allocation of a UFC configuration
+// into config->time_boundaries, sorted. libdatadog does not expose them, so
+// the JSON is scanned for these keys rather than parsed: a key of the same
+// name elsewhere (e.g. in a JSON variation value) at worst adds a boundary,
+// which only makes results expire sooner.
+//
+// Returns false if one of them is not a timestamp parse_timestamp_ms
+// understands, in which case results cannot be cached safely.
+static bool time_boundaries_from_json(configuration_t *config, VALUE json_str) {
+  const char *json = RSTRING_PTR(json_str);
+  const char *end = json + RSTRING_LEN(json_str);
+  long capacity = 0;
+
+  for (const char *p = json; p < end; p++) {
+    if (*p != '"') {
+      continue;
+    }
+    const char *key = p + 1;
+    size_t key_len;
+    if ((size_t)(end - key) > strlen("startAt\"") && memcmp(key, "startAt\"", strlen("startAt\"")) == 0) {
+      key_len = strlen("startAt");
+    } else if ((size_t)(end - key) > strlen("endAt\"") && memcmp(key, "endAt\"", strlen("endAt\"")) == 0) {
+      key_len = strlen("endAt");
+    } else {
+      continue;
+    }
+
+    const char *value = skip_json_whitespace(key + key_len + 1, end);
+    if (value == end || *value != ':') {
+      // Not a key, but a string value
+      continue;
+    }
+    value = skip_json_whitespace(value + 1, end);
+    if ((size_t)(end - value) >= strlen("null") && memcmp(value, "null", strlen("null")) == 0) {
+      p = value;
+      continue;
+    }
+    if (value == end || *value != '"') {
+      return false;
+    }
+    const char *value_end = memchr(value + 1, '"', end - (value + 1));
+    int64_t boundary;
+    if (value_end == NULL || !parse_timestamp_ms(value + 1, value_end - (value + 1), &boundary)) {
+      return false;
+    }
+
+    if (config->time_boundaries_count == capacity) {
+      capacity = capacity == 0 ? 8 : capacity * 2;
+      REALLOC_N(config->time_boundaries, int64_t, capacity);
+    }
+    config->time_boundaries[config->time_boundaries_count++] = boundary;
+    p = value_end;
+  }
+
+  if (config->time_boundaries_count > 0) {
+    qsort(config->time_boundaries, config->time_boundaries_count, sizeof(int64_t), compare_int64);
+  }
+  return true;
+}
+
+// The first time boundary after now_ms, or INT64_MAX if there is none
+static int64_t next_time_boundary(configuration_t *config, int64_t now_ms) {
+  long low = 0, high = config->time_boundaries_count;
+  while (low < high) {
+    long middle = low + (high - low) / 2;
+    if (config->time_boundaries[middle] <= now_ms) {
+      low = middle + 1;
+    } else {
+      high = middle;
+    }
+  }
+  return low < config->time_boundaries_count ? config->time_boundaries[low] : INT64_MAX;
 }
 
 /*
@@ -125,21 +500,67 @@ void feature_flags_init(VALUE core_module) {
  *
  * Creates a new Configuration from a JSON string.
  *
+ * Evaluation results are cached, unless an allocation has a startAt or endAt
+ * that cannot be parsed (see time_boundaries_from_json).
+ *
  * @param json_str [String] The JSON configuration string
  * @return [Configuration] The configuration instance
  * @raise [Datadog::Core::FeatureFlags::Error] If the JSON is invalid
  */
 static VALUE configuration_new(VALUE klass, VALUE json_str) {
+  ENFORCE_TYPE(json_str, T_STRING);
+
+  // Allocate first, so that the configuration cannot leak if allocating raises.
+  configuration_t *config;
+  VALUE wrapped = TypedData_Make_Struct(klass, configuration_t, &configuration_data_type, config);
+
   struct ddog_ffe_Result_HandleConfiguration result = ddog_ffe_configuration_new(borrow_str(json_str));
   if (result.tag == DDOG_FFE_RESULT_HANDLE_CONFIGURATION_ERR_HANDLE_CONFIGURATION) {
     raise_error(feature_flags_error_class, "Failed to create configuration from JSON: %"PRIsVALUE, get_error_details_and_drop(&result.err));
   }
-  return TypedData_Wrap_Struct(klass, &configuration_data_type, result.ok);
+  config->handle = result.ok;
+
+  if (time_boundaries_from_json(config, json_str)) {
+    config->cache = ruby_xcalloc(EVALUATION_CACHE_SIZE, sizeof(evaluation_cache_entry_t));
+  }
+  RB_GC_GUARD(json_str);
+  return wrapped;
+}
+
+static void configuration_mark(void *ptr) {
+  configuration_t *config = (configuration_t *)ptr;
+  if (config->cache == NULL) {
+    return;
+  }
+
+  for (size_t i = 0; i < EVALUATION_CACHE_SIZE; i++) {
+    evaluation_cache_entry_t *entry = &config->cache[i];
+    if (!entry->used) {
+      continue;
+    }
+
+    rb_gc_mark(entry->flag_key);
+    rb_gc_mark(entry->context_attributes);
+    resolution_details_mark(&entry->details);
+  }
 }
 
 static void configuration_free(void *ptr) {
-  ddog_ffe_Handle_Configuration config = (ddog_ffe_Handle_Configuration)ptr;
-  ddog_ffe_configuration_drop(&config);
+  configuration_t *config = (configuration_t *)ptr;
+
+  if (config->handle != NULL) {
+    ddog_ffe_configuration_drop(&config->handle);
+  }
+  ruby_xfree(config->cache);
+  ruby_xfree(config->time_boundaries);
+  ruby_xfree(config);
+}
+
+static size_t configuration_size(const void *ptr) {
+  const configuration_t *config = (const configuration_t *)ptr;
+  return sizeof(configuration_t) +
+    (config->cache != NULL ? EVALUATION_CACHE_SIZE * sizeof(evaluation_cache_entry_t) : 0) +
+    config->time_boundaries_count * sizeof(int64_t);
 }
 
 static ddog_ffe_ExpectedFlagType expected_type_from_value(VALUE expected_type) {
@@ -287,60 +708,459 @@ static ddog_ffe_Handle_EvaluationContext evaluation_context_from_hash(VALUE hash
   return context;
 }
 
+#define FNV_64_OFFSET_BASIS 14695981039346656037ULL
+#define FNV_64_PRIME 1099511628211ULL
+
+static inline uint64_t fnv1a_64(uint64_t hash, const void *data, size_t len) {
+  const uint8_t *bytes = (const uint8_t *)data;
+  for (size_t i = 0; i < len; i++) {
+    hash ^= bytes[i];
+    hash *= FNV_64_PRIME;
+  }
+  return hash;
+}
+
+// splitmix64 finalizer, to spread the bits of combined hashes
+static inline uint64_t mix_64(uint64_t x) {
+  x ^= x >> 30;
+  x *= 0xbf58476d1ce4e5b9ULL;
+  x ^= x >> 27;
+  x *= 0x94d049bb133111ebULL;
+  x ^= x >> 31;
+  return x;
+}
+
+static inline uint64_t hash_string(uint64_t hash, VALUE str) {
+  long len = RSTRING_LEN(str);
+  hash = fnv1a_64(hash, &len, sizeof(len));
+  return fnv1a_64(hash, RSTRING_PTR(str), len);
+}
+
+// Whether evaluation_context_foreach_callback passes the value to
+// libdatadog. Only those are hashed and compared by the evaluation cache, so
+// contexts differing in ignored values share their results.
+static inline bool is_evaluated_context_value(VALUE value) {
+  switch (TYPE(value)) {
+    case T_STRING:
+    case T_FIXNUM:
+    case T_FLOAT:
+    case T_TRUE:
+    case T_FALSE:
+      return true;
+    default:
+      return false;
+  }
+}
+
+// Callback function for rb_hash_foreach to hash each key-value pair
+static int context_hash_foreach_callback(VALUE key, VALUE value, VALUE arg) {
+  uint64_t *hash = (uint64_t *)arg;
+
+  ENFORCE_TYPE(key, T_STRING);
+  uint64_t entry = hash_string(FNV_64_OFFSET_BASIS, key);
+  uint8_t tag = (uint8_t)TYPE(value);
+
+  switch (tag) {
+    case T_STRING:
+      entry = hash_string(fnv1a_64(entry, &tag, 1), value);
+      break;
+    case T_FIXNUM:
+    case T_FLOAT: {
+      // Hashed like libdatadog sees them, so 1 and 1.0 are the same
+      double number = NUM2DBL(value);
+      tag = T_FLOAT;
+      entry = fnv1a_64(fnv1a_64(entry, &tag, 1), &number, sizeof(number));
+      break;
+    }
+    case T_TRUE:
+    case T_FALSE:
+      entry = fnv1a_64(entry, &tag, 1);
+      break;
+    default:
+      return ST_CONTINUE;
+  }
+
+  // Entries are summed, so that the hash does not depend on their order.
+  *hash += mix_64(entry);
+  return ST_CONTINUE;
+}
+
+// Hashes the content of an evaluation context Hash, for the evaluation
+// cache of Configuration. Does not allocate.
+static uint64_t context_hash_from_hash(VALUE hash) {
+  uint64_t result = 0;
+  rb_hash_foreach(hash, context_hash_foreach_callback, (VALUE)&result);
+  return mix_64(result);
+}
+
+static int context_attributes_foreach_callback(VALUE key, VALUE value, VALUE arg) {
+  if (is_evaluated_context_value(value)) {
+    rb_hash_aset(arg, key, RB_TYPE_P(value, T_STRING) ? rb_str_new_frozen(value) : value);
+  }
+  return ST_CONTINUE;
+}
+
+// Copies the entries of an evaluation context Hash that are evaluated (see
+// is_evaluated_context_value) into a new frozen Hash, which evaluation cache
+// entries keep to compare the contexts they are looked up with.
+static VALUE context_attributes_from_hash(VALUE hash) {
+  VALUE attributes = rb_hash_new();
+  rb_hash_foreach(hash, context_attributes_foreach_callback, attributes);
+  return rb_obj_freeze(attributes);
+}
+
+struct context_attributes_compare {
+  VALUE attributes;
+  long count;
+  bool equal;
+};
+
+static int context_attributes_compare_foreach_callback(VALUE key, VALUE value, VALUE arg) {
+  struct context_attributes_compare *compare = (struct context_attributes_compare *)arg;
+  if (!is_evaluated_context_value(value)) {
+    return ST_CONTINUE;
+  }
+  compare->count++;
+
+  VALUE other = rb_hash_lookup2(compare->attributes, key, Qundef);
+  switch (TYPE(value)) {
+    case T_STRING:
+      compare->equal = RB_TYPE_P(other, T_STRING) &&
+        RSTRING_LEN(other) == RSTRING_LEN(value) &&
+        memcmp(RSTRING_PTR(other), RSTRING_PTR(value), RSTRING_LEN(value)) == 0;
+      break;
+    case T_FIXNUM:
+    case T_FLOAT:
+      // Compared like libdatadog sees them, as context_hash_foreach_callback hashes them
+      compare->equal = (RB_TYPE_P(other, T_FIXNUM) || RB_TYPE_P(other, T_FLOAT)) && NUM2DBL(other) == NUM2DBL(value);
+      break;
+    default:
+      compare->equal = other == value;
+      break;
+  }
+  return compare->equal ? ST_CONTINUE : ST_STOP;
+}
+
+// Whether the evaluated entries of an evaluation context Hash are the same
+// as the ones of attributes (see context_attributes_from_hash). Does not
+// allocate, nor call back into Ruby.
+static bool context_attributes_equal(VALUE attributes, VALUE hash) {
+  if (attributes == hash) {
+    return true;
+  }
+
+  struct context_attributes_compare compare = {.attributes = attributes, .count = 0, .equal = true};
+  rb_hash_foreach(hash, context_attributes_compare_foreach_callback, (VALUE)&compare);
+  return compare.equal && compare.count == (long)RHASH_SIZE(attributes);
+}
+
+/*
+ * call-seq:
+ *   EvaluationContext.new(context) -> EvaluationContext
+ *
+ * Builds an evaluation context once, so that it can be passed to many
+ * Configuration#get_assignment (or #get_assignments) calls instead of a
+ * Hash, which would otherwise be converted (and hashed) again by every call.
+ *
+ * The attributes are copied, so later changes to the Hash are not seen by
+ * the EvaluationContext.
+ *
+ * @param context [Hash] Evaluation context with targeting_key and other attributes
+ * @return [EvaluationContext] The evaluation context
+ */
+static VALUE evaluation_context_new(VALUE klass, VALUE context_hash) {
+  ENFORCE_TYPE(context_hash, T_HASH);
+
+  // Allocate first, so that the context cannot leak if allocating raises.
+  evaluation_context_t *context;
+  VALUE wrapped = TypedData_Make_Struct(klass, evaluation_context_t, &evaluation_context_typed_data, context);
+  context->hash = context_hash_from_hash(context_hash);
+  context->attributes = context_attributes_from_hash(context_hash);
+  context->handle = evaluation_context_from_hash(context_hash);
+  return wrapped;
+}
+
+static void evaluation_context_mark(void *ptr) {
+  evaluation_context_t *context = (evaluation_context_t *)ptr;
+
+  rb_gc_mark(context->attributes);
+}
+
+static void evaluation_context_free(void *ptr) {
+  evaluation_context_t *context = (evaluation_context_t *)ptr;
+
+  if (context->handle != NULL) {
+    ddog_ffe_evaluation_context_drop(&context->handle);
+  }
+  ruby_xfree(context);
+}
+
+static inline bool is_evaluation_context(VALUE context) {
+  return rb_typeddata_is_kind_of(context, &evaluation_context_typed_data);
+}
+
+// State for configuration_get_assignment(s), shared with its ensure callback
+struct evaluation_args {
+  configuration_t *config;
+  // An Array of flag keys for get_assignments, a single one for get_assignment
+  VALUE flag_keys;
+  ddog_ffe_ExpectedFlagType expected_ty;
+  // A Hash or an EvaluationContext
+  VALUE context;
+  uint64_t context_hash;
+  // The Hash the evaluation cache compares, see context_attributes_equal. For
+  // a Hash context, this is the context itself until the first cache miss
+  // replaces it with the copy that cache entries keep.
+  VALUE context_attributes;
+  bool context_attributes_copied;
+  // When the evaluation started, if the configuration has time boundaries
+  int64_t now_ms;
+  // Only needed on cache misses, so built from a Hash context on the first one
+  ddog_ffe_Handle_EvaluationContext native_context;
+  bool context_owned;
+};
+
+static void evaluation_args_init(
+  struct evaluation_args *args,
+  VALUE self,
+  VALUE flag_keys,
+  VALUE expected_type,
+  VALUE context
+) {
+  *args = (struct evaluation_args){
+    .config = (configuration_t *)rb_check_typeddata(self, &configuration_data_type),
+    .flag_keys = flag_keys,
+    .expected_ty = expected_type_from_value(expected_type),
+    .context = context,
+    .context_hash = 0,
+    .context_attributes = Qnil,
+    .context_attributes_copied = false,
+    .now_ms = 0,
+    .native_context = NULL,
+    .context_owned = false,
+  };
+
+  if (args->config->time_boundaries_count > 0) {
+    args->now_ms = current_timestamp_ms();
+  }
+
+  if (is_evaluation_context(context)) {
+    evaluation_context_t *evaluation_context =
+      (evaluation_context_t *)rb_check_typeddata(context, &evaluation_context_typed_data);
+    args->context_hash = evaluation_context->hash;
+    args->context_attributes = evaluation_context->attributes;
+    args->context_attributes_copied = true;
+  } else {
+    ENFORCE_TYPE(context, T_HASH);
+    args->context_hash = context_hash_from_hash(context);
+    args->context_attributes = context;
+  }
+}
+
+// Returns the native context of args. An EvaluationContext owns its own,
+// which the caller must keep alive while using it.
+static ddog_ffe_Handle_EvaluationContext native_context(struct evaluation_args *args) {
+  if (args->native_context == NULL) {
+    if (is_evaluation_context(args->context)) {
+      args->native_context =
+        ((evaluation_context_t *)rb_check_typeddata(args->context, &evaluation_context_typed_data))->handle;
+    } else {
+      args->native_context = evaluation_context_from_hash(args->context);
+      args->context_owned = true;
+    }
+  }
+  return args->native_context;
+}
+
+// Returns the context attributes for a new cache entry, copying them from a
+// Hash context once per call
+static VALUE cached_context_attributes(struct evaluation_args *args) {
+  if (!args->context_attributes_copied) {
+    args->context_attributes = context_attributes_from_hash(args->context);
+    args->context_attributes_copied = true;
+  }
+  return args->context_attributes;
+}
+
+static inline bool cache_entry_matches(
+  evaluation_cache_entry_t *entry,
+  VALUE flag_key,
+  struct evaluation_args *args
+) {
+  return entry->used &&
+    entry->context_hash == args->context_hash &&
+    entry->expected_ty == args->expected_ty &&
+    entry->expires_at_ms > args->now_ms &&
+    RSTRING_LEN(entry->flag_key) == RSTRING_LEN(flag_key) &&
+    memcmp(RSTRING_PTR(entry->flag_key), RSTRING_PTR(flag_key), RSTRING_LEN(flag_key)) == 0 &&
+    context_attributes_equal(entry->context_attributes, args->context_attributes);
+}
+
+// Evaluates a flag into a new ResolutionDetails, served from the evaluation
+// cache when the same flag was already evaluated against the same context.
+//
+// The ResolutionDetails is allocated (zeroed, so that it is safe to mark
+// and free) before evaluating, so that the result cannot leak if the
+// allocation raises.
+static VALUE evaluate_flag(struct evaluation_args *args, VALUE flag_key) {
+  ENFORCE_TYPE(flag_key, T_STRING);
+
+  configuration_t *config = args->config;
+  evaluation_cache_entry_t *entry = NULL;
+  if (config->cache != NULL) {
+    uint64_t key_hash = hash_string(FNV_64_OFFSET_BASIS, flag_key);
+    size_t slot = mix_64(key_hash ^ args->context_hash ^ (uint64_t)args->expected_ty) & (EVALUATION_CACHE_SIZE - 1);
+    entry = &config->cache[slot];
+  }
+
+  resolution_details_t *details;
+  VALUE wrapped = TypedData_Make_Struct(
+    resolution_details_class, resolution_details_t, &resolution_details_typed_data, details);
+
+  if (entry != NULL && cache_entry_matches(entry, flag_key, args)) {
+    *details = entry->details;
+    // Each result gets its own copy, which callers are free to change
+    if (RB_TYPE_P(details->raw_value, T_STRING)) {
+      details->raw_value = rb_str_dup(details->raw_value);
+    }
+  } else {
+    details->handle = ddog_ffe_get_assignment(
+      config->handle,
+      RSTRING_PTR(flag_key),
+      args->expected_ty,
+      native_context(args)
+    );
+    converted_resolution_details(wrapped);
+    if (entry == NULL) {
+      return wrapped;
+    }
+
+    // Everything is allocated before the entry is replaced, so that it stays
+    // consistent if an allocation raises.
+    VALUE cached_flag_key = rb_str_new_frozen(flag_key);
+    VALUE context_attributes = cached_context_attributes(args);
+    VALUE cached_raw_value = RB_TYPE_P(details->raw_value, T_STRING) ?
+      rb_str_new_frozen(details->raw_value) : details->raw_value;
+
+    entry->used = true;
+    entry->context_hash = args->context_hash;
+    entry->expected_ty = args->expected_ty;
+    entry->flag_key = cached_flag_key;
+    entry->context_attributes = context_attributes;
+    entry->expires_at_ms = next_time_boundary(config, args->now_ms);
+    entry->details = *details;
+    entry->details.raw_value = cached_raw_value;
+  }
+
+  return wrapped;
+}
+
+static VALUE get_assignment_body(VALUE p) {
+  struct evaluation_args *args = (struct evaluation_args *)p;
+
+  return evaluate_flag(args, args->flag_keys);
+}
+
+static VALUE get_assignments_body(VALUE p) {
+  struct evaluation_args *args = (struct evaluation_args *)p;
+
+  VALUE results = rb_ary_new_capa(RARRAY_LEN(args->flag_keys));
+  for (long i = 0; i < RARRAY_LEN(args->flag_keys); i++) {
+    rb_ary_push(results, evaluate_flag(args, rb_ary_entry(args->flag_keys, i)));
+  }
+  return results;
+}
+
+static VALUE evaluation_args_ensure(VALUE p) {
+  struct evaluation_args *args = (struct evaluation_args *)p;
+
+  if (args->context_owned) {
+    ddog_ffe_evaluation_context_drop(&args->native_context);
+  }
+  return Qnil;
+}
+
 /*
  * call-seq:
  *   configuration.get_assignment(flag_key, expected_type, context) -> ResolutionDetails
  *
  * Get assignment for a feature flag.
  *
+ * Results are cached by flag key, expected type and context content, so
+ * evaluating the same flag against an equal context again does not run the
+ * rules again.
+ *
  * @param flag_key [String] The key of the feature flag
  * @param expected_type [Symbol] Expected type (:boolean, :string, :number, :object, :any, :integer, :float)
- * @param context [Hash] Evaluation context with targeting_key and other attributes
+ * @param context [Hash, EvaluationContext] Evaluation context with targeting_key and other attributes
  * @return [ResolutionDetails] The resolution details
  */
-static VALUE configuration_get_assignment(VALUE self, VALUE flag_key, VALUE expected_type, VALUE context_hash) {
+static VALUE configuration_get_assignment(VALUE self, VALUE flag_key, VALUE expected_type, VALUE context) {
   ENFORCE_TYPED_DATA(self, &configuration_data_type);
   ENFORCE_TYPE(flag_key, T_STRING);
   ENFORCE_TYPE(expected_type, T_SYMBOL);
-  ENFORCE_TYPE(context_hash, T_HASH);
 
-  const ddog_ffe_Handle_Configuration config =
-    (ddog_ffe_Handle_Configuration)rb_check_typeddata(self, &configuration_data_type);
-  const ddog_ffe_ExpectedFlagType expected_ty = expected_type_from_value(expected_type);
-  ddog_ffe_Handle_EvaluationContext context = evaluation_context_from_hash(context_hash);
+  struct evaluation_args args;
+  evaluation_args_init(&args, self, flag_key, expected_type, context);
 
-  ddog_ffe_Handle_ResolutionDetails resolution_details = ddog_ffe_get_assignment(
-    config,
-    RSTRING_PTR(flag_key),
-    expected_ty,
-    context
-  );
-
-  ddog_ffe_evaluation_context_drop(&context);
-
-  return TypedData_Wrap_Struct(resolution_details_class, &resolution_details_typed_data, resolution_details);
-}
-
-static void resolution_details_free(void *ptr) {
-  ddog_ffe_Handle_ResolutionDetails resolution_details = (ddog_ffe_Handle_ResolutionDetails)ptr;
-  ddog_ffe_assignment_drop(&resolution_details);
+  VALUE result = rb_ensure(get_assignment_body, (VALUE)&args, evaluation_args_ensure, (VALUE)&args);
+  RB_GC_GUARD(context);
+  return result;
 }
 
 /*
  * call-seq:
- *   resolution_details.raw_value() -> Object
+ *   configuration.get_assignments(flag_keys, expected_type, context) -> Array<ResolutionDetails>
  *
- * Get the raw resolved value from libdatadog.
+ * Get assignments for many feature flags of the same type, against the same
+ * context. A Hash context is hashed, and converted, only once for all of them.
  *
- * The value can be any type depending on the feature flag (String, Integer, Float, Boolean, or nil).
- * For object types, returns the raw JSON string without parsing.
+ * @param flag_keys [Array<String>] The keys of the feature flags
+ * @param expected_type [Symbol] Expected type (:boolean, :string, :number, :object, :any, :integer, :float)
+ * @param context [Hash, EvaluationContext] Evaluation context with targeting_key and other attributes
+ * @return [Array<ResolutionDetails>] The resolution details, in the order of flag_keys
  */
-static VALUE resolution_details_get_raw_value(VALUE self) {
-  ddog_ffe_Handle_ResolutionDetails resolution_details =
-    (ddog_ffe_Handle_ResolutionDetails)rb_check_typeddata(self, &resolution_details_typed_data);
+static VALUE configuration_get_assignments(VALUE self, VALUE flag_keys, VALUE expected_type, VALUE context) {
+  ENFORCE_TYPED_DATA(self, &configuration_data_type);
+  ENFORCE_TYPE(flag_keys, T_ARRAY);
+  ENFORCE_TYPE(expected_type, T_SYMBOL);
 
-  struct ddog_ffe_VariantValue value = ddog_ffe_assignment_get_value(resolution_details);
+  struct evaluation_args args;
+  evaluation_args_init(&args, self, flag_keys, expected_type, context);
 
+  VALUE results = rb_ensure(get_assignments_body, (VALUE)&args, evaluation_args_ensure, (VALUE)&args);
+  RB_GC_GUARD(context);
+  return results;
+}
+
+static void resolution_details_mark(void *ptr) {
+  resolution_details_t *details = (resolution_details_t *)ptr;
+
+  rb_gc_mark(details->raw_value);
+  rb_gc_mark(details->flag_type);
+  rb_gc_mark(details->variant);
+  rb_gc_mark(details->allocation_key);
+  rb_gc_mark(details->serial_id);
+  rb_gc_mark(details->reason);
+  rb_gc_mark(details->error_code);
+  rb_gc_mark(details->error_message);
+}
+
+static void resolution_details_free(void *ptr) {
+  resolution_details_t *details = (resolution_details_t *)ptr;
+
+  if (details->handle != NULL) {
+    ddog_ffe_assignment_drop(&details->handle);
+  }
+  ruby_xfree(details);
+}
+
+static size_t resolution_details_size(const void *ptr) {
+  (void)ptr;
+  return sizeof(resolution_details_t);
+}
+
+static VALUE raw_value_from_variant(struct ddog_ffe_VariantValue value) {
   switch (value.tag) {
     case DDOG_FFE_VARIANT_VALUE_STRING:
       return str_from_borrow(value.string);
@@ -360,20 +1180,7 @@ static VALUE resolution_details_get_raw_value(VALUE self) {
   }
 }
 
-/*
- * call-seq:
- *   resolution_details.flag_type() -> Symbol or nil
- *
- * Get the type of the flag value.
- *
- * @return [Symbol, nil] One of: :string, :integer, :float, :boolean, :object, nil
- */
-static VALUE resolution_details_get_flag_type(VALUE self) {
-  ddog_ffe_Handle_ResolutionDetails resolution_details =
-    (ddog_ffe_Handle_ResolutionDetails)rb_check_typeddata(self, &resolution_details_typed_data);
-
-  struct ddog_ffe_VariantValue value = ddog_ffe_assignment_get_value(resolution_details);
-
+static VALUE flag_type_from_variant(struct ddog_ffe_VariantValue value) {
   switch (value.tag) {
     case DDOG_FFE_VARIANT_VALUE_STRING:
       return ID2SYM(id_string);
@@ -393,19 +1200,117 @@ static VALUE resolution_details_get_flag_type(VALUE self) {
   }
 }
 
+static VALUE reason_from_enum(enum ddog_ffe_Reason reason) {
+  switch (reason) {
+    case DDOG_FFE_REASON_STATIC:
+      return reason_static;
+    case DDOG_FFE_REASON_DEFAULT:
+      return reason_default;
+    case DDOG_FFE_REASON_TARGETING_MATCH:
+      return reason_targeting_match;
+    case DDOG_FFE_REASON_SPLIT:
+      return reason_split;
+    case DDOG_FFE_REASON_DISABLED:
+      return reason_disabled;
+    case DDOG_FFE_REASON_ERROR:
+      return reason_error;
+    default:
+      return reason_unknown;
+  }
+}
+
+static VALUE error_code_from_enum(enum ddog_ffe_ErrorCode error_code) {
+  switch (error_code) {
+    case DDOG_FFE_ERROR_CODE_OK:
+      return Qnil;
+    case DDOG_FFE_ERROR_CODE_TYPE_MISMATCH:
+      return error_code_type_mismatch;
+    case DDOG_FFE_ERROR_CODE_PARSE_ERROR:
+      return error_code_parse_error;
+    case DDOG_FFE_ERROR_CODE_FLAG_NOT_FOUND:
+      return error_code_flag_not_found;
+    case DDOG_FFE_ERROR_CODE_TARGETING_KEY_MISSING:
+      return error_code_targeting_key_missing;
+    case DDOG_FFE_ERROR_CODE_INVALID_CONTEXT:
+      return error_code_invalid_context;
+    case DDOG_FFE_ERROR_CODE_PROVIDER_NOT_READY:
+      return error_code_provider_not_ready;
+    case DDOG_FFE_ERROR_CODE_GENERAL:
+    default:
+      return error_code_general;
+  }
+}
+
+// Returns the ResolutionDetails of self, converting all of its fields on the
+// first call.
+//
+// Each field is stored as soon as it is converted, so that the ones
+// already allocated stay reachable (and marked) while the others are; if a
+// conversion raises, the handle is kept and the next access retries.
+static resolution_details_t *converted_resolution_details(VALUE self) {
+  resolution_details_t *details = (resolution_details_t *)rb_check_typeddata(self, &resolution_details_typed_data);
+  if (details->converted) {
+    return details;
+  }
+
+  ddog_ffe_Handle_ResolutionDetails handle = details->handle;
+  struct ddog_ffe_VariantValue value = ddog_ffe_assignment_get_value(handle);
+
+  details->flag_type = flag_type_from_variant(value);
+  details->raw_value = raw_value_from_variant(value);
+  details->variant = interned_str_from_borrow(ddog_ffe_assignment_get_variant(handle));
+  details->allocation_key = interned_str_from_borrow(ddog_ffe_assignment_get_allocation_key(handle));
+
+  struct ddog_Option_I32 serial_id = ddog_ffe_assignment_get_serial_id(handle);
+  details->serial_id = serial_id.tag == DDOG_OPTION_I32_SOME_I32 ? INT2NUM(serial_id.some) : Qnil;
+
+  details->reason = reason_from_enum(ddog_ffe_assignment_get_reason(handle));
+  details->error_code = error_code_from_enum(ddog_ffe_assignment_get_error_code(handle));
+  details->error_message = str_from_borrow(ddog_ffe_assignment_get_error_message(handle));
+  details->do_log = ddog_ffe_assignment_get_do_log(handle);
+
+  details->converted = true;
+  details->handle = NULL;
+  ddog_ffe_assignment_drop(&handle);
+
+  return details;
+}
+
+/*
+ * call-seq:
+ *   resolution_details.raw_value() -> Object
+ *
+ * Get the raw resolved value from libdatadog.
+ *
+ * The value can be any type depending on the feature flag (String, Integer, Float, Boolean, or nil).
+ * For object types, returns the raw JSON string without parsing.
+ */
+static VALUE resolution_details_get_raw_value(VALUE self) {
+  return converted_resolution_details(self)->raw_value;
+}
+
+/*
+ * call-seq:
+ *   resolution_details.flag_type() -> Symbol or nil
+ *
+ * Get the type of the flag value.
+ *
+ * @return [Symbol, nil] One of: :string, :integer, :float, :boolean, :object, nil
+ */
+static VALUE resolution_details_get_flag_type(VALUE self) {
+  return converted_resolution_details(self)->flag_type;
+}
+
 /*
  * call-seq:
  *   resolution_details.variant() -> String or nil
  *
  * Get the variant identifier.
  *
- * @return [String, nil] The variant identifier or nil
+ * @return [String, nil] The variant identifier (frozen) or nil
  */
 static VALUE resolution_details_get_variant(VALUE self) {
-  ddog_ffe_Handle_ResolutionDetails resolution_details =
-    (ddog_ffe_Handle_ResolutionDetails)rb_check_typeddata(self, &resolution_details_typed_data);
-  struct ddog_ffe_BorrowedStr variant = ddog_ffe_assignment_get_variant(resolution_details);
-  return str_from_borrow(variant);
+  return converted_resolution_details(self)->variant;
 }
 
 /*
@@ -414,13 +1319,10 @@ static VALUE resolution_details_get_variant(VALUE self) {
  *
  * Get the allocation key.
  *
- * @return [String, nil] The allocation key or nil
+ * @return [String, nil] The allocation key (frozen) or nil
  */
 static VALUE resolution_details_get_allocation_key(VALUE self) {
-  ddog_ffe_Handle_ResolutionDetails resolution_details =
-    (ddog_ffe_Handle_ResolutionDetails)rb_check_typeddata(self, &resolution_details_typed_data);
-  struct ddog_ffe_BorrowedStr allocation_key = ddog_ffe_assignment_get_allocation_key(resolution_details);
-  return str_from_borrow(allocation_key);
+  return converted_resolution_details(self)->allocation_key;
 }
 
 /*
@@ -438,13 +1340,7 @@ static VALUE resolution_details_get_allocation_key(VALUE self) {
  * @return [Integer, nil] The split serial id or nil when absent
  */
 static VALUE resolution_details_get_serial_id(VALUE self) {
-  ddog_ffe_Handle_ResolutionDetails resolution_details =
-    (ddog_ffe_Handle_ResolutionDetails)rb_check_typeddata(self, &resolution_details_typed_data);
-  struct ddog_Option_I32 serial_id = ddog_ffe_assignment_get_serial_id(resolution_details);
-  if (serial_id.tag == DDOG_OPTION_I32_SOME_I32) {
-    return INT2NUM(serial_id.some);
-  }
-  return Qnil;
+  return converted_resolution_details(self)->serial_id;
 }
 
 /*
@@ -453,30 +1349,10 @@ static VALUE resolution_details_get_serial_id(VALUE self) {
  *
  * Get the reason for the resolution.
  *
- * @return [String] One of: "STATIC", "DEFAULT", "TARGETING_MATCH", "SPLIT", "DISABLED", "ERROR", "UNKNOWN"
+ * @return [String] One of: "STATIC", "DEFAULT", "TARGETING_MATCH", "SPLIT", "DISABLED", "ERROR", "UNKNOWN" (frozen)
  */
 static VALUE resolution_details_get_reason(VALUE self) {
-  ddog_ffe_Handle_ResolutionDetails resolution_details =
-    (ddog_ffe_Handle_ResolutionDetails)rb_check_typeddata(self, &resolution_details_typed_data);
-
-  enum ddog_ffe_Reason reason = ddog_ffe_assignment_get_reason(resolution_details);
-
-  switch (reason) {
-    case DDOG_FFE_REASON_STATIC:
-      return rb_str_new_lit("STATIC");
-    case DDOG_FFE_REASON_DEFAULT:
-      return rb_str_new_lit("DEFAULT");
-    case DDOG_FFE_REASON_TARGETING_MATCH:
-      return rb_str_new_lit("TARGETING_MATCH");
-    case DDOG_FFE_REASON_SPLIT:
-      return rb_str_new_lit("SPLIT");
-    case DDOG_FFE_REASON_DISABLED:
-      return rb_str_new_lit("DISABLED");
-    case DDOG_FFE_REASON_ERROR:
-      return rb_str_new_lit("ERROR");
-    default:
-      return rb_str_new_lit("UNKNOWN");
-  }
+  return converted_resolution_details(self)->reason;
 }
 
 /*
@@ -485,33 +1361,10 @@ static VALUE resolution_details_get_reason(VALUE self) {
  *
  * Get the error code if there was an error.
  *
- * @return [String, nil] Error code or nil if no error
+ * @return [String, nil] Error code (frozen) or nil if no error
  */
 static VALUE resolution_details_get_error_code(VALUE self) {
-  ddog_ffe_Handle_ResolutionDetails resolution_details =
-    (ddog_ffe_Handle_ResolutionDetails)rb_check_typeddata(self, &resolution_details_typed_data);
-
-  enum ddog_ffe_ErrorCode error_code = ddog_ffe_assignment_get_error_code(resolution_details);
-
-  switch (error_code) {
-    case DDOG_FFE_ERROR_CODE_OK:
-      return Qnil;
-    case DDOG_FFE_ERROR_CODE_TYPE_MISMATCH:
-      return rb_str_new_lit("TYPE_MISMATCH");
-    case DDOG_FFE_ERROR_CODE_PARSE_ERROR:
-      return rb_str_new_lit("PARSE_ERROR");
-    case DDOG_FFE_ERROR_CODE_FLAG_NOT_FOUND:
-      return rb_str_new_lit("FLAG_NOT_FOUND");
-    case DDOG_FFE_ERROR_CODE_TARGETING_KEY_MISSING:
-      return rb_str_new_lit("TARGETING_KEY_MISSING");
-    case DDOG_FFE_ERROR_CODE_INVALID_CONTEXT:
-      return rb_str_new_lit("INVALID_CONTEXT");
-    case DDOG_FFE_ERROR_CODE_PROVIDER_NOT_READY:
-      return rb_str_new_lit("PROVIDER_NOT_READY");
-    case DDOG_FFE_ERROR_CODE_GENERAL:
-    default:
-      return rb_str_new_lit("GENERAL");
-  }
+  return converted_resolution_details(self)->error_code;
 }
 
 /*
@@ -523,10 +1376,7 @@ static VALUE resolution_details_get_error_code(VALUE self) {
  * @return [String, nil] Error message or nil
  */
 static VALUE resolution_details_get_error_message(VALUE self) {
-  ddog_ffe_Handle_ResolutionDetails resolution_details =
-    (ddog_ffe_Handle_ResolutionDetails)rb_check_typeddata(self, &resolution_details_typed_data);
-  struct ddog_ffe_BorrowedStr error_message = ddog_ffe_assignment_get_error_message(resolution_details);
-  return str_from_borrow(error_message);
+  return converted_resolution_details(self)->error_message;
 }
 
 /*
@@ -538,9 +1388,7 @@ static VALUE resolution_details_get_error_message(VALUE self) {
  * @return [Boolean] True if should be logged
  */
 static VALUE resolution_details_get_do_log(VALUE self) {
-  ddog_ffe_Handle_ResolutionDetails resolution_details =
-    (ddog_ffe_Handle_ResolutionDetails)rb_check_typeddata(self, &resolution_details_typed_data);
-  return ddog_ffe_assignment_get_do_log(resolution_details) ? Qtrue : Qfalse;
+  return converted_resolution_details(self)->do_log ? Qtrue : Qfalse;
 }
 
 /*
@@ -549,19 +1397,16 @@ static VALUE resolution_details_get_do_log(VALUE self) {
  *
  * Get the flag metadata.
  *
- * @return [Hash{String => String}] The flag metadata as a hash
+ * @return [Hash{String => String}] The flag metadata as a (frozen) hash
  */
 static VALUE resolution_details_get_flag_metadata(VALUE self) {
-  ddog_ffe_Handle_ResolutionDetails resolution_details =
-    (ddog_ffe_Handle_ResolutionDetails)rb_check_typeddata(self, &resolution_details_typed_data);
-  (void)resolution_details;
-
-  VALUE hash = rb_hash_new();
+  ENFORCE_TYPED_DATA(self, &resolution_details_typed_data);
 
   // TODO(FFL-1450): datadog-ffe-ffi-1.0.1 has a memory corruption bug
   // when returning flag metadata. Therefore, this section is
   // currently commented out. We'll uncommented it when the bug is
-  // fixed in libdatadog.
+  // fixed in libdatadog (converting it in converted_resolution_details,
+  // into a new frozen hash).
   //
   // This is not a blocker as flag_metadata should be empty for now
   // until we decide to add more fields to it.
@@ -576,5 +1421,253 @@ static VALUE resolution_details_get_flag_metadata(VALUE self) {
   //   rb_hash_aset(hash, key, value);
   // }
 
-  return hash;
+  return empty_flag_metadata;
+}
+
+// ExposureBuffer
+//
+// Every method runs with the GVL held, and does not call back into Ruby
+// while updating the buffer, so it needs no lock.
+
+/*
+ * call-seq:
+ *   ExposureBuffer.new(limit, deduplication_limit) -> ExposureBuffer
+ *
+ * Creates a buffer of up to limit exposures, skipping the exposures that
+ * repeat the last one of the same flag and targeting key. Up to about
+ * deduplication_limit (flag key, targeting key) are remembered.
+ *
+ * @param limit [Integer] Maximum number of buffered exposures
+ * @param deduplication_limit [Integer] Number of exposures remembered for deduplication
+ * @return [ExposureBuffer] The exposure buffer
+ */
+static VALUE exposure_buffer_new(VALUE klass, VALUE limit, VALUE deduplication_limit) {
+  ENFORCE_TYPE(limit, T_FIXNUM);
+  ENFORCE_TYPE(deduplication_limit, T_FIXNUM);
+  long capacity = FIX2LONG(limit);
+  long seen_limit = FIX2LONG(deduplication_limit);
+  if (capacity <= 0 || seen_limit <= 0) {
+    rb_raise(rb_eArgError, "limits must be positive");
+  }
+
+  size_t seen_capacity = 1;
+  while (seen_capacity < (size_t)seen_limit) {
+    seen_capacity <<= 1;
+  }
+
+  exposure_buffer_t *buffer;
+  VALUE wrapped = TypedData_Make_Struct(klass, exposure_buffer_t, &exposure_buffer_typed_data, buffer);
+  buffer->ring = ruby_xcalloc(capacity, sizeof(exposure_t));
+  buffer->capacity = capacity;
+  buffer->seen = ruby_xcalloc(seen_capacity, sizeof(exposure_seen_t));
+  buffer->seen_capacity = seen_capacity;
+  return wrapped;
+}
+
+static void exposure_buffer_mark(void *ptr) {
+  exposure_buffer_t *buffer = (exposure_buffer_t *)ptr;
+
+  if (buffer->ring != NULL) {
+    for (size_t i = 0; i < buffer->length; i++) {
+      exposure_t *exposure = &buffer->ring[(buffer->start + i) % buffer->capacity];
+      rb_gc_mark(exposure->flag_key);
+      rb_gc_mark(exposure->allocation_key);
+      rb_gc_mark(exposure->variant);
+      rb_gc_mark(exposure->targeting_key);
+      rb_gc_mark(exposure->attributes);
+    }
+  }
+
+  if (buffer->seen != NULL) {
+    for (size_t i = 0; i < buffer->seen_capacity; i++) {
+      exposure_seen_t *seen = &buffer->seen[i];
+      if (seen->key_hash == 0) {
+        continue;
+      }
+
+      rb_gc_mark(seen->flag_key);
+      rb_gc_mark(seen->targeting_key);
+      rb_gc_mark(seen->allocation_key);
+      rb_gc_mark(seen->variant);
+    }
+  }
+}
+
+static void exposure_buffer_free(void *ptr) {
+  exposure_buffer_t *buffer = (exposure_buffer_t *)ptr;
+
+  ruby_xfree(buffer->ring);
+  ruby_xfree(buffer->seen);
+  ruby_xfree(buffer);
+}
+
+static size_t exposure_buffer_size(const void *ptr) {
+  const exposure_buffer_t *buffer = (const exposure_buffer_t *)ptr;
+  return sizeof(exposure_buffer_t) +
+    buffer->capacity * sizeof(exposure_t) +
+    buffer->seen_capacity * sizeof(exposure_seen_t);
+}
+
+// nil and "" are the same key, like they were for the Ruby deduplicator
+static inline bool exposure_key_equal(VALUE a, VALUE b) {
+  long a_len = NIL_P(a) ? 0 : RSTRING_LEN(a);
+  long b_len = NIL_P(b) ? 0 : RSTRING_LEN(b);
+  return a_len == b_len && (a_len == 0 || memcmp(RSTRING_PTR(a), RSTRING_PTR(b), a_len) == 0);
+}
+
+static inline VALUE frozen_str_or_nil(VALUE str) {
+  return NIL_P(str) ? Qnil : rb_str_new_frozen(str);
+}
+
+/*
+ * call-seq:
+ *   exposure_buffer.push(flag_key, allocation_key, variant, targeting_key, attributes) -> Boolean
+ *
+ * Records the exposure of a subject to a flag evaluation, timestamped now,
+ * unless it is the same as the last one recorded for that flag and subject.
+ *
+ * The attributes are copied, so later changes to the Hash are not seen by
+ * the recorded exposure.
+ *
+ * @param flag_key [String] The key of the feature flag
+ * @param allocation_key [String, nil] The allocation key of the evaluation
+ * @param variant [String, nil] The variant of the evaluation
+ * @param targeting_key [String, nil] The targeting key of the subject
+ * @param attributes [Hash, nil] The evaluation context fields of the subject
+ * @return [Boolean] False if the exposure was a duplicate, or the buffer is closed
+ */
+static VALUE exposure_buffer_push(
+  VALUE self,
+  VALUE flag_key,
+  VALUE allocation_key,
+  VALUE variant,
+  VALUE targeting_key,
+  VALUE attributes
+) {
+  exposure_buffer_t *buffer = (exposure_buffer_t *)rb_check_typeddata(self, &exposure_buffer_typed_data);
+  ENFORCE_TYPE(flag_key, T_STRING);
+  if (!NIL_P(allocation_key)) ENFORCE_TYPE(allocation_key, T_STRING);
+  if (!NIL_P(variant)) ENFORCE_TYPE(variant, T_STRING);
+  if (!NIL_P(targeting_key) && !RB_TYPE_P(targeting_key, T_STRING)) {
+    targeting_key = rb_obj_as_string(targeting_key);
+  }
+  if (!NIL_P(attributes)) ENFORCE_TYPE(attributes, T_HASH);
+
+  if (buffer->closed) {
+    return Qfalse;
+  }
+
+  uint64_t key_hash = hash_string(FNV_64_OFFSET_BASIS, flag_key);
+  if (!NIL_P(targeting_key)) {
+    key_hash = hash_string(key_hash, targeting_key);
+  }
+  key_hash = mix_64(key_hash) | 1;
+
+  exposure_seen_t *seen = &buffer->seen[key_hash & (buffer->seen_capacity - 1)];
+  if (seen->key_hash == key_hash &&
+      exposure_key_equal(seen->flag_key, flag_key) &&
+      exposure_key_equal(seen->targeting_key, targeting_key) &&
+      exposure_key_equal(seen->allocation_key, allocation_key) &&
+      exposure_key_equal(seen->variant, variant)) {
+    return Qfalse;
+  }
+
+  // Copy before updating the buffer, so that it is not left half-updated if copying raises
+  flag_key = rb_str_new_frozen(flag_key);
+  allocation_key = frozen_str_or_nil(allocation_key);
+  variant = frozen_str_or_nil(variant);
+  targeting_key = frozen_str_or_nil(targeting_key);
+  if (!NIL_P(attributes)) attributes = rb_hash_dup(attributes);
+
+  seen->key_hash = key_hash;
+  seen->flag_key = flag_key;
+  seen->targeting_key = targeting_key;
+  seen->allocation_key = allocation_key;
+  seen->variant = variant;
+
+  if (buffer->length == buffer->capacity) {
+    buffer->start = (buffer->start + 1) % buffer->capacity;
+    buffer->dropped++;
+  } else {
+    buffer->length++;
+  }
+
+  buffer->ring[(buffer->start + buffer->length - 1) % buffer->capacity] = (exposure_t){
+    .timestamp_ms = current_timestamp_ms(),
+    .flag_key = flag_key,
+    .allocation_key = allocation_key,
+    .variant = variant,
+    .targeting_key = targeting_key,
+    .attributes = attributes,
+  };
+
+  return Qtrue;
+}
+
+/*
+ * call-seq:
+ *   exposure_buffer.pop() -> [Array, Integer]
+ *
+ * Removes all the buffered exposures.
+ *
+ * Each exposure is an Array of
+ * [timestamp_ms, flag_key, allocation_key, variant, targeting_key, attributes].
+ *
+ * @return [Array(Array<Array>, Integer)] The exposures, oldest first, and how
+ *   many were dropped because the buffer was full since the last pop
+ */
+static VALUE exposure_buffer_pop(VALUE self) {
+  exposure_buffer_t *buffer = (exposure_buffer_t *)rb_check_typeddata(self, &exposure_buffer_typed_data);
+
+  VALUE exposures = rb_ary_new_capa(buffer->length);
+  for (size_t i = 0; i < buffer->length; i++) {
+    exposure_t *exposure = &buffer->ring[(buffer->start + i) % buffer->capacity];
+    rb_ary_push(exposures, rb_ary_new_from_args(
+      6,
+      LL2NUM(exposure->timestamp_ms),
+      exposure->flag_key,
+      exposure->allocation_key,
+      exposure->variant,
+      exposure->targeting_key,
+      exposure->attributes
+    ));
+  }
+  VALUE dropped = SIZET2NUM(buffer->dropped);
+
+  memset(buffer->ring, 0, buffer->capacity * sizeof(exposure_t));
+  buffer->start = 0;
+  buffer->length = 0;
+  buffer->dropped = 0;
+
+  return rb_ary_new_from_args(2, exposures, dropped);
+}
+
+/*
+ * call-seq:
+ *   exposure_buffer.empty?() -> Boolean
+ */
+static VALUE exposure_buffer_is_empty(VALUE self) {
+  exposure_buffer_t *buffer = (exposure_buffer_t *)rb_check_typeddata(self, &exposure_buffer_typed_data);
+  return buffer->length == 0 ? Qtrue : Qfalse;
+}
+
+/*
+ * call-seq:
+ *   exposure_buffer.length() -> Integer
+ */
+static VALUE exposure_buffer_length(VALUE self) {
+  exposure_buffer_t *buffer = (exposure_buffer_t *)rb_check_typeddata(self, &exposure_buffer_typed_data);
+  return SIZET2NUM(buffer->length);
+}
+
+/*
+ * call-seq:
+ *   exposure_buffer.close() -> nil
+ *
+ * Stops accepting exposures. The buffered ones can still be popped.
+ */
+static VALUE exposure_buffer_close(VALUE self) {
+  exposure_buffer_t *buffer = (exposure_buffer_t *)rb_check_typeddata(self, &exposure_buffer_typed_data);
+  buffer->closed = true;
+  return Qnil;
 }
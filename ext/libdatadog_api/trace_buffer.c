@@ -0,0 +1,241 @@
+#include <ruby.h>
+#include <stdbool.h>
+
+#include "datadog_ruby_common.h"
+#include "trace_buffer.h"
+
+/*
+ * Native counterpart of Datadog::Tracing::CRubyTraceBuffer, used by the
+ * writer when sending through the native transport.
+ *
+ * Application threads push finished traces (whose spans were usually already
+ * converted into native spans, see TraceChunk) and the writer thread drains
+ * them in one batch.  Like the Ruby buffer, it holds at most +max_size+
+ * traces and, when full, a new trace replaces a random one.
+ *
+ * No operation below calls back into Ruby code or releases the GVL, so each
+ * one runs atomically with respect to other Ruby threads without needing a
+ * lock.  Unlike Core::Buffer::CRuby, the buffer therefore never goes over
+ * +max_size+, and the health metrics are updated in the same step.
+ */
+
+typedef struct {
+  VALUE *traces;
+  long   count;
+  long   capacity;
+  long   max_size;  /* 0 or negative means unbounded */
+  bool   closed;
+
+  /* Health metrics, reset on every drain (see MeasuredBuffer) */
+  long   accepted;
+  long   accepted_lengths;
+  long   dropped;
+  long   spans;
+} trace_buffer_t;
+
+#define UNBOUNDED_INITIAL_CAPACITY 16
+
+static ID at_spans_id;
+static VALUE trace_buffer_class = Qnil;
+
+static void trace_buffer_dmark(void *ptr) {
+  trace_buffer_t *buffer = (trace_buffer_t *)ptr;
+  for (long i = 0; i < buffer->count; i++) {
+    rb_gc_mark(buffer->traces[i]);
+  }
+}
+
+static void trace_buffer_dfree(void *ptr) {
+  trace_buffer_t *buffer = (trace_buffer_t *)ptr;
+  ruby_xfree(buffer->traces);
+  ruby_xfree(buffer);
+}
+
+static size_t trace_buffer_dsize(const void *ptr) {
+  const trace_buffer_t *buffer = (const trace_buffer_t *)ptr;
+  return sizeof(trace_buffer_t) + (size_t)buffer->capacity * sizeof(VALUE);
+}
+
+static const rb_data_type_t trace_buffer_typed_data = {
+  .wrap_struct_name = "Datadog::Tracing::Transport::Native::TraceBuffer",
+  .function = {
+    .dmark = trace_buffer_dmark,
+    .dfree = trace_buffer_dfree,
+    .dsize = trace_buffer_dsize,
+  },
+  .flags = RUBY_TYPED_FREE_IMMEDIATELY
+};
+
+static trace_buffer_t *get_trace_buffer(VALUE self) {
+  trace_buffer_t *buffer;
+  TypedData_Get_Struct(self, trace_buffer_t, &trace_buffer_typed_data, buffer);
+  return buffer;
+}
+
+/*
+ * Number of spans in +trace+, read straight from TraceSegment's @spans so
+ * that pushing never calls a Ruby method.  Anything else counts as 0 spans.
+ */
+static long trace_span_count(VALUE trace) {
+  if (RB_SPECIAL_CONST_P(trace)) return 0;
+
+  VALUE spans = rb_ivar_get(trace, at_spans_id);
+  return RB_TYPE_P(spans, T_ARRAY) ? RARRAY_LEN(spans) : 0;
+}
+
+static void trace_buffer_add(trace_buffer_t *buffer, VALUE trace) {
+  long span_count = trace_span_count(trace);
+
+  if (buffer->max_size > 0 && buffer->count >= buffer->max_size) {
+    /* Full: replace a random trace, drawn from the same generator as Kernel#rand */
+    long index = (long)rb_genrand_ulong_limited((unsigned long)buffer->count - 1);
+    VALUE discarded = buffer->traces[index];
+    buffer->traces[index] = trace;
+
+    buffer->dropped++;
+    buffer->spans -= trace_span_count(discarded);
+  } else {
+    if (buffer->count == buffer->capacity) {
+      /* Only unbounded buffers grow, bounded ones are allocated at max_size */
+      long capacity = buffer->capacity * 2;
+      buffer->traces = ruby_xrealloc2(buffer->traces, (size_t)capacity, sizeof(VALUE));
+      buffer->capacity = capacity;
+    }
+    buffer->traces[buffer->count++] = trace;
+  }
+
+  buffer->accepted++;
+  buffer->accepted_lengths += span_count;
+  buffer->spans += span_count;
+}
+
+/* ========================================================================
+ * TraceBuffer._native_new
+ *
+ * Ruby signature:
+ *   TraceBuffer._native_new(max_size) -> TraceBuffer
+ * ======================================================================== */
+
+static VALUE _native_new(DDTRACE_UNUSED VALUE klass, VALUE max_size) {
+  ENFORCE_TYPE(max_size, T_FIXNUM);
+
+  trace_buffer_t *buffer;
+  VALUE wrapped = TypedData_Make_Struct(
+      trace_buffer_class, trace_buffer_t, &trace_buffer_typed_data, buffer);
+
+  buffer->max_size = FIX2LONG(max_size);
+  buffer->capacity = buffer->max_size > 0 ? buffer->max_size : UNBOUNDED_INITIAL_CAPACITY;
+  buffer->traces = ruby_xmalloc2((size_t)buffer->capacity, sizeof(VALUE));
+
+  return wrapped;
+}
+
+/* ========================================================================
+ * Instance methods
+ * ======================================================================== */
+
+/*
+ * push(trace) -> trace, or nil when closed
+ *
+ * Never blocks: when the buffer is full, a random trace gets discarded.
+ */
+static VALUE _native_push(VALUE self, VALUE trace) {
+  trace_buffer_t *buffer = get_trace_buffer(self);
+  if (buffer->closed) return Qnil;
+
+  trace_buffer_add(buffer, trace);
+  return trace;
+}
+
+/* concat(traces) -> nil; bulk alternative to #push */
+static VALUE _native_concat(VALUE self, VALUE traces) {
+  ENFORCE_TYPE(traces, T_ARRAY);
+
+  trace_buffer_t *buffer = get_trace_buffer(self);
+  if (buffer->closed) return Qnil;
+
+  for (long i = 0; i < RARRAY_LEN(traces); i++) {
+    trace_buffer_add(buffer, RARRAY_AREF(traces, i));
+  }
+  return Qnil;
+}
+
+/*
+ * _native_drain -> [traces, accepted, accepted_lengths, dropped, spans]
+ *
+ * Returns the stored traces along with the health metrics accumulated since
+ * the previous drain, and resets both.
+ */
+static VALUE _native_drain(VALUE self) {
+  trace_buffer_t *buffer = get_trace_buffer(self);
+
+  /* May trigger GC, so only forget the traces once they have been copied */
+  VALUE traces = rb_ary_new_from_values(buffer->count, buffer->traces);
+  VALUE result = rb_ary_new_from_args(5,
+      traces,
+      LONG2NUM(buffer->accepted),
+      LONG2NUM(buffer->accepted_lengths),
+      LONG2NUM(buffer->dropped),
+      LONG2NUM(buffer->spans));
+
+  buffer->count = 0;
+  buffer->accepted = 0;
+  buffer->accepted_lengths = 0;
+  buffer->dropped = 0;
+  buffer->spans = 0;
+
+  return result;
+}
+
+static VALUE _native_length(VALUE self) {
+  return LONG2NUM(get_trace_buffer(self)->count);
+}
+
+static VALUE _native_empty_p(VALUE self) {
+  return get_trace_buffer(self)->count == 0 ? Qtrue : Qfalse;
+}
+
+static VALUE _native_max_size(VALUE self) {
+  return LONG2NUM(get_trace_buffer(self)->max_size);
+}
+
+/* Prevents further pushes; draining is still allowed. */
+static VALUE _native_close(VALUE self) {
+  get_trace_buffer(self)->closed = true;
+  return Qtrue;
+}
+
+static VALUE _native_closed_p(VALUE self) {
+  return get_trace_buffer(self)->closed ? Qtrue : Qfalse;
+}
+
+/* ========================================================================
+ * Initialization
+ * ======================================================================== */
+
+void trace_buffer_init(VALUE tracing_module) {
+  VALUE transport_module = rb_define_module_under(tracing_module, "Transport");
+  VALUE native_module =
+      rb_define_module_under(transport_module, "Native");
+
+  trace_buffer_class =
+      rb_define_class_under(native_module, "TraceBuffer", rb_cObject);
+  rb_undef_alloc_func(trace_buffer_class);
+
+  /* Factory */
+  rb_define_singleton_method(trace_buffer_class, "_native_new", _native_new, 1);
+
+  /* Same interface as Core::Buffer::Random; #pop is defined in Ruby */
+  rb_define_method(trace_buffer_class, "push",          _native_push, 1);
+  rb_define_method(trace_buffer_class, "concat",        _native_concat, 1);
+  rb_define_method(trace_buffer_class, "_native_drain", _native_drain, 0);
+  rb_define_method(trace_buffer_class, "length",        _native_length, 0);
+  rb_define_method(trace_buffer_class, "empty?",        _native_empty_p, 0);
+  rb_define_method(trace_buffer_class, "max_size",      _native_max_size, 0);
+  rb_define_method(trace_buffer_class, "close",         _native_close, 0);
+  rb_define_method(trace_buffer_class, "closed?",       _native_closed_p, 0);
+
+  at_spans_id = rb_intern("@spans");
+
+  rb_require("datadog/tracing/transport/native/trace_buffer");
+}
@@ -8,9 +8,14 @@
 #pragma GCC diagnostic pop
 #endif
 #include <ruby/thread.h>
+#include <errno.h>
+#include <inttypes.h>
 #include <limits.h>
+#include <math.h>
+#include <pthread.h>
 #include <stdbool.h>
 #include <string.h>
+#include <time.h>
 #include <datadog/data-pipeline.h>
 #include <datadog/shared-runtime.h>
 
@@ -26,26 +31,69 @@ typedef struct {
   ddog_TracerSpan *span;
 } raw_span_owner;
 
-/* Internal: convert a Ruby Span into the supplied raw Rust span owner */
-static void convert_ruby_span_to_rust(VALUE span, raw_span_owner *owner);
+/* See "Repeated strings" */
+typedef struct {
+  st_index_t hash;
+  size_t     offset;  /* into string_table_t.bytes */
+  size_t     len;     /* 0 for an empty slot */
+} string_table_slot;
+
+typedef struct {
+  string_table_slot *slots;  /* open addressing, +capacity+ is a power of 2 */
+  size_t             capacity;
+  size_t             count;
+  char              *bytes;  /* the distinct strings, back to back */
+  size_t             bytes_len;
+  size_t             bytes_capacity;
+  size_t             duplicate_bytes;
+} string_table_t;
+
+typedef struct trace_tags trace_tags_t;
+typedef struct async_sender async_sender_t;
+
+static void string_table_free(string_table_t *strings);
+static size_t string_table_memsize(const string_table_t *strings);
+
+static void async_sender_free(async_sender_t *sender);
+static bool async_sender_orphan(async_sender_t *sender, ddog_TraceExporter *exporter,
+                                const ddog_ForkSafeRuntime *runtime);
+static void async_sender_before_fork(async_sender_t *sender);
+static void async_sender_wait_for_send_in_progress(async_sender_t *sender);
+static void async_sender_after_fork_in_parent(async_sender_t *sender);
+static void async_sender_after_fork_in_child(async_sender_t *sender);
+
+/* Internal: convert a Ruby Span into the supplied raw Rust span owner,
+ * returning its estimated encoded size */
+static size_t convert_ruby_span_to_rust(VALUE span, raw_span_owner *owner,
+                                      const trace_tags_t *tags,
+                                      string_table_t *strings);
 
 /* TracerSpan methods */
 static VALUE _native_from_span(VALUE klass, VALUE span);
 
+/* TraceChunk methods */
+static VALUE _native_chunk_from_spans(VALUE klass, VALUE spans);
+
 /* TraceExporter methods */
 static VALUE _native_exporter_new(int argc, VALUE *argv, VALUE klass);
 static VALUE _native_send_traces(VALUE self, VALUE traces);
+static VALUE _native_prepare_trace(VALUE self, VALUE trace);
+static VALUE _native_set_first_span_tags(VALUE self, VALUE first_span_tags);
 static VALUE _native_before_fork(VALUE self);
 static VALUE _native_after_fork_in_parent(VALUE self);
 static VALUE _native_after_fork_in_child(VALUE self);
 
 /* Response helpers */
-static VALUE create_ok_response(long trace_count, VALUE payload);
+static VALUE create_ok_response(long trace_count, VALUE payload,
+                                size_t duplicate_string_bytes);
 static VALUE create_error_response(ddog_TraceExporterErrorCode code,
                                     long trace_count);
 
 /* GC / TypedData */
 static void tracer_span_dfree(void *ptr);
+static void trace_chunk_dfree(void *ptr);
+static size_t trace_chunk_dsize(const void *ptr);
+static void trace_exporter_dmark(void *ptr);
 static void trace_exporter_dfree(void *ptr);
 
 /* ========================================================================
@@ -66,6 +114,35 @@ static ID at_status_id;
 static ID at_meta_id;
 static ID at_metrics_id;
 static ID at_metastruct_id;
+static ID at_events_id;
+static ID at_links_id;
+
+/* Instance variable IDs on SpanEvent / SpanLink (@name and @trace_id are
+ * shared with Span) */
+static ID at_attributes_id;
+static ID at_time_unix_nano_id;
+static ID at_span_id_id;
+static ID at_trace_flags_id;
+static ID at_trace_state_id;
+static ID at_dropped_attributes_id;
+
+/* Instance variable IDs on TraceSegment (@id, @resource, @meta and @metrics
+ * are shared with Span) */
+static ID at_spans_id;
+static ID at_root_span_id_id;
+static ID at_agent_sample_rate_id;
+static ID at_hostname_id;
+static ID at_lang_id;
+static ID at_origin_id;
+static ID at_process_id_id;
+static ID at_rate_limiter_rate_id;
+static ID at_rule_sample_rate_id;
+static ID at_runtime_id_id;
+static ID at_sample_rate_id;
+static ID at_sampling_decision_maker_id;
+static ID at_sampling_priority_id;
+static ID at_profiling_enabled_id;
+static ID at_apm_tracing_enabled_id;
 
 /* Method IDs for time / integer operations */
 static ID id_duration_method;
@@ -86,12 +163,14 @@ static ID kw_server_error;
 static ID kw_client_error;
 static ID kw_trace_count;
 static ID kw_payload;
+static ID kw_duplicate_string_bytes;
 
 /* ========================================================================
  * Ruby class references (marked as GC roots)
  * ======================================================================== */
 
 static VALUE tracer_span_class    = Qnil;
+static VALUE trace_chunk_class    = Qnil;
 static VALUE trace_exporter_class = Qnil;
 
 /* ========================================================================
@@ -114,6 +193,49 @@ static void tracer_span_dfree(void *ptr) {
   }
 }
 
+/*
+ * A TraceChunk owns the Rust spans of one trace, converted ahead of the send
+ * (see _native_chunk_from_spans).  _native_send_traces moves the spans into the
+ * payload and flags the chunk as sent; any spans still owned when the chunk is
+ * collected (e.g. the trace was dropped before being sent) are freed here.
+ */
+typedef struct {
+  ddog_TracerSpan **spans;
+  long              len;
+  long              capacity;
+  bool              sent;
+  /* See "Payload size estimates" */
+  size_t            encoded_bytes;
+  /* The distinct strings of the spans, see "Repeated strings" */
+  string_table_t    strings;
+} trace_chunk_t;
+
+static const rb_data_type_t trace_chunk_typed_data = {
+  .wrap_struct_name = "Datadog::Tracing::Transport::Native::TraceChunk",
+  .function = {
+    .dmark = NULL,
+    .dfree = trace_chunk_dfree,
+    .dsize = trace_chunk_dsize,
+  },
+  .flags = RUBY_TYPED_FREE_IMMEDIATELY
+};
+
+static void trace_chunk_dfree(void *ptr) {
+  trace_chunk_t *chunk = (trace_chunk_t *)ptr;
+  for (long i = 0; i < chunk->len; i++) {
+    if (chunk->spans[i] != NULL) ddog_tracer_span_free(chunk->spans[i]);
+  }
+  ruby_xfree(chunk->spans);
+  string_table_free(&chunk->strings);
+  ruby_xfree(chunk);
+}
+
+static size_t trace_chunk_dsize(const void *ptr) {
+  const trace_chunk_t *chunk = (const trace_chunk_t *)ptr;
+  return sizeof(trace_chunk_t) + (size_t)chunk->capacity * sizeof(ddog_TracerSpan *) +
+         string_table_memsize(&chunk->strings);
+}
+
 /*
  * The TraceExporter wrapper owns both the Rust exporter and the SharedRuntime
  * that drives its background workers.  Fork-safety hooks operate on the
@@ -122,21 +244,37 @@ static void tracer_span_dfree(void *ptr) {
 typedef struct {
   ddog_TraceExporter       *exporter;
   const ddog_ForkSafeRuntime *runtime;
+  async_sender_t           *async_sender;  /* NULL unless started, see async_sender_t */
+  VALUE                     first_span_tags;  /* frozen Hash, or Qnil; see trace_tags_t */
+  size_t                    max_payload_size;  /* see trace_payload */
 } trace_exporter_t;
 
 static const rb_data_type_t trace_exporter_typed_data = {
   .wrap_struct_name = "Datadog::Tracing::Transport::Native::TraceExporter",
   .function = {
-    .dmark = NULL,
+    .dmark = trace_exporter_dmark,
     .dfree = trace_exporter_dfree,
     .dsize = NULL,
   },
   .flags = RUBY_TYPED_FREE_IMMEDIATELY
 };
 
+static void trace_exporter_dmark(void *ptr) {
+  trace_exporter_t *wrapper = (trace_exporter_t *)ptr;
+  rb_gc_mark(wrapper->first_span_tags);
+}
+
 static void trace_exporter_dfree(void *ptr) {
   if (ptr != NULL) {
     trace_exporter_t *wrapper = (trace_exporter_t *)ptr;
+    /* A sender thread still running (the transport was not closed) uses the
+     * exporter, so it frees it, and the runtime, once it exits.  Joining it
+     * here would block GC until the send in progress gets cancelled. */
+    if (wrapper->async_sender != NULL &&
+        async_sender_orphan(wrapper->async_sender, wrapper->exporter, wrapper->runtime)) {
+      wrapper->exporter = NULL;
+      wrapper->runtime = NULL;
+    }
     if (wrapper->exporter != NULL) {
       ddog_trace_exporter_free(wrapper->exporter);
     }
@@ -259,72 +397,301 @@ static inline trace_id_t split_trace_id(VALUE trace_id) {
 }
 
 /* ========================================================================
- * Hash iteration callbacks for meta / metrics
+ * Payload size estimates
+ *
+ * Batches are split into payloads of at most +max_payload_size+ bytes (see
+ * trace_payload), but the payloads are only encoded by libdatadog when they
+ * are sent.  Their size is instead estimated while converting the spans, from
+ * what a msgpack v0.4 encoding would take: the length of every string plus a
+ * small header, 9 bytes per number, and a fixed part per span covering its
+ * field names and scalar fields.  This is meant to be in the right ballpark,
+ * not exact, which is why the default limit leaves plenty of headroom below
+ * what the agent accepts.
+ * ======================================================================== */
+
+/* Same as Traces::Chunker::DEFAULT_MAX_PAYLOAD_SIZE */
+#define DEFAULT_MAX_PAYLOAD_SIZE (5 * 1024 * 1024)
+
+#define SPAN_ENCODED_OVERHEAD   160
+#define STRING_ENCODED_OVERHEAD 3
+#define NUMBER_ENCODED_BYTES    9
+/* The tags set by set_trace_tags are not counted one by one */
+#define TRACE_TAGS_ENCODED_BYTES 512
+
+static inline size_t encoded_string_bytes(VALUE str) {
+  return (size_t)RSTRING_LEN(str) + STRING_ENCODED_OVERHEAD;
+}
+
+/* ========================================================================
+ * Repeated strings
+ *
+ * Most span strings (service, name, well-known meta keys such as
+ * "http.method", "component" or "_dd.*", and many values) repeat across the
+ * spans of a payload.  libdatadog copies every slice it gets, and the v0.4
+ * payload it sends repeats them too.  The FFI does not (yet) accept interned
+ * strings nor encode v0.5 (string table) payloads, so for now we only keep
+ * track of the strings a payload repeats, to report how many bytes a string
+ * table would save (see +duplicate_string_bytes+ on the Response).
+ *
+ * Every trace chunk records the distinct strings of its spans while they are
+ * converted, which may be long before the send (see TraceChunk).  Pushing the
+ * chunk into a payload then merges them into the payload's own table, so that
+ * strings repeated across the chunks of a payload are counted too.
+ *
+ * The tables keep a copy of every distinct string and compare contents, so a
+ * hash collision is never counted as a repeat.  They use malloc rather than
+ * Ruby's allocator, so recording a string never runs GC, which could move
+ * strings whose pointers were already borrowed.  A string that cannot be
+ * recorded for lack of memory is simply not counted.
+ * ======================================================================== */
+
+#define STRING_TABLE_INITIAL_CAPACITY 64
+#define STRING_TABLE_INITIAL_BYTES    1024
+
+/* Frees the strings of the table, but keeps counting its +duplicate_bytes+ */
+static void string_table_free(string_table_t *strings) {
+  free(strings->slots);
+  free(strings->bytes);
+  *strings = (string_table_t){.duplicate_bytes = strings->duplicate_bytes};
+}
+
+static void string_table_clear(string_table_t *strings) {
+  if (strings->slots != NULL) {
+    memset(strings->slots, 0, strings->capacity * sizeof(string_table_slot));
+  }
+  strings->count = 0;
+  strings->bytes_len = 0;
+  strings->duplicate_bytes = 0;
+}
+
+static size_t string_table_memsize(const string_table_t *strings) {
+  return strings->capacity * sizeof(string_table_slot) + strings->bytes_capacity;
+}
+
+/* Returns the slot holding +ptr+, or the empty slot where it goes. */
+static string_table_slot *string_table_find(const string_table_t *strings, st_index_t hash,
+                                            const char *ptr, size_t len) {
+  size_t mask = strings->capacity - 1;
+  for (size_t i = hash & mask;; i = (i + 1) & mask) {
+    string_table_slot *slot = &strings->slots[i];
+    if (slot->len == 0) return slot;
+    if (slot->hash == hash && slot->len == len &&
+        memcmp(strings->bytes + slot->offset, ptr, len) == 0) {
+      return slot;
+    }
+  }
+}
+
+/* Makes room for one more string of +len+ bytes.  Returns false when out of
+ * memory, leaving the table as it was. */
+static bool string_table_reserve(string_table_t *strings, size_t len) {
+  if (strings->bytes_capacity - strings->bytes_len < len) {
+    size_t bytes_capacity = strings->bytes_capacity == 0 ? STRING_TABLE_INITIAL_BYTES : strings->bytes_capacity * 2;
+    while (bytes_capacity - strings->bytes_len < len) bytes_capacity *= 2;
+    char *bytes = realloc(strings->bytes, bytes_capacity);
+    if (bytes == NULL) return false;
+    strings->bytes = bytes;
+    strings->bytes_capacity = bytes_capacity;
+  }
+
+  /* Keep the load factor at most 3/4 */
+  if ((strings->count + 1) * 4 > strings->capacity * 3) {
+    size_t capacity = strings->capacity == 0 ? STRING_TABLE_INITIAL_CAPACITY : strings->capacity * 2;
+    string_table_slot *slots = calloc(capacity, sizeof(string_table_slot));
+    if (slots == NULL) return false;
+    size_t mask = capacity - 1;
+    for (size_t i = 0; i < strings->capacity; i++) {
+      const string_table_slot *slot = &strings->slots[i];
+      if (slot->len == 0) continue;
+      size_t j = slot->hash & mask;
+      while (slots[j].len != 0) j = (j + 1) & mask;
+      slots[j] = *slot;
+    }
+    free(strings->slots);
+    strings->slots = slots;
+    strings->capacity = capacity;
+  }
+  return true;
+}
+
+/* Adds a string to the table, or counts it as a duplicate if already there. */
+static void string_table_add(string_table_t *strings, st_index_t hash,
+                             const char *ptr, size_t len) {
+  if (!string_table_reserve(strings, len)) return;
+
+  string_table_slot *slot = string_table_find(strings, hash, ptr, len);
+  if (slot->len != 0) {
+    strings->duplicate_bytes += len;
+    return;
+  }
+  memcpy(strings->bytes + strings->bytes_len, ptr, len);
+  *slot = (string_table_slot){.hash = hash, .offset = strings->bytes_len, .len = len};
+  strings->bytes_len += len;
+  strings->count++;
+}
+
+/* Records a String being added to a span.  Does not call Ruby code. */
+static void string_table_record(string_table_t *strings, VALUE str) {
+  if (strings == NULL || RSTRING_LEN(str) == 0) return;
+
+  const char *ptr = RSTRING_PTR(str);
+  size_t len = (size_t)RSTRING_LEN(str);
+  string_table_add(strings, st_hash(ptr, len, 0), ptr, len);
+}
+
+/* Adds the strings of +from+ into +into+, counting those it already had. */
+static void string_table_merge(string_table_t *into, const string_table_t *from) {
+  into->duplicate_bytes += from->duplicate_bytes;
+  for (size_t i = 0; i < from->capacity; i++) {
+    const string_table_slot *slot = &from->slots[i];
+    if (slot->len == 0) continue;
+    string_table_add(into, slot->hash, from->bytes + slot->offset, slot->len);
+  }
+}
+
+/* ========================================================================
+ * Span meta / metrics
+ *
+ * The FFI sets meta and metrics one entry at a time.  Rather than calling it
+ * from the hash iteration callback, each hash is walked collecting borrowed
+ * (ptr, len) slices of its keys and values into a stack-allocated batch,
+ * which is then handed to libdatadog in one tight loop (flush_tag_batch, the
+ * single place that would switch to a bulk setter once the FFI offers one).
+ * This keeps the per-entry callback down to a couple of type checks, and
+ * most spans fit in a single batch.
+ *
+ * Collecting does not call Ruby code, nor allocate with Ruby's allocator,
+ * while slices are pending (see the Bignum case in metrics_iter_cb and
+ * "Repeated strings"), so no GC can move the strings before the batch is
+ * flushed.  libdatadog copies the slices before each call returns.
  *
  * The libdatadog setters return owned errors rather than raising. Stash the
- * first error in a context struct and stop iteration with ST_STOP so the
- * caller can free the still-unowned Rust span before turning the error into
- * a Ruby exception. (This is about span ownership, not hash iteration: MRI
- * restores rb_hash_foreach's iteration state via rb_ensure if a callback
- * exits non-locally.)
+ * first error in the batch and stop iteration with ST_STOP so the caller can
+ * free the still-unowned Rust span before turning the error into a Ruby
+ * exception. (This is about span ownership, not hash iteration: MRI restores
+ * rb_hash_foreach's iteration state via rb_ensure if a callback exits
+ * non-locally.)
  * ======================================================================== */
 
+#define TAG_BATCH_CAPACITY 64
+
+typedef struct {
+  ddog_CharSlice key;
+  ddog_CharSlice value;   /* meta only */
+  double         number;  /* metrics only */
+} tag_batch_entry;
+
 typedef struct {
-  ddog_TracerSpan        *span;
-  ddog_TraceExporterError *error;  /* first error, if any */
-  long                    skipped; /* entries skipped due to wrong type */
-} hash_iter_ctx;
+  ddog_TracerSpan         *span;
+  bool                     metrics;  /* entries are metrics rather than meta */
+  long                     len;
+  ddog_TraceExporterError *error;    /* first error, if any */
+  long                     skipped;  /* entries skipped due to wrong type */
+  size_t                   encoded_bytes;  /* of the entries collected so far */
+  string_table_t          *strings;  /* may be NULL */
+  tag_batch_entry          entries[TAG_BATCH_CAPACITY];
+} tag_batch;
+
+/* Sets the collected entries on the span.  Returns false on error. */
+static bool flush_tag_batch(tag_batch *batch) {
+  long len = batch->len;
+  batch->len = 0;
+
+  for (long i = 0; i < len; i++) {
+    const tag_batch_entry *entry = &batch->entries[i];
+    ddog_TraceExporterError *err = batch->metrics
+        ? ddog_tracer_span_set_metric(batch->span, entry->key, entry->number)
+        : ddog_tracer_span_set_meta(batch->span, entry->key, entry->value);
+    if (err != NULL) {
+      batch->error = err;
+      return false;
+    }
+  }
+  return true;
+}
 
 static int meta_iter_cb(VALUE key, VALUE value, VALUE arg) {
-  hash_iter_ctx *ctx = (hash_iter_ctx *)arg;
+  tag_batch *batch = (tag_batch *)arg;
 
   /*
    * The types are checked below, so build the ddog_CharSlice directly instead
    * of repeating char_slice_from_ruby_string()'s ENFORCE_TYPE check.
-   * libdatadog copies both slices before the FFI call returns and retains no
-   * pointer into the Ruby-owned string storage.
    */
   if (!RB_TYPE_P(key, T_STRING) || !RB_TYPE_P(value, T_STRING)) {
-    ctx->skipped++;
+    batch->skipped++;
     return ST_CONTINUE;
   }
 
-  ddog_CharSlice ks = {.ptr = RSTRING_PTR(key),   .len = RSTRING_LEN(key)};
-  ddog_CharSlice vs = {.ptr = RSTRING_PTR(value), .len = RSTRING_LEN(value)};
+  batch->encoded_bytes += encoded_string_bytes(key) + encoded_string_bytes(value);
+  string_table_record(batch->strings, key);
+  string_table_record(batch->strings, value);
 
-  ddog_TraceExporterError *err = ddog_tracer_span_set_meta(ctx->span, ks, vs);
-  if (err != NULL) {
-    ctx->error = err;
-    return ST_STOP;
-  }
+  batch->entries[batch->len++] = (tag_batch_entry){
+    .key   = {.ptr = RSTRING_PTR(key),   .len = RSTRING_LEN(key)},
+    .value = {.ptr = RSTRING_PTR(value), .len = RSTRING_LEN(value)},
+  };
+  if (batch->len == TAG_BATCH_CAPACITY && !flush_tag_batch(batch)) return ST_STOP;
 
   return ST_CONTINUE;
 }
 
 static int metrics_iter_cb(VALUE key, VALUE value, VALUE arg) {
-  hash_iter_ctx *ctx = (hash_iter_ctx *)arg;
+  tag_batch *batch = (tag_batch *)arg;
 
-  if (!RB_TYPE_P(key, T_STRING) ||
-      (!RB_TYPE_P(value, T_FLOAT) && !RB_TYPE_P(value, T_FIXNUM) &&
-       !RB_TYPE_P(value, T_BIGNUM))) {
-    ctx->skipped++;
+  double number;
+  if (!RB_TYPE_P(key, T_STRING)) {
+    batch->skipped++;
     return ST_CONTINUE;
   }
+  /* Same conversions as NUM2DBL, which cannot raise for these types */
+  if (RB_FLOAT_TYPE_P(value)) {
+    number = RFLOAT_VALUE(value);
+  } else if (FIXNUM_P(value)) {
+    number = (double)FIX2LONG(value);
+  } else if (RB_TYPE_P(value, T_BIGNUM)) {
+    /* rb_big2dbl may call Warning.warn, so don't hold borrowed slices */
+    if (!flush_tag_batch(batch)) return ST_STOP;
+    number = rb_big2dbl(value);
+  } else {
+    batch->skipped++;
+    return ST_CONTINUE;
+  }
+
+  batch->encoded_bytes += encoded_string_bytes(key) + NUMBER_ENCODED_BYTES;
+  string_table_record(batch->strings, key);
 
   /* See meta_iter_cb: the key type is checked above, so build the slice
    * directly. */
-  ddog_CharSlice ks = {.ptr = RSTRING_PTR(key), .len = RSTRING_LEN(key)};
-
-  ddog_TraceExporterError *err =
-      ddog_tracer_span_set_metric(ctx->span, ks, NUM2DBL(value));
-  if (err != NULL) {
-    ctx->error = err;
-    return ST_STOP;
-  }
+  batch->entries[batch->len++] = (tag_batch_entry){
+    .key    = {.ptr = RSTRING_PTR(key), .len = RSTRING_LEN(key)},
+    .number = number,
+  };
+  if (batch->len == TAG_BATCH_CAPACITY && !flush_tag_batch(batch)) return ST_STOP;
 
   return ST_CONTINUE;
 }
 
+/* Sets every entry of the +hash+ (meta or metrics) on the span in +batch+. */
+static void set_span_tags(tag_batch *batch, VALUE hash, bool metrics) {
+  batch->metrics = metrics;
+  batch->len = 0;
+  batch->skipped = 0;
+
+  rb_hash_foreach(hash, metrics ? metrics_iter_cb : meta_iter_cb, (VALUE)batch);
+  if (batch->error == NULL) flush_tag_batch(batch);
+
+  ddog_TraceExporterError *err = batch->error;
+  batch->error = NULL;
+  check_exporter_error(metrics ? "Failed to set span metric" : "Failed to set span meta", err);
+
+  if (batch->skipped > 0) {
+    log_warning(rb_sprintf(
+        metrics ? "Native trace exporter: skipped %ld non-numeric metrics entries"
+                : "Native trace exporter: skipped %ld non-string meta entries",
+        batch->skipped));
+  }
+}
+
 typedef struct {
   ddog_TracerValueToken *tokens;
   size_t len;
@@ -333,6 +700,7 @@ typedef struct {
   uint8_t **scratch;
   size_t scratch_len;
   size_t scratch_capacity;
+  size_t scratch_bytes;  /* total length of the copied strings */
 } structured_value_ctx;
 
 static ddog_TracerValueToken *append_structured_value_token(
@@ -367,6 +735,7 @@ static const uint8_t *copy_structured_value_bytes(
 
   uint8_t *copy = ruby_xmalloc(len);
   ctx->scratch[ctx->scratch_len++] = copy;
+  ctx->scratch_bytes += len;
   /* ruby_xmalloc may trigger GC, so retrieve the Ruby buffer only after it
    * returns and do not call Ruby again before the copy completes. */
   memcpy(copy, RSTRING_PTR(string), len);
@@ -631,6 +1000,445 @@ static void set_prepared_metastruct(
   }
   free_prepared_metastruct(prepared);
 }
+/* ========================================================================
+ * Span events and span links
+ *
+ * The FFI has no setter for the top-level span_events / span_links fields,
+ * so both are sent as JSON-encoded meta tags, which every agent version
+ * understands: "events" (what the Ruby transport falls back to for agents
+ * without native span events support) and "_dd.span_links".
+ *
+ * The JSON is written here directly from the SpanEvent / SpanLink ivars,
+ * matching SpanEvent#to_hash / SpanLink#to_hash, instead of building those
+ * Hashes and calling #to_json on them.  These helpers may call Ruby (e.g.
+ * Integer#to_s), so they run before the Rust span is allocated.
+ * ======================================================================== */
+
+#define SPAN_JSON_MAX_DEPTH 64
+#define JSON_CAT(buf, literal) rb_str_buf_cat(buf, "" literal, sizeof(literal) - 1)
+
+static void json_append_string(VALUE buf, VALUE str) {
+  str = rb_str_export_to_enc(str, rb_utf8_encoding());
+  if (rb_enc_str_coderange(str) == ENC_CODERANGE_BROKEN) {
+    str = rb_str_scrub(str, Qnil);
+  }
+
+  JSON_CAT(buf, "\"");
+  long len = RSTRING_LEN(str);
+  long run_start = 0;
+  for (long i = 0; i < len; i++) {
+    unsigned char c = (unsigned char)RSTRING_PTR(str)[i];
+    if (c >= 0x20 && c != '"' && c != '\\') continue;
+
+    /* Re-read the pointer: appending to buf may run GC */
+    rb_str_buf_cat(buf, RSTRING_PTR(str) + run_start, i - run_start);
+    char escaped[7];
+    switch (c) {
+      case '"':  JSON_CAT(buf, "\\\""); break;
+      case '\\': JSON_CAT(buf, "\\\\"); break;
+      case '\n': JSON_CAT(buf, "\\n"); break;
+      case '\r': JSON_CAT(buf, "\\r"); break;
+      case '\t': JSON_CAT(buf, "\\t"); break;
+      default:
+        snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+        rb_str_buf_cat(buf, escaped, 6);
+    }
+    run_start = i + 1;
+  }
+  rb_str_buf_cat(buf, RSTRING_PTR(str) + run_start, len - run_start);
+  JSON_CAT(buf, "\"");
+}
+
+static void json_append_u64(VALUE buf, uint64_t value) {
+  char digits[21];
+  int len = snprintf(digits, sizeof(digits), "%" PRIu64, value);
+  rb_str_buf_cat(buf, digits, len);
+}
+
+static void json_append_value(VALUE buf, VALUE value, unsigned int depth);
+
+typedef struct {
+  VALUE buf;
+  unsigned int depth;
+  bool first;
+} json_hash_ctx;
+
+static int json_append_hash_entry(VALUE key, VALUE value, VALUE arg) {
+  json_hash_ctx *ctx = (json_hash_ctx *)arg;
+  if (!ctx->first) JSON_CAT(ctx->buf, ",");
+  ctx->first = false;
+
+  json_append_string(ctx->buf, rb_obj_as_string(key));
+  JSON_CAT(ctx->buf, ":");
+  json_append_value(ctx->buf, value, ctx->depth);
+  return ST_CONTINUE;
+}
+
+static void json_append_value(VALUE buf, VALUE value, unsigned int depth) {
+  if (depth >= SPAN_JSON_MAX_DEPTH) {
+    rb_raise(rb_eArgError, "span event value exceeds maximum depth of %d", SPAN_JSON_MAX_DEPTH);
+  }
+
+  if (value == Qnil) {
+    JSON_CAT(buf, "null");
+  } else if (value == Qtrue) {
+    JSON_CAT(buf, "true");
+  } else if (value == Qfalse) {
+    JSON_CAT(buf, "false");
+  } else if (RB_INTEGER_TYPE_P(value)) {
+    rb_str_buf_append(buf, rb_obj_as_string(value));
+  } else if (RB_FLOAT_TYPE_P(value)) {
+    /* SpanEvent rejects non-finite attributes; JSON has no literal for them */
+    if (isfinite(RFLOAT_VALUE(value))) {
+      rb_str_buf_append(buf, rb_obj_as_string(value));
+    } else {
+      JSON_CAT(buf, "null");
+    }
+  } else if (RB_TYPE_P(value, T_ARRAY)) {
+    JSON_CAT(buf, "[");
+    for (long i = 0; i < RARRAY_LEN(value); i++) {
+      if (i > 0) JSON_CAT(buf, ",");
+      json_append_value(buf, rb_ary_entry(value, i), depth + 1);
+    }
+    JSON_CAT(buf, "]");
+  } else if (RB_TYPE_P(value, T_HASH)) {
+    json_hash_ctx ctx = {.buf = buf, .depth = depth + 1, .first = true};
+    JSON_CAT(buf, "{");
+    rb_hash_foreach(value, json_append_hash_entry, (VALUE)&ctx);
+    JSON_CAT(buf, "}");
+  } else {
+    /* Strings, and Symbols or other objects the way #to_json renders them */
+    json_append_string(buf, rb_obj_as_string(value));
+  }
+}
+
+static VALUE new_json_buffer(void) {
+  VALUE buf = rb_str_buf_new(256);
+  rb_enc_associate_index(buf, rb_utf8_encindex());
+  return buf;
+}
+
+/* Span#events -> JSON array of SpanEvent#to_hash, or nil when there are none */
+static VALUE span_events_json(VALUE span) {
+  VALUE events = rb_ivar_get(span, at_events_id);
+  if (!RB_TYPE_P(events, T_ARRAY) || RARRAY_LEN(events) == 0) return Qnil;
+
+  VALUE buf = new_json_buffer();
+  JSON_CAT(buf, "[");
+  for (long i = 0; i < RARRAY_LEN(events); i++) {
+    VALUE event = rb_ary_entry(events, i);
+    if (i > 0) JSON_CAT(buf, ",");
+
+    JSON_CAT(buf, "{\"name\":");
+    json_append_value(buf, rb_ivar_get(event, at_name_id), 0);
+    JSON_CAT(buf, ",\"time_unix_nano\":");
+    json_append_value(buf, rb_ivar_get(event, at_time_unix_nano_id), 0);
+
+    VALUE attributes = rb_ivar_get(event, at_attributes_id);
+    if (RB_TYPE_P(attributes, T_HASH) && RHASH_SIZE(attributes) > 0) {
+      JSON_CAT(buf, ",\"attributes\":");
+      json_append_value(buf, attributes, 0);
+    }
+    JSON_CAT(buf, "}");
+  }
+  JSON_CAT(buf, "]");
+  return buf;
+}
+
+typedef struct {
+  VALUE buf;
+  bool first;
+} json_link_attributes_ctx;
+
+/* Same flattening as Tracing::Utils.serialize_attribute: array elements get
+ * their index appended to the key, and every value is sent as a String. */
+static void json_append_link_attribute(
+    json_link_attributes_ctx *ctx, VALUE key, VALUE value, unsigned int depth) {
+  if (RB_TYPE_P(value, T_ARRAY)) {
+    if (depth >= SPAN_JSON_MAX_DEPTH) {
+      rb_raise(rb_eArgError, "span link attribute exceeds maximum depth of %d", SPAN_JSON_MAX_DEPTH);
+    }
+    for (long i = 0; i < RARRAY_LEN(value); i++) {
+      VALUE indexed_key = rb_sprintf("%"PRIsVALUE".%ld", key, i);
+      json_append_link_attribute(ctx, indexed_key, rb_ary_entry(value, i), depth + 1);
+    }
+    return;
+  }
+
+  if (!ctx->first) JSON_CAT(ctx->buf, ",");
+  ctx->first = false;
+  json_append_string(ctx->buf, rb_obj_as_string(key));
+  JSON_CAT(ctx->buf, ":");
+  json_append_string(ctx->buf, rb_obj_as_string(value));
+}
+
+static int json_append_link_attribute_entry(VALUE key, VALUE value, VALUE arg) {
+  json_append_link_attribute((json_link_attributes_ctx *)arg, key, value, 0);
+  return ST_CONTINUE;
+}
+
+/* Span#links -> JSON array of SpanLink#to_hash, or nil when there are none */
+static VALUE span_links_json(VALUE span) {
+  VALUE links = rb_ivar_get(span, at_links_id);
+  if (!RB_TYPE_P(links, T_ARRAY) || RARRAY_LEN(links) == 0) return Qnil;
+
+  VALUE buf = new_json_buffer();
+  JSON_CAT(buf, "[");
+  for (long i = 0; i < RARRAY_LEN(links); i++) {
+    VALUE link = rb_ary_entry(links, i);
+    if (i > 0) JSON_CAT(buf, ",");
+
+    VALUE rb_span_id = rb_ivar_get(link, at_span_id_id);
+    VALUE rb_trace_id = rb_ivar_get(link, at_trace_id_id);
+    trace_id_t trace_id = rb_trace_id == Qnil ? (trace_id_t){0} : split_trace_id(rb_trace_id);
+
+    JSON_CAT(buf, "{\"span_id\":");
+    json_append_u64(buf, rb_span_id == Qnil ? 0 : NUM2ULL(rb_span_id));
+    JSON_CAT(buf, ",\"trace_id\":");
+    json_append_u64(buf, trace_id.low);
+    if (trace_id.high != 0) {
+      JSON_CAT(buf, ",\"trace_id_high\":");
+      json_append_u64(buf, trace_id.high);
+    }
+
+    VALUE attributes = rb_ivar_get(link, at_attributes_id);
+    if (RB_TYPE_P(attributes, T_HASH) && RHASH_SIZE(attributes) > 0) {
+      json_link_attributes_ctx ctx = {.buf = buf, .first = true};
+      JSON_CAT(buf, ",\"attributes\":{");
+      rb_hash_foreach(attributes, json_append_link_attribute_entry, (VALUE)&ctx);
+      JSON_CAT(buf, "}");
+    }
+
+    VALUE dropped = rb_ivar_get(link, at_dropped_attributes_id);
+    if (RB_INTEGER_TYPE_P(dropped) && NUM2LL(dropped) > 0) {
+      JSON_CAT(buf, ",\"dropped_attributes_count\":");
+      json_append_value(buf, dropped, 0);
+    }
+
+    VALUE trace_state = rb_ivar_get(link, at_trace_state_id);
+    if (trace_state != Qnil) {
+      JSON_CAT(buf, ",\"tracestate\":");
+      json_append_string(buf, rb_obj_as_string(trace_state));
+    }
+
+    /* When set, the high bit distinguishes "not sampled" from "not set" */
+    VALUE trace_flags = rb_ivar_get(link, at_trace_flags_id);
+    JSON_CAT(buf, ",\"flags\":");
+    json_append_u64(buf, trace_flags == Qnil ? 0 : ((uint64_t)NUM2UINT(trace_flags) | (1ULL << 31)));
+    JSON_CAT(buf, "}");
+  }
+  JSON_CAT(buf, "]");
+  return buf;
+}
+
+static void set_span_json_meta(ddog_TracerSpan *span, ddog_CharSlice key, VALUE json) {
+  if (json == Qnil) return;
+
+  ddog_CharSlice value = {.ptr = RSTRING_PTR(json), .len = RSTRING_LEN(json)};
+  check_exporter_error("Failed to set span meta",
+                       ddog_tracer_span_set_meta(span, key, value));
+}
+
+/* ========================================================================
+ * Trace-level tags
+ *
+ * The HTTP transport runs TraceFormatter#format! on every trace, which copies
+ * the trace-level values of the TraceSegment (sampling decision and rates,
+ * origin, runtime id, ...) into the tags of its root span, and a few
+ * process-wide tags (git metadata, process tags) into its first span.  When
+ * converting a TraceSegment, the native exporter sets the same tags directly
+ * on the Rust spans instead, reading the TraceSegment ivars and using the
+ * process-wide tags given once to _native_exporter_new.  The Ruby spans are
+ * left untouched.
+ *
+ * Unlike Metadata::Tagging#set_tag, setting a meta tag does not remove a
+ * metric of the same name from the span (nor the other way around), as the
+ * FFI cannot remove entries.
+ * ======================================================================== */
+
+struct trace_tags {
+  VALUE trace;            /* TraceSegment */
+  VALUE root_span;        /* receives the trace-level tags */
+  bool  partial;          /* root span not found, root_span is the last span */
+  VALUE first_span;       /* receives first_span_tags */
+  VALUE first_span_tags;  /* Hash[String, String], or Qnil */
+};
+
+/* See Metadata::Tagging::NUMERIC_TAG_SIZE_RANGE */
+#define NUMERIC_TAG_MAX (1LL << 53)
+
+#define SLICE_EQUALS(slice, literal) \
+  ((slice).len == sizeof(literal) - 1 && memcmp((slice).ptr, "" literal, sizeof(literal) - 1) == 0)
+
+/* Tags always sent as meta (see Metadata::Tagging::ENSURE_AGENT_TAGS) */
+static bool is_agent_meta_tag(ddog_CharSlice key) {
+  return SLICE_EQUALS(key, "_dd.origin") || SLICE_EQUALS(key, "version") ||
+         SLICE_EQUALS(key, "http.status_code") || SLICE_EQUALS(key, "_dd.hostname");
+}
+
+/*
+ * Returns +value+ as Metadata::Tagging#set_tag stores it: numbers are kept as
+ * metrics, except for integers outside of NUMERIC_TAG_MAX and agent meta
+ * tags, and anything else becomes a String.  May call Ruby code.
+ */
+static VALUE tag_value(VALUE value, bool agent_meta_tag) {
+  if (!agent_meta_tag) {
+    if (RB_FLOAT_TYPE_P(value)) return value;
+    if (FIXNUM_P(value)) {
+      long long number = FIX2LONG(value);
+      if (number >= -NUMERIC_TAG_MAX && number <= NUMERIC_TAG_MAX) return value;
+    }
+  }
+  return RB_TYPE_P(value, T_STRING) ? value : rb_obj_as_string(value);
+}
+
+/* Sets a value returned by tag_value as a meta or metric of +span+. */
+static void set_span_tag_value(ddog_TracerSpan *span, ddog_CharSlice key, VALUE value) {
+  ddog_TraceExporterError *err;
+  if (RB_TYPE_P(value, T_STRING)) {
+    ddog_CharSlice vs = {.ptr = RSTRING_PTR(value), .len = RSTRING_LEN(value)};
+    err = ddog_tracer_span_set_meta(span, key, vs);
+  } else {
+    err = ddog_tracer_span_set_metric(span, key, NUM2DBL(value));
+  }
+  check_exporter_error("Failed to set span tag", err);
+}
+
+/* Metadata::Tagging#set_tag, for a +key+ that does not point into a Ruby string */
+static void set_span_tag(ddog_TracerSpan *span, ddog_CharSlice key, VALUE value) {
+  VALUE stored = tag_value(value, is_agent_meta_tag(key));
+  set_span_tag_value(span, key, stored);
+  RB_GC_GUARD(stored);
+}
+
+static void set_span_metric(ddog_TracerSpan *span, ddog_CharSlice key, double value) {
+  check_exporter_error("Failed to set span metric",
+                       ddog_tracer_span_set_metric(span, key, value));
+}
+
+static int tag_iter_cb(VALUE key, VALUE value, VALUE arg) {
+  ddog_TracerSpan *span = (ddog_TracerSpan *)arg;
+  if (!RB_TYPE_P(key, T_STRING)) return ST_CONTINUE;
+
+  ddog_CharSlice ks = {.ptr = RSTRING_PTR(key), .len = RSTRING_LEN(key)};
+  VALUE stored = tag_value(value, is_agent_meta_tag(ks));
+  /* tag_value may have called Ruby code, so borrow the key again */
+  ks = (ddog_CharSlice){.ptr = RSTRING_PTR(key), .len = RSTRING_LEN(key)};
+  set_span_tag_value(span, ks, stored);
+  RB_GC_GUARD(stored);
+  return ST_CONTINUE;
+}
+
+/* TraceFormatter#tag_knuth_sampling_rate!: the rate with at most 6 decimals */
+static void set_knuth_sampling_rate(ddog_TracerSpan *span, VALUE rate) {
+  char buf[64];
+  int len = snprintf(buf, sizeof(buf), "%.6f", round(NUM2DBL(rate) * 1e6) / 1e6);
+  if (len <= 0 || (size_t)len >= sizeof(buf)) return;
+
+  while (buf[len - 1] == '0') len--;
+  if (buf[len - 1] == '.') len--;
+
+  ddog_CharSlice value = {.ptr = buf, .len = (uintptr_t)len};
+  check_exporter_error("Failed to set span meta",
+                       ddog_tracer_span_set_meta(span, DDOG_CHARSLICE_C("_dd.p.ksr"), value));
+}
+
+/* TraceFormatter#tag_high_order_trace_id! */
+static void set_high_order_trace_id(ddog_TracerSpan *span, VALUE trace_id) {
+  if (!RB_INTEGER_TYPE_P(trace_id)) return;
+
+  uint64_t high = split_trace_id(trace_id).high;
+  if (high == 0) return;
+
+  char buf[17];
+  snprintf(buf, sizeof(buf), "%016" PRIx64, high);
+  ddog_CharSlice value = {.ptr = buf, .len = 16};
+  check_exporter_error("Failed to set span meta",
+                       ddog_tracer_span_set_meta(span, DDOG_CHARSLICE_C("_dd.p.tid"), value));
+}
+
+/*
+ * Finds the root span of +trace+ the same way TraceFormatter does, and
+ * returns the spans to convert.
+ */
+static VALUE init_trace_tags(trace_tags_t *tags, VALUE trace, VALUE first_span_tags) {
+  VALUE spans = rb_ivar_get(trace, at_spans_id);
+  ENFORCE_TYPE(spans, T_ARRAY);
+
+  long span_count = RARRAY_LEN(spans);
+  VALUE root_span_id = rb_ivar_get(trace, at_root_span_id_id);
+  VALUE root_span = Qnil;
+  if (root_span_id != Qnil) {
+    for (long i = 0; i < span_count && i < RARRAY_LEN(spans); i++) {
+      VALUE span = rb_ary_entry(spans, i);
+      if (rb_equal(rb_ivar_get(span, at_id_id), root_span_id)) {
+        root_span = span;
+        break;
+      }
+    }
+  }
+
+  *tags = (trace_tags_t){
+    .trace           = trace,
+    .root_span       = root_span != Qnil ? root_span : rb_ary_entry(spans, -1),
+    .partial         = root_span == Qnil,
+    .first_span      = rb_ary_entry(spans, 0),
+    .first_span_tags = first_span_tags,
+  };
+  return spans;
+}
+
+/* Applies TraceFormatter#format! to the Rust span converted from +span+. */
+static void set_trace_tags(VALUE span, ddog_TracerSpan *rust_span, const trace_tags_t *tags) {
+  VALUE trace = tags->trace;
+
+  if (span == tags->root_span) {
+    if (!tags->partial) {
+      VALUE meta = rb_ivar_get(trace, at_meta_id);
+      VALUE metrics = rb_ivar_get(trace, at_metrics_id);
+      if (RB_TYPE_P(meta, T_HASH)) rb_hash_foreach(meta, tag_iter_cb, (VALUE)rust_span);
+      if (RB_TYPE_P(metrics, T_HASH)) rb_hash_foreach(metrics, tag_iter_cb, (VALUE)rust_span);
+    }
+
+    VALUE agent_sample_rate = rb_ivar_get(trace, at_agent_sample_rate_id);
+    VALUE rule_sample_rate  = rb_ivar_get(trace, at_rule_sample_rate_id);
+    VALUE value;
+
+    if (RTEST(agent_sample_rate)) set_span_tag(rust_span, DDOG_CHARSLICE_C("_dd.agent_psr"), agent_sample_rate);
+    if (RTEST(value = rb_ivar_get(trace, at_hostname_id))) set_span_tag(rust_span, DDOG_CHARSLICE_C("_dd.hostname"), value);
+    if (RTEST(rule_sample_rate)) {
+      set_knuth_sampling_rate(rust_span, rule_sample_rate);
+    } else if (RTEST(agent_sample_rate)) {
+      set_knuth_sampling_rate(rust_span, agent_sample_rate);
+    }
+    if ((value = rb_ivar_get(trace, at_lang_id)) != Qnil) set_span_tag(rust_span, DDOG_CHARSLICE_C("language"), value);
+    if (RTEST(value = rb_ivar_get(trace, at_origin_id))) set_span_tag(rust_span, DDOG_CHARSLICE_C("_dd.origin"), value);
+    if (RTEST(value = rb_ivar_get(trace, at_process_id_id))) set_span_tag(rust_span, DDOG_CHARSLICE_C("process_id"), value);
+    if (RTEST(rule_sample_rate)) set_span_tag(rust_span, DDOG_CHARSLICE_C("_dd.rule_psr"), rule_sample_rate);
+    if (RTEST(value = rb_ivar_get(trace, at_runtime_id_id))) set_span_tag(rust_span, DDOG_CHARSLICE_C("runtime-id"), value);
+    if (RTEST(value = rb_ivar_get(trace, at_rate_limiter_rate_id))) set_span_tag(rust_span, DDOG_CHARSLICE_C("_dd.limit_psr"), value);
+    if (RTEST(value = rb_ivar_get(trace, at_sample_rate_id))) set_span_tag(rust_span, DDOG_CHARSLICE_C("_sample_rate"), value);
+    if (RTEST(value = rb_ivar_get(trace, at_sampling_decision_maker_id))) set_span_tag(rust_span, DDOG_CHARSLICE_C("_dd.p.dm"), value);
+    set_high_order_trace_id(rust_span, rb_ivar_get(trace, at_id_id));
+    /* Metadata::Tagging#set_metric skips values that Float() rejects */
+    value = rb_ivar_get(trace, at_sampling_priority_id);
+    if (RB_FLOAT_TYPE_P(value) || RB_INTEGER_TYPE_P(value)) {
+      set_span_metric(rust_span, DDOG_CHARSLICE_C("_sampling_priority_v1"), NUM2DBL(value));
+    }
+    if ((value = rb_ivar_get(trace, at_profiling_enabled_id)) != Qnil) {
+      set_span_metric(rust_span, DDOG_CHARSLICE_C("_dd.profiling.enabled"), RTEST(value) ? 1 : 0);
+    }
+  }
+
+  if (!RTEST(rb_ivar_get(trace, at_apm_tracing_enabled_id))) {
+    set_span_metric(rust_span, DDOG_CHARSLICE_C("_dd.apm.enabled"), 0);
+  }
+
+  if (span == tags->first_span && tags->first_span_tags != Qnil) {
+    rb_hash_foreach(tags->first_span_tags, tag_iter_cb, (VALUE)rust_span);
+  }
+}
+
 /* ========================================================================
  * Internal: convert a Ruby Span into a raw_span_owner
  *
@@ -638,7 +1446,9 @@ static void set_prepared_metastruct(
  * in TypedData or consumed by a trace chunk.
  * ======================================================================== */
 
-static void convert_ruby_span_to_rust(VALUE span, raw_span_owner *owner) {
+static size_t convert_ruby_span_to_rust(VALUE span, raw_span_owner *owner,
+                                        const trace_tags_t *tags,
+                                        string_table_t *strings) {
   /* 1. Read Ruby ivars */
   VALUE rb_name      = rb_ivar_get(span, at_name_id);
   VALUE rb_service   = rb_ivar_get(span, at_service_id);
@@ -649,6 +1459,12 @@ static void convert_ruby_span_to_rust(VALUE span, raw_span_owner *owner) {
   VALUE rb_trace_id  = rb_ivar_get(span, at_trace_id_id);
   VALUE rb_status    = rb_ivar_get(span, at_status_id);
 
+  /* TraceFormatter#set_resource! */
+  if (tags != NULL && span == tags->root_span && !tags->partial) {
+    VALUE rb_trace_resource = rb_ivar_get(tags->trace, at_resource_id);
+    if (rb_trace_resource != Qnil) rb_resource = rb_trace_resource;
+  }
+
   ENFORCE_TYPE(rb_name, T_STRING);
   if (rb_service != Qnil) ENFORCE_TYPE(rb_service, T_STRING);
   if (rb_resource != Qnil) ENFORCE_TYPE(rb_resource, T_STRING);
@@ -680,9 +1496,33 @@ static void convert_ruby_span_to_rust(VALUE span, raw_span_owner *owner) {
 
   /* Structured-value normalisation can call Ruby code. Snapshot it before
    * borrowing scalar string pointers or allocating the Rust span. */
+  VALUE rb_events_json = span_events_json(span);
+  VALUE rb_links_json = span_links_json(span);
+
   prepared_metastruct metastruct = {0};
   prepare_metastruct(span, &metastruct);
 
+
+  size_t encoded_bytes = SPAN_ENCODED_OVERHEAD + encoded_string_bytes(rb_name);
+  if (rb_service != Qnil) encoded_bytes += encoded_string_bytes(rb_service);
+  if (rb_resource != Qnil) encoded_bytes += encoded_string_bytes(rb_resource);
+  if (rb_type != Qnil) encoded_bytes += encoded_string_bytes(rb_type);
+  if (rb_events_json != Qnil) encoded_bytes += encoded_string_bytes(rb_events_json);
+  if (rb_links_json != Qnil) encoded_bytes += encoded_string_bytes(rb_links_json);
+  for (size_t i = 0; i < metastruct.len; i++) {
+    /* The scratch bytes include the key */
+    const structured_value_ctx *value = &metastruct.entries[i].value;
+    encoded_bytes += value->scratch_bytes + (value->len + 1) * NUMBER_ENCODED_BYTES;
+  }
+  if (tags != NULL && (span == tags->root_span || span == tags->first_span)) {
+    encoded_bytes += TRACE_TAGS_ENCODED_BYTES;
+  }
+
+  string_table_record(strings, rb_name);
+  if (rb_service != Qnil) string_table_record(strings, rb_service);
+  if (rb_resource != Qnil) string_table_record(strings, rb_resource);
+  if (rb_type != Qnil) string_table_record(strings, rb_type);
+
   /* No Ruby calls may occur between borrowing these pointers and span_new. */
   ddog_CharSlice name_s     = char_slice_from_ruby_string(rb_name);
   ddog_CharSlice service_s  = nullable_char_slice(rb_service);
@@ -710,31 +1550,28 @@ static void convert_ruby_span_to_rust(VALUE span, raw_span_owner *owner) {
   set_prepared_metastruct(owner->span, &metastruct);
 
   /* 4. Populate meta and metrics */
-  hash_iter_ctx ctx = {.span = owner->span, .error = NULL, .skipped = 0};
+  tag_batch batch = {.span = owner->span, .error = NULL, .encoded_bytes = 0, .strings = strings};
 
   VALUE rb_meta = rb_ivar_get(span, at_meta_id);
   if (RB_TYPE_P(rb_meta, T_HASH) && RHASH_SIZE(rb_meta) > 0) {
-    rb_hash_foreach(rb_meta, meta_iter_cb, (VALUE)&ctx);
-    check_exporter_error("Failed to set span meta", ctx.error);
-    if (ctx.skipped > 0) {
-      log_warning(rb_sprintf(
-          "Native trace exporter: skipped %ld non-string meta entries",
-          ctx.skipped));
-      ctx.skipped = 0;
-    }
+    set_span_tags(&batch, rb_meta, false);
   }
 
   VALUE rb_metrics = rb_ivar_get(span, at_metrics_id);
   if (RB_TYPE_P(rb_metrics, T_HASH) && RHASH_SIZE(rb_metrics) > 0) {
-    rb_hash_foreach(rb_metrics, metrics_iter_cb, (VALUE)&ctx);
-    check_exporter_error("Failed to set span metric", ctx.error);
-    if (ctx.skipped > 0) {
-      log_warning(rb_sprintf(
-          "Native trace exporter: skipped %ld non-numeric metrics entries",
-          ctx.skipped));
-    }
+    set_span_tags(&batch, rb_metrics, true);
   }
 
+  /* 5. Trace-level tags, overriding the span's own */
+  if (tags != NULL) set_trace_tags(span, owner->span, tags);
+
+  /* 6. Span events and links, after meta so they win over same-named tags */
+  set_span_json_meta(owner->span, DDOG_CHARSLICE_C("events"), rb_events_json);
+  set_span_json_meta(owner->span, DDOG_CHARSLICE_C("_dd.span_links"), rb_links_json);
+  RB_GC_GUARD(rb_events_json);
+  RB_GC_GUARD(rb_links_json);
+
+  return encoded_bytes + batch.encoded_bytes;
 }
 
 static VALUE free_raw_span(VALUE arg) {
@@ -757,7 +1594,7 @@ typedef struct {
 
 static VALUE convert_and_wrap_span(VALUE arg) {
   wrap_span_ctx *ctx = (wrap_span_ctx *)arg;
-  convert_ruby_span_to_rust(ctx->span, &ctx->owner);
+  convert_ruby_span_to_rust(ctx->span, &ctx->owner, NULL, NULL);
 
   VALUE wrapped = TypedData_Wrap_Struct(
       tracer_span_class, &tracer_span_typed_data, ctx->owner.span);
@@ -772,6 +1609,73 @@ static VALUE _native_from_span(DDTRACE_UNUSED VALUE klass, VALUE span) {
       free_raw_span, (VALUE)&ctx.owner);
 }
 
+/* ========================================================================
+ * TraceChunk._native_from_spans
+ *
+ * Ruby signature:
+ *   TraceChunk._native_from_spans(spans) -> TraceChunk
+ *
+ * Converts every span of a trace up-front, so that it can be done when the
+ * trace finishes (on the application thread that finished it) instead of in
+ * one batch for all traces when the writer thread flushes.  The conversion
+ * does not depend on the exporter, so no exporter is needed here.
+ *
+ * TraceExporter#_native_prepare_trace does the same for a whole TraceSegment,
+ * also setting its trace-level tags (see trace_tags_t).
+ * ======================================================================== */
+
+typedef struct {
+  VALUE               spans;
+  trace_chunk_t      *chunk;
+  raw_span_owner      owner;
+  const trace_tags_t *tags;  /* may be NULL */
+} convert_chunk_ctx;
+
+static VALUE convert_chunk_spans(VALUE arg) {
+  convert_chunk_ctx *ctx = (convert_chunk_ctx *)arg;
+  trace_chunk_t *chunk = ctx->chunk;
+
+  /* Converting a span may call back into Ruby, so re-check the array length
+   * on every iteration instead of trusting the capacity computed upfront. */
+  for (long j = 0; j < chunk->capacity && j < RARRAY_LEN(ctx->spans); j++) {
+    chunk->encoded_bytes += convert_ruby_span_to_rust(
+        rb_ary_entry(ctx->spans, j), &ctx->owner, ctx->tags, &chunk->strings);
+    chunk->spans[chunk->len++] = ctx->owner.span;
+    ctx->owner.span = NULL;
+  }
+  return Qnil;
+}
+
+static VALUE free_convert_chunk_resources(VALUE arg) {
+  convert_chunk_ctx *ctx = (convert_chunk_ctx *)arg;
+  free_raw_span((VALUE)&ctx->owner);
+  return Qnil;
+}
+
+static VALUE chunk_from_spans(VALUE spans, const trace_tags_t *tags) {
+  /* Wrap first (zeroed), so the GC owns and frees any span converted before
+   * an exception. */
+  trace_chunk_t *chunk;
+  VALUE wrapped = TypedData_Make_Struct(
+      trace_chunk_class, trace_chunk_t, &trace_chunk_typed_data, chunk);
+
+  long span_count = RARRAY_LEN(spans);
+  chunk->spans = ruby_xcalloc(span_count > 0 ? (size_t)span_count : 1, sizeof(ddog_TracerSpan *));
+  chunk->capacity = span_count;
+
+  convert_chunk_ctx ctx = {.spans = spans, .chunk = chunk, .owner = {.span = NULL}, .tags = tags};
+  rb_ensure(
+      convert_chunk_spans, (VALUE)&ctx,
+      free_convert_chunk_resources, (VALUE)&ctx);
+
+  return wrapped;
+}
+
+static VALUE _native_chunk_from_spans(DDTRACE_UNUSED VALUE klass, VALUE spans) {
+  ENFORCE_TYPE(spans, T_ARRAY);
+  return chunk_from_spans(spans, NULL);
+}
+
 /* ========================================================================
  * Response class helpers
  * ======================================================================== */
@@ -804,12 +1708,17 @@ static VALUE create_error_response(ddog_TraceExporterErrorCode code,
  * (typically JSON containing +rate_by_service+).  It is surfaced here so
  * that callers matching the +Datadog::Core::Transport::Response+ interface
  * can parse service sampling rates, just as the Net::HTTP transport does.
+ *
+ * +duplicate_string_bytes+ is the size of the strings that were repeated in
+ * the payload (see "Repeated strings").
  */
-static VALUE create_ok_response(long trace_count, VALUE payload) {
+static VALUE create_ok_response(long trace_count, VALUE payload,
+                                size_t duplicate_string_bytes) {
   VALUE kwargs = rb_hash_new();
-  rb_hash_aset(kwargs, ID2SYM(kw_ok),          Qtrue);
-  rb_hash_aset(kwargs, ID2SYM(kw_trace_count), LONG2NUM(trace_count));
-  rb_hash_aset(kwargs, ID2SYM(kw_payload),     payload);
+  rb_hash_aset(kwargs, ID2SYM(kw_ok),                     Qtrue);
+  rb_hash_aset(kwargs, ID2SYM(kw_trace_count),            LONG2NUM(trace_count));
+  rb_hash_aset(kwargs, ID2SYM(kw_payload),                payload);
+  rb_hash_aset(kwargs, ID2SYM(kw_duplicate_string_bytes), SIZET2NUM(duplicate_string_bytes));
   return rb_funcallv_kw(response_class, id_new, 1, &kwargs, RB_PASS_KEYWORDS);
 }
 
@@ -822,9 +1731,16 @@ static VALUE create_ok_response(long trace_count, VALUE payload) {
  *   TraceExporter._native_new(
  *     url:, tracer_version: nil, language: nil, language_version: nil,
  *     language_interpreter: nil, hostname: nil, env: nil,
- *     service: nil, version: nil) -> TraceExporter
+ *     service: nil, version: nil, first_span_tags: nil,
+ *     client_computed_stats: false, max_payload_size: nil) -> TraceExporter
  *
  * +url+ is required (String).  All other arguments may be nil.
+ * +first_span_tags+ (Hash[String, String]) are the process-wide tags set on
+ * the first span of every TraceSegment this exporter converts.
+ * +client_computed_stats+ tells the agent that the tracer already computes
+ * the stats of the traces it sends, so the agent must not compute them again.
+ * +max_payload_size+ (Integer, in bytes) is the size above which a batch gets
+ * split into several payloads (see trace_payload).
  * ======================================================================== */
 
 static VALUE _native_exporter_new(
@@ -843,6 +1759,9 @@ static VALUE _native_exporter_new(
   VALUE rb_env                  = rb_hash_fetch(options, ID2SYM(rb_intern("env")));
   VALUE rb_service              = rb_hash_fetch(options, ID2SYM(rb_intern("service")));
   VALUE rb_version              = rb_hash_fetch(options, ID2SYM(rb_intern("version")));
+  VALUE rb_first_span_tags      = rb_hash_lookup2(options, ID2SYM(rb_intern("first_span_tags")), Qnil);
+  VALUE rb_client_computed_stats = rb_hash_lookup2(options, ID2SYM(rb_intern("client_computed_stats")), Qfalse);
+  VALUE rb_max_payload_size     = rb_hash_lookup2(options, ID2SYM(rb_intern("max_payload_size")), Qnil);
 
   /* Phase 1: validate types (may raise, no Rust resources yet) */
   ENFORCE_TYPE(rb_url, T_STRING);
@@ -854,6 +1773,16 @@ static VALUE _native_exporter_new(
   if (rb_env                  != Qnil) ENFORCE_TYPE(rb_env,                  T_STRING);
   if (rb_service              != Qnil) ENFORCE_TYPE(rb_service,              T_STRING);
   if (rb_version              != Qnil) ENFORCE_TYPE(rb_version,              T_STRING);
+  if (rb_first_span_tags      != Qnil) ENFORCE_TYPE(rb_first_span_tags,      T_HASH);
+  ENFORCE_BOOLEAN(rb_client_computed_stats);
+  size_t max_payload_size = DEFAULT_MAX_PAYLOAD_SIZE;
+  if (rb_max_payload_size != Qnil) {
+    ENFORCE_TYPE(rb_max_payload_size, T_FIXNUM);
+    if (FIX2LONG(rb_max_payload_size) <= 0) {
+      raise_error(rb_eArgError, "max_payload_size must be positive");
+    }
+    max_payload_size = (size_t)FIX2LONG(rb_max_payload_size);
+  }
 
   /* Phase 2: configure before creating the separately-owned runtime. */
   ddog_TraceExporterConfig *config = NULL;
@@ -869,6 +1798,15 @@ static VALUE _native_exporter_new(
   set_config_field(config, ddog_trace_exporter_config_set_service,           rb_service,               "service");
   set_config_field(config, ddog_trace_exporter_config_set_version,           rb_version,               "version");
 
+  if (rb_client_computed_stats == Qtrue) {
+    ddog_TraceExporterError *stats_err =
+        ddog_trace_exporter_config_set_client_computed_stats(config, true);
+    if (stats_err != NULL) {
+      ddog_trace_exporter_config_free(config);
+      check_exporter_error("Failed to set client_computed_stats", stats_err);
+    }
+  }
+
   /*
    * Create a SharedRuntime and attach it to the config before building the
    * exporter.  The exporter holds a clone of the runtime's Arc; we keep our
@@ -911,9 +1849,27 @@ static VALUE _native_exporter_new(
   trace_exporter_t *wrapper = ruby_xmalloc(sizeof(trace_exporter_t));
   wrapper->exporter = exporter;
   wrapper->runtime  = runtime;
+  wrapper->async_sender = NULL;
+  wrapper->first_span_tags = Qnil;
+  wrapper->max_payload_size = max_payload_size;
+
+  VALUE wrapped = TypedData_Wrap_Struct(trace_exporter_class, &trace_exporter_typed_data,
+                                        wrapper);
+  _native_set_first_span_tags(wrapped, rb_first_span_tags);
+  return wrapped;
+}
+
+/* Replaces the tags given as +first_span_tags+ to _native_new. */
+static VALUE _native_set_first_span_tags(VALUE self, VALUE first_span_tags) {
+  trace_exporter_t *wrapper;
+  TypedData_Get_Struct(self, trace_exporter_t, &trace_exporter_typed_data, wrapper);
 
-  return TypedData_Wrap_Struct(trace_exporter_class, &trace_exporter_typed_data,
-                               wrapper);
+  if (first_span_tags != Qnil) {
+    ENFORCE_TYPE(first_span_tags, T_HASH);
+    first_span_tags = rb_obj_freeze(rb_hash_dup(first_span_tags));
+  }
+  wrapper->first_span_tags = first_span_tags;
+  return Qnil;
 }
 
 /* ========================================================================
@@ -929,7 +1885,11 @@ static VALUE _native_before_fork(VALUE self) {
   if (wrapper == NULL || wrapper->runtime == NULL) {
     raise_error(rb_eRuntimeError, "TraceExporter has not been initialized or was already freed");
   }
+  /* Same order as the Ruby-side hook for synchronous sends: stop new sends,
+   * pause the runtime (safe during a send), then wait for the send to drain. */
+  if (wrapper->async_sender != NULL) async_sender_before_fork(wrapper->async_sender);
   ddog_SharedRuntimeFFIError *err = ddog_shared_runtime_before_fork(wrapper->runtime);
+  if (wrapper->async_sender != NULL) async_sender_wait_for_send_in_progress(wrapper->async_sender);
   check_shared_runtime_error("Failed to prepare for fork", err);
   return Qnil;
 }
@@ -941,6 +1901,7 @@ static VALUE _native_after_fork_in_parent(VALUE self) {
     raise_error(rb_eRuntimeError, "TraceExporter has not been initialized or was already freed");
   }
   ddog_SharedRuntimeFFIError *err = ddog_shared_runtime_after_fork_parent(wrapper->runtime);
+  if (wrapper->async_sender != NULL) async_sender_after_fork_in_parent(wrapper->async_sender);
   check_shared_runtime_error("Failed to restore after fork in parent", err);
   return Qnil;
 }
@@ -952,6 +1913,7 @@ static VALUE _native_after_fork_in_child(VALUE self) {
     raise_error(rb_eRuntimeError, "TraceExporter has not been initialized or was already freed");
   }
   ddog_SharedRuntimeFFIError *err = ddog_shared_runtime_after_fork_child(wrapper->runtime);
+  if (wrapper->async_sender != NULL) async_sender_after_fork_in_child(wrapper->async_sender);
   check_shared_runtime_error("Failed to restore after fork in child", err);
   return Qnil;
 }
@@ -962,43 +1924,79 @@ static VALUE _native_after_fork_in_child(VALUE self) {
  * The send call performs blocking network I/O.  Releasing the GVL lets
  * other Ruby threads (application code, test mock servers, etc.) run
  * while we wait for the agent's response.
+ *
+ * A batch split into several payloads (see trace_payload) sends them one
+ * after the other, from the calling thread: the FFI only offers a blocking
+ * send, and does not document concurrent sends on one exporter as safe.
+ * Each payload is a request of its own, with its own cancellation token,
+ * retries (done by libdatadog) and outcome: the agent rejecting one payload
+ * does not lose the traces of the others.
  * ======================================================================== */
 
+/*
+ * One request's worth of trace chunks.  Payloads are filled in order, and a
+ * new one is started whenever the next trace chunk would take the current one
+ * over the exporter's +max_payload_size+ (see "Payload size estimates").  A
+ * trace chunk larger than that on its own still gets a payload of its own
+ * rather than being dropped, as its size is only an estimate.
+ */
+typedef struct {
+  ddog_TracerTraceChunks        *chunks;  /* NULL once sent (or queued) */
+  long                           trace_count;
+  size_t                         encoded_bytes;
+  string_table_t                 strings;  /* see "Repeated strings" */
+  ddog_TraceExporterCancelToken *cancel_token;
+  ddog_TraceExporterResponse    *response;
+  ddog_TraceExporterErrorCode    error_code;
+  bool                           failed;
+} trace_payload;
+
 typedef struct {
-  const ddog_TraceExporter       *exporter;
-  ddog_TracerTraceChunks         *chunks;
-  ddog_TraceExporterResponse     *response;
-  ddog_TraceExporterCancelToken  *cancel_token;  /* borrowed, not owned */
-  ddog_TraceExporterErrorCode     error_code;
-  bool                            failed;
-  bool                            send_ran;
-} send_chunks_args_t;
-
-static void *send_chunks_without_gvl(void *data) {
-  send_chunks_args_t *args = (send_chunks_args_t *)data;
+  const ddog_TraceExporter *exporter;
+  trace_payload            *payloads;
+  long                      payload_count;
+  bool                      send_ran;
+} send_payloads_args_t;
+
+static void send_payload(const ddog_TraceExporter *exporter, trace_payload *payload) {
+  ddog_TracerTraceChunks *chunks = payload->chunks;
+  /* Consumed whatever the outcome */
+  payload->chunks = NULL;
   ddog_TraceExporterError *err = ddog_trace_exporter_send_trace_chunks(
-      args->exporter, args->chunks, &args->response, args->cancel_token);
+      exporter, chunks, &payload->response, payload->cancel_token);
   if (err != NULL) {
-    args->error_code = err->code;
-    args->failed = true;
+    payload->error_code = err->code;
+    payload->failed = true;
     ddog_trace_exporter_error_free(err);
   }
+}
+
+/* Runs without the GVL: no Ruby APIs here.  Once interrupted, the remaining
+ * sends fail right away, as every cancellation token was cancelled. */
+static void *send_payloads_without_gvl(void *data) {
+  send_payloads_args_t *args = (send_payloads_args_t *)data;
+  for (long i = 0; i < args->payload_count; i++) {
+    send_payload(args->exporter, &args->payloads[i]);
+  }
+
   args->send_ran = true;
   return NULL;
 }
 
 /*
- * Unblock function: cooperatively cancel an in-flight send.
+ * Unblock function: cooperatively cancel the in-flight sends.
  *
  * Called by Ruby when an interrupt (Thread#kill, shutdown) fires while
  * the thread is inside rb_thread_call_without_gvl2.  Cancelling the
- * token causes the Rust HTTP pipeline to abort the in-flight request
+ * tokens causes the Rust HTTP pipeline to abort the in-flight requests
  * and return promptly, which is not possible with RUBY_UBF_IO's
  * signal-based approach.
  */
-static void interrupt_exporter_call(void *cancel_token) {
-  ddog_trace_exporter_cancel_token_cancel(
-      (const ddog_TraceExporterCancelToken *)cancel_token);
+static void interrupt_exporter_call(void *data) {
+  send_payloads_args_t *args = (send_payloads_args_t *)data;
+  for (long i = 0; i < args->payload_count; i++) {
+    ddog_trace_exporter_cancel_token_cancel(args->payloads[i].cancel_token);
+  }
 }
 
 /*
@@ -1026,10 +2024,17 @@ static int check_if_pending_exception(void) {
  * +traces+ is an Array of Arrays of Spans:
  *   [[span, span, ...], [span, ...], ...]
  *
- * Each inner array maps to one trace chunk (Vec<Span> in Rust).
+ * Each inner array maps to one trace chunk (Vec<Span> in Rust).  An inner
+ * element may instead be a TraceChunk whose spans were already converted, in
+ * which case they are moved into the payload without touching Ruby objects,
+ * or a TraceSegment, whose spans get its trace-level tags (see trace_tags_t)
+ * while being converted.
  *
- * On success returns [Response(ok: true, trace_count: N)].
- * On error returns [Response(ok: false, ...)].
+ * The trace chunks are split into as many payloads as needed to keep each
+ * under the exporter's +max_payload_size+ (see trace_payload), which are sent
+ * one after the other.  Returns one Response per payload, in order, each with the
+ * trace_count of its payload: Response(ok: true, ...) when it was sent,
+ * Response(ok: false, ...) otherwise.
  *
  * The chunk-building loop calls into Ruby (ENFORCE_TYPE,
  * convert_ruby_span_to_rust) which may raise.  We use rb_ensure so
@@ -1043,110 +2048,203 @@ typedef struct {
   VALUE                     traces;
   long                      trace_count;
   raw_span_owner            span_owner;
-  ddog_TracerTraceChunks   *chunks;  /* NULL after send consumes it */
+  trace_chunk_t             converted;  /* spans of the trace being converted */
+  trace_payload            *payloads;
+  long                      payload_count;
+  long                      payload_capacity;
+  size_t                    max_payload_size;
+  async_sender_t           *async_sender;  /* _native_enqueue_traces only */
+  VALUE                     first_span_tags;
 } send_traces_ctx;
 
+/* Returns the payload a trace chunk of +encoded_bytes+ goes into, starting a
+ * new one when it does not fit in the current one. */
+static trace_payload *payload_for_chunk(send_traces_ctx *ctx, size_t encoded_bytes,
+                                        long remaining_traces) {
+  if (ctx->payload_count > 0) {
+    trace_payload *current = &ctx->payloads[ctx->payload_count - 1];
+    if (current->encoded_bytes + encoded_bytes <= ctx->max_payload_size) return current;
+    /* Nothing else goes into it, so only its duplicate_bytes are still needed */
+    string_table_free(&current->strings);
+  }
+
+  if (ctx->payload_count == ctx->payload_capacity) {
+    long capacity = ctx->payload_capacity == 0 ? 1 : ctx->payload_capacity * 2;
+    REALLOC_N(ctx->payloads, trace_payload, capacity);
+    ctx->payload_capacity = capacity;
+  }
+  trace_payload *payload = &ctx->payloads[ctx->payload_count];
+  *payload = (trace_payload){.chunks = NULL};
+  ddog_TraceExporterError *chunks_err =
+      ddog_tracer_trace_chunks_new((size_t)remaining_traces, &payload->chunks);
+  if (chunks_err != NULL) {
+    ddog_trace_exporter_error_free(chunks_err);
+    raise_error(rb_eRuntimeError, "Failed to allocate trace chunks");
+  }
+  ctx->payload_count++;
+  return payload;
+}
+
+/* Moves the spans of +chunk+ into a new trace chunk of the payload it fits in. */
+static void push_chunk(send_traces_ctx *ctx, trace_chunk_t *chunk, long remaining_traces) {
+  trace_payload *payload = payload_for_chunk(ctx, chunk->encoded_bytes, remaining_traces);
+  payload->trace_count++;
+  payload->encoded_bytes += chunk->encoded_bytes;
+  string_table_merge(&payload->strings, &chunk->strings);
+
+  /* Propagate a begin_chunk failure instead of swallowing it: continuing
+   * would build an incomplete payload and still report success. rb_ensure
+   * frees chunks on the raise. Today this only fails for an absurd
+   * span_count, but a future libdatadog change (e.g. a fallible allocator)
+   * could make it reachable. */
+  ddog_TraceExporterError *begin_err =
+      ddog_tracer_trace_chunks_begin_chunk(payload->chunks, (size_t)chunk->len);
+  check_exporter_error("Failed to begin trace chunk", begin_err);
+  for (long j = 0; j < chunk->len; j++) {
+    ddog_TracerSpan *span = chunk->spans[j];
+    chunk->spans[j] = NULL;
+    /* push_span consumes the span on every path. */
+    ddog_TraceExporterError *push_err =
+        ddog_tracer_trace_chunks_push_span(payload->chunks, span);
+    check_exporter_error("Failed to push span into trace chunk", push_err);
+  }
+}
+
+/* Moves the already-converted spans of a TraceChunk into a payload. */
+static void push_prepared_chunk(send_traces_ctx *ctx, VALUE prepared, long remaining_traces) {
+  trace_chunk_t *chunk;
+  TypedData_Get_Struct(prepared, trace_chunk_t, &trace_chunk_typed_data, chunk);
+  if (chunk->sent) {
+    raise_error(rb_eArgError, "TraceChunk was already sent");
+  }
+  /* Flag it before pushing: push_span consumes spans even on failure, so a
+   * partially pushed chunk must never be pushed again. */
+  chunk->sent = true;
+  push_chunk(ctx, chunk, remaining_traces);
+  string_table_free(&chunk->strings);
+}
+
+/* Converts +chunk_spans+ into ctx->converted, then moves them into a payload. */
+static void push_converted_chunk(send_traces_ctx *ctx, VALUE chunk_spans,
+                                 const trace_tags_t *tags, long remaining_traces) {
+  trace_chunk_t *converted = &ctx->converted;
+  long span_count = RARRAY_LEN(chunk_spans);
+  if (span_count > converted->capacity) {
+    REALLOC_N(converted->spans, ddog_TracerSpan *, span_count);
+    converted->capacity = span_count;
+  }
+  converted->len = 0;
+  converted->encoded_bytes = 0;
+  string_table_clear(&converted->strings);
+
+  /* Converting a span may call back into Ruby, so re-check the array length
+   * on every iteration instead of trusting span_count. */
+  for (long j = 0; j < span_count && j < RARRAY_LEN(chunk_spans); j++) {
+    converted->encoded_bytes += convert_ruby_span_to_rust(
+        rb_ary_entry(chunk_spans, j), &ctx->span_owner, tags, &converted->strings);
+    converted->spans[converted->len++] = ctx->span_owner.span;
+    ctx->span_owner.span = NULL;
+  }
+
+  push_chunk(ctx, converted, remaining_traces);
+}
+
+/* Builds the payloads from Ruby spans (or TraceChunks, or TraceSegments)
+ * into ctx->payloads. */
+static void build_trace_chunks(send_traces_ctx *ctx) {
+  for (long i = 0; i < ctx->trace_count; i++) {
+    VALUE trace = rb_ary_entry(ctx->traces, i);
+    long remaining_traces = ctx->trace_count - i;
+    if (rb_typeddata_is_kind_of(trace, &trace_chunk_typed_data)) {
+      push_prepared_chunk(ctx, trace, remaining_traces);
+    } else if (RB_TYPE_P(trace, T_ARRAY)) {
+      push_converted_chunk(ctx, trace, NULL, remaining_traces);
+    } else {
+      trace_tags_t tags;
+      VALUE spans = init_trace_tags(&tags, trace, ctx->first_span_tags);
+      push_converted_chunk(ctx, spans, &tags, remaining_traces);
+    }
+  }
+}
+
 /*
- * Body: build trace chunks from Ruby spans, then send them.
+ * Body: build the payloads from Ruby spans, then send them.
  * Passed to rb_ensure as the "try" block.
  */
 static VALUE build_and_send_traces(VALUE arg) {
   send_traces_ctx *ctx = (send_traces_ctx *)arg;
 
-  for (long i = 0; i < ctx->trace_count; i++) {
-    VALUE chunk_spans = rb_ary_entry(ctx->traces, i);
-    ENFORCE_TYPE(chunk_spans, T_ARRAY);
-
-    long span_count = RARRAY_LEN(chunk_spans);
-    /* Propagate a begin_chunk failure instead of swallowing it: continuing
-     * would build an incomplete payload and still report success. rb_ensure
-     * frees chunks on the raise. Today this only fails for an absurd
-     * span_count, but a future libdatadog change (e.g. a fallible allocator)
-     * could make it reachable. */
-    ddog_TraceExporterError *begin_err =
-        ddog_tracer_trace_chunks_begin_chunk(ctx->chunks, (size_t)span_count);
-    check_exporter_error("Failed to begin trace chunk", begin_err);
-    for (long j = 0; j < span_count; j++) {
-      convert_ruby_span_to_rust(
-          rb_ary_entry(chunk_spans, j), &ctx->span_owner);
-
-      ddog_TraceExporterError *push_err =
-          ddog_tracer_trace_chunks_push_span(ctx->chunks, ctx->span_owner.span);
-      /* push_span consumes the span on every path. */
-      ctx->span_owner.span = NULL;
-      check_exporter_error("Failed to push span into trace chunk", push_err);
-    }
-  }
+  build_trace_chunks(ctx);
 
   /*
    * Send with the GVL released so other Ruby threads run during I/O.
    *
    * Custom behaviour of this call site:
    *  - We use the gvl2 variant precisely because it does NOT auto-raise a
-   *    pending interrupt on return: the send consumes chunks and allocates
-   *    a Rust response, so we must inspect/free those before letting any
+   *    pending interrupt on return: the sends consume chunks and allocate
+   *    Rust responses, so we must inspect/free those before letting any
    *    exception propagate (otherwise they leak).
-   *  - The unblock function cancels a per-send cancellation token, which
-   *    cooperatively aborts the in-flight Rust HTTP request (RUBY_UBF_IO
-   *    could not cancel the Rust pipeline).
-   *  - An interrupt can make gvl2 return before send_chunks_without_gvl
-   *    runs, so we loop until the send actually executes or an exception
+   *  - The unblock function cancels the per-payload cancellation tokens,
+   *    which cooperatively abort the in-flight Rust HTTP requests
+   *    (RUBY_UBF_IO could not cancel the Rust pipeline).
+   *  - An interrupt can make gvl2 return before send_payloads_without_gvl
+   *    runs, so we loop until the sends actually execute or an exception
    *    is pending.
    */
-  ddog_TraceExporterCancelToken *cancel_token =
-      ddog_trace_exporter_cancel_token_new();
-
-  send_chunks_args_t args = {
-    .exporter     = ctx->exporter,
-    .chunks       = ctx->chunks,
-    .response     = NULL,
-    .cancel_token = cancel_token,
-    .failed       = false,
-    .send_ran     = false,
+  for (long i = 0; i < ctx->payload_count; i++) {
+    ctx->payloads[i].cancel_token = ddog_trace_exporter_cancel_token_new();
+  }
+
+  send_payloads_args_t args = {
+    .exporter      = ctx->exporter,
+    .payloads      = ctx->payloads,
+    .payload_count = ctx->payload_count,
+    .send_ran      = false,
   };
 
   int pending_exception = 0;
   while (!args.send_ran && !pending_exception) {
     rb_thread_call_without_gvl2(
-        send_chunks_without_gvl, &args,
-        interrupt_exporter_call, cancel_token);
+        send_payloads_without_gvl, &args,
+        interrupt_exporter_call, &args);
 
     if (!args.send_ran) {
       pending_exception = check_if_pending_exception();
     }
   }
-
-  ddog_trace_exporter_cancel_token_drop(cancel_token);
-  /* Only null chunks when the send actually ran and consumed them.
-   * If an interrupt fired before the send executed, chunks are still
-   * live and the ensure handler must free them. */
-  if (args.send_ran) {
-    ctx->chunks = NULL;
-  }
-
-  /* Extract the response body as a Ruby string before freeing. */
-  VALUE payload = Qnil;
-  if (args.response != NULL) {
-    ddog_ByteSlice body =
-        ddog_trace_exporter_response_get_body(args.response);
-    if (body.len > 0) {
-      payload = rb_str_new((const char *)body.ptr, (long)body.len);
+  /* The chunks of each payload were consumed by its send (send_payload nulls
+   * them).  If an interrupt fired before the sends executed, chunks are
+   * still live and the ensure handler must free them. */
+
+  /* Extract the response bodies as Ruby strings before freeing.  The ensure
+   * handler frees any response left if this raises. */
+  VALUE bodies = rb_ary_new_capa(ctx->payload_count);
+  for (long i = 0; i < ctx->payload_count; i++) {
+    trace_payload *payload = &ctx->payloads[i];
+    VALUE body_string = Qnil;
+    if (payload->response != NULL) {
+      ddog_ByteSlice body =
+          ddog_trace_exporter_response_get_body(payload->response);
+      if (body.len > 0) {
+        body_string = rb_str_new((const char *)body.ptr, (long)body.len);
+      }
+      ddog_trace_exporter_response_free(payload->response);
+      payload->response = NULL;
     }
-    ddog_trace_exporter_response_free(args.response);
-    args.response = NULL;
+    rb_ary_push(bodies, body_string);
   }
 
   /*
    * Re-check for a pending interrupt unconditionally before deciding the
    * outcome.  In a race, the unblock function (interrupt_exporter_call) can
-   * fire -- cancelling the token -- while the send still completes, so
+   * fire -- cancelling the tokens -- while the sends still complete, so
    * rb_thread_call_without_gvl2 returns with args.send_ran == true.  In that
    * case the loop above exits without ever calling check_if_pending_exception(),
    * leaving the interrupt pending.  If we did not check here, the cancelled
-   * send would fall through and be reported as an ordinary transport error
-   * response, swallowing the interrupt (e.g. Thread#kill / shutdown).
+   * sends would fall through and be reported as ordinary transport error
+   * responses, swallowing the interrupt (e.g. Thread#kill / shutdown).
    *
-   * This runs after the response has already been extracted and freed and
+   * This runs after the responses have already been extracted and freed and
    * after chunks have been handed off to the ensure handler, so re-raising
    * here leaks nothing.
    */
@@ -1157,32 +2255,45 @@ static VALUE build_and_send_traces(VALUE arg) {
     rb_jump_tag(pending_exception);
   }
 
-  if (args.failed) {
-    VALUE err_resp = create_error_response(args.error_code, ctx->trace_count);
-    return rb_ary_new_from_args(1, err_resp);
+  VALUE responses = rb_ary_new_capa(ctx->payload_count);
+  for (long i = 0; i < ctx->payload_count; i++) {
+    const trace_payload *payload = &ctx->payloads[i];
+    VALUE response = payload->failed ?
+        create_error_response(payload->error_code, payload->trace_count) :
+        create_ok_response(payload->trace_count, rb_ary_entry(bodies, i),
+                           payload->strings.duplicate_bytes);
+    rb_ary_push(responses, response);
   }
-
-  VALUE ok_resp = create_ok_response(ctx->trace_count, payload);
-  return rb_ary_new_from_args(1, ok_resp);
+  return responses;
 }
 
 /*
- * Ensure: free the current raw span and any chunks not consumed by the send.
+ * Ensure: free the current raw spans and any payload not consumed by a send.
  * This runs whether build_and_send_traces returned normally or raised.
  */
 static VALUE free_send_resources(VALUE arg) {
   send_traces_ctx *ctx = (send_traces_ctx *)arg;
   free_raw_span((VALUE)&ctx->span_owner);
-  if (ctx->chunks != NULL) {
-    ddog_tracer_trace_chunks_free(ctx->chunks);
-    ctx->chunks = NULL;
+  for (long j = 0; j < ctx->converted.len; j++) {
+    if (ctx->converted.spans[j] != NULL) ddog_tracer_span_free(ctx->converted.spans[j]);
+  }
+  ruby_xfree(ctx->converted.spans);
+  string_table_free(&ctx->converted.strings);
+  ctx->converted = (trace_chunk_t){.spans = NULL};
+  for (long i = 0; i < ctx->payload_count; i++) {
+    trace_payload *payload = &ctx->payloads[i];
+    string_table_free(&payload->strings);
+    if (payload->chunks != NULL) ddog_tracer_trace_chunks_free(payload->chunks);
+    if (payload->response != NULL) ddog_trace_exporter_response_free(payload->response);
+    if (payload->cancel_token != NULL) ddog_trace_exporter_cancel_token_drop(payload->cancel_token);
   }
+  ruby_xfree(ctx->payloads);
+  ctx->payloads = NULL;
+  ctx->payload_count = 0;
   return Qnil;
 }
 
-static VALUE _native_send_traces(VALUE self, VALUE traces) {
-  ENFORCE_TYPE(traces, T_ARRAY);
-
+static trace_exporter_t *get_initialized_exporter(VALUE self) {
   trace_exporter_t *wrapper;
   TypedData_Get_Struct(self, trace_exporter_t, &trace_exporter_typed_data,
                        wrapper);
@@ -1190,36 +2301,662 @@ static VALUE _native_send_traces(VALUE self, VALUE traces) {
     raise_error(rb_eRuntimeError,
                 "TraceExporter has not been initialized or was already freed");
   }
+  return wrapper;
+}
 
-  long trace_count = RARRAY_LEN(traces);
-
-  /* Empty batch -> empty response (matches existing transport behaviour) */
-  if (trace_count == 0) {
-    return rb_ary_new();
-  }
-
-  /* Allocate trace chunks */
-  ddog_TracerTraceChunks *chunks = NULL;
-  ddog_TraceExporterError *chunks_err =
-      ddog_tracer_trace_chunks_new((size_t)trace_count, &chunks);
-  if (chunks_err != NULL) {
-    ddog_trace_exporter_error_free(chunks_err);
-    raise_error(rb_eRuntimeError, "Failed to allocate trace chunks");
-  }
-
+/* Runs +body+ (build_and_send_traces or build_and_enqueue_traces) on the
+ * payloads of +traces+, with free_send_resources as its ensure. */
+static VALUE with_trace_chunks(trace_exporter_t *wrapper, VALUE traces,
+                               VALUE (*body)(VALUE)) {
   send_traces_ctx ctx = {
     .exporter    = wrapper->exporter,
     .traces      = traces,
-    .trace_count = trace_count,
+    .trace_count = RARRAY_LEN(traces),
     .span_owner  = {.span = NULL},
-    .chunks      = chunks,
+    .converted   = {.spans = NULL},
+    .payloads    = NULL,
+    .max_payload_size = wrapper->max_payload_size,
+    .async_sender = wrapper->async_sender,
+    .first_span_tags = wrapper->first_span_tags,
   };
 
   return rb_ensure(
-      build_and_send_traces, (VALUE)&ctx,
+      body, (VALUE)&ctx,
       free_send_resources, (VALUE)&ctx);
 }
 
+static VALUE _native_send_traces(VALUE self, VALUE traces) {
+  ENFORCE_TYPE(traces, T_ARRAY);
+  trace_exporter_t *wrapper = get_initialized_exporter(self);
+
+  /* Empty batch -> empty response (matches existing transport behaviour) */
+  if (RARRAY_LEN(traces) == 0) {
+    return rb_ary_new();
+  }
+
+  return with_trace_chunks(wrapper, traces, build_and_send_traces);
+}
+
+/* ========================================================================
+ * TraceExporter#_native_prepare_trace
+ *
+ * Ruby signature:
+ *   exporter._native_prepare_trace(trace_segment) -> TraceChunk
+ *
+ * Like TraceChunk._native_from_spans, but for a TraceSegment, also setting
+ * its trace-level tags and this exporter's first_span_tags.
+ * ======================================================================== */
+
+static VALUE _native_prepare_trace(VALUE self, VALUE trace) {
+  trace_exporter_t *wrapper = get_initialized_exporter(self);
+
+  trace_tags_t tags;
+  VALUE spans = init_trace_tags(&tags, trace, wrapper->first_span_tags);
+  VALUE chunk = chunk_from_spans(spans, &tags);
+  RB_GC_GUARD(trace);
+  return chunk;
+}
+
+/* ========================================================================
+ * Asynchronous sends
+ *
+ * _native_send_traces blocks the calling (writer) thread for the whole HTTP
+ * round trip, so a slow agent delays every later flush.  Once started (see
+ * _native_start_async_sender), _native_enqueue_traces instead only converts
+ * the traces, which needs the GVL, and hands the resulting trace chunks to a
+ * native sender thread that performs the sends one at a time without ever
+ * touching Ruby.
+ *
+ * A batch split into several payloads (see trace_payload) queues each of them
+ * as a separate send.
+ *
+ * At most +max_in_flight+ payloads may be queued or being sent; payloads
+ * enqueued beyond that are dropped (and counted) rather than blocking the
+ * caller.  Outcomes are reported back by polling: _native_poll_async_sends
+ * returns a Response for every send completed since the previous poll, so the
+ * caller can update its stats and the agent service rates.
+ *
+ * The sender thread is paused and drained around forks (see the fork safety
+ * hooks), and does not exist in a forked child until the next enqueue.
+ *
+ * _native_stop_async_sender (called by Transport#close) stops and joins the
+ * thread.  An exporter garbage collected with its sender still running only
+ * asks the thread to stop, and the thread frees everything on its way out
+ * (see async_sender_orphan), so that GC never waits for a send.  The sender
+ * is allocated with malloc rather than ruby_xmalloc for that reason.
+ * ======================================================================== */
+
+#define ASYNC_SENDER_MAX_IN_FLIGHT_LIMIT 64
+
+typedef struct {
+  ddog_TracerTraceChunks *chunks;
+  long                    trace_count;
+  size_t                  duplicate_string_bytes;
+} async_send_job;
+
+typedef struct {
+  long                        trace_count;
+  size_t                      duplicate_string_bytes;
+  bool                        failed;
+  ddog_TraceExporterErrorCode error_code;
+  uint8_t                    *body;  /* malloc'd copy of the agent response, or NULL */
+  size_t                      body_len;
+} async_send_result;
+
+/* All fields are protected by +lock+, except for those only used by the Ruby
+ * thread that owns the exporter (+thread+, +thread_running+). */
+struct async_sender {
+  pthread_mutex_t lock;
+  pthread_cond_t  work_available;  /* signalled on enqueue, resume and stop */
+  pthread_cond_t  idle;            /* signalled whenever a send completes */
+  pthread_t       thread;
+  bool            thread_running;
+  bool            stopping;
+  bool            paused;
+  bool            sending;
+  bool            orphaned;  /* the thread frees the sender, see async_sender_orphan */
+  ddog_TraceExporterCancelToken *cancel_token;  /* of the send in progress */
+  const ddog_TraceExporter *exporter;
+  /* Freed by the thread when orphaned */
+  ddog_TraceExporter         *orphaned_exporter;
+  const ddog_ForkSafeRuntime *orphaned_runtime;
+
+  long               max_in_flight;
+  async_send_job    *jobs;     /* ring buffer with max_in_flight entries */
+  long               jobs_head;
+  long               jobs_count;
+  async_send_result *results;  /* ring buffer with max_in_flight entries */
+  long               results_head;
+  long               results_count;
+
+  uint64_t enqueued;
+  uint64_t dropped;
+  uint64_t traces_dropped;
+  uint64_t completed;
+  uint64_t results_dropped;
+};
+
+static long async_sender_in_flight(async_sender_t *sender) {
+  return sender->jobs_count + (sender->sending ? 1 : 0);
+}
+
+/* Called with the lock held.  When nobody polled for a while, the oldest
+ * result is dropped in favour of the newest one. */
+static void async_sender_push_result(async_sender_t *sender, async_send_result result) {
+  if (sender->results_count == sender->max_in_flight) {
+    free(sender->results[sender->results_head].body);
+    sender->results_head = (sender->results_head + 1) % sender->max_in_flight;
+    sender->results_count--;
+    sender->results_dropped++;
+  }
+  long position = (sender->results_head + sender->results_count) % sender->max_in_flight;
+  sender->results[position] = result;
+  sender->results_count++;
+}
+
+/* Runs on the sender thread, which is not a Ruby thread: no Ruby APIs here. */
+static void *async_sender_loop(void *arg) {
+  async_sender_t *sender = (async_sender_t *)arg;
+
+  pthread_mutex_lock(&sender->lock);
+  while (true) {
+    while (!sender->stopping && (sender->paused || sender->jobs_count == 0)) {
+      pthread_cond_wait(&sender->work_available, &sender->lock);
+    }
+    if (sender->stopping) break;
+
+    async_send_job job = sender->jobs[sender->jobs_head];
+    sender->jobs_head = (sender->jobs_head + 1) % sender->max_in_flight;
+    sender->jobs_count--;
+    sender->sending = true;
+    sender->cancel_token = ddog_trace_exporter_cancel_token_new();
+    pthread_mutex_unlock(&sender->lock);
+
+    async_send_result result = {
+      .trace_count = job.trace_count,
+      .duplicate_string_bytes = job.duplicate_string_bytes,
+    };
+    ddog_TraceExporterResponse *response = NULL;
+    /* Consumes the chunks, whatever the outcome */
+    ddog_TraceExporterError *err = ddog_trace_exporter_send_trace_chunks(
+        sender->exporter, job.chunks, &response, sender->cancel_token);
+    if (err != NULL) {
+      result.failed = true;
+      result.error_code = err->code;
+      ddog_trace_exporter_error_free(err);
+    }
+    if (response != NULL) {
+      ddog_ByteSlice body = ddog_trace_exporter_response_get_body(response);
+      if (body.len > 0 && (result.body = malloc(body.len)) != NULL) {
+        memcpy(result.body, body.ptr, body.len);
+        result.body_len = body.len;
+      }
+      ddog_trace_exporter_response_free(response);
+    }
+
+    pthread_mutex_lock(&sender->lock);
+    ddog_trace_exporter_cancel_token_drop(sender->cancel_token);
+    sender->cancel_token = NULL;
+    sender->sending = false;
+    sender->completed++;
+    async_sender_push_result(sender, result);
+    pthread_cond_broadcast(&sender->idle);
+  }
+  bool orphaned = sender->orphaned;
+  pthread_mutex_unlock(&sender->lock);
+
+  if (orphaned) {
+    if (sender->orphaned_exporter != NULL) ddog_trace_exporter_free(sender->orphaned_exporter);
+    if (sender->orphaned_runtime != NULL) ddog_shared_runtime_free(sender->orphaned_runtime);
+    async_sender_free(sender);
+  }
+
+  return NULL;
+}
+
+__attribute__((warn_unused_result))
+static int async_sender_start_thread(async_sender_t *sender) {
+  int error = pthread_create(&sender->thread, NULL, async_sender_loop, sender);
+  if (error == 0) sender->thread_running = true;
+  return error;
+}
+
+/* Frees queued payloads and unpolled results.  Called with the lock held, or
+ * when the sender thread is not running. */
+static void async_sender_discard_pending(async_sender_t *sender) {
+  for (; sender->jobs_count > 0; sender->jobs_count--) {
+    ddog_tracer_trace_chunks_free(sender->jobs[sender->jobs_head].chunks);
+    sender->jobs_head = (sender->jobs_head + 1) % sender->max_in_flight;
+  }
+  for (; sender->results_count > 0; sender->results_count--) {
+    free(sender->results[sender->results_head].body);
+    sender->results_head = (sender->results_head + 1) % sender->max_in_flight;
+  }
+}
+
+static void async_sender_init_sync(async_sender_t *sender) {
+  pthread_mutex_init(&sender->lock, NULL);
+  pthread_cond_init(&sender->work_available, NULL);
+  pthread_cond_init(&sender->idle, NULL);
+}
+
+/* Cancels the send in progress (if any) and tells the sender thread to exit. */
+static void async_sender_request_stop(async_sender_t *sender) {
+  pthread_mutex_lock(&sender->lock);
+  sender->stopping = true;
+  if (sender->cancel_token != NULL) {
+    ddog_trace_exporter_cancel_token_cancel(sender->cancel_token);
+  }
+  pthread_cond_broadcast(&sender->work_available);
+  pthread_mutex_unlock(&sender->lock);
+}
+
+/* Frees the sender, whose thread must not be running (or be the caller).
+ * Payloads still queued are lost.  Does not use Ruby APIs. */
+static void async_sender_free(async_sender_t *sender) {
+  async_sender_discard_pending(sender);
+  pthread_cond_destroy(&sender->idle);
+  pthread_cond_destroy(&sender->work_available);
+  pthread_mutex_destroy(&sender->lock);
+  free(sender->jobs);
+  free(sender->results);
+  free(sender);
+}
+
+/* Called when the exporter is garbage collected.  If the sender thread is
+ * running, hands it the sender, +exporter+ and +runtime+ to free once it
+ * exits, and returns true.  Otherwise frees the sender and returns false. */
+static bool async_sender_orphan(async_sender_t *sender, ddog_TraceExporter *exporter,
+                                const ddog_ForkSafeRuntime *runtime) {
+  if (!sender->thread_running) {
+    async_sender_free(sender);
+    return false;
+  }
+
+  /* The thread may free the sender as soon as the lock is released */
+  pthread_t thread = sender->thread;
+  pthread_mutex_lock(&sender->lock);
+  sender->orphaned = true;
+  sender->orphaned_exporter = exporter;
+  sender->orphaned_runtime = runtime;
+  sender->stopping = true;
+  if (sender->cancel_token != NULL) {
+    ddog_trace_exporter_cancel_token_cancel(sender->cancel_token);
+  }
+  pthread_cond_broadcast(&sender->work_available);
+  pthread_mutex_unlock(&sender->lock);
+  pthread_detach(thread);
+  return true;
+}
+
+static void *async_sender_join_without_gvl(void *data) {
+  async_sender_t *sender = (async_sender_t *)data;
+  pthread_join(sender->thread, NULL);
+  return NULL;
+}
+
+typedef struct {
+  async_sender_t *sender;
+  bool            include_queued;  /* otherwise, only wait for the send in progress */
+  bool            has_deadline;
+  struct timespec deadline;        /* CLOCK_REALTIME, as used by pthread_cond_timedwait */
+  bool            interrupted;
+  bool            drained;
+} async_sender_wait_args;
+
+static void *async_sender_wait_without_gvl(void *data) {
+  async_sender_wait_args *args = (async_sender_wait_args *)data;
+  async_sender_t *sender = args->sender;
+
+  pthread_mutex_lock(&sender->lock);
+  while (!args->interrupted) {
+    bool busy = sender->sending || (args->include_queued && sender->jobs_count > 0);
+    if (!busy) {
+      args->drained = true;
+      break;
+    }
+    if (!args->has_deadline) {
+      pthread_cond_wait(&sender->idle, &sender->lock);
+    } else if (pthread_cond_timedwait(&sender->idle, &sender->lock, &args->deadline) == ETIMEDOUT) {
+      break;
+    }
+  }
+  pthread_mutex_unlock(&sender->lock);
+  return NULL;
+}
+
+static void interrupt_async_sender_wait(void *data) {
+  async_sender_wait_args *args = (async_sender_wait_args *)data;
+  pthread_mutex_lock(&args->sender->lock);
+  args->interrupted = true;
+  pthread_cond_broadcast(&args->sender->idle);
+  pthread_mutex_unlock(&args->sender->lock);
+}
+
+/* Fork safety: stop picking up new payloads.  See _native_before_fork. */
+static void async_sender_before_fork(async_sender_t *sender) {
+  pthread_mutex_lock(&sender->lock);
+  sender->paused = true;
+  pthread_mutex_unlock(&sender->lock);
+}
+
+/* Not interruptible, as the fork must not happen mid-send; the wait is bounded
+ * by the exporter's request timeout. */
+static void async_sender_wait_for_send_in_progress(async_sender_t *sender) {
+  async_sender_wait_args args = {.sender = sender, .include_queued = false};
+  rb_thread_call_without_gvl(async_sender_wait_without_gvl, &args, NULL, NULL);
+}
+
+static void async_sender_after_fork_in_parent(async_sender_t *sender) {
+  pthread_mutex_lock(&sender->lock);
+  sender->paused = false;
+  pthread_cond_broadcast(&sender->work_available);
+  pthread_mutex_unlock(&sender->lock);
+}
+
+/* The sender thread does not exist in the child, and the queued payloads are
+ * still owned (and will be sent) by the parent.  The thread gets restarted by
+ * the next enqueue. */
+static void async_sender_after_fork_in_child(async_sender_t *sender) {
+  async_sender_init_sync(sender);
+  sender->thread_running = false;
+  sender->paused = false;
+  sender->sending = false;
+  sender->cancel_token = NULL;
+  async_sender_discard_pending(sender);
+}
+
+/* ------------------------------------------------------------------------
+ * TraceExporter#_native_start_async_sender
+ *
+ * Ruby signature:
+ *   exporter._native_start_async_sender(max_in_flight) -> nil
+ * ------------------------------------------------------------------------ */
+
+static VALUE _native_start_async_sender(VALUE self, VALUE max_in_flight) {
+  trace_exporter_t *wrapper = get_initialized_exporter(self);
+  long max = NUM2LONG(max_in_flight);
+  if (max < 1 || max > ASYNC_SENDER_MAX_IN_FLIGHT_LIMIT) {
+    raise_error(rb_eArgError, "max_in_flight must be between 1 and %d", ASYNC_SENDER_MAX_IN_FLIGHT_LIMIT);
+  }
+  if (wrapper->async_sender != NULL) {
+    raise_error(rb_eRuntimeError, "Async sender was already started");
+  }
+
+  async_sender_t *sender = calloc(1, sizeof(async_sender_t));
+  if (sender == NULL) rb_memerror();
+  sender->jobs = calloc((size_t)max, sizeof(async_send_job));
+  sender->results = calloc((size_t)max, sizeof(async_send_result));
+  if (sender->jobs == NULL || sender->results == NULL) {
+    free(sender->jobs);
+    free(sender->results);
+    free(sender);
+    rb_memerror();
+  }
+  sender->exporter = wrapper->exporter;
+  sender->max_in_flight = max;
+  async_sender_init_sync(sender);
+
+  int error = async_sender_start_thread(sender);
+  if (error != 0) {
+    async_sender_free(sender);
+    raise_error(rb_eRuntimeError, "Failed to start native trace sender thread: %s", strerror(error));
+  }
+  wrapper->async_sender = sender;
+
+  return Qnil;
+}
+
+static async_sender_t *get_async_sender(VALUE self) {
+  trace_exporter_t *wrapper = get_initialized_exporter(self);
+  if (wrapper->async_sender == NULL) {
+    raise_error(rb_eRuntimeError, "Async sender was not started, or was stopped");
+  }
+  return wrapper->async_sender;
+}
+
+/* ------------------------------------------------------------------------
+ * TraceExporter#_native_stop_async_sender
+ *
+ * Ruby signature:
+ *   exporter._native_stop_async_sender -> nil
+ *
+ * Cancels the send in progress, if any, and waits (with the GVL released)
+ * for the sender thread to exit.  Payloads still queued and results not
+ * polled yet are discarded, so call _native_async_flush and
+ * _native_poll_async_sends first.  Does nothing if the sender was not
+ * started.
+ * ------------------------------------------------------------------------ */
+
+static VALUE _native_stop_async_sender(VALUE self) {
+  trace_exporter_t *wrapper = get_initialized_exporter(self);
+  async_sender_t *sender = wrapper->async_sender;
+  if (sender == NULL) return Qnil;
+
+  /* Detached first, so the fork hooks (which may run while the GVL is
+   * released) and GC leave it alone */
+  wrapper->async_sender = NULL;
+  async_sender_request_stop(sender);
+  /* Not interruptible: the wait is bounded by the cancellation of the send
+   * in progress. */
+  if (sender->thread_running) {
+    rb_thread_call_without_gvl(async_sender_join_without_gvl, sender, NULL, NULL);
+    sender->thread_running = false;
+  }
+  async_sender_free(sender);
+
+  return Qnil;
+}
+
+/* Called with the lock held */
+static void async_sender_count_dropped(async_sender_t *sender, long trace_count) {
+  sender->dropped++;
+  sender->traces_dropped += (uint64_t)trace_count;
+}
+
+/* ------------------------------------------------------------------------
+ * TraceExporter#_native_enqueue_traces
+ *
+ * Ruby signature:
+ *   exporter._native_enqueue_traces(traces) -> true | false
+ *
+ * Accepts the same +traces+ as _native_send_traces, and queues each of their
+ * payloads separately.  Returns false, without converting anything, when
+ * +max_in_flight+ payloads are already queued or being sent, and also when
+ * only some of the payloads fit (the others are dropped).
+ * ------------------------------------------------------------------------ */
+
+/* Body: build the payloads, then queue them.  Passed to rb_ensure. */
+static VALUE build_and_enqueue_traces(VALUE arg) {
+  send_traces_ctx *ctx = (send_traces_ctx *)arg;
+  async_sender_t *sender = ctx->async_sender;
+
+  build_trace_chunks(ctx);
+
+  long queued = 0;
+  pthread_mutex_lock(&sender->lock);
+  for (long i = 0; i < ctx->payload_count; i++) {
+    trace_payload *payload = &ctx->payloads[i];
+    /* Converting may have released the GVL, so check for room again */
+    if (async_sender_in_flight(sender) < sender->max_in_flight) {
+      long position = (sender->jobs_head + sender->jobs_count) % sender->max_in_flight;
+      sender->jobs[position] = (async_send_job){
+        .chunks      = payload->chunks,
+        .trace_count = payload->trace_count,
+        .duplicate_string_bytes = payload->strings.duplicate_bytes,
+      };
+      sender->jobs_count++;
+      sender->enqueued++;
+      payload->chunks = NULL;  /* now owned by the sender */
+      queued++;
+    } else {
+      async_sender_count_dropped(sender, payload->trace_count);
+    }
+  }
+  if (queued > 0) pthread_cond_signal(&sender->work_available);
+  pthread_mutex_unlock(&sender->lock);
+
+  return queued == ctx->payload_count ? Qtrue : Qfalse;
+}
+
+static VALUE _native_enqueue_traces(VALUE self, VALUE traces) {
+  ENFORCE_TYPE(traces, T_ARRAY);
+  trace_exporter_t *wrapper = get_initialized_exporter(self);
+  async_sender_t *sender = get_async_sender(self);
+
+  if (RARRAY_LEN(traces) == 0) return Qtrue;
+
+  /* Restart the sender thread in a forked child */
+  if (!sender->thread_running) {
+    int error = async_sender_start_thread(sender);
+    if (error != 0) {
+      raise_error(rb_eRuntimeError, "Failed to start native trace sender thread: %s", strerror(error));
+    }
+  }
+
+  bool full;
+  pthread_mutex_lock(&sender->lock);
+  full = async_sender_in_flight(sender) >= sender->max_in_flight;
+  if (full) async_sender_count_dropped(sender, RARRAY_LEN(traces));
+  pthread_mutex_unlock(&sender->lock);
+  if (full) return Qfalse;
+
+  return with_trace_chunks(wrapper, traces, build_and_enqueue_traces);
+}
+
+/* ------------------------------------------------------------------------
+ * TraceExporter#_native_poll_async_sends
+ *
+ * Ruby signature:
+ *   exporter._native_poll_async_sends -> Array[Response]
+ *
+ * Returns one Response per send completed since the previous call, oldest
+ * first.
+ * ------------------------------------------------------------------------ */
+
+typedef struct {
+  async_send_result *results;
+  VALUE             *payloads;
+  long               count;
+} poll_results_ctx;
+
+static VALUE copy_result_bodies(VALUE arg) {
+  poll_results_ctx *ctx = (poll_results_ctx *)arg;
+  for (long i = 0; i < ctx->count; i++) {
+    ctx->payloads[i] = Qnil;
+  }
+  for (long i = 0; i < ctx->count; i++) {
+    async_send_result *result = &ctx->results[i];
+    if (result->body != NULL) {
+      ctx->payloads[i] = rb_str_new((const char *)result->body, (long)result->body_len);
+      free(result->body);
+      result->body = NULL;
+    }
+  }
+  return Qnil;
+}
+
+/* Ensure: frees the bodies not copied when rb_str_new raised */
+static VALUE free_result_bodies(VALUE arg) {
+  poll_results_ctx *ctx = (poll_results_ctx *)arg;
+  for (long i = 0; i < ctx->count; i++) {
+    free(ctx->results[i].body);
+    ctx->results[i].body = NULL;
+  }
+  return Qnil;
+}
+
+static VALUE _native_poll_async_sends(VALUE self) {
+  async_sender_t *sender = get_async_sender(self);
+
+  /* Take the results out under the lock, then build the Responses without it */
+  async_send_result results[ASYNC_SENDER_MAX_IN_FLIGHT_LIMIT];
+  long count = 0;
+  pthread_mutex_lock(&sender->lock);
+  for (; sender->results_count > 0; sender->results_count--) {
+    results[count++] = sender->results[sender->results_head];
+    sender->results_head = (sender->results_head + 1) % sender->max_in_flight;
+  }
+  pthread_mutex_unlock(&sender->lock);
+
+  /* Copy (and free) every body first; building the Responses calls Ruby code */
+  VALUE payloads[ASYNC_SENDER_MAX_IN_FLIGHT_LIMIT];
+  poll_results_ctx ctx = {.results = results, .payloads = payloads, .count = count};
+  rb_ensure(copy_result_bodies, (VALUE)&ctx, free_result_bodies, (VALUE)&ctx);
+
+  VALUE responses = rb_ary_new_capa(count);
+  for (long i = 0; i < count; i++) {
+    VALUE response = results[i].failed ?
+        create_error_response(results[i].error_code, results[i].trace_count) :
+        create_ok_response(results[i].trace_count, payloads[i],
+                           results[i].duplicate_string_bytes);
+    rb_ary_push(responses, response);
+  }
+  return responses;
+}
+
+/* ------------------------------------------------------------------------
+ * TraceExporter#_native_async_flush
+ *
+ * Ruby signature:
+ *   exporter._native_async_flush(timeout_seconds) -> true | false
+ *
+ * Waits (with the GVL released) until every queued payload was sent.
+ * Returns false if that did not happen within +timeout_seconds+.
+ * ------------------------------------------------------------------------ */
+
+static VALUE _native_async_flush(VALUE self, VALUE timeout_seconds) {
+  async_sender_t *sender = get_async_sender(self);
+  double timeout = NUM2DBL(timeout_seconds);
+
+  /* A forked child has nothing of its own queued until the thread restarts */
+  if (!sender->thread_running) return Qtrue;
+
+  async_sender_wait_args args = {.sender = sender, .include_queued = true, .has_deadline = true};
+  clock_gettime(CLOCK_REALTIME, &args.deadline);
+  long long deadline_ns =
+      (long long)args.deadline.tv_nsec + (long long)(timeout > 0 ? timeout * 1e9 : 0);
+  args.deadline.tv_sec += (time_t)(deadline_ns / 1000000000LL);
+  args.deadline.tv_nsec = (long)(deadline_ns % 1000000000LL);
+
+  rb_thread_call_without_gvl(
+      async_sender_wait_without_gvl, &args,
+      interrupt_async_sender_wait, &args);
+  if (args.interrupted) rb_thread_check_ints();
+
+  return args.drained ? Qtrue : Qfalse;
+}
+
+/* ------------------------------------------------------------------------
+ * TraceExporter#_native_async_stats
+ *
+ * Ruby signature:
+ *   exporter._native_async_stats -> Hash
+ * ------------------------------------------------------------------------ */
+
+static VALUE _native_async_stats(VALUE self) {
+  async_sender_t *sender = get_async_sender(self);
+
+  pthread_mutex_lock(&sender->lock);
+  long in_flight = async_sender_in_flight(sender);
+  uint64_t enqueued = sender->enqueued;
+  uint64_t dropped = sender->dropped;
+  uint64_t traces_dropped = sender->traces_dropped;
+  uint64_t completed = sender->completed;
+  uint64_t results_dropped = sender->results_dropped;
+  pthread_mutex_unlock(&sender->lock);
+
+  VALUE stats = rb_hash_new();
+  rb_hash_aset(stats, ID2SYM(rb_intern("in_flight")),       LONG2NUM(in_flight));
+  rb_hash_aset(stats, ID2SYM(rb_intern("max_in_flight")),   LONG2NUM(sender->max_in_flight));
+  rb_hash_aset(stats, ID2SYM(rb_intern("enqueued")),        ULL2NUM(enqueued));
+  rb_hash_aset(stats, ID2SYM(rb_intern("dropped")),         ULL2NUM(dropped));
+  rb_hash_aset(stats, ID2SYM(rb_intern("traces_dropped")),  ULL2NUM(traces_dropped));
+  rb_hash_aset(stats, ID2SYM(rb_intern("completed")),       ULL2NUM(completed));
+  rb_hash_aset(stats, ID2SYM(rb_intern("results_dropped")), ULL2NUM(results_dropped));
+  return stats;
+}
+
 /* ========================================================================
  * Initialization
  * ======================================================================== */
@@ -1241,6 +2978,17 @@ void trace_exporter_init(VALUE tracing_module) {
   rb_define_singleton_method(tracer_span_class, "_native_from_span",
                              _native_from_span, 1);
 
+  /* ----------------------------------------------------------------
+   * TraceChunk class
+   * ---------------------------------------------------------------- */
+  trace_chunk_class =
+      rb_define_class_under(native_module, "TraceChunk", rb_cObject);
+  rb_undef_alloc_func(trace_chunk_class);
+
+  /* Factory */
+  rb_define_singleton_method(trace_chunk_class, "_native_from_spans",
+                             _native_chunk_from_spans, 1);
+
   /* ----------------------------------------------------------------
    * TraceExporter class
    * ---------------------------------------------------------------- */
@@ -1256,6 +3004,26 @@ void trace_exporter_init(VALUE tracing_module) {
   rb_define_method(trace_exporter_class, "_native_send_traces",
                    _native_send_traces, 1);
 
+  /* Instance: _native_prepare_trace(trace_segment) -> TraceChunk */
+  rb_define_method(trace_exporter_class, "_native_prepare_trace",
+                   _native_prepare_trace, 1);
+  rb_define_method(trace_exporter_class, "_native_set_first_span_tags",
+                   _native_set_first_span_tags, 1);
+
+  /* Instance: asynchronous sends */
+  rb_define_method(trace_exporter_class, "_native_start_async_sender",
+                   _native_start_async_sender, 1);
+  rb_define_method(trace_exporter_class, "_native_stop_async_sender",
+                   _native_stop_async_sender, 0);
+  rb_define_method(trace_exporter_class, "_native_enqueue_traces",
+                   _native_enqueue_traces, 1);
+  rb_define_method(trace_exporter_class, "_native_poll_async_sends",
+                   _native_poll_async_sends, 0);
+  rb_define_method(trace_exporter_class, "_native_async_flush",
+                   _native_async_flush, 1);
+  rb_define_method(trace_exporter_class, "_native_async_stats",
+                   _native_async_stats, 0);
+
   /* Instance: fork safety hooks */
   rb_define_method(trace_exporter_class, "_native_before_fork",
                    _native_before_fork, 0);
@@ -1293,6 +3061,33 @@ void trace_exporter_init(VALUE tracing_module) {
   at_meta_id       = rb_intern("@meta");
   at_metrics_id    = rb_intern("@metrics");
   at_metastruct_id = rb_intern("@metastruct");
+  at_events_id     = rb_intern("@events");
+  at_links_id      = rb_intern("@links");
+
+  /* SpanEvent / SpanLink ivars */
+  at_attributes_id         = rb_intern("@attributes");
+  at_time_unix_nano_id     = rb_intern("@time_unix_nano");
+  at_span_id_id            = rb_intern("@span_id");
+  at_trace_flags_id        = rb_intern("@trace_flags");
+  at_trace_state_id        = rb_intern("@trace_state");
+  at_dropped_attributes_id = rb_intern("@dropped_attributes");
+
+  /* TraceSegment ivars */
+  at_spans_id                   = rb_intern("@spans");
+  at_root_span_id_id            = rb_intern("@root_span_id");
+  at_agent_sample_rate_id       = rb_intern("@agent_sample_rate");
+  at_hostname_id                = rb_intern("@hostname");
+  at_lang_id                    = rb_intern("@lang");
+  at_origin_id                  = rb_intern("@origin");
+  at_process_id_id              = rb_intern("@process_id");
+  at_rate_limiter_rate_id       = rb_intern("@rate_limiter_rate");
+  at_rule_sample_rate_id        = rb_intern("@rule_sample_rate");
+  at_runtime_id_id              = rb_intern("@runtime_id");
+  at_sample_rate_id             = rb_intern("@sample_rate");
+  at_sampling_decision_maker_id = rb_intern("@sampling_decision_maker");
+  at_sampling_priority_id       = rb_intern("@sampling_priority");
+  at_profiling_enabled_id       = rb_intern("@profiling_enabled");
+  at_apm_tracing_enabled_id     = rb_intern("@apm_tracing_enabled");
 
   /* Methods */
   id_duration_method = rb_intern("duration");
@@ -1309,4 +3104,5 @@ void trace_exporter_init(VALUE tracing_module) {
   kw_client_error   = rb_intern("client_error");
   kw_trace_count    = rb_intern("trace_count");
   kw_payload        = rb_intern("payload");
+  kw_duplicate_string_bytes = rb_intern("duplicate_string_bytes");
 }
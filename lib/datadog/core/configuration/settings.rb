@@ -328,6 +328,16 @@ module Datadog
               o.default true
             end
 
+            # Records each individual garbage collection step (above a minimum duration, or ending a major GC) as its
+            # own timeline event, including the GC reason and the number of heap pages freed, instead of only showing
+            # GC time coalesced into one event per ~10ms. Requires `gc_enabled`.
+            #
+            # @warn This setting is experimental and may be removed or changed in future versions.
+            option :experimental_gc_timeline_events_enabled do |o|
+              o.type :bool
+              o.default false
+            end
+
             # Can be used to enable/disable the Datadog::Profiling.allocation_count feature.
             #
             # Requires allocation profiling to be enabled.
@@ -338,6 +348,18 @@ module Datadog
               o.default false
             end
 
+            # Can be used to switch allocation sampling from picking every Nth allocation to picking allocations at
+            # randomized (exponentially-distributed) byte intervals. This makes bigger objects proportionally more likely
+            # to be sampled and avoids biases from periodic allocation patterns.
+            #
+            # This feature is experimental and disabled by default. Requires allocation profiling to be enabled.
+            #
+            # @default false
+            option :experimental_allocation_poisson_sampling_enabled do |o|
+              o.type :bool
+              o.default false
+            end
+
             # Can be used to enable/disable the collection of heap profiles.
             #
             # This feature is in preview and disabled by default. Requires Ruby 3.1+.
@@ -4,6 +4,9 @@ module Datadog
   module Core
     # Used to access ddsketch APIs.
     # APIs in this class are implemented as native code.
+    #
+    # Points are binned natively with ~0.78% relative accuracy; the libdatadog sketch is only built when encoding,
+    # which is why sketches can be merged, queried for quantiles, and encoded without being reset.
     class DDSketch
       def self.supported?
         Datadog::Core::LIBDATADOG_API_FAILURE.nil?
@@ -14,6 +17,14 @@ module Datadog
           raise(ArgumentError, "DDSketch is not supported: #{Datadog::Core::LIBDATADOG_API_FAILURE}")
         end
       end
+
+      # Encodes the sketch to the protobuf format expected by the agent.
+      #
+      # @param reset [Boolean] whether to empty the sketch afterwards, so that it can be reused
+      # @return [String] the encoded sketch as a binary string
+      def encode(reset: true)
+        _native_encode(reset)
+      end
     end
   end
 end
@@ -18,8 +18,25 @@ module Datadog
       class Configuration # rubocop:disable Lint/EmptyClass
       end
 
+      # Evaluation context built once from a Hash, to be reused by many
+      # Configuration#get_assignment (or #get_assignments) calls
+      # This class is defined in the C extension
+      class EvaluationContext # rubocop:disable Lint/EmptyClass
+      end
+
+      # Buffer of exposures for the OpenFeature exposures worker, deduplicating
+      # repeated exposures of a subject to the same flag evaluation
+      # This class is defined in the C extension
+      class ExposureBuffer # rubocop:disable Lint/EmptyClass
+      end
+
       # Resolution details for a feature flag evaluation
       # Base class is defined in the C extension, with Ruby methods added here
+      #
+      # The native fields are converted once per evaluation, and evaluations
+      # served from the cache of the Configuration share them, except for
+      # the raw value, which each of them gets its own copy of. Variants,
+      # allocation keys, reasons, error codes and flag metadata are frozen.
       class ResolutionDetails
         attr_writer :value
 
@@ -30,7 +47,6 @@ module Datadog
         def value
           return @value if defined?(@value)
 
-          # NOTE: Raw value method call doesn't support memoization right now
           value = raw_value
 
           # NOTE: Lazy parsing of the JSON is a temporary solution and will be
@@ -4,6 +4,7 @@
 
 require_relative "error"
 require_relative "fatal_exceptions"
+require_relative "path_registry"
 
 module Datadog
   module DI
@@ -22,8 +23,9 @@ module Datadog
     # @api private
     class CodeTracker
       def initialize
-        @registry = {}
-        @per_method_registry = {}
+        @registry = PathRegistry.new
+        @per_method_registry = PathRegistry.new
+        @line_indexes = {}
         @trace_point_lock = Mutex.new
         @registry_lock = Mutex.new
         @compiled_trace_point = nil
@@ -32,8 +34,9 @@ module Datadog
       # Populates the registry with iseqs for files that were loaded
       # before code tracking started.
       #
-      # Uses the all_iseqs C extension to walk the Ruby object space and
-      # find instruction sequences for already-loaded code. Whole-file
+      # Uses the file_iseqs C extension to walk the Ruby object space and
+      # find instruction sequences for already-loaded code, grouped by
+      # file (eval'd code is skipped during the walk). Whole-file
       # iseqs are stored in the main registry; per-method/block/class
       # iseqs are stored in per_method_registry as fallback for files
       # whose whole-file iseq was GC'd.
@@ -58,65 +61,64 @@ module Datadog
       #
       # @return [void]
       def backfill_registry
-        iseqs = DI.file_iseqs
+        iseqs_by_path = DI.file_iseqs
         have_iseq_type = DI.respond_to?(:iseq_type)
         registry_lock.synchronize do
-          iseqs.each do |iseq|
-            path = iseq.absolute_path
-            next unless path
+          iseqs_by_path.each do |path, iseqs|
+            iseqs.each do |iseq|
+              whole_file = if have_iseq_type
+                type = DI.iseq_type(iseq)
+                # Require first_lineno == 0 to exclude compile_file/compile
+                # iseqs. These are :top type but have first_lineno == 1 and
+                # produce iseq objects distinct from require-produced iseqs.
+                # Targeted TracePoints are bound to the specific iseq object
+                # — a probe on a compile_file iseq silently never fires when
+                # the require-produced code runs.
+                (type == :top || type == :main) && iseq.first_lineno == 0
+              else
+                iseq.first_lineno == 0
+              end
 
-            whole_file = if have_iseq_type
-              type = DI.iseq_type(iseq)
-              # Require first_lineno == 0 to exclude compile_file/compile
-              # iseqs. These are :top type but have first_lineno == 1 and
-              # produce iseq objects distinct from require-produced iseqs.
-              # Targeted TracePoints are bound to the specific iseq object
-              # — a probe on a compile_file iseq silently never fires when
-              # the require-produced code runs.
-              (type == :top || type == :main) && iseq.first_lineno == 0
-            else
-              iseq.first_lineno == 0
-            end
+              if whole_file
+                # Ruby 3.2.9+ creates dummy profiler iseqs during require/load
+                # (rb_iseq_alloc_with_dummy_path in iseq.c). These have type
+                # :top, first_lineno == 0, and the same absolute_path as the
+                # real iseq — but iseq_size == 0 (no bytecode). A targeted
+                # TracePoint on a dummy iseq can't find child iseqs and raises
+                # ArgumentError "can not enable any hooks". Filter them out:
+                # a real top-level iseq always has at least one trace event.
+                next if iseq.trace_points.empty?
 
-            if whole_file
-              # Ruby 3.2.9+ creates dummy profiler iseqs during require/load
-              # (rb_iseq_alloc_with_dummy_path in iseq.c). These have type
-              # :top, first_lineno == 0, and the same absolute_path as the
-              # real iseq — but iseq_size == 0 (no bytecode). A targeted
-              # TracePoint on a dummy iseq can't find child iseqs and raises
-              # ArgumentError "can not enable any hooks". Filter them out:
-              # a real top-level iseq always has at least one trace event.
-              next if iseq.trace_points.empty?
+                # Do not overwrite entries from :script_compiled — those are
+                # captured at load time and are authoritative.
+                next if registry.key?(path)
 
-              # Do not overwrite entries from :script_compiled — those are
-              # captured at load time and are authoritative.
-              next if registry.key?(path)
+                registry[path] = iseq
+              else
+                # Skip top-level script iseqs (:top/:main) produced by
+                # RubyVM::InstructionSequence.compile_file and .compile
+                # (compile source to bytecode without executing it).
+                # These represent the file body,
+                # not a method or block. They pass the first_lineno check
+                # (lineno != 0) but a targeted TracePoint bound to one
+                # of these never fires for method-level code — the
+                # user's probe silently produces no snapshots.
+                #
+                # On Ruby < 3.1 (no iseq_type), we cannot distinguish
+                # these from method iseqs, so they leak into
+                # per_method_registry. If iseq_for_line selects a leaked
+                # top-level iseq instead of the real method iseq, the
+                # probe installs but silently never fires — same failure
+                # as above. This requires the application to call
+                # compile_file and hold the result, which is rare outside
+                # tooling like bootsnap (which discards it).
+                next if have_iseq_type && (type == :top || type == :main)
 
-              registry[path] = iseq
-            else
-              # Skip top-level script iseqs (:top/:main) produced by
-              # RubyVM::InstructionSequence.compile_file and .compile
-              # (compile source to bytecode without executing it).
-              # These represent the file body,
-              # not a method or block. They pass the first_lineno check
-              # (lineno != 0) but a targeted TracePoint bound to one
-              # of these never fires for method-level code — the
-              # user's probe silently produces no snapshots.
-              #
-              # On Ruby < 3.1 (no iseq_type), we cannot distinguish
-              # these from method iseqs, so they leak into
-              # per_method_registry. If iseq_for_line selects a leaked
-              # top-level iseq instead of the real method iseq, the
-              # probe installs but silently never fires — same failure
-              # as above. This requires the application to call
-              # compile_file and hold the result, which is rare outside
-              # tooling like bootsnap (which discards it).
-              next if have_iseq_type && (type == :top || type == :main)
-
-              # Store per-method/block/class iseqs as fallback for files
-              # whose whole-file iseq was GC'd. These can be used to
-              # target line probes on lines within their range.
-              (per_method_registry[path] ||= []) << iseq
+                # Store per-method/block/class iseqs as fallback for files
+                # whose whole-file iseq was GC'd. These can be used to
+                # target line probes on lines within their range.
+                (per_method_registry[path] ||= []) << iseq
+              end
             end
           end
         end
@@ -249,37 +251,8 @@ module Datadog
       # If no paths match, an empty array is returned.
       def iseqs_for_path_suffix(suffix)
         registry_lock.synchronize do
-          exact = registry[suffix]
-          return [suffix, exact] if exact
-
-          # Normalize Windows-style backslash separators (DEBUG-5111) upfront
-          # so the suffix-shortening loop's "/+" regex can strip leading
-          # components on probes whose sourceFile uses backslashes.
-          suffix = Utils.normalize_windows_separators(suffix)
-
-          # Per the design comment in utils.rb, attempt case-sensitive
-          # matching first (steps 5-6) and only fall back to case-insensitive
-          # matching (steps 7-8) when no case-sensitive match is found.
-          [false, true].each do |case_insensitive|
-            working_suffix = suffix.dup
-            loop do
-              inexact = []
-              registry.each do |path, iseq|
-                if Utils.path_matches_suffix?(path, working_suffix, case_insensitive: case_insensitive)
-                  inexact << [path, iseq]
-                end
-              end
-              if inexact.length > 1
-                raise Error::MultiplePathsMatch, "Multiple paths matched requested suffix"
-              end
-              if inexact.any?
-                return inexact.first
-              end
-              break unless working_suffix.include?("/")
-              working_suffix.sub!(%r{.*/+}, "")
-            end
-          end
-          nil
+          path = registry.resolve_path_suffix(suffix)
+          path ? [path, registry[path]] : nil
         end
       end
 
@@ -300,23 +273,13 @@ module Datadog
         # Fall back to per-method iseqs.
         registry_lock.synchronize do
           # Resolve the path using the per-method registry keys.
-          path = resolve_path_suffix(suffix, per_method_registry.keys)
+          path = per_method_registry.resolve_path_suffix(suffix)
           return nil unless path
 
           iseqs = per_method_registry[path]
           return nil unless iseqs
 
-          # Only match event types the instrumenter subscribes to
-          # (:line, :return, :b_return — see hook_line). Lines that
-          # only carry :call (e.g. a `def` line within the defined
-          # method's own iseq, not the enclosing scope) have no
-          # subscribed event at that position; TracePoint#enable
-          # raises because it cannot bind an enabled event there.
-          matches = iseqs.select do |iseq|
-            iseq.trace_points.any? do |tp_line, event|
-              tp_line == line && (event == :line || event == :return || event == :b_return)
-            end
-          end
+          matches = iseqs_at_line(path, iseqs, line)
           # When multiple iseqs contain the target line (e.g. a method
           # and an inline block sharing the same line), picking one
           # would silently miss executions in the other context.
@@ -355,6 +318,7 @@ module Datadog
         registry_lock.synchronize do
           registry.clear
           per_method_registry.clear
+          @line_indexes.clear
         end
       end
 
@@ -371,33 +335,37 @@ module Datadog
       attr_reader :trace_point_lock
       attr_reader :registry_lock
 
-      # Resolves a path suffix against a set of known paths.
-      # Returns the matching path or nil.
+      # Returns the per-method iseqs of the file at +path+ which a line
+      # probe on +line+ can target.
+      #
+      # Only event types the instrumenter subscribes to (:line, :return,
+      # :b_return — see hook_line) are considered. Lines that only carry
+      # :call (e.g. a `def` line within the defined method's own iseq,
+      # not the enclosing scope) have no subscribed event at that
+      # position; TracePoint#enable raises because it cannot bind an
+      # enabled event there.
+      #
+      # When the C extension is available, the lines of the file's iseqs
+      # are indexed by DI::LineIndex the first time the file is probed,
+      # instead of going through the trace points of every iseq for every
+      # probe. The index is rebuilt if iseqs were added to the file since.
       #
       # Must be called within registry_lock.
-      def resolve_path_suffix(suffix, paths)
-        # Exact match.
-        return suffix if paths.include?(suffix)
-
-        # Normalize Windows-style backslash separators (DEBUG-5111) upfront
-        # so the suffix-shortening loop's "/+" regex can strip leading
-        # components on probes whose sourceFile uses backslashes.
-        suffix = Utils.normalize_windows_separators(suffix)
-
-        # Suffix match. Per the design comment in utils.rb, attempt
-        # case-sensitive matching first (steps 5-6) and only fall back to
-        # case-insensitive (steps 7-8) when no case-sensitive match is found.
-        [false, true].each do |case_insensitive|
-          working_suffix = suffix.dup
-          loop do
-            matches = paths.select { |p| Utils.path_matches_suffix?(p, working_suffix, case_insensitive: case_insensitive) }
-            raise Error::MultiplePathsMatch, "Multiple paths matched requested suffix" if matches.length > 1
-            return matches.first if matches.any?
-            break unless working_suffix.include?("/")
-            working_suffix.sub!(%r{.*/+}, "")
+      def iseqs_at_line(path, iseqs, line)
+        unless defined?(DI::LineIndex)
+          return iseqs.select do |iseq|
+            iseq.trace_points.any? do |tp_line, event|
+              tp_line == line && (event == :line || event == :return || event == :b_return)
+            end
           end
         end
-        nil
+
+        indexed_count, line_index = @line_indexes[path]
+        unless indexed_count == iseqs.length
+          line_index = DI::LineIndex.new(iseqs)
+          @line_indexes[path] = [iseqs.length, line_index]
+        end
+        line_index.iseqs_at(line)
       end
     end
   end
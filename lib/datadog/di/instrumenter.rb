@@ -162,6 +162,7 @@ module Datadog
         loc = target_method&.source_location
         # @type var instrumenter: Instrumenter
         instrumenter = self
+        rate_limiter = early_rate_limiter(probe)
 
         mod = Module.new do
           # Argument delegation follows docs/Delegation.md: on Ruby 3+
@@ -186,6 +187,9 @@ module Datadog
           # access it directly, bypassing Thread#[]/Thread#[]= method dispatch
           # so user probes on those cannot recurse.
           #
+          # Invocations of a probe over its rate limit are skipped in the
+          # same check, see #early_rate_limiter.
+          #
           # The original method is invoked via super. That super call lives
           # in a block passed to #run_method_probe and captures its binding
           # from inside this define_method block — the only place super
@@ -198,7 +202,7 @@ module Datadog
               # steep:ignore FallbackAny below: Steep cannot narrow the
               # **kwargs parameter inside this define_method block, so it
               # falls back to untyped at the super and run_method_probe sites.
-              if DI.in_probe?
+              if rate_limiter&.exhausted? || DI.in_probe?
                 return super(*args, **kwargs, &target_block) # steep:ignore FallbackAny
               end
 
@@ -213,7 +217,7 @@ module Datadog
             end
           else
             define_method(method_name) do |*args, &target_block|
-              if DI.in_probe?
+              if rate_limiter&.exhausted? || DI.in_probe?
                 return super(*args, &target_block)
               end
 
@@ -350,7 +354,10 @@ module Datadog
         else
           [:line]
         end
+        rate_limiter = early_rate_limiter(probe)
         tp = TracePoint.new(*types) do |tp|
+          next if rate_limiter&.exhausted?
+
           line_trace_point_callback(probe, iseq, responder, tp)
         end
 
@@ -811,6 +818,24 @@ module Datadog
         # TODO test this path
       end
 
+      # Returns the rate limiter of the probe if it can be checked before
+      # #run_method_probe or #line_trace_point_callback is invoked, or nil.
+      #
+      # DI::ProbeRateLimiter#exhausted? is implemented in C and does not
+      # take a token, so invocations of a probe over its rate limit are
+      # skipped for the cost of a C method call instead of going through
+      # the Ruby callbacks only to be denied by the rate limiter there.
+      # Probes with a condition are not checked early: their condition is
+      # evaluated on every invocation so that evaluation errors are
+      # reported regardless of the probe rate limit.
+      def early_rate_limiter(probe)
+        return if probe.condition
+        return unless defined?(DI::ProbeRateLimiter)
+
+        rate_limiter = probe.rate_limiter
+        rate_limiter if DI::ProbeRateLimiter === rate_limiter
+      end
+
       def build_trace_point_context(probe, tp)
         stack = caller_locations
         # We have two helper methods being invoked from the trace point
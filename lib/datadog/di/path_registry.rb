@@ -0,0 +1,130 @@
+# frozen_string_literal: true
+
+require_relative "error"
+require_relative "utils"
+
+module Datadog
+  module DI
+    # Mapping from paths of loaded files to their compiled code, which
+    # can resolve the path suffixes specified in line probes.
+    #
+    # Applications can have tens of thousands of loaded files; checking
+    # every path against the suffix (several times, as the suffix is
+    # shortened) made installing a line probe linear in the number of
+    # loaded files. When the C extension is available, the paths are
+    # additionally kept in DI::PathIndex (a trie over path components),
+    # where a suffix lookup only depends on the number of components
+    # in the suffix.
+    #
+    # This class is not thread-safe; CodeTracker serializes access
+    # to its registries.
+    #
+    # @api private
+    class PathRegistry
+      include Enumerable
+
+      def initialize
+        @entries = {}
+        @index = nil
+      end
+
+      def [](path)
+        @entries[path]
+      end
+
+      def []=(path, value)
+        @index&.add(path) unless @entries.key?(path)
+        @entries[path] = value
+      end
+
+      def delete(path)
+        @index&.delete(path)
+        @entries.delete(path)
+      end
+
+      def clear
+        @index&.clear
+        @entries.clear
+        self
+      end
+
+      def key?(path)
+        @entries.key?(path)
+      end
+
+      def keys
+        @entries.keys
+      end
+
+      def length
+        @entries.length
+      end
+
+      def empty?
+        @entries.empty?
+      end
+
+      def each(&block)
+        return enum_for(:each) unless block
+
+        @entries.each(&block)
+        self
+      end
+
+      # Returns the path matching the path suffix of a line probe, or nil.
+      #
+      # An exact match is returned if there is one. Otherwise, per the
+      # design comment in utils.rb, the suffix is matched case-sensitively
+      # first (steps 5-6) and only case-insensitively (steps 7-8) when no
+      # case-sensitive match is found, shortening it one leading path
+      # component at a time until it matches.
+      #
+      # @raise [Error::MultiplePathsMatch] if the suffix matches more than one path
+      def resolve_path_suffix(suffix)
+        return suffix if @entries.key?(suffix)
+
+        # Normalize Windows-style backslash separators (DEBUG-5111) upfront
+        # so the suffix-shortening loop's "/+" regex can strip leading
+        # components on probes whose sourceFile uses backslashes.
+        suffix = Utils.normalize_windows_separators(suffix)
+
+        [false, true].each do |case_insensitive|
+          working_suffix = suffix.dup
+          loop do
+            matches = paths_matching_suffix(working_suffix, case_insensitive)
+            raise Error::MultiplePathsMatch, "Multiple paths matched requested suffix" if matches.length > 1
+            return matches.first if matches.any?
+            break unless working_suffix.include?("/")
+            working_suffix.sub!(%r{.*/+}, "")
+          end
+        end
+        nil
+      end
+
+      private
+
+      # Returns up to two of the paths matching the suffix, which is
+      # enough to know whether the match is ambiguous.
+      def paths_matching_suffix(suffix, case_insensitive)
+        if (index = self.index)
+          index.match(suffix, case_insensitive)
+        else
+          @entries.each_key.select do |path|
+            Utils.path_matches_suffix?(path, suffix, case_insensitive: case_insensitive)
+          end.first(2)
+        end
+      end
+
+      # The index is created on first lookup, so that paths registered
+      # before the C extension was loaded are indexed too.
+      def index
+        return @index if @index
+        return unless defined?(DI::PathIndex)
+
+        index = DI::PathIndex.new
+        @entries.each_key { |path| index.add(path) }
+        @index = index
+      end
+    end
+  end
+end
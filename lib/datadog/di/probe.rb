@@ -98,7 +98,14 @@ module Datadog
         @condition = condition
 
         @rate_limit = rate_limit || ((@capture_snapshot || !@capture_expressions.empty?) ? 1 : 5000)
-        @rate_limiter = Datadog::Core::TokenBucket.new(@rate_limit)
+        # The native rate limiter can be checked by the instrumenter before
+        # any Ruby code runs for a probe invocation, see
+        # Instrumenter#early_rate_limiter.
+        @rate_limiter = if defined?(DI::ProbeRateLimiter)
+          DI::ProbeRateLimiter.new(@rate_limit)
+        else
+          Datadog::Core::TokenBucket.new(@rate_limit)
+        end
 
         # At most one report per second.
         # We create the rate limiter here even though it may never be used,
@@ -57,8 +57,7 @@ module Datadog
         end
       end
 
-      private
-
+      # The normalized identifiers to redact. Also read by DI::NativeSerializer.
       def redacted_identifiers
         @redacted_identifiers ||= begin
           names = DEFAULT_REDACTED_IDENTIFIERS + settings.dynamic_instrumentation.redacted_identifiers
@@ -72,6 +71,8 @@ module Datadog
         end
       end
 
+      # Regexp matching the names of the classes to redact. Also read by
+      # DI::NativeSerializer.
       def redacted_type_names_regexp
         @redacted_type_names_regexp ||= begin
           names = settings.dynamic_instrumentation.redacted_type_names
@@ -96,6 +97,8 @@ module Datadog
         end
       end
 
+      private
+
       # Copied from dd-trace-py
       DEFAULT_REDACTED_IDENTIFIERS = [
         "2fa",
@@ -173,6 +173,13 @@ module Datadog
       # (integers, strings, arrays, hashes).
       #
       # Respects string length, collection size and traversal depth limits.
+      #
+      # When the C extension is available, values are serialized by
+      # DI::NativeSerializer, which produces the same result without
+      # going through Ruby method dispatch for every serialized node.
+      # It hands values it does not serialize itself (those targeted by
+      # custom serializers, or whose serialization raises) back to
+      # #serialize_value_in_ruby.
       def serialize_value(value, name: nil,
         depth: settings.dynamic_instrumentation.max_capture_depth,
         attribute_count: nil,
@@ -180,6 +187,132 @@ module Datadog
         collection_size: nil,
         type: nil)
         attribute_count ||= settings.dynamic_instrumentation.max_capture_attribute_count
+        if type.nil? && (native = native_serializer)
+          native.serialize(value, name, depth, attribute_count, length, collection_size, @@flat_registry)
+        else
+          serialize_value_in_ruby(value, name, depth, attribute_count, length, collection_size, type)
+        end
+      end
+
+      # This method is used for serializing arbitrary values into log messages.
+      # Because the output is meant to be human-readable, we cannot use
+      # the "normal" serialization format which is meant to be machine-readable.
+      # Serialize objects with depth of 1 and include the class name.
+      #
+      # Note that this method does not (currently) utilize the custom
+      # serializers that the "normal" serialization logic uses.
+      #
+      # This serializer differs from the RFC in two ways:
+      # 1. We omit the middle of long strings rather than the end,
+      #    and also the inner entries in arrays/hashes/objects.
+      # 2. We use Ruby-ish syntax for hashes and objects.
+      #
+      # We also use the Ruby-like syntax for symbols, which don't exist
+      # in other languages.
+      #
+      # +name+, when given, is the identifier the template expression
+      # references at its top level; a redacted identifier yields the
+      # redaction placeholder, mirroring #serialize_value on the snapshot path.
+      def serialize_value_for_message(value, depth: 1, name: nil)
+        # This method is more verbose than "normal" Ruby code to avoid
+        # array allocations.
+
+        return REDACTED_VALUE_FOR_MESSAGE if redactor.redact_type?(value)
+        return REDACTED_VALUE_FOR_MESSAGE if name && redactor.redact_identifier?(name)
+
+        case value
+        when NilClass
+          "nil"
+        when Integer, Float, TrueClass, FalseClass, Time, Date
+          value.to_s
+        when String
+          serialize_string_or_symbol_for_message(value)
+        when Symbol
+          ":" + serialize_string_or_symbol_for_message(value) # steep:ignore ArgumentTypeMismatch
+        when Array
+          return "..." if depth <= 0
+
+          max = max_capture_collection_size_for_message
+          if value.length > max
+            value_ = value[0...max - 1] || []
+            value_ << "..."
+            value_ << value[-1]
+            value = value_
+          end
+          "[" + value.map do |item|
+            serialize_value_for_message(item, depth: depth - 1)
+          end.join(", ") + "]"
+        when Hash
+          return "..." if depth <= 0
+
+          max = max_capture_collection_size_for_message
+          keys = value.keys
+          truncated = false
+          if value.length > max
+            keys_ = keys[0...max - 1] || []
+            keys_ << keys[-1]
+            keys = keys_
+            truncated = true
+          end
+          serialized = keys.map do |key|
+            serialized_value = if (String === key || Symbol === key) && redactor.redact_identifier?(key)
+              REDACTED_VALUE_FOR_MESSAGE
+            else
+              serialize_value_for_message(value[key], depth: depth - 1)
+            end
+            "#{serialize_value_for_message(key, depth: depth - 1)} => #{serialized_value}"
+          end
+          if truncated
+            serialized[serialized.length] = serialized[serialized.length - 1]
+            serialized[serialized.length - 2] = "..."
+          end
+          "{#{serialized.join(", ")}}"
+        else
+          return "..." if depth <= 0
+
+          vars = value.instance_variables
+          truncated = false
+          max = max_capture_attribute_count_for_message
+          if vars.length > max
+            vars_ = vars[0...max - 1] || []
+            vars_ << vars[-1]
+            truncated = true
+            vars = vars_
+          end
+          serialized = vars.map do |var|
+            # +var+ here is always the instance variable name which is a
+            # symbol, we do not need to run it through our serializer.
+            serialized_value = if redactor.redact_identifier?(var)
+              REDACTED_VALUE_FOR_MESSAGE
+            else
+              serialize_value_for_message(value.send(:instance_variable_get, var), depth: depth - 1)
+            end
+            "#{var}=#{serialized_value}"
+          end
+          if truncated
+            serialized << serialized.last
+            serialized[-2] = "..."
+          end
+          serialized = if serialized.any?
+            " " + serialized.join(" ")
+          end
+          "#<#{class_name(value.class)}#{serialized}>"
+        end
+      rescue Exception => exc # standard:disable Lint/RescueException
+        raise if SERIALIZABLE_FATAL_EXCEPTION_CLASSES.any? { |klass| exc.is_a?(klass) }
+
+        telemetry&.report(exc, description: "Error serializing for message")
+        # TODO class_name(foo) can also fail, which we don't handle here.
+        # Telemetry reporting could potentially also fail?
+        "#<#{class_name(value.class)}: serialization error>"
+      end
+
+      private
+
+      # Ruby implementation of #serialize_value.
+      #
+      # Positional arguments, since it is also called by DI::NativeSerializer.
+      def serialize_value_in_ruby(value, name, depth, attribute_count, length, collection_size, type)
         cls = type || value.class
         begin
           if redactor.redact_type?(value)
@@ -367,120 +500,25 @@ module Datadog
         end
       end
 
-      # This method is used for serializing arbitrary values into log messages.
-      # Because the output is meant to be human-readable, we cannot use
-      # the "normal" serialization format which is meant to be machine-readable.
-      # Serialize objects with depth of 1 and include the class name.
-      #
-      # Note that this method does not (currently) utilize the custom
-      # serializers that the "normal" serialization logic uses.
-      #
-      # This serializer differs from the RFC in two ways:
-      # 1. We omit the middle of long strings rather than the end,
-      #    and also the inner entries in arrays/hashes/objects.
-      # 2. We use Ruby-ish syntax for hashes and objects.
-      #
-      # We also use the Ruby-like syntax for symbols, which don't exist
-      # in other languages.
-      #
-      # +name+, when given, is the identifier the template expression
-      # references at its top level; a redacted identifier yields the
-      # redaction placeholder, mirroring #serialize_value on the snapshot path.
-      def serialize_value_for_message(value, depth: 1, name: nil)
-        # This method is more verbose than "normal" Ruby code to avoid
-        # array allocations.
-
-        return REDACTED_VALUE_FOR_MESSAGE if redactor.redact_type?(value)
-        return REDACTED_VALUE_FOR_MESSAGE if name && redactor.redact_identifier?(name)
-
-        case value
-        when NilClass
-          "nil"
-        when Integer, Float, TrueClass, FalseClass, Time, Date
-          value.to_s
-        when String
-          serialize_string_or_symbol_for_message(value)
-        when Symbol
-          ":" + serialize_string_or_symbol_for_message(value) # steep:ignore ArgumentTypeMismatch
-        when Array
-          return "..." if depth <= 0
-
-          max = max_capture_collection_size_for_message
-          if value.length > max
-            value_ = value[0...max - 1] || []
-            value_ << "..."
-            value_ << value[-1]
-            value = value_
-          end
-          "[" + value.map do |item|
-            serialize_value_for_message(item, depth: depth - 1)
-          end.join(", ") + "]"
-        when Hash
-          return "..." if depth <= 0
-
-          max = max_capture_collection_size_for_message
-          keys = value.keys
-          truncated = false
-          if value.length > max
-            keys_ = keys[0...max - 1] || []
-            keys_ << keys[-1]
-            keys = keys_
-            truncated = true
-          end
-          serialized = keys.map do |key|
-            serialized_value = if (String === key || Symbol === key) && redactor.redact_identifier?(key)
-              REDACTED_VALUE_FOR_MESSAGE
-            else
-              serialize_value_for_message(value[key], depth: depth - 1)
-            end
-            "#{serialize_value_for_message(key, depth: depth - 1)} => #{serialized_value}"
-          end
-          if truncated
-            serialized[serialized.length] = serialized[serialized.length - 1]
-            serialized[serialized.length - 2] = "..."
-          end
-          "{#{serialized.join(", ")}}"
-        else
-          return "..." if depth <= 0
+      # Returns the DI::NativeSerializer for this serializer, or nil when
+      # the C extension is not available.
+      def native_serializer
+        return @native_serializer if defined?(@native_serializer)
 
-          vars = value.instance_variables
-          truncated = false
-          max = max_capture_attribute_count_for_message
-          if vars.length > max
-            vars_ = vars[0...max - 1] || []
-            vars_ << vars[-1]
-            truncated = true
-            vars = vars_
-          end
-          serialized = vars.map do |var|
-            # +var+ here is always the instance variable name which is a
-            # symbol, we do not need to run it through our serializer.
-            serialized_value = if redactor.redact_identifier?(var)
-              REDACTED_VALUE_FOR_MESSAGE
-            else
-              serialize_value_for_message(value.send(:instance_variable_get, var), depth: depth - 1)
-            end
-            "#{var}=#{serialized_value}"
-          end
-          if truncated
-            serialized << serialized.last
-            serialized[-2] = "..."
-          end
-          serialized = if serialized.any?
-            " " + serialized.join(" ")
-          end
-          "#<#{class_name(value.class)}#{serialized}>"
-        end
-      rescue Exception => exc # standard:disable Lint/RescueException
-        raise if SERIALIZABLE_FATAL_EXCEPTION_CLASSES.any? { |klass| exc.is_a?(klass) }
+        @native_serializer = (DI::NativeSerializer.new(self, redactor) if defined?(DI::NativeSerializer))
+      end
 
-        telemetry&.report(exc, description: "Error serializing for message")
-        # TODO class_name(foo) can also fail, which we don't handle here.
-        # Telemetry reporting could potentially also fail?
-        "#<#{class_name(value.class)}: serialization error>"
+      # Read by DI::NativeSerializer when a string is serialized without
+      # an explicit length limit.
+      def max_capture_string_length
+        settings.dynamic_instrumentation.max_capture_string_length
       end
 
-      private
+      # Read by DI::NativeSerializer when a collection is serialized
+      # without an explicit size limit.
+      def max_capture_collection_size
+        settings.dynamic_instrumentation.max_capture_collection_size
+      end
 
       MAX_MESSAGE_COLLECTION_SIZE = 3
       MAX_MESSAGE_ATTRIBUTE_COUNT = 5
@@ -2,9 +2,7 @@
 
 require_relative "transport"
 require_relative "evaluation_engine"
-require_relative "exposures/buffer"
 require_relative "exposures/worker"
-require_relative "exposures/deduplicator"
 require_relative "exposures/reporter"
 require_relative "metrics/flag_eval_metrics"
 require_relative "flag_evaluation/writer"
@@ -1,7 +1,5 @@
 # frozen_string_literal: true
 
-require_relative "../../core/utils/time"
-
 module Datadog
   module OpenFeature
     module Exposures
@@ -11,29 +9,24 @@ module Datadog
         ALLOWED_FIELD_TYPES = [String, Integer, Float, TrueClass, FalseClass].freeze
 
         class << self
-          def cache_key(result, flag_key:, context:)
-            "#{flag_key}:#{context.targeting_key}"
-          end
-
-          def cache_value(result, flag_key:, context:)
-            "#{result.allocation_key}:#{result.variant}"
-          end
+          # Builds an event from an exposure popped from `Core::FeatureFlags::ExposureBuffer`
+          def build(exposure)
+            timestamp_ms, flag_key, allocation_key, variant, targeting_key, fields = exposure
 
-          def build(result, flag_key:, context:)
             {
-              timestamp: current_timestamp_ms,
+              timestamp: timestamp_ms,
               allocation: {
-                key: result.allocation_key,
+                key: allocation_key,
               },
               flag: {
                 key: flag_key,
               },
               variant: {
-                key: result.variant,
+                key: variant,
               },
               subject: {
-                id: context.targeting_key,
-                attributes: extract_attributes(context),
+                id: targeting_key,
+                attributes: extract_attributes(fields),
               },
             }.freeze
           end
@@ -42,17 +35,15 @@ module Datadog
 
           # NOTE: We take all filds of the context that does not support nesting
           #       and will ignore targeting key as it will be set as `subject.id`
-          def extract_attributes(context)
-            context.fields.select do |key, value|
+          def extract_attributes(fields)
+            return {} if fields.nil?
+
+            fields.select do |key, value|
               next false if key == TARGETING_KEY_FIELD
 
               ALLOWED_FIELD_TYPES.include?(value.class)
             end
           end
-
-          def current_timestamp_ms
-            (Datadog::Core::Utils::Time.now.to_f * 1000).to_i
-          end
         end
       end
     end
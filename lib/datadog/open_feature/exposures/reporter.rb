@@ -1,8 +1,5 @@
 # frozen_string_literal: true
 
-require_relative "event"
-require_relative "deduplicator"
-
 module Datadog
   module OpenFeature
     module Exposures
@@ -12,7 +9,6 @@ module Datadog
           @worker = worker
           @logger = logger
           @telemetry = telemetry
-          @deduplicator = Deduplicator.new
         end
 
         # NOTE: Reporting expects evaluation context to be always present, but it
@@ -22,12 +18,7 @@ module Datadog
           return false if context.nil?
           return false unless result.log?
 
-          key = Event.cache_key(result, flag_key: flag_key, context: context)
-          value = Event.cache_value(result, flag_key: flag_key, context: context)
-          return false if @deduplicator.duplicate?(key, value)
-
-          event = Event.build(result, flag_key: flag_key, context: context)
-          @worker.enqueue(event)
+          @worker.enqueue(flag_key, result.allocation_key, result.variant, context.targeting_key, context.fields)
         rescue => e
           @logger.debug { "OpenFeature: Failed to report resolution details: #{e.class}: #{e.message}" }
           @telemetry.report(e, description: "OpenFeature: Failed to report resolution details")
@@ -1,16 +1,20 @@
 # frozen_string_literal: true
 
+require_relative "../../core/feature_flags"
 require_relative "../../core/utils/time"
 require_relative "../../core/workers/queue"
 require_relative "../../core/workers/polling"
 
-require_relative "buffer"
+require_relative "event"
 require_relative "batch_builder"
 
 module Datadog
   module OpenFeature
     module Exposures
       # This class is responsible for sending exposures to the Agent
+      #
+      # Exposures are recorded (and deduplicated) by a native buffer on the
+      # evaluation path, and only turned into events by the worker thread
       class Worker
         include Core::Workers::Queue
         include Core::Workers::Polling
@@ -19,7 +23,8 @@ module Datadog
         GRACEFUL_SHUTDOWN_WAIT_INTERVAL_SECONDS = 0.5
 
         DEFAULT_FLUSH_INTERVAL_SECONDS = 30
-        DEFAULT_BUFFER_LIMIT = Buffer::DEFAULT_LIMIT
+        DEFAULT_BUFFER_LIMIT = 1_000
+        DEFAULT_DEDUPLICATION_LIMIT = 1_000
 
         def initialize(
           settings:,
@@ -35,7 +40,7 @@ module Datadog
           @batch_builder = BatchBuilder.new(settings)
           @buffer_limit = buffer_limit
 
-          self.buffer = Buffer.new(buffer_limit)
+          self.buffer = Core::FeatureFlags::ExposureBuffer.new(buffer_limit, DEFAULT_DEDUPLICATION_LIMIT)
           self.fork_policy = Core::Workers::Async::Thread::FORK_POLICY_RESTART
           self.loop_base_interval = flush_interval_seconds
           self.enabled = true
@@ -53,20 +58,25 @@ module Datadog
           super
         end
 
-        def enqueue(event)
-          buffer.push(event)
+        # Records an exposure, unless it is the same as the last one recorded
+        # for that flag and targeting key
+        #
+        # @return [Boolean] true if the exposure was recorded
+        def enqueue(flag_key, allocation_key, variant, targeting_key, attributes)
+          return false unless buffer.push(flag_key, allocation_key, variant, targeting_key, attributes)
+
           start unless running?
 
           true
         end
 
         def dequeue
-          [buffer.pop, buffer.dropped_count]
+          buffer.pop
         end
 
         def perform(*args)
-          events, dropped = args
-          send_events(Array(events), dropped.to_i)
+          exposures, dropped = args
+          send_events(Array(exposures).map { |exposure| Event.build(exposure) }, dropped.to_i)
         end
 
         def graceful_shutdown
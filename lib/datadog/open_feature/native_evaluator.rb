@@ -24,8 +24,10 @@ module Datadog
       # @param default_value [Object] The default value to return if the flag is
       #                              not found or evaluation itself fails
       # @param expected_type [Symbol] The expected type of the flag
-      # @param context [Hash] The context of the evaluation, containing targeting key
-      #                       and other attributes
+      # @param context [Hash, Core::FeatureFlags::EvaluationContext] The context of the
+      #                       evaluation, containing targeting key and other attributes.
+      #                       An EvaluationContext built once can be reused across many
+      #                       evaluations
       #
       # @return [Core::FeatureFlags::ResolutionDetails] The assignment for the flag
       def get_assignment(flag_key, default_value:, expected_type:, context:)
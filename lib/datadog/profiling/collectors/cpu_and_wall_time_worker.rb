@@ -34,6 +34,7 @@ module Datadog
         # @rbs gvl_profiling_enabled: bool
         # @rbs sighandler_sampling_enabled: bool
         # @rbs skip_idle_samples_for_testing: false
+        # @rbs allocation_poisson_sampling_enabled: bool
         # @rbs return: void
         def initialize(
           gc_profiling_enabled:,
@@ -49,6 +50,7 @@ module Datadog
           # profiler overhead!
           dynamic_sampling_rate_enabled: true,
           skip_idle_samples_for_testing: false,
+          allocation_poisson_sampling_enabled: false,
           idle_sampling_helper: IdleSamplingHelper.new(thread_context_collector: thread_context_collector)
         )
           unless dynamic_sampling_rate_enabled
@@ -74,6 +76,7 @@ module Datadog
             dynamic_sampling_rate_overhead_target_percentage: dynamic_sampling_rate_overhead_target_percentage,
             allocation_profiling_enabled: allocation_profiling_enabled,
             allocation_counting_enabled: allocation_counting_enabled,
+            allocation_poisson_sampling_enabled: allocation_poisson_sampling_enabled,
             gvl_profiling_enabled: gvl_profiling_enabled,
             sighandler_sampling_enabled: sighandler_sampling_enabled,
             skip_idle_samples_for_testing: skip_idle_samples_for_testing,
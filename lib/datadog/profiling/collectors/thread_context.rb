@@ -22,7 +22,8 @@ module Datadog
           waiting_for_gvl_threshold_ns:,
           otel_context_enabled:,
           native_filenames_enabled:,
-          show_classes:
+          show_classes:,
+          gc_timeline_events_enabled:
         )
           tracer_context_key = safely_extract_context_key_from(tracer)
           self.class._native_initialize(
@@ -35,6 +36,7 @@ module Datadog
             otel_context_enabled: otel_context_enabled,
             native_filenames_enabled: native_filenames_enabled,
             show_classes: show_classes,
+            gc_timeline_events_enabled: gc_timeline_events_enabled,
             overhead_filename: __FILE__,
           )
         end
@@ -48,6 +50,7 @@ module Datadog
           otel_context_enabled: false,
           native_filenames_enabled: true,
           show_classes: false,
+          gc_timeline_events_enabled: false,
           trigger_global_reset: true,
           **options
         )
@@ -60,6 +63,7 @@ module Datadog
             otel_context_enabled: otel_context_enabled,
             native_filenames_enabled: native_filenames_enabled,
             show_classes: show_classes,
+            gc_timeline_events_enabled: gc_timeline_events_enabled,
             **options,
           )
 
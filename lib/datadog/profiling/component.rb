@@ -62,6 +62,8 @@ module Datadog
           dynamic_sampling_rate_overhead_target_percentage: overhead_target_percentage,
           allocation_profiling_enabled: allocation_profiling_enabled,
           allocation_counting_enabled: settings.profiling.advanced.allocation_counting_enabled,
+          allocation_poisson_sampling_enabled:
+            settings.profiling.advanced.experimental_allocation_poisson_sampling_enabled,
           gvl_profiling_enabled: enable_gvl_profiling?(settings, logger),
           sighandler_sampling_enabled: settings.profiling.advanced.sighandler_sampling_enabled,
           cpu_sampling_interval_ms: cpu_sampling_interval_ms,
@@ -106,6 +108,7 @@ module Datadog
           otel_context_enabled: settings.profiling.advanced.preview_otel_context_enabled,
           native_filenames_enabled: settings.profiling.advanced.native_filenames_enabled,
           show_classes: settings.profiling.advanced.experimental_show_classes_enabled,
+          gc_timeline_events_enabled: settings.profiling.advanced.experimental_gc_timeline_events_enabled,
         )
       end
 
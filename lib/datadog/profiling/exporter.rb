@@ -92,6 +92,10 @@ module Datadog
         gvl_waiting_time_ns_total = worker_stats.delete(:gvl_waiting_time_ns_total)
         metrics << ["ruby_global_lock_wait_time_total", gvl_waiting_time_ns_total] if gvl_waiting_time_ns_total
 
+        # Same as above. We report a summary of the histogram, rather than the raw bucket counts.
+        gvl_waiting_time_ns_histogram = worker_stats.delete(:gvl_waiting_time_ns_histogram)
+        add_gvl_waiting_time_metrics(metrics, gvl_waiting_time_ns_histogram) if gvl_waiting_time_ns_histogram
+
         process_tags = Datadog.configuration.experimental_propagate_process_tags_enabled ?
           Core::Environment::Process.serialized : ""
 
@@ -135,6 +139,29 @@ module Datadog
       def duration_below_threshold?(start, finish)
         (finish - start) < minimum_duration_seconds
       end
+
+      # The histogram is log2-bucketed: bucket N holds waits shorter than `1024 << N` ns (see
+      # `gvl_waiting_histogram_bucket_for` in the native extension), so the reported percentiles are upper bounds.
+      #: (Array[[::String, ::Numeric]], Array[::Integer]) -> void
+      def add_gvl_waiting_time_metrics(metrics, histogram)
+        count = histogram.sum
+        metrics << ["ruby_global_lock_wait_count", count]
+        return if count.zero?
+
+        metrics << ["ruby_global_lock_wait_time_p50", gvl_waiting_time_percentile_ns(histogram, count, 0.50)]
+        metrics << ["ruby_global_lock_wait_time_p99", gvl_waiting_time_percentile_ns(histogram, count, 0.99)]
+      end
+
+      #: (Array[::Integer], ::Integer, ::Float) -> ::Integer
+      def gvl_waiting_time_percentile_ns(histogram, count, percentile)
+        target = (count * percentile).ceil
+        seen = 0
+        histogram.each_with_index do |bucket_count, bucket|
+          seen += bucket_count
+          return 1024 << bucket if seen >= target
+        end
+        1024 << (histogram.size - 1)
+      end
     end
   end
 end
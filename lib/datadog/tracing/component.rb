@@ -104,14 +104,14 @@ module Datadog
           return writer
         end
 
-        if settings.tracing.native_transport && (transport = build_native_transport(agent_settings))
+        if settings.tracing.native_transport && (transport = build_native_transport(settings, agent_settings))
           options = options.merge(transport: transport)
         end
 
         Tracing::Writer.new(agent_settings: agent_settings, **options)
       end
 
-      def build_native_transport(agent_settings)
+      def build_native_transport(settings, agent_settings)
         require_relative "transport/native"
 
         unless Transport::Native.supported?
@@ -124,7 +124,10 @@ module Datadog
 
         Transport::Native::Transport.new(
           agent_settings: agent_settings,
-          logger: Datadog.logger
+          logger: Datadog.logger,
+          eager_conversion: settings.tracing.native_transport_eager_conversion,
+          async_send: settings.tracing.native_transport_async_send,
+          stats_computation: settings.tracing.native_transport_stats_computation
         )
       end
 
@@ -498,6 +498,44 @@ module Datadog
                 o.type :bool
               end
 
+              # When using the native trace transport, convert each trace into native spans as soon as it
+              # finishes, instead of converting all buffered traces at once when they get flushed.
+              #
+              # This option is recommended for internal use only.
+              #
+              # @default `false`
+              # @return [Boolean]
+              option :native_transport_eager_conversion do |o|
+                o.default false
+                o.type :bool
+              end
+
+              # When using the native trace transport, hand each batch of traces to a native sender thread
+              # instead of having the writer wait for the agent to respond to it. At most a few batches can be
+              # in flight; when the agent is too slow to keep up, further batches get dropped.
+              #
+              # This option is recommended for internal use only.
+              #
+              # @default `false`
+              # @return [Boolean]
+              option :native_transport_async_send do |o|
+                o.default false
+                o.type :bool
+              end
+
+              # When using the native trace transport, compute the trace stats (hits, errors and latency
+              # distributions) in the tracer and send them to the agent's `/v0.6/stats` endpoint, so that the
+              # traces dropped by sampling no longer need to be sent to the agent.
+              #
+              # This option is recommended for internal use only.
+              #
+              # @default `false`
+              # @return [Boolean]
+              option :native_transport_stats_computation do |o|
+                o.default false
+                o.type :bool
+              end
+
               # A custom writer instance.
               # The object must respect the {Datadog::Tracing::Writer} interface.
               #
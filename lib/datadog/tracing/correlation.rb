@@ -102,7 +102,7 @@ module Datadog
       end
 
       def format_trace_id_128(trace_id)
-        if !Tracing::Utils::TraceId.to_high_order(trace_id).zero?
+        if trace_id > Tracing::Utils::EXTERNAL_MAX_ID
           Kernel.format("%032x", trace_id)
         else
           Tracing::Utils::TraceId.to_low_order(trace_id).to_s
@@ -103,12 +103,12 @@ module Datadog
         end
 
         def build_tags(digest)
-          high_order = Tracing::Utils::TraceId.to_high_order(digest.trace_id)
+          high_order = Tracing::Utils::TraceId.to_high_order_hex(digest.trace_id)
           tags = digest.trace_distributed_tags || {}
 
-          return tags if high_order == 0
+          return tags unless high_order
 
-          tags.merge(Tracing::Metadata::Ext::Distributed::TAG_TID => format("%016x", high_order))
+          tags.merge(Tracing::Metadata::Ext::Distributed::TAG_TID => high_order)
         end
 
         # Side effect: Remove high order 64 bit hex-encoded `tid` tag from distributed tags
@@ -118,7 +118,7 @@ module Datadog
           return trace_id unless high_order.size == 16
           return trace_id unless /\A[0-9a-f]+\z/i.match?(high_order)
 
-          Tracing::Utils::TraceId.concatenate(high_order.to_i(16), trace_id)
+          Tracing::Utils::TraceId.concatenate_hex(high_order, trace_id)
         end
 
         # Export trace distributed tags through the `x-datadog-tags` key.
@@ -42,6 +42,11 @@ module Datadog
         @processors = value
       end
 
+      # @!visibility private
+      def self.empty?
+        @processors.empty?
+      end
+
       def self.apply_processors!(trace)
         @processors.inject(trace) do |current_trace, processor|
           next nil if current_trace.nil? || current_trace.empty?
@@ -37,6 +37,10 @@ module Datadog
         :profiling_enabled,
         :apm_tracing_enabled
 
+      # The spans of this trace, already converted by the native transport when the trace got written.
+      # @!visibility private
+      attr_accessor :native_chunk
+
       # rubocop:disable Metrics/CyclomaticComplexity
       # rubocop:disable Metrics/PerceivedComplexity
       # @param spans [Array<Datadog::Span>]
@@ -138,9 +142,16 @@ module Datadog
       # The String returned is padded with zeros, having a fixed length of 16 characters.
       # If the high order part is zero, it returns nil.
       def high_order_tid
-        high_order = Tracing::Utils::TraceId.to_high_order(@id)
+        Tracing::Utils::TraceId.to_high_order_hex(@id)
+      end
 
-        format("%016x", high_order) if high_order != 0
+      # Returns a copy of this trace holding only +spans+, with the same trace-level tags.
+      # @!visibility private
+      def with_spans(spans)
+        dup.tap do |trace|
+          trace.spans = spans
+          trace.native_chunk = nil
+        end
       end
 
       protected
@@ -150,6 +161,8 @@ module Datadog
         :meta,
         :metrics
 
+      attr_writer :spans
+
       private
 
       attr_writer \
@@ -1,8 +1,14 @@
 # frozen_string_literal: true
 
 require "json"
-require_relative "trace_formatter"
+require_relative "../../core/environment/ext"
+require_relative "../../core/environment/git"
+require_relative "../../core/environment/process"
+require_relative "../../core/git/ext"
+require_relative "../pipeline"
 require_relative "statistics"
+require_relative "native/stats"
+require_relative "native/stats_concentrator"
 
 module Datadog
   module Tracing
@@ -11,8 +17,11 @@ module Datadog
       #
       # Converts Ruby Span objects directly to Rust spans and delegates
       # serialization and sending to the Rust data pipeline, which handles
-      # stats computation, msgpack encoding, and HTTP transport with retry
-      # logic.
+      # msgpack encoding and HTTP transport with retry logic. Trace stats can
+      # be computed in the tracer as well (see {Native::StatsConcentrator}).
+      #
+      # The trace-level tags that {TraceFormatter} adds for the other transports
+      # are instead set natively on the Rust spans while converting them.
       #
       # Implements the same +send_traces+ / +stats+ interface as
       # {Datadog::Tracing::Transport::Traces::Transport} so it can be used
@@ -39,27 +48,51 @@ module Datadog
         # The hierarchy is:
         #   Datadog::Tracing::Transport::Native::TraceExporter (C)
         #   Datadog::Tracing::Transport::Native::TracerSpan (C)
+        #   Datadog::Tracing::Transport::Native::TraceChunk (C)
+        #   Datadog::Tracing::Transport::Native::TraceBuffer (C, +#pop+ in +native/trace_buffer.rb+)
         #   Datadog::Tracing::Transport::Native::Response (Ruby)
 
         # Drop-in transport that delegates to the native trace exporter.
         class Transport
           include Statistics
 
+          DEFAULT_MAX_IN_FLIGHT_SENDS = 4
+          # Same as {Traces::Chunker::DEFAULT_MAX_PAYLOAD_SIZE}
+          DEFAULT_MAX_PAYLOAD_SIZE = 5 * 1024 * 1024
+          # How long #close waits for sends queued with +async_send+ to complete
+          ASYNC_CLOSE_TIMEOUT_SECONDS = 1
+
           attr_reader :logger
 
           # @param agent_settings [Datadog::Core::Configuration::AgentSettingsResolver::AgentSettings]
           #   Agent connection settings (provides +#url+).
           # @param logger [Logger]
-          def initialize(agent_settings:, logger:)
+          # @param eager_conversion [Boolean] convert each trace into native spans when it gets written
+          #   (see #prepare_trace), instead of converting the whole batch in #send_traces.
+          # @param async_send [Boolean] have #send_traces queue the batch for a native sender thread
+          #   instead of waiting for the agent to respond (see #send_traces).
+          # @param max_in_flight_sends [Integer] with +async_send+, how many payloads may be queued or being
+          #   sent at once; further payloads are dropped.
+          # @param stats_computation [Boolean] compute the trace stats in the tracer (see {StatsConcentrator}),
+          #   and only send the traces kept by sampling to the agent.
+          # @param max_payload_size [Integer] estimated size, in bytes, above which a batch is split into several
+          #   payloads, sent one after the other (see #send_traces).
+          def initialize(
+            agent_settings:,
+            logger:,
+            eager_conversion: false,
+            async_send: false,
+            max_in_flight_sends: DEFAULT_MAX_IN_FLIGHT_SENDS,
+            stats_computation: false,
+            max_payload_size: DEFAULT_MAX_PAYLOAD_SIZE
+          )
             unless Native.supported?
               raise "Native transport is not supported: #{UNSUPPORTED_REASON}"
             end
 
             @logger = logger
-
-            # Guards the one-shot warning about span fields the native exporter
-            # does not yet convert (see #warn_unsupported_fields!).
-            @unsupported_fields_warned = false
+            @eager_conversion = eager_conversion
+            @async_send = async_send
 
             # Serializes native sends and is held across a fork. See the
             # fork-safety note below.
@@ -83,6 +116,18 @@ module Datadog
             service = Datadog.configuration.service
             version = Datadog.configuration.version
 
+            if stats_computation
+              @stats_mutex = Mutex.new
+              @stats_concentrator = StatsConcentrator.new(
+                env: env,
+                service: service,
+                version: version,
+                hostname: hostname,
+                tracer_version: tracer_version
+              )
+              @stats_transport = Stats.default(agent_settings: agent_settings, logger: logger)
+            end
+
             exporter = Native::TraceExporter._native_new(
               url: url,
               tracer_version: tracer_version,
@@ -92,8 +137,12 @@ module Datadog
               hostname: hostname,
               env: env,
               service: service,
-              version: version
+              version: version,
+              first_span_tags: (@first_span_tags = first_span_tags),
+              client_computed_stats: stats_computation,
+              max_payload_size: max_payload_size
             )
+            exporter._native_start_async_sender(max_in_flight_sends) if async_send
             @exporter = exporter
 
             # Fork safety: the native exporter owns a long-lived tokio runtime
@@ -217,15 +266,24 @@ module Datadog
           # native exporter so its runtime can shut down. Idempotent: safe to
           # call multiple times and safe to call after the finalizer has run.
           def close
+            exporter = nil
             fork_hooks = @send_mutex.synchronize do
               hooks = @fork_hooks
               return if hooks.nil?
 
               @fork_hooks = nil
+              exporter = @exporter
               @exporter = nil
               hooks
             end
 
+            # Done before removing the fork hooks, which must stay in place while the sender thread runs
+            if @async_send && exporter
+              flush_async_sends(exporter)
+              exporter._native_stop_async_sender
+            end
+            flush_stats(force: true) if @stats_concentrator
+
             fork_hooks.each do |stage, block|
               Core::Utils::AtForkMonkeyPatch.remove_at_fork(stage, block)
             end
@@ -260,21 +318,32 @@ module Datadog
           # Each trace is a {Datadog::Tracing::TraceSegment} whose +#spans+
           # returns an +Array+ of {Datadog::Tracing::Span}.
           #
+          # A batch whose estimated size exceeds +max_payload_size+ is split into several payloads, which are sent
+          # to the agent one after the other, each getting its own response. A payload rejected by the agent thus only
+          # loses its own traces.
+          #
+          # With +async_send+, the traces are only converted and queued for the native sender thread, and the
+          # responses returned are those of the payloads whose send completed since the previous call (usually
+          # earlier batches). A payload is dropped when +max_in_flight_sends+ payloads are already in flight.
+          #
+          # With +stats_computation+, the stats of every trace are recorded first, and only the traces kept by
+          # sampling are sent. The stats buckets that are complete are then sent as well.
+          #
           # @param traces [Array<Datadog::Tracing::TraceSegment>]
-          # @return [Array<Response>] one response per batch sent
+          # @return [Array<Response>] one response per payload sent
           def send_traces(traces)
             return [] if traces.empty?
 
-            # Apply trace-level tags to root spans (same as the HTTP transport)
-            traces.each { |trace| TraceFormatter.format!(trace) }
-
-            # Build the Array<Array<Span>> structure expected by the C extension.
-            # Each trace segment becomes one inner array (one trace chunk).
-            chunks = traces.map(&:spans)
+            if @stats_concentrator
+              traces = @stats_mutex.synchronize { @stats_concentrator.add(traces) }
+              flush_stats
+              return [] if traces.empty?
+            end
 
-            # Span events and span links are not yet converted and would be
-            # dropped. Warn (once) so the loss is visible.
-            warn_unsupported_fields!(chunks)
+            # Each trace segment becomes one trace chunk: either the one already converted by
+            # #prepare_trace or, otherwise, the segment itself, which the C extension converts
+            # along with its trace-level tags.
+            chunks = traces.map { |trace| take_prepared_chunk(trace) || trace }
 
             # Serialize the native send and hold the mutex across it so a
             # concurrent fork's :before hook blocks until this send drains
@@ -287,7 +356,13 @@ module Datadog
               exporter = @exporter
               raise "Native transport has been closed" if exporter.nil?
 
-              exporter._native_send_traces(chunks)
+              update_first_span_tags(exporter)
+
+              if @async_send
+                enqueue_traces(exporter, chunks)
+              else
+                exporter._native_send_traces(chunks)
+              end
             end
 
             # Update statistics from the response
@@ -300,31 +375,119 @@ module Datadog
             [InternalErrorResponse.new(e)]
           end
 
+          # Converts a finished trace into native spans right away, on the thread that finished it.
+          #
+          # Otherwise, #send_traces converts every span of every trace in the batch at once, on the writer
+          # thread and while holding the GVL, which for large batches stalls application threads for a
+          # noticeable amount of time. Converting each trace as it finishes spreads that work out.
+          #
+          # This is skipped when +Pipeline.before_flush+ processors are configured, as these run right before
+          # sending and may still change (or drop) the trace.
+          #
+          # @param trace [Datadog::Tracing::TraceSegment]
+          def prepare_trace(trace)
+            return unless @eager_conversion && trace && !trace.empty? && Pipeline.empty?
+
+            exporter = @exporter
+            return unless exporter
+
+            trace.native_chunk = exporter._native_prepare_trace(trace)
+            nil
+          rescue => e
+            # The trace still gets converted (and any error reported) by #send_traces
+            logger.debug { "Native transport failed to prepare trace: #{e.class} #{e.message}" }
+            nil
+          end
+
+          # Builds the buffer the writer keeps finished traces in until they are sent.
+          #
+          # The native buffer has the same behavior as {Datadog::Tracing::TraceBuffer}, but pushing a trace
+          # into it, which happens on the thread that finished the trace, does not run any Ruby code.
+          #
+          # @param max_size [Integer] maximum number of traces kept; when full, a new trace replaces a random one
+          # @return [TraceBuffer]
+          def build_trace_buffer(max_size)
+            TraceBuffer._native_new(max_size)
+          end
+
+          # @return [Hash, nil] counters of the +async_send+ sender thread (batches in flight, enqueued, dropped,
+          #   completed...), or +nil+ when not using +async_send+ or closed
+          def async_stats
+            exporter = @exporter
+            exporter._native_async_stats if @async_send && exporter
+          end
+
           private
 
-          # Warn, at most once per transport, when a batch contains span fields
-          # the native exporter does not yet convert (span events and span
-          # links). These are silently dropped by the native path; full support
-          # is tracked separately. The check is cheap: the fields are already-
-          # materialized collections on each Span.
-          def warn_unsupported_fields!(chunks)
-            return if @unsupported_fields_warned
-
-            unsupported = []
-            chunks.each do |spans|
-              spans.each do |span|
-                unsupported << "span events" if span.events.any?
-                unsupported << "span links" if span.links.any?
-              end
+          # Queues +chunks+ for the sender thread and returns the responses of the sends completed since the
+          # previous call.
+          def enqueue_traces(exporter, chunks)
+            unless exporter._native_enqueue_traces(chunks)
+              logger.debug { "Native transport dropped traces: too many sends in flight" }
             end
-            return if unsupported.empty?
 
-            @unsupported_fields_warned = true
-            fields = unsupported.uniq.join(", ")
-            logger.warn do
-              "Native transport does not yet support: #{fields}. This data will not be sent to Datadog. " \
-                "Unset DD_EXPERIMENTAL_NATIVE_TRANSPORT_ENABLED to use the default transport if you rely on these."
+            exporter._native_poll_async_sends
+          end
+
+          def flush_async_sends(exporter)
+            unless exporter._native_async_flush(ASYNC_CLOSE_TIMEOUT_SECONDS)
+              logger.debug { "Native transport closed before all queued traces were sent" }
             end
+
+            exporter._native_poll_async_sends.each { |response| update_stats_from_response!(response) }
+          rescue => e
+            logger.debug { "Native transport failed to flush queued traces: #{e.class} #{e.message}" }
+          end
+
+          # Sends the stats buckets that are complete, or all of them with +force+.
+          def flush_stats(force: false)
+            payload = @stats_mutex.synchronize { @stats_concentrator.flush(force: force) }
+            return unless payload
+
+            response = @stats_transport.send_stats(payload)
+            logger.debug { "Native transport failed to send trace stats: #{response.inspect}" } unless response.ok?
+          rescue => e
+            logger.debug { "Native transport failed to send trace stats: #{e.class} #{e.message}" }
+          end
+
+          # Returns (and detaches) the chunk prepared for +trace+ by #prepare_trace, if it can still be used.
+          def take_prepared_chunk(trace)
+            return unless @eager_conversion
+
+            prepared_chunk = trace.native_chunk
+            return unless prepared_chunk
+
+            trace.native_chunk = nil
+            # A processor added after the trace was prepared may have changed it
+            prepared_chunk if Pipeline.empty?
+          end
+
+          # Tags set on the first span of every trace (see TraceFormatter#tag_process_tags! and the git tags).
+          # These are process-wide, so the exporter gets them once rather than with every trace.
+          def first_span_tags
+            tags = {}
+
+            if Datadog.configuration.experimental_propagate_process_tags_enabled
+              tags[Core::Environment::Ext::TAG_PROCESS_TAGS] = Core::Environment::Process.serialized
+            end
+
+            repository_url = Core::Environment::Git.git_repository_url
+            tags[Core::Git::Ext::TAG_REPOSITORY_URL] = repository_url unless repository_url.nil?
+
+            commit_sha = Core::Environment::Git.git_commit_sha
+            tags[Core::Git::Ext::TAG_COMMIT_SHA] = commit_sha unless commit_sha.nil?
+
+            tags
+          end
+
+          # Process tags may still change after the transport was created (e.g. Rails sets the application
+          # name once initialized), so they are checked again once per flush.
+          def update_first_span_tags(exporter)
+            tags = first_span_tags
+            return if tags == @first_span_tags
+
+            exporter._native_set_first_span_tags(tags)
+            @first_span_tags = tags
           end
 
           def tracer_version_string
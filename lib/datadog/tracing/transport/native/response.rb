@@ -14,10 +14,14 @@ module Datadog
         class Response
           SERVICE_RATE_KEY = "rate_by_service"
 
+          # Size in bytes of the strings that were repeated within the sent
+          # payload, i.e. what encoding it with a string table would save.
+          attr_reader :duplicate_string_bytes
+
           attr_reader :trace_count, :payload
 
           def initialize(ok:, internal_error: false, server_error: false, client_error: false,
-            not_found: false, unsupported: false, trace_count: 0, payload: nil)
+            not_found: false, unsupported: false, trace_count: 0, payload: nil, duplicate_string_bytes: 0)
             @ok = ok
             @internal_error = internal_error
             @server_error = server_error
@@ -26,6 +30,7 @@ module Datadog
             @unsupported = unsupported
             @trace_count = trace_count
             @payload = payload
+            @duplicate_string_bytes = duplicate_string_bytes
           end
 
           def ok?
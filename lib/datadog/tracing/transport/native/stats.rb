@@ -0,0 +1,64 @@
+# frozen_string_literal: true
+
+require "msgpack"
+require_relative "../../../core/transport/http"
+require_relative "../../../core/transport/http/api/endpoint"
+require_relative "../../../core/transport/http/response"
+require_relative "../../../core/transport/parcel"
+require_relative "../../../core/transport/request"
+require_relative "../../../core/transport/transport"
+
+module Datadog
+  module Tracing
+    module Transport
+      module Native
+        # Sends the payloads built by {StatsConcentrator} to the agent's +/v0.6/stats+ endpoint.
+        module Stats
+          # Request for trace stats
+          class Request < Core::Transport::Request
+          end
+
+          # Response from the trace stats endpoint
+          class Response
+            include Core::Transport::HTTP::Response
+          end
+
+          # Endpoint for submitting trace stats
+          class Endpoint < Core::Transport::HTTP::API::Endpoint
+            def initialize(path)
+              super(:post, path)
+            end
+
+            def call(env, &block)
+              env.verb = verb
+              env.path = path
+              env.body = env.request.parcel.data
+              env.headers["content-type"] = env.request.parcel.content_type
+
+              Response.new(yield(env))
+            end
+          end
+
+          V06 = Endpoint.new("/v0.6/stats")
+
+          # Transport for trace stats
+          class Transport < Core::Transport::Transport
+            def send_stats(payload)
+              parcel = Core::Transport::Parcel.new(MessagePack.pack(payload), content_type: "application/msgpack")
+
+              client.send_request(:stats, Request.new(parcel))
+            end
+          end
+
+          module_function
+
+          def default(agent_settings:, logger:)
+            Core::Transport::HTTP.build(agent_settings: agent_settings, logger: logger) do |transport|
+              transport.api "v0.6", V06, default: true
+            end.to_transport(Transport)
+          end
+        end
+      end
+    end
+  end
+end
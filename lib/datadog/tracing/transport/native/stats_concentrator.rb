@@ -0,0 +1,201 @@
+# frozen_string_literal: true
+
+require_relative "../../../core/ddsketch"
+require_relative "../../../core/environment/ext"
+require_relative "../../../core/environment/identity"
+require_relative "../../../core/environment/process"
+require_relative "../../../core/utils/time"
+require_relative "../../metadata/ext"
+require_relative "../../sampling/ext"
+require_relative "../../sampling/span/ext"
+
+module Datadog
+  module Tracing
+    module Transport
+      module Native
+        # Computes the trace stats (APM stats) that the agent would otherwise compute from every span it receives:
+        # hits, errors, top-level hits and duration distributions, per service, operation name, resource, type,
+        # HTTP status code and span kind, in 10 second buckets.
+        #
+        # Once the stats of a trace are recorded, the trace no longer needs to reach the agent unless it was kept by
+        # sampling, so #add returns only what must still be sent: kept traces in full, and for dropped traces only
+        # the spans kept by single span sampling.
+        #
+        # Buckets are flushed to the agent's +/v0.6/stats+ endpoint once they are complete (see #flush).
+        #
+        # Not thread-safe: the native transport only uses it from the thread sending traces (and #close).
+        class StatsConcentrator
+          BUCKET_DURATION_NS = 10 * 1_000_000_000
+
+          # Besides top-level spans, the agent also computes stats of spans with these span kinds
+          SPAN_KINDS_WITH_STATS = [
+            Metadata::Ext::SpanKind::TAG_SERVER,
+            Metadata::Ext::SpanKind::TAG_CLIENT,
+            Metadata::Ext::SpanKind::TAG_PRODUCER,
+            Metadata::Ext::SpanKind::TAG_CONSUMER,
+          ].freeze
+
+          SYNTHETICS_ORIGIN_PREFIX = "synthetics"
+
+          # Values of the +IsTraceRoot+ field
+          TRACE_ROOT_TRUE = 1
+          TRACE_ROOT_FALSE = 2
+
+          # Stats of the spans sharing the same aggregation key within a bucket
+          GroupedStats = Struct.new(:hits, :errors, :duration, :top_level_hits, :ok_summary, :error_summary)
+
+          def initialize(env:, service:, version:, hostname:, tracer_version:)
+            @env = env
+            @service = service
+            @version = version
+            @hostname = hostname
+            @tracer_version = tracer_version
+            @buckets = {}
+            @sequence = 0
+            @pid = Process.pid
+          end
+
+          # Records the stats of +traces+.
+          #
+          # @param traces [Array<Datadog::Tracing::TraceSegment>]
+          # @return [Array<Datadog::Tracing::TraceSegment>] the traces (or parts of traces) that must still be sent
+          def add(traces)
+            discard_inherited_buckets
+
+            traces.each_with_object([]) do |trace, kept|
+              synthetics = trace.origin&.start_with?(SYNTHETICS_ORIGIN_PREFIX) || false
+              trace.spans.each { |span| add_span(span, synthetics) }
+
+              if dropped?(trace)
+                single_spans = trace.spans.select { |span| span.get_metric(Sampling::Span::Ext::TAG_MECHANISM) }
+                kept << trace.with_spans(single_spans) unless single_spans.empty?
+              else
+                kept << trace
+              end
+            end
+          end
+
+          # Removes the buckets that are complete, or all of them with +force+, and returns them as a
+          # +/v0.6/stats+ payload.
+          #
+          # @return [Hash, nil] the payload, or +nil+ when there is nothing to flush
+          def flush(force: false)
+            discard_inherited_buckets
+
+            now_ns = Core::Utils::Time.now.to_i * 1_000_000_000
+            flushed = []
+            @buckets.delete_if do |start_ns, groups|
+              next false unless force || start_ns + BUCKET_DURATION_NS <= now_ns
+
+              flushed << serialize_bucket(start_ns, groups)
+              true
+            end
+            return if flushed.empty?
+
+            @sequence += 1
+            payload = {
+              "Hostname" => @hostname || "",
+              "Env" => @env || "",
+              "Version" => @version || "",
+              "Service" => @service || "",
+              "Lang" => Core::Environment::Ext::LANG,
+              "TracerVersion" => @tracer_version,
+              "RuntimeID" => Core::Environment::Identity.id,
+              "Sequence" => @sequence,
+              "Stats" => flushed,
+            }
+            if Datadog.configuration.experimental_propagate_process_tags_enabled
+              payload["ProcessTags"] = Core::Environment::Process.serialized
+            end
+            payload
+          end
+
+          def empty?
+            @buckets.empty?
+          end
+
+          private
+
+          # P0 traces: neither kept by the sampler nor by the user
+          def dropped?(trace)
+            priority = trace.sampling_priority
+            !priority.nil? && priority <= Sampling::Ext::Priority::AUTO_REJECT
+          end
+
+          def add_span(span, synthetics)
+            return unless (start_time = span.start_time) && (duration = span.duration)
+
+            top_level = span.parent_id == 0 || span.get_metric(Metadata::Ext::TAG_TOP_LEVEL) == 1.0
+            span_kind = span.get_tag(Metadata::Ext::TAG_KIND)
+            return unless top_level ||
+              span.get_metric(Metadata::Ext::Analytics::TAG_MEASURED) == 1.0 ||
+              SPAN_KINDS_WITH_STATS.include?(span_kind)
+
+            duration_ns = (duration * 1e9).to_i
+            end_ns = start_time.to_i * 1_000_000_000 + start_time.nsec + duration_ns
+            groups = (@buckets[end_ns - end_ns % BUCKET_DURATION_NS] ||= {})
+
+            key = [
+              span.service,
+              span.name,
+              span.resource,
+              span.type,
+              span.get_tag(Metadata::Ext::HTTP::TAG_STATUS_CODE).to_i,
+              span_kind,
+              synthetics,
+              (span.parent_id == 0) ? TRACE_ROOT_TRUE : TRACE_ROOT_FALSE,
+            ]
+            stats = (groups[key] ||= GroupedStats.new(0, 0, 0, 0, nil, nil))
+
+            stats.hits += 1
+            stats.duration += duration_ns
+            stats.top_level_hits += 1 if top_level
+            if span.status == Metadata::Ext::Errors::STATUS
+              stats.errors += 1
+              (stats.error_summary ||= Core::DDSketch.new).add(duration_ns)
+            else
+              (stats.ok_summary ||= Core::DDSketch.new).add(duration_ns)
+            end
+          end
+
+          def serialize_bucket(start_ns, groups)
+            {
+              "Start" => start_ns,
+              "Duration" => BUCKET_DURATION_NS,
+              "Stats" => groups.map do |(service, name, resource, type, status_code, span_kind, synthetics, trace_root), stats|
+                {
+                  "Service" => service || "",
+                  "Name" => name || "",
+                  "Resource" => resource || "",
+                  "Type" => type || "",
+                  "HTTPStatusCode" => status_code,
+                  "SpanKind" => span_kind || "",
+                  "Synthetics" => synthetics,
+                  "IsTraceRoot" => trace_root,
+                  "Hits" => stats.hits,
+                  "Errors" => stats.errors,
+                  "TopLevelHits" => stats.top_level_hits,
+                  "Duration" => stats.duration,
+                  "OkSummary" => encode_summary(stats.ok_summary),
+                  "ErrorSummary" => encode_summary(stats.error_summary),
+                }
+              end,
+            }
+          end
+
+          def encode_summary(sketch)
+            (sketch || Core::DDSketch.new).encode
+          end
+
+          # A forked child must not report the stats its parent recorded
+          def discard_inherited_buckets
+            return if @pid == Process.pid
+
+            @buckets.clear
+            @pid = Process.pid
+          end
+        end
+      end
+    end
+  end
+end
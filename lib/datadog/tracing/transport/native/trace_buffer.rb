@@ -0,0 +1,44 @@
+# frozen_string_literal: true
+
+module Datadog
+  module Tracing
+    module Transport
+      module Native
+        # Trace buffer used by the writer with the native transport, in place of {Datadog::Tracing::TraceBuffer}.
+        #
+        # +push+, +concat+, +length+, +empty?+, +max_size+, +close+ and +closed?+ are defined by the C extension
+        # in +ext/libdatadog_api/trace_buffer.c+, which also keeps the health metrics. Only reporting these
+        # metrics, once per drain, happens here.
+        class TraceBuffer
+          # Stored traces are returned and the buffer is reset.
+          def pop
+            traces, accepted, accepted_lengths, dropped, spans = _native_drain
+            measure_pop(traces, accepted, accepted_lengths, dropped, spans)
+            traces
+          end
+
+          private
+
+          # Reports the same metrics as {Datadog::Tracing::MeasuredBuffer#measure_pop}
+          def measure_pop(traces, accepted, accepted_lengths, dropped, spans)
+            # Accepted, cumulative totals
+            Datadog.health_metrics.queue_accepted(accepted)
+            Datadog.health_metrics.queue_accepted_lengths(accepted_lengths)
+
+            # Dropped, cumulative totals
+            Datadog.health_metrics.queue_dropped(dropped)
+
+            # Queue gauges, current values
+            Datadog.health_metrics.queue_max_length(max_size)
+            Datadog.health_metrics.queue_spans(spans)
+            Datadog.health_metrics.queue_length(traces.length)
+          rescue => e
+            Datadog.logger.debug(
+              "Failed to measure queue. Cause: #{e.class}: #{e.message} Source: #{Array(e.backtrace).first}"
+            )
+          end
+        end
+      end
+    end
+  end
+end
@@ -67,6 +67,15 @@ module Datadog
       module TraceId
         MAX = (1 << 128) - 1
 
+        # A high order part, shifted into place (+min+), along with the (exclusive) upper bound of the trace ids
+        # sharing it (+max+), and its hexadecimal +_dd.p.tid+ form.
+        #
+        # 128-bit trace ids generated within the same second share their high order part, so the last one is
+        # cached: generating a 128-bit trace id then allocates a single Integer, and formatting or parsing its
+        # high order part allocates nothing. The last high order part of a trace id coming from elsewhere (e.g.
+        # extracted from distributed headers) is cached separately, so that it does not evict the generated one.
+        HighOrder = Struct.new(:seconds, :min, :max, :hex)
+
         module_function
 
         # Format for generating 128 bits trace id =>
@@ -76,10 +85,13 @@ module Datadog
         def next_id
           return Utils.next_id unless Datadog.configuration.tracing.trace_id_128_bit_generation_enabled
 
-          concatenate(
-            Core::Utils::Time.now.to_i << 32,
-            Utils.next_id
-          )
+          seconds = Core::Utils::Time.now.to_i
+          high_order = @generated_high_order
+          unless high_order&.seconds == seconds
+            high_order = @generated_high_order = build_high_order(seconds << 32, seconds)
+          end
+
+          high_order.min | Utils.next_id
         end
 
         def to_high_order(trace_id)
@@ -93,6 +105,35 @@ module Datadog
         def concatenate(high_order, low_order)
           high_order << 64 | low_order
         end
+
+        # Returns the high order part of +trace_id+ as a 16 characters hexadecimal String, or +nil+ if it is zero.
+        def to_high_order_hex(trace_id)
+          return if trace_id <= Utils::EXTERNAL_MAX_ID
+
+          high_order = cached_high_order { |cached| trace_id >= cached.min && trace_id < cached.max }
+          high_order ||= (@high_order = build_high_order(to_high_order(trace_id)))
+          high_order.hex
+        end
+
+        # Reverse of {.to_high_order_hex}: combines a 16 characters hexadecimal high order part with +low_order+.
+        def concatenate_hex(high_order_hex, low_order)
+          high_order = cached_high_order { |cached| cached.hex == high_order_hex }
+          high_order ||= (@high_order = build_high_order(high_order_hex.to_i(16)))
+          high_order.min | low_order
+        end
+
+        def cached_high_order
+          generated = @generated_high_order
+          return generated if generated && yield(generated)
+
+          other = @high_order
+          other if other && yield(other)
+        end
+
+        def build_high_order(value, seconds = nil)
+          HighOrder.new(seconds, value << 64, (value + 1) << 64, format("%016x", value).freeze).freeze
+        end
+        private_class_method :cached_high_order, :build_high_order
       end
     end
   end
@@ -33,7 +33,7 @@ module Datadog
 
           # Buffers
           buffer_size = options.fetch(:buffer_size, DEFAULT_BUFFER_MAX_SIZE)
-          @trace_buffer = TraceBuffer.new(buffer_size)
+          @trace_buffer = build_trace_buffer(buffer_size)
 
           # Threading
           @shutdown = ConditionVariable.new
@@ -110,6 +110,15 @@ module Datadog
 
         alias_method :flush_data, :callback_traces
 
+        # Transports may provide a buffer of their own (e.g. the native transport)
+        def build_trace_buffer(buffer_size)
+          if @transport.respond_to?(:build_trace_buffer)
+            @transport.build_trace_buffer(buffer_size)
+          else
+            TraceBuffer.new(buffer_size)
+          end
+        end
+
         def perform
           loop do
             @back_off = flush_data ? @flush_interval : [@back_off * BACK_OFF_RATIO, BACK_OFF_MAX].min
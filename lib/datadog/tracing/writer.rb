@@ -117,6 +117,10 @@ module Datadog
         # Associate trace with runtime metrics
         Runtime::Metrics.associate_trace(trace)
 
+        # Let transports that support it (e.g. the native transport) do their per-trace work now, on the
+        # thread that finished the trace, rather than for the whole batch when flushing.
+        @transport.prepare_trace(trace) if @transport.respond_to?(:prepare_trace)
+
         worker_local = @worker
 
         if worker_local
@@ -469,6 +469,23 @@ RSpec.describe Datadog::Core::Configuration::Settings do
         end
       end
 
+      describe "#experimental_gc_timeline_events_enabled" do
+        subject(:experimental_gc_timeline_events_enabled) do
+          settings.profiling.advanced.experimental_gc_timeline_events_enabled
+        end
+
+        it { is_expected.to be false }
+      end
+
+      describe "#experimental_gc_timeline_events_enabled=" do
+        it "updates the #experimental_gc_timeline_events_enabled setting" do
+          expect { settings.profiling.advanced.experimental_gc_timeline_events_enabled = true }
+            .to change { settings.profiling.advanced.experimental_gc_timeline_events_enabled }
+            .from(false)
+            .to(true)
+        end
+      end
+
       describe "#allocation_counting_enabled" do
         subject(:allocation_counting_enabled) { settings.profiling.advanced.allocation_counting_enabled }
 
@@ -484,6 +501,23 @@ RSpec.describe Datadog::Core::Configuration::Settings do
         end
       end
 
+      describe "#experimental_allocation_poisson_sampling_enabled" do
+        subject(:experimental_allocation_poisson_sampling_enabled) do
+          settings.profiling.advanced.experimental_allocation_poisson_sampling_enabled
+        end
+
+        it { is_expected.to be false }
+      end
+
+      describe "#experimental_allocation_poisson_sampling_enabled=" do
+        it "updates the #experimental_allocation_poisson_sampling_enabled setting" do
+          expect { settings.profiling.advanced.experimental_allocation_poisson_sampling_enabled = true }
+            .to change { settings.profiling.advanced.experimental_allocation_poisson_sampling_enabled }
+            .from(false)
+            .to(true)
+        end
+      end
+
       describe "#experimental_heap_enabled" do
         subject(:experimental_heap_enabled) { settings.profiling.advanced.experimental_heap_enabled }
 
@@ -52,6 +52,96 @@ RSpec.describe Datadog::Core::DDSketch do
       end
     end
 
+    describe "#add_all" do
+      it "adds every point to the sketch" do
+        expect { sketch.add_all([1.0, 2, 3.5, 0]) }.to change { sketch.count }.from(0.0).to(4.0)
+      end
+
+      it "returns the sketch" do
+        expect(sketch.add_all([1.0])).to be sketch
+      end
+
+      it "matches adding the points one by one" do
+        points = Array.new(1_000) { |i| i * 1.5 }
+        one_by_one = described_class.new
+        points.each { |point| one_by_one.add(point) }
+
+        expect(sketch.add_all(points).encode).to eq(one_by_one.encode)
+      end
+
+      context "when a point is invalid" do
+        it "raises an error and leaves the sketch unchanged" do
+          expect { sketch.add_all([1.0, -1.0]) }.to raise_error(::RuntimeError, "DDSketch add_all failed: point is invalid")
+          expect(sketch.count).to be 0.0
+        end
+      end
+
+      context "when a point is not a number" do
+        it "raises an error" do
+          expect { sketch.add_all([1.0, "2"]) }.to raise_error(::TypeError)
+        end
+      end
+    end
+
+    describe "#merge" do
+      let(:other) { described_class.new.add_all([0, 10.0, 20.0]) }
+
+      it "adds the points of the other sketch" do
+        sketch.add(5.0)
+
+        expect(sketch.merge(other)).to be sketch
+        expect(sketch.count).to be 4.0
+        expect(other.count).to be 3.0
+      end
+
+      it "encodes like a sketch with all the points" do
+        expected = described_class.new.add_all([5.0, 0, 10.0, 20.0])
+
+        expect(sketch.add(5.0).merge(other).encode).to eq(expected.encode)
+      end
+
+      it "supports merging a sketch into itself" do
+        other.merge(other)
+
+        expect(other.count).to be 6.0
+        expect(other.quantile(1)).to be_within(0.01 * 20.0).of(20.0)
+      end
+    end
+
+    describe "#quantile" do
+      it "returns nil when the sketch is empty" do
+        expect(sketch.quantile(0.5)).to be nil
+      end
+
+      it "returns values within the relative accuracy" do
+        sketch.add_all((1..1_000).to_a)
+
+        expect(sketch.quantile(0)).to be_within(0.01).of(1.0)
+        expect(sketch.quantile(0.5)).to be_within(0.01 * 500).of(500.0)
+        expect(sketch.quantile(0.99)).to be_within(0.01 * 990).of(990.0)
+        expect(sketch.quantile(1)).to be_within(0.01 * 1_000).of(1_000.0)
+      end
+
+      it "returns zero for zero points" do
+        sketch.add_all([0, 0, 100.0])
+
+        expect(sketch.quantile(0.5)).to be 0.0
+      end
+
+      it "raises an error for quantiles outside of 0..1" do
+        sketch.add(1.0)
+
+        expect { sketch.quantile(1.5) }.to raise_error(ArgumentError, "quantile must be between 0 and 1")
+        expect { sketch.quantile(-0.1) }.to raise_error(ArgumentError)
+      end
+
+      it "keeps the highest values accurate when the lowest bins get collapsed" do
+        sketch.add_all([1.0, 1e300])
+
+        expect(sketch.quantile(1)).to be_within(0.01 * 1e300).of(1e300)
+      end
+    end
+
     describe "#count" do
       subject(:count) { sketch.count }
 
@@ -93,6 +183,13 @@ RSpec.describe Datadog::Core::DDSketch do
         expect { sketch.encode }.to change { sketch.count }.from(3.0).to(0.0)
       end
 
+      it "keeps the sketch when reset is false" do
+        encoded = sketch.encode(reset: false)
+
+        expect(sketch.count).to be 3.0
+        expect(sketch.encode).to eq(encoded)
+      end
+
       it "can be decoded" do
         42.times { sketch.add(0) }
         decoded = Test::DDSketch.decode(encode)
@@ -100,6 +197,29 @@ RSpec.describe Datadog::Core::DDSketch do
         # @ivoanjo: Not amazingly interesting, but just a simple sanity check that the round trip works
         expect(decoded.zeroCount).to be(42.0)
       end
+
+      context "when compared with a sketch built by libdatadog" do
+        let(:random) { Random.new(42) }
+        let(:points) { [0, 0, 1e-310, 1e-5, 0.5, 1.0, 1.015625, 2.0, 3.0, 12_345.678] + Array.new(1_000) { random.rand * 10_000 } }
+
+        def bins(encoded)
+          decoded = Test::DDSketch.decode(encoded)
+          store = decoded.positiveValues
+          bins = store.binCounts.to_h
+          store.contiguousBinCounts.each_with_index do |count, offset|
+            index = store.contiguousBinIndexOffset + offset
+            bins[index] = bins.fetch(index, 0.0) + count unless count.zero?
+          end
+
+          {gamma: decoded.mapping.gamma, zero_count: decoded.zeroCount, bins: bins}
+        end
+
+        it "encodes the same bins and counts" do
+          expected = described_class::Testing._native_encode_with_libdatadog(points)
+
+          expect(bins(described_class.new.add_all(points).encode)).to eq(bins(expected))
+        end
+      end
     end
   end
 end
@@ -2,6 +2,8 @@
 
 require "datadog/core"
 require "datadog/core/feature_flags"
+require "json"
+require "time"
 
 RSpec.describe Datadog::Core::FeatureFlags do
   let(:flags_json) do
@@ -88,6 +90,24 @@ RSpec.describe Datadog::Core::FeatureFlags do
           expect(result.error_code).to be_nil
           expect(result.error_message).to be_nil
         end
+
+        it "converts the fields once and returns the same objects on every access" do
+          expect(result.raw_value).to be(result.raw_value)
+          expect(result.variant).to be(result.variant)
+          expect(result.flag_metadata).to be(result.flag_metadata)
+        end
+
+        it "returns frozen strings shared between evaluations" do
+          other = configuration.get_assignment(
+            "test-flag", :object, {"targeting_key" => "other-user", "email" => "other@example.com"}
+          )
+
+          expect(result.variant).to be_frozen
+          expect(result.variant).to be(other.variant)
+          expect(result.allocation_key).to be(other.allocation_key)
+          expect(result.reason).to be(other.reason)
+          expect(result.flag_metadata).to eq({}).and be_frozen
+        end
       end
 
       context "when flag is missing" do
@@ -148,5 +168,224 @@ RSpec.describe Datadog::Core::FeatureFlags do
         end
       end
     end
+
+    describe "#get_assignment with an EvaluationContext" do
+      subject(:configuration) { described_class::Configuration.new(flags_json) }
+
+      let(:context_hash) { {"targeting_key" => "test-user", "email" => "user@example.com"} }
+      let(:context) { described_class::EvaluationContext.new(context_hash) }
+
+      it "evaluates the same as with the Hash it was built from" do
+        result = configuration.get_assignment("test-flag", :object, context)
+
+        expect(result.value).to eq({"feature" => "enabled", "color" => "blue", "count" => 42})
+        expect(result.variant).to eq("treatment")
+        expect(result.reason).to eq("TARGETING_MATCH")
+      end
+
+      it "can be reused across evaluations" do
+        results = Array.new(3) { configuration.get_assignment("test-flag", :object, context) }
+
+        expect(results.map(&:variant)).to eq(["treatment"] * 3)
+      end
+
+      it "does not see changes made to the Hash after it was built" do
+        context
+        context_hash["email"] = "user@different-domain.com"
+
+        expect(configuration.get_assignment("test-flag", :object, context).variant).to eq("treatment")
+      end
+    end
+
+    describe "#get_assignments" do
+      subject(:configuration) { described_class::Configuration.new(flags_json) }
+
+      let(:context_hash) { {"targeting_key" => "test-user", "email" => "user@example.com"} }
+
+      it "returns the resolution details of every flag, in order" do
+        results = configuration.get_assignments(["test-flag", "non-existent-flag"], :object, context_hash)
+
+        expect(results.map(&:variant)).to eq(["treatment", nil])
+        expect(results.map(&:error_code)).to eq([nil, "FLAG_NOT_FOUND"])
+      end
+
+      it "accepts an EvaluationContext" do
+        context = described_class::EvaluationContext.new(context_hash)
+
+        expect(configuration.get_assignments(["test-flag"], :object, context).map(&:variant)).to eq(["treatment"])
+      end
+
+      it "returns an empty array without flag keys" do
+        expect(configuration.get_assignments([], :object, context_hash)).to eq([])
+      end
+
+      it "raises for a flag key that is not a String" do
+        expect { configuration.get_assignments(["test-flag", :not_a_string], :object, context_hash) }
+          .to raise_error(TypeError)
+      end
+    end
+  end
+
+  describe "evaluation cache" do
+    subject(:configuration) { described_class::Configuration.new(flags_json) }
+
+    let(:context_hash) { {"targeting_key" => "test-user", "email" => "user@example.com"} }
+
+    it "serves equal evaluations from the cache, regardless of the context key order" do
+      first = configuration.get_assignment("test-flag", :object, context_hash)
+      second = configuration.get_assignment("test-flag", :object, context_hash.to_a.reverse.to_h)
+
+      expect(second).to_not be(first)
+      expect(second.value).to eq(first.value)
+      expect(second.reason).to eq("TARGETING_MATCH")
+    end
+
+    it "gives every result its own copy of the raw value" do
+      first = configuration.get_assignment("test-flag", :object, context_hash)
+      first.raw_value << " "
+      second = configuration.get_assignment("test-flag", :object, context_hash)
+
+      expect(second.raw_value).to_not be_frozen
+      expect(second.raw_value).to_not eq(first.raw_value)
+      expect(second.value).to eq({"feature" => "enabled", "color" => "blue", "count" => 42})
+    end
+
+    it "does not share results between different contexts, types, or flags" do
+      configuration.get_assignment("test-flag", :object, context_hash)
+
+      other_results = [
+        configuration.get_assignment("test-flag", :object, context_hash.merge("email" => "user@other.com")),
+        configuration.get_assignment("test-flag", :string, context_hash),
+        configuration.get_assignment("non-existent-flag", :object, context_hash),
+      ]
+
+      expect(other_results.map(&:variant)).to eq([nil, nil, nil])
+      expect(other_results[2].error_code).to eq("FLAG_NOT_FOUND")
+    end
+
+    it "does not serve an EvaluationContext from the cache of a different one" do
+      configuration.get_assignment("test-flag", :object, described_class::EvaluationContext.new(context_hash))
+      other_context = described_class::EvaluationContext.new(context_hash.merge("email" => "user@other.com"))
+
+      expect(configuration.get_assignment("test-flag", :object, other_context).variant).to be_nil
+    end
+
+    it "compares the context of cached results with the current one" do
+      mutable_context = {"targeting_key" => "test-user", "email" => +"user@example.com"}
+      configuration.get_assignment("test-flag", :object, mutable_context)
+      mutable_context["email"].replace("user@other.com")
+
+      expect(configuration.get_assignment("test-flag", :object, mutable_context).variant).to be_nil
+      expect(configuration.get_assignment("test-flag", :object, context_hash).variant).to eq("treatment")
+    end
+
+    context "with an allocation limited in time" do
+      subject(:configuration) { described_class::Configuration.new(JSON.generate(flags)) }
+
+      let(:boundary) { Time.now.utc + 0.3 }
+      let(:flags) do
+        JSON.parse(flags_json).tap do |flags|
+          flags["flags"]["test-flag"]["allocations"].first[boundary_key] = boundary.iso8601(3)
+        end
+      end
+
+      def wait_for_boundary
+        sleep(boundary - Time.now.utc + 0.05)
+      end
+
+      context "when it ends" do
+        let(:boundary_key) { "endAt" }
+
+        it "does not serve results evaluated before the end after it" do
+          expect(configuration.get_assignment("test-flag", :object, context_hash).variant).to eq("treatment")
+          wait_for_boundary
+
+          result = configuration.get_assignment("test-flag", :object, context_hash)
+          expect(result.variant).to be_nil
+          expect(result.reason).to eq("DEFAULT")
+        end
+      end
+
+      context "when it starts" do
+        let(:boundary_key) { "startAt" }
+
+        it "does not serve results evaluated before the start after it" do
+          expect(configuration.get_assignment("test-flag", :object, context_hash).variant).to be_nil
+          wait_for_boundary
+
+          expect(configuration.get_assignment("test-flag", :object, context_hash).variant).to eq("treatment")
+        end
+      end
+    end
+  end
+
+  describe "ExposureBuffer" do
+    subject(:buffer) { described_class::ExposureBuffer.new(2, 16) }
+
+    let(:attributes) { {"targeting_key" => "user-1", "plan" => "pro"} }
+
+    it "records exposures with a timestamp, and pops them all" do
+      now_ms = (Time.now.to_f * 1000).to_i
+
+      expect(buffer.push("flag", "allocation", "variant", "user-1", attributes)).to be(true)
+      expect(buffer.length).to eq(1)
+
+      exposures, dropped = buffer.pop
+
+      expect(exposures).to match([[be_within(1_000).of(now_ms), "flag", "allocation", "variant", "user-1", attributes]])
+      expect(dropped).to eq(0)
+      expect(buffer).to be_empty
+    end
+
+    it "copies the attributes" do
+      pushed_attributes = attributes.dup
+      buffer.push("flag", "allocation", "variant", "user-1", pushed_attributes)
+      pushed_attributes["plan"] = "free"
+
+      expect(buffer.pop.first.first.last).to eq(attributes)
+    end
+
+    it "skips the exposures repeating the last one of the same flag and targeting key" do
+      expect(buffer.push("flag", "allocation", "variant", "user-1", attributes)).to be(true)
+      expect(buffer.push(+"flag", "allocation", "variant", "user-1", {})).to be(false)
+      expect(buffer.pop.first.size).to eq(1)
+
+      expect(buffer.push("flag", "allocation", "variant", "user-1", attributes)).to be(false)
+      expect(buffer.push("flag", "allocation", "other-variant", "user-1", attributes)).to be(true)
+      expect(buffer.push("flag", "allocation", "variant", "user-2", attributes)).to be(true)
+    end
+
+    it "replaces the oldest exposures when full, and counts them" do
+      3.times { |i| buffer.push("flag-#{i}", nil, nil, nil, nil) }
+
+      exposures, dropped = buffer.pop
+
+      expect(exposures.map { |exposure| exposure[1] }).to eq(["flag-1", "flag-2"])
+      expect(dropped).to eq(1)
+      expect(buffer.pop).to eq([[], 0])
+    end
+
+    it "does not record exposures once closed" do
+      buffer.close
+
+      expect(buffer.push("flag", "allocation", "variant", "user-1", attributes)).to be(false)
+      expect(buffer).to be_empty
+    end
+
+    it "raises for non-positive limits" do
+      expect { described_class::ExposureBuffer.new(0, 16) }.to raise_error(ArgumentError)
+    end
+  end
+
+  describe "EvaluationContext" do
+    describe ".new" do
+      it "raises for a context that is not a Hash" do
+        expect { described_class::EvaluationContext.new("not a hash") }.to raise_error(TypeError)
+      end
+
+      it "raises for keys that are not Strings" do
+        expect { described_class::EvaluationContext.new({email: "user@example.com"}) }.to raise_error(TypeError)
+      end
+    end
   end
 end
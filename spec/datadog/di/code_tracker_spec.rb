@@ -10,6 +10,11 @@ RSpec.describe Datadog::DI::CodeTracker do
     described_class.new
   end
 
+  # Groups iseqs like DI.file_iseqs does, which skips eval'd code (no absolute path)
+  def iseqs_by_path(*iseqs)
+    iseqs.select(&:absolute_path).group_by(&:absolute_path)
+  end
+
   shared_context "when code tracker is running" do
     before do
       # Stub backfill so tests that use this context only exercise
@@ -233,13 +238,6 @@ RSpec.describe Datadog::DI::CodeTracker do
         trace_points: [[10, :call], [11, :line]],)
     end
 
-    let(:eval_iseq) do
-      instance_double(RubyVM::InstructionSequence,
-        absolute_path: nil,
-        first_lineno: 1,
-        trace_points: [[1, :line]],)
-    end
-
     # On Ruby 3.1+ iseq_type exists natively; on older Rubies
     # backfill_registry falls back to first_lineno == 0.
     # Only stub iseq_type when it actually exists — RSpec's
@@ -264,7 +262,7 @@ RSpec.describe Datadog::DI::CodeTracker do
     end
 
     it "populates registry with whole-file iseqs" do
-      allow(Datadog::DI).to receive(:file_iseqs).and_return([whole_file_iseq])
+      allow(Datadog::DI).to receive(:file_iseqs).and_return(iseqs_by_path(whole_file_iseq))
 
       expect(tracker.send(:registry)).to be_empty
       tracker.backfill_registry
@@ -275,15 +273,7 @@ RSpec.describe Datadog::DI::CodeTracker do
     end
 
     it "skips per-method iseqs" do
-      allow(Datadog::DI).to receive(:file_iseqs).and_return([per_method_iseq])
-
-      tracker.backfill_registry
-
-      expect(tracker.send(:registry)).to be_empty
-    end
-
-    it "skips eval iseqs (nil absolute_path)" do
-      allow(Datadog::DI).to receive(:file_iseqs).and_return([eval_iseq])
+      allow(Datadog::DI).to receive(:file_iseqs).and_return(iseqs_by_path(per_method_iseq))
 
       tracker.backfill_registry
 
@@ -298,7 +288,7 @@ RSpec.describe Datadog::DI::CodeTracker do
         absolute_path: "/app/lib/foo.rb",
         first_lineno: 0,
         trace_points: [],)
-      expect(Datadog::DI).to receive(:file_iseqs).and_return([dummy_iseq])
+      expect(Datadog::DI).to receive(:file_iseqs).and_return(iseqs_by_path(dummy_iseq))
 
       tracker.backfill_registry
 
@@ -315,7 +305,7 @@ RSpec.describe Datadog::DI::CodeTracker do
         first_lineno: 0,
         trace_points: [[1, :line]],)
       # Dummy comes first — simulates the heap ordering that causes the bug
-      expect(Datadog::DI).to receive(:file_iseqs).and_return([dummy_iseq, real_iseq])
+      expect(Datadog::DI).to receive(:file_iseqs).and_return(iseqs_by_path(dummy_iseq, real_iseq))
 
       tracker.backfill_registry
 
@@ -337,7 +327,7 @@ RSpec.describe Datadog::DI::CodeTracker do
         absolute_path: path,
         first_lineno: 0,
         trace_points: [[1, :line]],)
-      allow(Datadog::DI).to receive(:file_iseqs).and_return([conflicting_iseq])
+      allow(Datadog::DI).to receive(:file_iseqs).and_return(iseqs_by_path(conflicting_iseq))
 
       tracker.backfill_registry
 
@@ -347,7 +337,7 @@ RSpec.describe Datadog::DI::CodeTracker do
     it "stores multiple files from a single backfill call" do
       iseq_a = instance_double(RubyVM::InstructionSequence, absolute_path: "/app/lib/a.rb", first_lineno: 0, trace_points: [[1, :line]])
       iseq_b = instance_double(RubyVM::InstructionSequence, absolute_path: "/app/lib/b.rb", first_lineno: 0, trace_points: [[1, :line]])
-      allow(Datadog::DI).to receive(:file_iseqs).and_return([iseq_a, iseq_b])
+      allow(Datadog::DI).to receive(:file_iseqs).and_return(iseqs_by_path(iseq_a, iseq_b))
 
       tracker.backfill_registry
 
@@ -358,7 +348,7 @@ RSpec.describe Datadog::DI::CodeTracker do
     end
 
     it "is idempotent when called twice with the same iseqs" do
-      allow(Datadog::DI).to receive(:file_iseqs).and_return([whole_file_iseq])
+      allow(Datadog::DI).to receive(:file_iseqs).and_return(iseqs_by_path(whole_file_iseq))
 
       tracker.backfill_registry
       tracker.backfill_registry
@@ -370,14 +360,14 @@ RSpec.describe Datadog::DI::CodeTracker do
 
     it "adds new files on second call without overwriting existing entries" do
       iseq_a = instance_double(RubyVM::InstructionSequence, absolute_path: "/app/lib/a.rb", first_lineno: 0, trace_points: [[1, :line]])
-      allow(Datadog::DI).to receive(:file_iseqs).and_return([iseq_a])
+      allow(Datadog::DI).to receive(:file_iseqs).and_return(iseqs_by_path(iseq_a))
 
       tracker.backfill_registry
 
       # Second call returns the original file plus a new one
       iseq_a_new = instance_double(RubyVM::InstructionSequence, absolute_path: "/app/lib/a.rb", first_lineno: 0, trace_points: [[1, :line]])
       iseq_b = instance_double(RubyVM::InstructionSequence, absolute_path: "/app/lib/b.rb", first_lineno: 0, trace_points: [[1, :line]])
-      allow(Datadog::DI).to receive(:file_iseqs).and_return([iseq_a_new, iseq_b])
+      allow(Datadog::DI).to receive(:file_iseqs).and_return(iseqs_by_path(iseq_a_new, iseq_b))
 
       tracker.backfill_registry
 
@@ -389,9 +379,7 @@ RSpec.describe Datadog::DI::CodeTracker do
 
     it "filters mixed iseq types from a single file" do
       # file_iseqs returns both whole-file and per-method iseqs for same file
-      allow(Datadog::DI).to receive(:file_iseqs).and_return(
-        [whole_file_iseq, per_method_iseq],
-      )
+      allow(Datadog::DI).to receive(:file_iseqs).and_return(iseqs_by_path(whole_file_iseq, per_method_iseq))
 
       tracker.backfill_registry
 
@@ -464,9 +452,7 @@ RSpec.describe Datadog::DI::CodeTracker do
       end
 
       it "falls back to first_lineno == 0 for whole-file detection" do
-        allow(Datadog::DI).to receive(:file_iseqs).and_return(
-          [whole_file_iseq, per_method_iseq],
-        )
+        allow(Datadog::DI).to receive(:file_iseqs).and_return(iseqs_by_path(whole_file_iseq, per_method_iseq))
 
         tracker.backfill_registry
 
@@ -476,7 +462,7 @@ RSpec.describe Datadog::DI::CodeTracker do
       end
 
       it "skips iseqs with non-zero first_lineno" do
-        allow(Datadog::DI).to receive(:file_iseqs).and_return([per_method_iseq])
+        allow(Datadog::DI).to receive(:file_iseqs).and_return(iseqs_by_path(per_method_iseq))
 
         tracker.backfill_registry
 
@@ -524,7 +510,7 @@ RSpec.describe Datadog::DI::CodeTracker do
 
     it "finds backfilled entries by suffix" do
       iseq = instance_double(RubyVM::InstructionSequence, absolute_path: "/app/lib/datadog/di/foo.rb", first_lineno: 0, trace_points: [[1, :line]])
-      allow(Datadog::DI).to receive(:file_iseqs).and_return([iseq])
+      allow(Datadog::DI).to receive(:file_iseqs).and_return(iseqs_by_path(iseq))
 
       tracker.backfill_registry
 
@@ -534,7 +520,7 @@ RSpec.describe Datadog::DI::CodeTracker do
 
     it "finds backfilled entries by exact path" do
       iseq = instance_double(RubyVM::InstructionSequence, absolute_path: "/app/lib/datadog/di/foo.rb", first_lineno: 0, trace_points: [[1, :line]])
-      allow(Datadog::DI).to receive(:file_iseqs).and_return([iseq])
+      allow(Datadog::DI).to receive(:file_iseqs).and_return(iseqs_by_path(iseq))
 
       tracker.backfill_registry
 
@@ -543,7 +529,7 @@ RSpec.describe Datadog::DI::CodeTracker do
     end
 
     it "returns nil for paths not in backfill" do
-      allow(Datadog::DI).to receive(:file_iseqs).and_return([])
+      allow(Datadog::DI).to receive(:file_iseqs).and_return({})
 
       tracker.backfill_registry
 
@@ -716,7 +702,7 @@ RSpec.describe Datadog::DI::CodeTracker do
           absolute_path: "/app/lib/foo.rb",
           first_lineno: 0,
           trace_points: [[1, :line]],)
-        allow(Datadog::DI).to receive(:file_iseqs).and_return([iseq])
+        allow(Datadog::DI).to receive(:file_iseqs).and_return(iseqs_by_path(iseq))
 
         tracker.backfill_registry
 
@@ -741,9 +727,7 @@ RSpec.describe Datadog::DI::CodeTracker do
       end
 
       before do
-        allow(Datadog::DI).to receive(:file_iseqs).and_return(
-          [method_iseq, other_method_iseq],
-        )
+        allow(Datadog::DI).to receive(:file_iseqs).and_return(iseqs_by_path(method_iseq, other_method_iseq))
         tracker.backfill_registry
       end
 
@@ -772,7 +756,7 @@ RSpec.describe Datadog::DI::CodeTracker do
       end
 
       before do
-        allow(Datadog::DI).to receive(:file_iseqs).and_return([call_only_iseq])
+        allow(Datadog::DI).to receive(:file_iseqs).and_return(iseqs_by_path(call_only_iseq))
         tracker.backfill_registry
       end
 
@@ -789,7 +773,7 @@ RSpec.describe Datadog::DI::CodeTracker do
 
     context "when no iseqs exist at all" do
       before do
-        allow(Datadog::DI).to receive(:file_iseqs).and_return([])
+        allow(Datadog::DI).to receive(:file_iseqs).and_return({})
         tracker.backfill_registry
       end
 
@@ -808,7 +792,7 @@ RSpec.describe Datadog::DI::CodeTracker do
       end
 
       before do
-        allow(Datadog::DI).to receive(:file_iseqs).and_return([method_iseq])
+        allow(Datadog::DI).to receive(:file_iseqs).and_return(iseqs_by_path(method_iseq))
         tracker.backfill_registry
       end
 
@@ -839,9 +823,7 @@ RSpec.describe Datadog::DI::CodeTracker do
       end
 
       before do
-        allow(Datadog::DI).to receive(:file_iseqs).and_return(
-          [method_iseq, block_iseq],
-        )
+        allow(Datadog::DI).to receive(:file_iseqs).and_return(iseqs_by_path(method_iseq, block_iseq))
         tracker.backfill_registry
       end
 
@@ -868,7 +850,7 @@ RSpec.describe Datadog::DI::CodeTracker do
       end
 
       before do
-        allow(Datadog::DI).to receive(:file_iseqs).and_return([iseq_a, iseq_b])
+        allow(Datadog::DI).to receive(:file_iseqs).and_return(iseqs_by_path(iseq_a, iseq_b))
         tracker.backfill_registry
       end
 
@@ -905,7 +887,7 @@ RSpec.describe Datadog::DI::CodeTracker do
         absolute_path: "/app/lib/foo.rb",
         first_lineno: 10,
         trace_points: [[10, :line]],)
-      allow(Datadog::DI).to receive(:file_iseqs).and_return([method_iseq])
+      allow(Datadog::DI).to receive(:file_iseqs).and_return(iseqs_by_path(method_iseq))
 
       tracker.backfill_registry
 
@@ -916,7 +898,7 @@ RSpec.describe Datadog::DI::CodeTracker do
     it "groups multiple per-method iseqs by path" do
       iseq_a = instance_double(RubyVM::InstructionSequence, absolute_path: "/app/lib/foo.rb", first_lineno: 5)
       iseq_b = instance_double(RubyVM::InstructionSequence, absolute_path: "/app/lib/foo.rb", first_lineno: 20)
-      allow(Datadog::DI).to receive(:file_iseqs).and_return([iseq_a, iseq_b])
+      allow(Datadog::DI).to receive(:file_iseqs).and_return(iseqs_by_path(iseq_a, iseq_b))
 
       tracker.backfill_registry
 
@@ -933,7 +915,7 @@ RSpec.describe Datadog::DI::CodeTracker do
       # Override the default iseq_type stub to return :top for this
       # specific iseq, simulating a compile_file-produced :top iseq.
       allow(Datadog::DI).to receive(:iseq_type).with(compile_file_iseq).and_return(:top)
-      allow(Datadog::DI).to receive(:file_iseqs).and_return([compile_file_iseq])
+      allow(Datadog::DI).to receive(:file_iseqs).and_return(iseqs_by_path(compile_file_iseq))
 
       tracker.backfill_registry
 
@@ -945,7 +927,7 @@ RSpec.describe Datadog::DI::CodeTracker do
       method_iseq = instance_double(RubyVM::InstructionSequence,
         absolute_path: "/app/lib/foo.rb",
         first_lineno: 10,)
-      allow(Datadog::DI).to receive(:file_iseqs).and_return([method_iseq])
+      allow(Datadog::DI).to receive(:file_iseqs).and_return(iseqs_by_path(method_iseq))
 
       tracker.backfill_registry
       tracker.clear
@@ -23,9 +23,10 @@ require_relative "backfill_integration_test_class"
 # Ruby 3.2.9+ creates dummy iseqs (no bytecode, empty trace_points)
 # for profiler frames during require. Filter them out — only the real
 # top-level iseq has trace events and can target child iseq lines.
-BACKFILL_TEST_TOP_ISEQ = Datadog::DI.file_iseqs.find { |i|
-  i.absolute_path&.end_with?("backfill_integration_test_class.rb") &&
-    !i.trace_points.empty? &&
+BACKFILL_TEST_TOP_ISEQ = Datadog::DI.file_iseqs.find { |path, _iseqs|
+  path.end_with?("backfill_integration_test_class.rb")
+}&.last&.find { |i|
+  !i.trace_points.empty? &&
     (Datadog::DI.respond_to?(:iseq_type) ? Datadog::DI.iseq_type(i) == :top : i.first_lineno == 0)
 }
 GC.enable
@@ -27,10 +27,11 @@ RSpec.describe "all_iseqs" do
   # Since we do have some knowledge about our own library, for now assert
   # that we have a reasonable set of files from dd-trace-rb in the iseqs.
   it "returns iseqs for loaded files" do
-    datadog_iseqs = file_iseqs.select do |iseq|
-      iseq.absolute_path =~ %r{lib/datadog/}
+    datadog_iseqs_by_path = file_iseqs.select do |path, _iseqs|
+      path =~ %r{lib/datadog/}
     end
-    paths = datadog_iseqs.map(&:absolute_path).uniq
+    paths = datadog_iseqs_by_path.keys
+    datadog_iseqs = datadog_iseqs_by_path.values.flatten
 
     # When this test was written, there were 650+ files with
     # iseqs in them and 5200+ iseq objects available.
@@ -45,4 +46,25 @@ RSpec.describe "all_iseqs" do
     # only (simplest case) that have no iseqs, therefore generally,
     # the loaded features and available iseqs are not correlated.
   end
+
+  it "groups the iseqs by absolute path" do
+    file_iseqs.each do |path, iseqs|
+      expect(path).to be_a(String)
+      expect(iseqs).not_to be_empty
+      iseqs.each do |iseq|
+        expect(iseq).to be_a(RubyVM::InstructionSequence)
+        expect(iseq.absolute_path).to eq(path)
+      end
+    end
+  end
+
+  it "skips the top-level iseqs of compiled code" do
+    skip "iseq types are not available before Ruby 3.1" unless Datadog::DI.respond_to?(:iseq_type)
+
+    # Keep the compiled iseq alive so that it is still found by the object space walk
+    compiled_iseq = RubyVM::InstructionSequence.compile("def loaded_file_iseqs_spec_compiled; end", "compiled.rb")
+
+    expect(iseqs).to include(compiled_iseq)
+    expect(file_iseqs.values.flatten).not_to include(compiled_iseq)
+  end
 end
@@ -0,0 +1,152 @@
+require "datadog/di/spec_helper"
+require "datadog/di/serializer"
+require_relative "../serializer_helper"
+
+class DINativeSerializerSpecSensitiveType; end
+
+class DINativeSerializerSpecFields
+  def initialize(**fields)
+    fields.each do |k, v|
+      instance_variable_set("@#{k}", v)
+    end
+  end
+end
+
+RSpec.describe "Datadog::DI::NativeSerializer" do
+  di_test
+
+  extend SerializerHelper
+
+  default_settings
+
+  before do
+    allow(di_settings).to receive(:redacted_identifiers).and_return(["custom-secret"])
+    allow(di_settings).to receive(:redacted_type_names).and_return(%w[DINativeSerializerSpecSensitiveType])
+  end
+
+  let(:redactor) { Datadog::DI::Redactor.new(settings) }
+
+  let(:serializer) { Datadog::DI::Serializer.new(settings, redactor) }
+
+  # Same serializer, without the native implementation
+  let(:ruby_serializer) do
+    Datadog::DI::Serializer.new(settings, redactor).tap do |serializer|
+      allow(serializer).to receive(:native_serializer).and_return(nil)
+    end
+  end
+
+  before do
+    skip "DI::NativeSerializer is not available" unless defined?(Datadog::DI::NativeSerializer)
+  end
+
+  values = {
+    "nil" => nil,
+    "booleans" => [true, false],
+    "numbers" => [42, 2**80, 4.2],
+    "strings" => ["x", "a" * 150, "é" * 120, "", "frozen".freeze],
+    "symbols" => [:sym, :"#{"b" * 150}"],
+    "binary strings" => ["\x80\xff".b, ("\x80" * 200).b, "\xff".dup.force_encoding(Encoding::UTF_8)],
+    "non-UTF-8 strings" => "日本".encode(Encoding::Shift_JIS),
+    "times and dates" => [Time.utc(2020, 1, 2, 3, 4, 5), Date.new(2020, 1, 2), DateTime.new(2020, 1, 2, 3, 4, 5)],
+    "nested arrays" => [1, [2, [3, [4]]]],
+    "long arrays" => (1..30).to_a,
+    "hashes with redacted keys" => {
+      a: 1, "password" => 2, HTTP_AUTHORIZATION: 3, "x-api-key" => 4, "@token" => 5, "Pass Word" => 6, 7 => 8,
+      "custom_secret" => 9, "Set-Cookie" => 10, "httpinfo" => 11,
+    },
+    "long hashes" => (1..30).map { |i| [i, i] }.to_h,
+    "redacted types" => DINativeSerializerSpecSensitiveType.new,
+    "objects" => DINativeSerializerSpecFields.new(a: 1, password: 2, b: [1, 2], c: {x: DINativeSerializerSpecFields.new(y: 1)}),
+    "objects with many fields" => DINativeSerializerSpecFields.new(**(1..20).map { |i| [:"v#{i}", i] }.to_h),
+    "instances of anonymous classes" => Class.new.new,
+    "exceptions" => IOError.new("test error"),
+    "other core types" => [1r, 2i, (1..2), Struct.new(:a).new(1)],
+  }
+
+  values.each do |description, value|
+    it "serializes #{description} like the Ruby implementation" do
+      [nil, "password", :@token, "normal"].each do |name|
+        expect(serializer.serialize_value(value, name: name)).to eq(ruby_serializer.serialize_value(value, name: name))
+      end
+      expect(serializer.serialize_value(value, depth: 1, length: 3, collection_size: 2))
+        .to eq(ruby_serializer.serialize_value(value, depth: 1, length: 3, collection_size: 2))
+      expect(serializer.serialize_value(value, depth: 0, attribute_count: 1))
+        .to eq(ruby_serializer.serialize_value(value, depth: 0, attribute_count: 1))
+    end
+  end
+
+  it "duplicates mutable strings" do
+    string = +"abc"
+    serialized = serializer.serialize_value(string)
+    string << "d"
+
+    expect(serialized[:value]).to eq("abc")
+  end
+
+  context "with a custom serializer" do
+    with_di_registry_change
+
+    before do
+      Datadog::DI::Serializer.register(condition: lambda { |value| value == "custom" }) do |serializer, value, name:, depth:|
+        {type: "Custom"}
+      end
+    end
+
+    it "hands the values it targets to the Ruby implementation" do
+      expect(serializer).to receive(:serialize_value_in_ruby).once.and_call_original
+
+      expect(serializer.serialize_value(["x", "custom"])).to eq(
+        type: "Array", elements: [{type: "String", value: "x"}, {type: "Custom"}],
+      )
+    end
+  end
+
+  context "when a custom serializer condition exits" do
+    with_di_registry_change
+
+    let(:condition_calls) { [] }
+
+    before do
+      calls = condition_calls
+      Datadog::DI::Serializer.register(condition: lambda { |value|
+        next false unless value == "exit"
+
+        calls << value
+        yield_exit
+      }) do |serializer, value, name:, depth:|
+        {type: "Custom"}
+      end
+    end
+
+    context "with an exception" do
+      define_method(:yield_exit) { raise "condition failed" }
+
+      it "serializes the value again with the Ruby implementation" do
+        allow(Datadog.logger).to receive(:warn)
+
+        serialized = serializer.serialize_value("exit")
+
+        expect(condition_calls.size).to eq(2)
+        expect(serialized).to eq(ruby_serializer.serialize_value("exit"))
+      end
+    end
+
+    context "with a fatal exception" do
+      define_method(:yield_exit) { raise SystemExit }
+
+      it "lets it propagate" do
+        expect { serializer.serialize_value("exit") }.to raise_error(SystemExit)
+        expect(condition_calls.size).to eq(1)
+      end
+    end
+
+    context "with throw" do
+      define_method(:yield_exit) { throw :serializer_spec_exit, :thrown }
+
+      it "lets it propagate" do
+        expect(catch(:serializer_spec_exit) { serializer.serialize_value("exit") }).to eq(:thrown)
+        expect(condition_calls.size).to eq(1)
+      end
+    end
+  end
+end
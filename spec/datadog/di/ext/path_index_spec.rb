@@ -0,0 +1,169 @@
+require "datadog/di/spec_helper"
+require "datadog/di/utils"
+
+RSpec.describe "Datadog::DI::PathIndex" do
+  subject(:index) { Datadog::DI::PathIndex.new }
+
+  let(:paths) do
+    %w[
+      /app/lib/foo.rb
+      /app/lib/bar.rb
+      /app/vendor/lib/foo.rb
+      /App/Lib/Baz.rb
+      /app//lib/qux.rb
+      relative/lib/quux.rb
+    ]
+  end
+
+  before do
+    paths.each { |path| index.add(path) }
+  end
+
+  it "finds the paths ending with the suffix at a path component boundary" do
+    expect(index.match("foo.rb", false)).to contain_exactly("/app/lib/foo.rb", "/app/vendor/lib/foo.rb")
+    expect(index.match("app/lib/foo.rb", false)).to eq(["/app/lib/foo.rb"])
+    expect(index.match("oo.rb", false)).to eq([])
+    expect(index.match("pp/lib/foo.rb", false)).to eq([])
+  end
+
+  it "returns at most two paths" do
+    index.add("/other/lib/foo.rb")
+
+    expect(index.match("lib/foo.rb", false).length).to eq(2)
+  end
+
+  it "only matches absolute suffixes exactly" do
+    expect(index.match("/app/lib/foo.rb", false)).to eq(["/app/lib/foo.rb"])
+    expect(index.match("/lib/foo.rb", false)).to eq([])
+  end
+
+  it "matches case-insensitively on request" do
+    expect(index.match("lib/baz.rb", false)).to eq([])
+    expect(index.match("lib/baz.rb", true)).to eq(["/App/Lib/Baz.rb"])
+  end
+
+  it "agrees with Utils.path_matches_suffix?" do
+    suffixes = %w[
+      foo.rb lib/foo.rb app/lib/foo.rb /app/lib/foo.rb lib//qux.rb lib/qux.rb
+      /lib/qux.rb LIB/FOO.RB relative/lib/quux.rb lib/quux.rb Baz.rb
+    ]
+    suffixes.product([false, true]).each do |suffix, case_insensitive|
+      expected = paths.select do |path|
+        Datadog::DI::Utils.path_matches_suffix?(path, suffix, case_insensitive: case_insensitive)
+      end
+      actual = index.match(suffix, case_insensitive)
+
+      expect(actual.length).to eq([expected.length, 2].min), "for #{suffix.inspect} (case_insensitive: #{case_insensitive})"
+      expect(expected).to include(*actual)
+    end
+  end
+
+  it "indexes each path once" do
+    index.add("/app/lib/foo.rb")
+
+    expect(index.size).to eq(paths.length)
+  end
+
+  it "keeps the encoding of the paths" do
+    index.add("/app/lib/café.rb")
+
+    expect(index.match("café.rb", false).first.encoding).to eq(Encoding::UTF_8)
+    expect(index.match("CAFÉ.RB", true)).to eq(["/app/lib/café.rb"])
+  end
+
+  describe "#delete" do
+    it "removes the path" do
+      expect(index.delete("/app/lib/foo.rb")).to be true
+
+      expect(index.match("foo.rb", false)).to eq(["/app/vendor/lib/foo.rb"])
+      expect(index.match("/app/lib/foo.rb", false)).to eq([])
+      expect(index.match("app/lib/FOO.rb", true)).to eq([])
+      expect(index.size).to eq(paths.length - 1)
+    end
+
+    it "returns false for unknown paths" do
+      expect(index.delete("/app/lib/unknown.rb")).to be false
+      expect(index.delete("lib/foo.rb")).to be false
+      expect(index.size).to eq(paths.length)
+    end
+
+    it "allows adding the path again" do
+      index.delete("/app/lib/foo.rb")
+      index.add("/app/lib/foo.rb")
+
+      expect(index.match("app/lib/foo.rb", false)).to eq(["/app/lib/foo.rb"])
+    end
+  end
+
+  describe "#clear" do
+    it "removes all paths" do
+      index.clear
+
+      expect(index.size).to eq(0)
+      expect(index.match("foo.rb", false)).to eq([])
+    end
+  end
+end
+
+RSpec.describe "Datadog::DI::LineIndex" do
+  let(:source) do
+    <<~RUBY
+      def first
+        value = 1
+        value
+      end
+
+      def second
+        [1].each do |item|
+          item
+        end
+      end
+    RUBY
+  end
+
+  # Per-method iseqs, as stored by CodeTracker#backfill_registry
+  let(:iseqs) do
+    result = []
+    queue = []
+    RubyVM::InstructionSequence.compile(source).each_child { |child| queue << child }
+    while (iseq = queue.shift)
+      result << iseq
+      iseq.each_child { |child| queue << child }
+    end
+    result
+  end
+
+  subject(:line_index) { Datadog::DI::LineIndex.new(iseqs) }
+
+  it "returns the iseqs with a line probe target on the line" do
+    expect(line_index.iseqs_at(2).map(&:label)).to eq(["first"])
+    expect(line_index.iseqs_at(8).map(&:label)).to eq(["block in second"])
+  end
+
+  it "includes the iseqs returning on the line" do
+    expect(line_index.iseqs_at(4).map(&:label)).to eq(["first"])
+    expect(line_index.iseqs_at(9).map(&:label)).to eq(["block in second"])
+  end
+
+  it "returns nothing for lines without a line probe target" do
+    expect(line_index.iseqs_at(1)).to eq([])
+    expect(line_index.iseqs_at(5)).to eq([])
+    expect(line_index.iseqs_at(100)).to eq([])
+  end
+
+  it "agrees with the trace points of the iseqs" do
+    (0..12).each do |line|
+      expected = iseqs.select do |iseq|
+        iseq.trace_points.any? do |tp_line, event|
+          tp_line == line && (event == :line || event == :return || event == :b_return)
+        end
+      end
+
+      expect(line_index.iseqs_at(line)).to eq(expected), "for line #{line}"
+    end
+  end
+
+  it "indexes no lines for no iseqs" do
+    expect(Datadog::DI::LineIndex.new([]).iseqs_at(1)).to eq([])
+  end
+end
@@ -0,0 +1,80 @@
+require "datadog/di/spec_helper"
+
+RSpec.describe "Datadog::DI::ProbeRateLimiter" do
+  subject(:rate_limiter) { Datadog::DI::ProbeRateLimiter.new(rate) }
+
+  let(:rate) { 2 }
+
+  it "starts with a full bucket" do
+    expect(rate_limiter.available_tokens).to eq(2.0)
+  end
+
+  describe "#allow?" do
+    it "allows up to rate invocations at once" do
+      expect(rate_limiter.allow?).to be true
+      expect(rate_limiter.allow?).to be true
+      expect(rate_limiter.allow?).to be false
+    end
+
+    it "refills the bucket over time" do
+      2.times { rate_limiter.allow? }
+      expect(rate_limiter.allow?).to be false
+
+      sleep 0.6
+
+      expect(rate_limiter.allow?).to be true
+    end
+
+    context "when rate is zero" do
+      let(:rate) { 0 }
+
+      it "allows nothing" do
+        expect(rate_limiter.allow?).to be false
+      end
+    end
+
+    context "when rate is negative" do
+      let(:rate) { -1 }
+
+      it "allows everything" do
+        3.times { expect(rate_limiter.allow?).to be true }
+      end
+    end
+  end
+
+  describe "#exhausted?" do
+    it "does not take a token" do
+      3.times { expect(rate_limiter.exhausted?).to be false }
+      expect(rate_limiter.available_tokens).to be > 1
+    end
+
+    it "returns true once the tokens are taken" do
+      2.times { rate_limiter.allow? }
+      expect(rate_limiter.exhausted?).to be true
+    end
+
+    context "when rate is zero" do
+      let(:rate) { 0 }
+
+      it "returns true" do
+        expect(rate_limiter.exhausted?).to be true
+      end
+    end
+
+    context "when rate is negative" do
+      let(:rate) { -1 }
+
+      it "returns false" do
+        expect(rate_limiter.exhausted?).to be false
+      end
+    end
+  end
+
+  context "when rate is not a number" do
+    let(:rate) { "1" }
+
+    it "raises ArgumentError" do
+      expect { rate_limiter }.to raise_error(ArgumentError, /rate must be a number/)
+    end
+  end
+end
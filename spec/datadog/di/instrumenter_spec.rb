@@ -111,6 +111,22 @@ RSpec.describe Datadog::DI::Instrumenter do
         expect(observed_calls.first.return_value).to eq 42
         expect(observed_calls.first.duration).to be_a(Float)
       end
+
+      context "when rate limited" do
+        let(:rate_limit) { 0 }
+
+        it "calls the target method without running the probe" do
+          hook_method(probe) do |payload|
+            observed_calls << payload
+          end
+
+          expect(instrumenter).not_to receive(:run_method_probe)
+
+          expect(HookTestClass.new.hook_test_method).to eq 42
+
+          expect(observed_calls).to be_empty
+        end
+      end
     end
 
     context "when target method yields to a block" do
@@ -1746,6 +1762,20 @@ RSpec.describe Datadog::DI::Instrumenter do
           expect(observed_calls[0]).to be_a(Datadog::DI::Context)
           expect(observed_calls[0].caller_locations).to be_a(Array)
         end
+
+        it "does not run the trace point callback once rate limited" do
+          hook_line(probe) do |payload|
+            observed_calls << payload
+          end
+
+          expect(instrumenter).to receive(:line_trace_point_callback).once.and_call_original
+
+          expect do
+            HookLineRecursiveTestClass.new.infinitely_recursive
+          end.to raise_error(SystemStackError)
+
+          expect(observed_calls.length).to eq 1
+        end
       end
     end
 
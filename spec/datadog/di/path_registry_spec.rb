@@ -0,0 +1,110 @@
+require "datadog/di/spec_helper"
+require "datadog/di/path_registry"
+
+RSpec.describe Datadog::DI::PathRegistry do
+  di_test
+
+  subject(:registry) { described_class.new }
+
+  shared_examples "path suffix resolution" do
+    before do
+      registry["/app/lib/foo.rb"] = :foo
+      registry["/app/lib/bar.rb"] = :bar
+      registry["/app/vendor/lib/bar.rb"] = :vendor_bar
+      registry["/app/Lib/Baz.rb"] = :baz
+    end
+
+    it "resolves exact paths" do
+      expect(registry.resolve_path_suffix("/app/lib/foo.rb")).to eq("/app/lib/foo.rb")
+    end
+
+    it "resolves suffixes at a path component boundary" do
+      expect(registry.resolve_path_suffix("lib/foo.rb")).to eq("/app/lib/foo.rb")
+      expect(registry.resolve_path_suffix("vendor/lib/bar.rb")).to eq("/app/vendor/lib/bar.rb")
+      expect(registry.resolve_path_suffix("oo.rb")).to be nil
+    end
+
+    it "shortens the suffix until it matches" do
+      expect(registry.resolve_path_suffix("/home/dev/project/lib/foo.rb")).to eq("/app/lib/foo.rb")
+    end
+
+    it "raises when the suffix matches several paths" do
+      expect do
+        registry.resolve_path_suffix("lib/bar.rb")
+      end.to raise_error(Datadog::DI::Error::MultiplePathsMatch, "Multiple paths matched requested suffix")
+    end
+
+    it "falls back to case-insensitive matching" do
+      expect(registry.resolve_path_suffix("lib/baz.rb")).to eq("/app/Lib/Baz.rb")
+    end
+
+    it "prefers case-sensitive matches" do
+      registry["/app/lib/FOO.rb"] = :upcased_foo
+
+      expect(registry.resolve_path_suffix("lib/FOO.rb")).to eq("/app/lib/FOO.rb")
+    end
+
+    it "normalizes Windows separators" do
+      expect(registry.resolve_path_suffix("C:\\project\\lib\\foo.rb")).to eq("/app/lib/foo.rb")
+    end
+
+    it "does not resolve deleted paths" do
+      registry.delete("/app/lib/foo.rb")
+
+      expect(registry.resolve_path_suffix("lib/foo.rb")).to be nil
+    end
+
+    it "resolves paths added after a lookup" do
+      registry.resolve_path_suffix("foo.rb")
+      registry["/app/lib/qux.rb"] = :qux
+
+      expect(registry.resolve_path_suffix("qux.rb")).to eq("/app/lib/qux.rb")
+    end
+
+    it "does not resolve paths after being cleared" do
+      registry.resolve_path_suffix("foo.rb")
+      registry.clear
+
+      expect(registry.resolve_path_suffix("foo.rb")).to be nil
+    end
+  end
+
+  context "with the native path index" do
+    before do
+      skip "DI::PathIndex is not available" unless defined?(Datadog::DI::PathIndex)
+    end
+
+    include_examples "path suffix resolution"
+  end
+
+  context "without the native path index" do
+    before do
+      hide_const("Datadog::DI::PathIndex")
+    end
+
+    include_examples "path suffix resolution"
+  end
+
+  describe "Hash-like access" do
+    it "stores values by path" do
+      registry["/app/lib/foo.rb"] = :foo
+
+      expect(registry["/app/lib/foo.rb"]).to eq(:foo)
+      expect(registry.key?("/app/lib/foo.rb")).to be true
+      expect(registry.keys).to eq(["/app/lib/foo.rb"])
+      expect(registry.length).to eq(1)
+      expect(registry.to_a).to eq([["/app/lib/foo.rb", :foo]])
+    end
+
+    it "deletes and clears paths" do
+      registry["/app/lib/foo.rb"] = :foo
+      registry["/app/lib/bar.rb"] = :bar
+
+      expect(registry.delete("/app/lib/foo.rb")).to eq(:foo)
+      expect(registry.keys).to eq(["/app/lib/bar.rb"])
+
+      registry.clear
+      expect(registry).to be_empty
+    end
+  end
+end
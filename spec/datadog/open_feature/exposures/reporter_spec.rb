@@ -4,21 +4,15 @@ require "spec_helper"
 require "datadog/open_feature/exposures/reporter"
 
 RSpec.describe Datadog::OpenFeature::Exposures::Reporter do
-  before do
-    allow(Datadog::OpenFeature::Exposures::Deduplicator).to receive(:new).and_return(deduplicator)
-  end
-
   subject(:reporter) { described_class.new(worker, telemetry: telemetry, logger: logger) }
 
   let(:worker) { instance_double(Datadog::OpenFeature::Exposures::Worker) }
   let(:telemetry) { instance_double(Datadog::Core::Telemetry::Component) }
   let(:logger) { logger_allowing_debug }
 
-  let(:deduplicator) { instance_double(Datadog::OpenFeature::Exposures::Deduplicator) }
+  let(:fields) { {"targeting_key" => "john-doe"} }
   let(:context) do
-    instance_double(
-      "OpenFeature::SDK::EvaluationContext", targeting_key: "john-doe", fields: {"targeting_key" => "john-doe"}
-    )
+    instance_double("OpenFeature::SDK::EvaluationContext", targeting_key: "john-doe", fields: fields)
   end
   let(:result) do
     Datadog::OpenFeature::ResolutionDetails.new(
@@ -37,28 +31,22 @@ RSpec.describe Datadog::OpenFeature::Exposures::Reporter do
 
   describe "#report" do
     context "when exposure has not been reported" do
-      before { allow(deduplicator).to receive(:duplicate?).and_return(false) }
-
-      it "enqueues event" do
-        expect(worker).to receive(:enqueue).and_return(true)
+      it "enqueues the exposure" do
+        expect(worker).to receive(:enqueue).with("feature_flag", "4-for-john-doe", "4", "john-doe", fields)
+          .and_return(true)
         expect(reporter.report(result, flag_key: "feature_flag", context: context)).to be(true)
       end
     end
 
     context "when exposure was already reported" do
-      before { allow(deduplicator).to receive(:duplicate?).and_return(true) }
-
-      it "does not enqueue event again" do
-        expect(worker).not_to receive(:enqueue)
+      it "returns false" do
+        expect(worker).to receive(:enqueue).and_return(false)
         expect(reporter.report(result, flag_key: "feature_flag", context: context)).to be(false)
       end
     end
 
     context "when worker enqueue fails" do
-      before do
-        allow(deduplicator).to receive(:duplicate?).and_return(false)
-        allow(worker).to receive(:enqueue).and_raise(error)
-      end
+      before { allow(worker).to receive(:enqueue).and_raise(error) }
 
       let(:error) { StandardError.new("Oops") }
 
@@ -81,7 +69,6 @@ RSpec.describe Datadog::OpenFeature::Exposures::Reporter do
       end
 
       it "skips enqueueing exposure" do
-        expect(deduplicator).not_to receive(:duplicate?)
         expect(worker).not_to receive(:enqueue)
 
         expect(reporter.report(result, flag_key: "feature_flag", context: context)).to be(false)
@@ -90,7 +77,6 @@ RSpec.describe Datadog::OpenFeature::Exposures::Reporter do
 
     context "when evaluation context is nil" do
       it "skips enqueueing exposure" do
-        expect(deduplicator).not_to receive(:duplicate?)
         expect(worker).not_to receive(:enqueue)
 
         expect(reporter.report(result, flag_key: "feature_flag", context: nil)).to be(false)
@@ -4,6 +4,8 @@ require "spec_helper"
 require "datadog/open_feature/transport"
 
 RSpec.describe Datadog::OpenFeature::Exposures::Worker do
+  before { skip_if_libdatadog_not_supported }
+
   after do
     worker.stop(true, 0.1)
     worker.join
@@ -25,15 +27,7 @@ RSpec.describe Datadog::OpenFeature::Exposures::Worker do
   let(:telemetry) { instance_double(Datadog::Core::Telemetry::Component) }
   let(:response) { instance_double(Datadog::Core::Transport::HTTP::Adapters::Net::Response, ok?: true) }
   let(:logger) { logger_allowing_debug }
-  let(:event) do
-    {
-      timestamp: 1_735_689_600_000,
-      allocation: {key: "control"},
-      flag: {key: "demo-flag"},
-      variant: {key: "v1"},
-      subject: {id: "user-1", attributes: {"plan" => "pro"}},
-    }
-  end
+  let(:event) { ["demo-flag", "control", "v1", "user-1", {"plan" => "pro"}] }
 
   describe "#start" do
     context "when worker is disabled" do
@@ -50,24 +44,8 @@ RSpec.describe Datadog::OpenFeature::Exposures::Worker do
 
   describe "#enqueue" do
     context "when worker is not started" do
-      let(:event_2) do
-        {
-          timestamp: 1_735_689_600_000,
-          allocation: {key: "control-2"},
-          flag: {key: "demo-flag2"},
-          variant: {key: "v2"},
-          subject: {id: "user-2", attributes: {"plan" => "pro"}},
-        }
-      end
-      let(:event_3) do
-        {
-          timestamp: 1_735_689_600_000,
-          allocation: {key: "control-3"},
-          flag: {key: "demo-flag3"},
-          variant: {key: "v3"},
-          subject: {id: "user-3", attributes: {"plan" => "pro"}},
-        }
-      end
+      let(:event_2) { ["demo-flag2", "control-2", "v2", "user-2", {"plan" => "pro"}] }
+      let(:event_3) { ["demo-flag3", "control-3", "v3", "user-3", {"plan" => "pro"}] }
 
       it "starts on demand and processes buffer" do
         batches_sent = 0
@@ -76,9 +54,9 @@ RSpec.describe Datadog::OpenFeature::Exposures::Worker do
           response
         end
 
-        worker.enqueue(event)
-        worker.enqueue(event_2)
-        worker.enqueue(event_3)
+        worker.enqueue(*event)
+        worker.enqueue(*event_2)
+        worker.enqueue(*event_3)
 
         try_wait_until { worker.running? }
         try_wait_until { batches_sent.positive? }
@@ -95,7 +73,7 @@ RSpec.describe Datadog::OpenFeature::Exposures::Worker do
       it "logs debug message" do
         expect_lazy_log(logger, :debug, /Resolution details upload response was not OK/)
 
-        worker.enqueue(event)
+        worker.enqueue(*event)
         try_wait_until { worker.running? }
 
         worker.flush
@@ -110,7 +88,7 @@ RSpec.describe Datadog::OpenFeature::Exposures::Worker do
       it "logs debug message" do
         expect_lazy_log(logger, :debug, /Resolution details upload response was not OK/)
 
-        worker.enqueue(event)
+        worker.enqueue(*event)
         try_wait_until { worker.running? }
 
         worker.flush
@@ -126,7 +104,7 @@ RSpec.describe Datadog::OpenFeature::Exposures::Worker do
         expect(telemetry).to receive(:report).with(error, description: /Failed to flush resolution details events/)
         expect_lazy_log(logger, :debug, /Failed to flush resolution details events/)
 
-        worker.enqueue(event)
+        worker.enqueue(*event)
         try_wait_until { worker.running? }
 
         expect { worker.perform }.not_to raise_error
@@ -136,6 +114,40 @@ RSpec.describe Datadog::OpenFeature::Exposures::Worker do
     end
   end
 
+  describe "#enqueue deduplication" do
+    before { allow(transport).to receive(:send_exposures).and_return(response) }
+
+    it "skips an exposure repeating the last one of the same flag and subject" do
+      expect(worker.enqueue(*event)).to be(true)
+      expect(worker.enqueue(*event)).to be(false)
+      expect(worker.enqueue("demo-flag", "control", "v2", "user-1", {})).to be(true)
+      expect(worker.enqueue("demo-flag", "control", "v2", "user-2", {})).to be(true)
+    end
+
+    it "sends the exposures as events" do
+      payloads = []
+      allow(transport).to receive(:send_exposures) do |payload|
+        payloads << payload
+        response
+      end
+
+      worker.enqueue(*event)
+      try_wait_until { payloads.any? }
+
+      expect(payloads.first[:exposures]).to match(
+        [
+          {
+            timestamp: kind_of(Integer),
+            allocation: {key: "control"},
+            flag: {key: "demo-flag"},
+            variant: {key: "v1"},
+            subject: {id: "user-1", attributes: {"plan" => "pro"}},
+          }
+        ]
+      )
+    end
+  end
+
   describe "#graceful_shutdown" do
     context "when buffer contains events" do
       before do
@@ -143,15 +155,7 @@ RSpec.describe Datadog::OpenFeature::Exposures::Worker do
         stub_const("Datadog::OpenFeature::Exposures::Worker::GRACEFUL_SHUTDOWN_WAIT_INTERVAL_SECONDS", 0.1)
       end
 
-      let(:event_2) do
-        {
-          timestamp: 1_735_689_600_000,
-          allocation: {key: "control-2"},
-          flag: {key: "demo-flag2"},
-          variant: {key: "v2"},
-          subject: {id: "user-2", attributes: {"plan" => "pro"}},
-        }
-      end
+      let(:event_2) { ["demo-flag2", "control-2", "v2", "user-2", {"plan" => "pro"}] }
 
       it "flushes remaining events before stopping" do
         batches_sent = 0
@@ -160,11 +164,11 @@ RSpec.describe Datadog::OpenFeature::Exposures::Worker do
           response
         end
 
-        worker.enqueue(event)
+        worker.enqueue(*event)
         try_wait_until { worker.running? }
         try_wait_until { batches_sent.positive? }
 
-        worker.enqueue(event_2)
+        worker.enqueue(*event_2)
         worker.graceful_shutdown
         try_wait_until { !worker.running? }
 
@@ -315,6 +315,44 @@ RSpec.describe Datadog::Profiling::Collectors::CpuAndWallTimeWorker do
       expect(samples_for_thread(all_samples, idle_helper_thread)).to_not be_empty
     end
 
+    context "when the process is idle and GVL profiling is enabled" do
+      before { skip_if_gvl_profiling_not_supported(self) }
+
+      let(:gvl_profiling_enabled) { true }
+
+      it "skips idle samples when no thread changed its GVL state since the last one" do
+        start
+
+        try_wait_until { cpu_and_wall_time_worker.stats.fetch(:trigger_idle_sample_skipped) > 0 }
+
+        cpu_and_wall_time_worker.stop
+
+        stats = cpu_and_wall_time_worker.stats
+        expect(stats.fetch(:trigger_idle_sample_skipped)).to be > 0
+        expect(stats.fetch(:trigger_simulated_signal_delivery_attempts)).to be > 0
+      end
+
+      it "still records the wall-time spent by idle threads" do
+        # This thread blocks before the GVL hooks get installed, so it never gets a recorded GVL state
+        idle_thread = Thread.new { sleep }
+        try_wait_until { idle_thread.status == "sleep" }
+
+        start
+        try_wait_until { cpu_and_wall_time_worker.stats.fetch(:trigger_idle_sample_skipped) > 0 }
+        recorder.serialize!
+
+        sleep 0.5
+
+        # The serialize flush picks up the time accumulated while nothing was being sampled
+        samples = samples_for_thread(samples_from_pprof_without_gc_and_overhead(recorder.serialize!), idle_thread)
+        cpu_and_wall_time_worker.stop
+        idle_thread.kill
+        idle_thread.join
+
+        expect(samples.sum { |it| it.values.fetch(:"wall-time") }).to be >= 400_000_000
+      end
+    end
+
     context "with allocation profiling enabled" do
       # We need this otherwise allocations_during_sample will never change
       let(:allocation_profiling_enabled) { true }
@@ -582,8 +620,11 @@ RSpec.describe Datadog::Profiling::Collectors::CpuAndWallTimeWorker do
               gvl_sampling_time_ns_total: be > 0,
               gvl_sampling_time_ns_avg: be > 0,
               gvl_waiting_time_ns_total: be > 0,
+              gvl_waiting_time_ns_histogram: all(be >= 0),
             )
           )
+          expect(cpu_and_wall_time_worker.stats.fetch(:gvl_waiting_time_ns_histogram).size).to be 24
+          expect(cpu_and_wall_time_worker.stats.fetch(:gvl_waiting_time_ns_histogram).sum).to be > 0
         end
 
         context "when 'Waiting for GVL' periods are below waiting_for_gvl_threshold_ns" do
@@ -1455,6 +1496,7 @@ RSpec.describe Datadog::Profiling::Collectors::CpuAndWallTimeWorker do
           trigger_sample_attempts: 0,
           trigger_sample_extra_sleep: 0,
           trigger_simulated_signal_delivery_attempts: 0,
+          trigger_idle_sample_skipped: 0,
           simulated_signal_delivery: 0,
           signal_handler_enqueued_sample: 0,
           signal_handler_prepared_sample: 0,
@@ -1483,11 +1525,16 @@ RSpec.describe Datadog::Profiling::Collectors::CpuAndWallTimeWorker do
           gvl_sampling_time_ns_total: nil,
           gvl_sampling_time_ns_avg: nil,
           gvl_waiting_time_ns_total: nil,
+          gvl_waiting_time_ns_histogram: nil,
           sample_count: 0,
           gc_samples: 0,
           gc_samples_missed_due_to_missing_context: 0,
           inactive_thread_samples_skipped: 0,
           profiler_thread_samples_skipped: 0,
+          gvl_waiting_time_ns_by_endpoint: {},
+          gvl_waiting_time_ns_unattributed: 0,
+          gc_timeline_events: 0,
+          gc_timeline_events_dropped: 0,
         }
       )
     end
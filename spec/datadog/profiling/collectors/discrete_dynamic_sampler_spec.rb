@@ -372,4 +372,108 @@ RSpec.describe "Datadog::Profiling::Collectors::DiscreteDynamicSampler" do
       end
     end
   end
+
+  describe "skipping events in bulk" do
+    before do
+      # At an event rate of 8/sec and 2 samples per second, we sample 1/4 of total events.
+      simulate_load(duration_seconds: 120, events_per_second: 8, sampling_seconds: 0.01)
+      # Make sure we start from a clean slate (e.g. right after a sample)
+      @now += 0.125 until maybe_sample(sampling_seconds: 0.01)
+    end
+
+    it "reports how many of the upcoming events will not be sampled" do
+      expect(sampler._native_state_snapshot.fetch(:sampling_interval)).to be 4
+      expect(sampler._native_events_until_next_sample).to eq(3)
+    end
+
+    it "samples the event right after the skipped ones" do
+      sampler._native_skipped_events(sampler._native_events_until_next_sample)
+
+      expect(sampler._native_events_until_next_sample).to eq(0)
+      expect(maybe_sample(sampling_seconds: 0.01)).to be true
+    end
+
+    it "produces the same sampling decisions as skipping events one by one" do
+      one_by_one = Array.new(3) { maybe_sample(sampling_seconds: 0.01) }
+
+      expect(one_by_one).to eq([false, false, false])
+      expect(maybe_sample(sampling_seconds: 0.01)).to be true
+    end
+  end
+
+  context "when Poisson byte sampling is enabled" do
+    before { sampler._native_enable_poisson_byte_sampling(to_ns(@now)) }
+
+    # Simulates a load where half the events are small and half are big, returning the number of samples and the
+    # sum of their weights for each event size.
+    def simulate_bytes_load(duration_seconds:, events_per_second:, sampling_seconds:, small_bytes:, big_bytes:)
+      num_events = (events_per_second.to_f * duration_seconds).to_i
+      time_between_events = duration_seconds.to_f / num_events
+      stats = {small_bytes => {events: 0, samples: 0, weight: 0}, big_bytes => {events: 0, samples: 0, weight: 0}}
+
+      num_events.times do |i|
+        @now += time_between_events
+        event_bytes = i.even? ? small_bytes : big_bytes
+        stats[event_bytes][:events] += 1
+        next unless sampler._native_should_sample_bytes(event_bytes, to_ns(@now))
+
+        stats[event_bytes][:samples] += 1
+        stats[event_bytes][:weight] += sampler._native_poisson_weight(event_bytes)
+        sampler._native_after_sample(to_ns(@now + sampling_seconds))
+        @now += sampling_seconds
+      end
+
+      stats
+    end
+
+    let(:stats) do
+      # Warm things up a little to overcome the hardcoded starting parameters
+      simulate_bytes_load(**load_parameters, duration_seconds: 5)
+      # Actual stat window we care about
+      simulate_bytes_load(**load_parameters, duration_seconds: 60)
+    end
+    # Max overhead of 2% with each sample taking 0.001 seconds means we can afford 20 samples per second, e.g. one
+    # every 50 events, or one every 50 * 220 bytes on average.
+    let(:load_parameters) do
+      {events_per_second: 1000, sampling_seconds: 0.001, small_bytes: 40, big_bytes: 400}
+    end
+
+    it "samples every event at startup" do
+      expect(Array.new(10) { sampler._native_should_sample_bytes(40, to_ns(@now)) }).to all(be(true))
+    end
+
+    it "samples events proportionally to their size" do
+      ratio = stats[400][:samples].to_f / stats[40][:samples]
+
+      expect(ratio).to be_between(5, 15)
+    end
+
+    it "weighs samples such that they represent all events" do
+      expect(stats[40][:weight]).to be_within(stats[40][:events] * 0.3).of(stats[40][:events])
+      expect(stats[400][:weight]).to be_within(stats[400][:events] * 0.15).of(stats[400][:events])
+    end
+
+    it "keeps the overall sampling rate within the overhead target" do
+      num_samples = stats.values.sum { |size_stats| size_stats[:samples] }
+
+      expect(num_samples).to be_between(600, 20 * 60 * 1.2)
+    end
+
+    it "includes the byte sampling parameters in its state snapshot" do
+      stats
+
+      expect(sampler._native_state_snapshot).to include(
+        bytes_per_event: be_within(20).of(220),
+        sampling_interval_bytes: be > 0,
+      )
+    end
+
+    it "does not allow events to be skipped in bulk" do
+      expect(sampler._native_events_until_next_sample).to be 0
+    end
+
+    it "gives a weight of 1 to events when the sampler has no data yet" do
+      expect(sampler._native_poisson_weight(1234)).to be 1
+    end
+  end
 end
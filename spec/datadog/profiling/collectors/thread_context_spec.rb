@@ -51,6 +51,7 @@ RSpec.describe Datadog::Profiling::Collectors::ThreadContext do
   let(:otel_context_enabled) { false }
   let(:native_filenames_enabled) { false }
   let(:show_classes) { true }
+  let(:gc_timeline_events_enabled) { false }
 
   subject(:thread_context_collector) do
     collector = described_class.new(
@@ -62,6 +63,7 @@ RSpec.describe Datadog::Profiling::Collectors::ThreadContext do
       otel_context_enabled: otel_context_enabled,
       native_filenames_enabled: native_filenames_enabled,
       show_classes: show_classes,
+      gc_timeline_events_enabled: gc_timeline_events_enabled,
     )
     # This simulates how every profiling start/restart also resets the state.
     described_class::Testing._native_global_reset_per_thread_context(collector)
@@ -414,6 +416,17 @@ RSpec.describe Datadog::Profiling::Collectors::ThreadContext do
               expect(t1_sample.labels).to include("trace endpoint": "profiler.test")
             end
 
+            it "attributes Waiting for GVL time to the trace endpoint" do
+              skip_if_gvl_profiling_not_supported(self)
+
+              sample
+              on_gvl_waiting(t1)
+              on_gvl_running(t1)
+              sample
+
+              expect(stats.fetch(:gvl_waiting_time_ns_by_endpoint)).to match("profiler.test" => be > 0)
+            end
+
             context "when endpoint_collection_enabled is false" do
               let(:endpoint_collection_enabled) { false }
 
@@ -1510,6 +1523,44 @@ RSpec.describe Datadog::Profiling::Collectors::ThreadContext do
         expect(gc_sample.labels.fetch(:end_timestamp_ns)).to be_between(@time_before, @time_after)
       end
     end
+
+    context "when gc_timeline_events_enabled is true" do
+      let(:gc_timeline_events_enabled) { true }
+      let(:gc_samples) { samples.select { |it| it.labels.fetch(:"thread name") == "Garbage Collection" } }
+      let(:gc_timeline_sample) { gc_samples.find { |it| it.labels.key?(:"gc pages freed") } }
+      let(:gc_flamegraph_sample) { gc_samples.find { |it| !it.labels.key?(:"gc pages freed") } }
+
+      before do
+        on_gc_start
+        sleep 0.001 # Make sure the GC step is above the minimum duration for timeline events
+        on_gc_finish
+        @time_after = profiler_system_epoch_time_now_ns
+        sample_after_gc
+      end
+
+      it "records each GC step as a timeline-only Garbage Collection sample" do
+        expect(gc_timeline_sample.values).to include("cpu-samples": 0, "cpu-time": 0, "wall-time": 0)
+        expect(gc_timeline_sample.values.fetch(:timeline)).to be >= 1_000_000
+        expect(gc_timeline_sample.labels).to match a_hash_including(
+          "thread id": "GC",
+          "thread name": "Garbage Collection",
+          event: "gc",
+          "gc cause": an_instance_of(String),
+          "gc type": an_instance_of(String),
+          end_timestamp_ns: be <= @time_after,
+        )
+        expect(gc_timeline_sample.locations.first.path).to eq "Garbage Collection"
+      end
+
+      it "does not include the coalesced Garbage Collection sample in the timeline" do
+        expect(gc_flamegraph_sample.values).to include("cpu-samples": 1, timeline: 0)
+        expect(gc_flamegraph_sample.labels).to_not include(:end_timestamp_ns)
+      end
+
+      it "increments the gc_timeline_events counter when the events get recorded" do
+        expect { samples }.to change { stats.fetch(:gc_timeline_events) }.from(0).to(1)
+      end
+    end
   end
 
   describe "#sample_allocation" do
@@ -1800,6 +1851,12 @@ RSpec.describe Datadog::Profiling::Collectors::ThreadContext do
           expect(on_gvl_running(t1)).to be true
         end
 
+        it "records the Waiting for GVL duration to be attributed on the next sample" do
+          expect { on_gvl_running(t1) }
+            .to change { per_thread_context.fetch(t1).fetch(:gvl_waiting_time_ns_to_attribute) }
+            .from(0)
+        end
+
         context "when called several times in a row" do
           before { on_gvl_running(t1) }
 
@@ -1828,6 +1885,22 @@ RSpec.describe Datadog::Profiling::Collectors::ThreadContext do
         it "flags that a sample is not needed" do
           expect(on_gvl_running(t1)).to be false
         end
+
+        it "still records the Waiting for GVL duration to be attributed on the next sample" do
+          expect { on_gvl_running(t1) }
+            .to change { per_thread_context.fetch(t1).fetch(:gvl_waiting_time_ns_to_attribute) }
+            .from(0)
+        end
+
+        context "when thread is sampled afterwards, outside of a trace" do
+          it "accounts the Waiting for GVL duration as unattributed" do
+            on_gvl_running(t1)
+
+            expect { sample }.to change { stats.fetch(:gvl_waiting_time_ns_unattributed) }.from(0)
+            expect(per_thread_context.fetch(t1).fetch(:gvl_waiting_time_ns_to_attribute)).to be 0
+            expect(stats.fetch(:gvl_waiting_time_ns_by_endpoint)).to be_empty
+          end
+        end
       end
     end
 
@@ -2006,6 +2079,18 @@ RSpec.describe Datadog::Profiling::Collectors::ThreadContext do
         expect(t1_samples.size).to eq(1)
         expect(t1_samples.sum { |s| s.values.fetch(:"wall-time") }).to be > 0
       end
+
+      it "records the suspended thread via serialize even when no per-tick sample happened since its last sample" do
+        # This happens when the CpuAndWallTimeWorker skips idle samples because no thread changed its GVL state
+        sample # updates the snapshot
+        recorder.serialize! # flush the sample above (and first on-serialize flush)
+
+        result = recorder.serialize!
+
+        t1_samples = samples_for_thread(samples_from_pprof(result), t1)
+        expect(t1_samples.size).to eq(1)
+        expect(t1_samples.sum { |s| s.values.fetch(:"wall-time") }).to be > 0
+      end
     end
   end
 
@@ -98,6 +98,8 @@ RSpec.describe Datadog::Profiling::Component do
             .to receive(:native_filenames_enabled).and_return(:native_filenames_enabled_config)
           expect(settings.profiling.advanced)
             .to receive(:experimental_show_classes_enabled).and_return(:experimental_show_classes_enabled_config)
+          expect(settings.profiling.advanced)
+            .to receive(:experimental_gc_timeline_events_enabled).and_return(:gc_timeline_events_enabled_config)
 
           expect(Datadog::Profiling::Collectors::ThreadContext).to receive(:new).with(
             recorder: dummy_stack_recorder,
@@ -108,6 +110,7 @@ RSpec.describe Datadog::Profiling::Component do
             otel_context_enabled: false,
             native_filenames_enabled: :native_filenames_enabled_config,
             show_classes: :experimental_show_classes_enabled_config,
+            gc_timeline_events_enabled: :gc_timeline_events_enabled_config,
           )
 
           build_profiler_component
@@ -145,6 +148,9 @@ RSpec.describe Datadog::Profiling::Component do
             .with(:overhead_target_percentage_config, logger).and_return(:overhead_target_percentage_config)
           expect(settings.profiling.advanced)
             .to receive(:allocation_counting_enabled).and_return(:allocation_counting_enabled_config)
+          expect(settings.profiling.advanced)
+            .to receive(:experimental_allocation_poisson_sampling_enabled)
+            .and_return(:allocation_poisson_sampling_enabled_config)
           expect(described_class).to receive(:enable_gvl_profiling?).and_return(:gvl_profiling_result)
           expect(settings.profiling.advanced)
             .to receive(:sighandler_sampling_enabled).and_return(:sighandler_sampling_enabled_config)
@@ -160,6 +166,7 @@ RSpec.describe Datadog::Profiling::Component do
             dynamic_sampling_rate_overhead_target_percentage: :overhead_target_percentage_config,
             allocation_profiling_enabled: false,
             allocation_counting_enabled: :allocation_counting_enabled_config,
+            allocation_poisson_sampling_enabled: :allocation_poisson_sampling_enabled_config,
             gvl_profiling_enabled: :gvl_profiling_result,
             sighandler_sampling_enabled: :sighandler_sampling_enabled_config,
             cpu_sampling_interval_ms: :cpu_sampling_interval_ms_config,
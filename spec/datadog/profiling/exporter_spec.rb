@@ -81,6 +81,41 @@ RSpec.describe Datadog::Profiling::Exporter do
       expect(JSON.parse(flush.info_json, symbolize_names: true)).to eq(info)
     end
 
+    context "when worker stats include GVL profiling data" do
+      let(:worker_stats) do
+        {
+          statA: 123,
+          gvl_waiting_time_ns_total: 10_000,
+          gvl_waiting_time_ns_histogram: [0, 90, 0, 9, 1] + [0] * 19,
+        }
+      end
+
+      it "reports GVL waiting metrics" do
+        expect(JSON.parse(flush.metrics)).to eq(
+          [
+            ["ruby_global_lock_wait_time_total", 10_000],
+            ["ruby_global_lock_wait_count", 100],
+            ["ruby_global_lock_wait_time_p50", 2048],
+            ["ruby_global_lock_wait_time_p99", 8192],
+          ]
+        )
+      end
+
+      it "does not include the GVL waiting data in the worker stats" do
+        expect(JSON.parse(flush.internal_metadata_json, symbolize_names: true).fetch(:worker_stats)).to eq(statA: 123)
+      end
+
+      context "when there were no Waiting for GVL periods" do
+        let(:worker_stats) { {gvl_waiting_time_ns_total: 0, gvl_waiting_time_ns_histogram: [0] * 24} }
+
+        it "reports only the total time and count" do
+          expect(JSON.parse(flush.metrics)).to eq(
+            [["ruby_global_lock_wait_time_total", 0], ["ruby_global_lock_wait_count", 0]]
+          )
+        end
+      end
+    end
+
     context "when pprof recorder has no data" do
       let(:pprof_recorder_serialize) { nil }
 
@@ -660,6 +660,51 @@ RSpec.describe Datadog::Tracing::Configuration::Settings do
       end
     end
 
+    describe "#native_transport_eager_conversion" do
+      subject(:native_transport_eager_conversion) { settings.tracing.native_transport_eager_conversion }
+
+      it { is_expected.to be false }
+    end
+
+    describe "#native_transport_eager_conversion=" do
+      it "changes the #native_transport_eager_conversion setting" do
+        expect { settings.tracing.native_transport_eager_conversion = true }
+          .to change { settings.tracing.native_transport_eager_conversion }
+          .from(false)
+          .to(true)
+      end
+    end
+
+    describe "#native_transport_async_send" do
+      subject(:native_transport_async_send) { settings.tracing.native_transport_async_send }
+
+      it { is_expected.to be false }
+    end
+
+    describe "#native_transport_async_send=" do
+      it "changes the #native_transport_async_send setting" do
+        expect { settings.tracing.native_transport_async_send = true }
+          .to change { settings.tracing.native_transport_async_send }
+          .from(false)
+          .to(true)
+      end
+    end
+
+    describe "#native_transport_stats_computation" do
+      subject(:native_transport_stats_computation) { settings.tracing.native_transport_stats_computation }
+
+      it { is_expected.to be false }
+    end
+
+    describe "#native_transport_stats_computation=" do
+      it "changes the #native_transport_stats_computation setting" do
+        expect { settings.tracing.native_transport_stats_computation = true }
+          .to change { settings.tracing.native_transport_stats_computation }
+          .from(false)
+          .to(true)
+      end
+    end
+
     describe "#sampler" do
       subject(:sampler) { settings.tracing.sampler }
 
@@ -31,6 +31,8 @@ RSpec.describe Datadog::Tracing::Pipeline do
       it "does not modify any spans" do
         expect(pipeline.process!([trace])).to eq([trace])
       end
+
+      it { is_expected.to be_empty }
     end
 
     context "with a callable added" do
@@ -38,6 +40,10 @@ RSpec.describe Datadog::Tracing::Pipeline do
         expect(pipeline.before_flush(callable)).to eq([callable])
       end
 
+      it "is no longer empty" do
+        expect { pipeline.before_flush(callable) }.to change { pipeline.empty? }.from(true).to(false)
+      end
+
       it "takes a block as an argument" do
         expect(pipeline.before_flush(&callable)).to eq([callable])
       end
@@ -2,12 +2,16 @@
 
 require "datadog/tracing/transport/native"
 require "datadog/tracing/span"
+require "datadog/tracing/span_event"
+require "datadog/tracing/span_link"
+require "datadog/tracing/trace_digest"
 require "datadog/tracing/trace_segment"
 require "datadog/tracing/transport/trace_formatter"
 require "datadog/appsec"
 require "datadog/appsec/actions_handler/serializable_backtrace"
 require "socket"
 require "msgpack"
+require "json"
 
 # Verifies that span data put into traces arrives on the wire (at the
 # mock agent) with the correct field values after going through the
@@ -160,6 +164,8 @@ RSpec.describe "Native transport wire-level conformance" do
         (attrs[:meta] || {}).each { |k, v| span.set_tag(k, v) }
         (attrs[:metrics] || {}).each { |k, v| span.set_metric(k, v) }
         (attrs[:metastruct] || {}).each { |k, v| span.set_metastruct_tag(k, v) }
+        span.events.concat(attrs[:events] || [])
+        span.links.concat(attrs[:links] || [])
       end
     end
     Datadog::Tracing::TraceSegment.new(spans, id: trace_id, root_span_id: spans.first.id)
@@ -246,6 +252,19 @@ RSpec.describe "Native transport wire-level conformance" do
       expect(metrics["custom.metric"]).to eq(42.5)
     end
 
+    it "preserves every entry of spans with more tags than fit in one batch" do
+      meta = 150.times.map { |i| ["meta.#{i}", "value-#{i}"] }.to_h
+      metrics = 150.times.map { |i| ["metric.#{i}", i * 1.5] }.to_h
+      trace = make_trace([{name: "op", meta: meta, metrics: metrics}])
+      # Span#set_metric would convert it to a Float
+      trace.spans.first.metrics["bignum"] = 1 << 70
+
+      span = send_and_decode([trace]).first.first
+
+      expect(span["meta"]).to include(meta)
+      expect(span["metrics"]).to include(metrics.merge("bignum" => (1 << 70).to_f))
+    end
+
     it "preserves structured metadata as per-key MessagePack blobs" do
       trace = make_trace([{
         name: "op",
@@ -338,6 +357,144 @@ RSpec.describe "Native transport wire-level conformance" do
     end
   end
 
+  describe "span events and span links" do
+    let(:span_events) do
+      [
+        Datadog::Tracing::SpanEvent.new(
+          "exception",
+          attributes: {"message" => "boom \"quoted\"\n", "count" => 2, "ratio" => 0.5, "lines" => [1, 2]},
+          time_unix_nano: 1_700_000_000_000_000_000,
+        ),
+        Datadog::Tracing::SpanEvent.new("empty", time_unix_nano: 1),
+      ]
+    end
+
+    let(:span_links) do
+      [
+        Datadog::Tracing::SpanLink.new(
+          Datadog::Tracing::TraceDigest.new(
+            span_id: 12345,
+            trace_id: (0xabc << 64) | 0xdef,
+            trace_sampling_priority: 1,
+            trace_state: "rojo=00f067aa0ba902b7",
+          ),
+          attributes: {"link.kind" => "follows_from", "flags" => [true, 1]},
+        ),
+        Datadog::Tracing::SpanLink.new(Datadog::Tracing::TraceDigest.new(span_id: 1, trace_id: 2)),
+      ]
+    end
+
+    it "sends span events as the JSON \"events\" tag, as the Ruby transport does" do
+      trace = make_trace([{name: "op", events: span_events}])
+
+      decoded = send_and_decode([trace])
+      meta = decoded.first.first["meta"]
+
+      expect(JSON.parse(meta["events"])).to eq(JSON.parse(span_events.map(&:to_hash).to_json))
+    end
+
+    it "sends span links as the JSON \"_dd.span_links\" tag" do
+      trace = make_trace([{name: "op", links: span_links}])
+
+      decoded = send_and_decode([trace])
+      meta = decoded.first.first["meta"]
+
+      expect(JSON.parse(meta["_dd.span_links"])).to eq(JSON.parse(span_links.map(&:to_hash).to_json))
+    end
+
+    it "does not add either tag to spans without events or links" do
+      decoded = send_and_decode([make_trace([{name: "op"}])])
+      meta = decoded.first.first["meta"] || {}
+
+      expect(meta).to_not include("events", "_dd.span_links")
+    end
+  end
+
+  describe "trace-level tags" do
+    def make_sampled_trace(root_span_id: 111)
+      spans = [111, 222].map do |id|
+        Datadog::Tracing::Span.new("op#{id}", service: "conformance-svc", resource: "op", id: id, trace_id: 42)
+      end
+      Datadog::Tracing::TraceSegment.new(
+        spans,
+        id: (0xabc << 64) | 42,
+        root_span_id: root_span_id,
+        agent_sample_rate: 0.5,
+        rule_sample_rate: 0.123456789,
+        hostname: "my-host",
+        lang: "ruby",
+        origin: "synthetics",
+        process_id: 1234,
+        runtime_id: "my-runtime-id",
+        rate_limiter_rate: 1.0,
+        sample_rate: 0.75,
+        sampling_priority: 2,
+        resource: "GET /trace",
+        tags: {"_dd.p.dm" => "-3", "custom.tag" => "value", "custom.number" => 7},
+        metrics: {"custom.metric" => 1.5},
+        profiling_enabled: true,
+        apm_tracing_enabled: false,
+      )
+    end
+
+    # The tags the HTTP transport sends, in the wire format
+    def formatted(trace)
+      Datadog::Tracing::Transport::TraceFormatter.format!(trace)
+      trace.spans.map do |span|
+        {
+          "resource" => span.resource,
+          "meta" => span.send(:meta),
+          "metrics" => span.send(:metrics),
+        }
+      end
+    end
+
+    def received(decoded)
+      decoded.first.sort_by { |span| span["span_id"] }.map do |span|
+        {
+          "resource" => span["resource"],
+          "meta" => span["meta"] || {},
+          "metrics" => span["metrics"] || {},
+        }
+      end
+    end
+
+    it "sets the same tags as TraceFormatter, without changing the Ruby spans" do
+      trace = make_sampled_trace
+
+      decoded = send_and_decode([trace])
+
+      expect(trace.spans.first.get_tag("language")).to be nil
+      formatted(make_sampled_trace).zip(received(decoded)).each do |expected, actual|
+        expect(actual["resource"]).to eq(expected["resource"])
+        expect(actual["meta"]).to include(expected["meta"])
+        expect(actual["metrics"]).to include(expected["metrics"])
+      end
+    end
+
+    it "tags the last span of partial traces, without the trace tags" do
+      decoded = send_and_decode([make_sampled_trace(root_span_id: nil)])
+
+      expected = formatted(make_sampled_trace(root_span_id: nil))
+      actual = received(decoded)
+      expect(actual.last["meta"]).to include(expected.last["meta"])
+      expect(actual.last["meta"]).to_not include("custom.tag")
+      expect(actual.last["resource"]).to eq("op")
+    end
+
+    it "sets the same tags for traces converted ahead of the send" do
+      trace = make_sampled_trace
+      trace.native_chunk = transport.instance_variable_get(:@exporter)._native_prepare_trace(trace)
+
+      decoded = send_and_decode([trace.native_chunk])
+
+      formatted(make_sampled_trace).zip(received(decoded)).each do |expected, actual|
+        expect(actual["meta"]).to include(expected["meta"])
+        expect(actual["metrics"]).to include(expected["metrics"])
+      end
+    end
+  end
+
   describe "trace ID" do
     it "preserves 64-bit trace IDs" do
       tid = 0x00000000deadbeef
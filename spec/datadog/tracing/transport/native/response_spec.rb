@@ -18,7 +18,7 @@ RSpec.describe "Datadog::Tracing::Transport::Native::Response" do
 
   def make_response(ok:, internal_error: false, server_error: false,
     client_error: false, not_found: false,
-    unsupported: false, trace_count: 0, payload: nil)
+    unsupported: false, trace_count: 0, payload: nil, duplicate_string_bytes: 0)
     resp = response_class.allocate
     resp.instance_variable_set(:@ok, ok)
     resp.instance_variable_set(:@internal_error, internal_error)
@@ -28,11 +28,14 @@ RSpec.describe "Datadog::Tracing::Transport::Native::Response" do
     resp.instance_variable_set(:@unsupported, unsupported)
     resp.instance_variable_set(:@trace_count, trace_count)
     resp.instance_variable_set(:@payload, payload)
+    resp.instance_variable_set(:@duplicate_string_bytes, duplicate_string_bytes)
     resp
   end
 
   describe "ok response" do
-    subject(:response) { make_response(ok: true, trace_count: 5, payload: '{"rate_by_service":{}}') }
+    subject(:response) do
+      make_response(ok: true, trace_count: 5, payload: '{"rate_by_service":{}}', duplicate_string_bytes: 42)
+    end
 
     it { expect(response.ok?).to be true }
     it { expect(response.internal_error?).to be false }
@@ -42,6 +45,7 @@ RSpec.describe "Datadog::Tracing::Transport::Native::Response" do
     it { expect(response.unsupported?).to be false }
     it { expect(response.trace_count).to eq(5) }
     it { expect(response.payload).to eq('{"rate_by_service":{}}') }
+    it { expect(response.duplicate_string_bytes).to eq(42) }
   end
 
   describe "internal error response" do
@@ -72,6 +76,12 @@ RSpec.describe "Datadog::Tracing::Transport::Native::Response" do
     it { expect(response.client_error?).to be true }
   end
 
+  describe ".new" do
+    it "defaults duplicate_string_bytes to 0" do
+      expect(response_class.new(ok: true).duplicate_string_bytes).to eq(0)
+    end
+  end
+
   describe "nil payload" do
     subject(:response) { make_response(ok: true) }
 
@@ -170,6 +170,84 @@ RSpec.describe "Datadog::Tracing::Transport::Native::TraceExporter#_native_send_
     end
   end
 
+  describe "with a max_payload_size" do
+    let(:exporter) do
+      trace_exporter_class._native_new(
+        url: "http://127.0.0.1:#{mock_agent.port}",
+        tracer_version: "1.0.0-test",
+        language: "ruby",
+        language_version: RUBY_VERSION,
+        language_interpreter: RUBY_ENGINE,
+        hostname: "test-host",
+        env: "test-env",
+        service: "test-service",
+        version: "0.0.1",
+        max_payload_size: max_payload_size,
+      )
+    end
+    let(:max_payload_size) { 2000 }
+
+    def trace_requests
+      mock_agent.requests.select { |request| request[:request_line].include?("/traces") }
+    end
+
+    it "keeps trace chunks that fit together in one payload" do
+      responses = exporter._native_send_traces([[make_span("op1")], [make_span("op2")]])
+
+      expect(responses.map(&:trace_count)).to eq([2])
+      expect(trace_requests.size).to eq(1)
+    end
+
+    it "splits the trace chunks into several payloads, sent separately" do
+      chunks = Array.new(3) { |i| [make_span("op#{i}", meta: {"padding" => "x" * 1000})] }
+
+      responses = exporter._native_send_traces(chunks)
+
+      expect(responses.size).to eq(3)
+      expect(responses).to all(have_attributes(ok?: true, trace_count: 1))
+      expect(responses.map(&:payload)).to all(include("rate_by_service"))
+      expect(trace_requests.size).to eq(3)
+    end
+
+    it "sends a trace chunk larger than max_payload_size in a payload of its own" do
+      large = [make_span("large", meta: {"padding" => "x" * 5000})]
+
+      responses = exporter._native_send_traces([[make_span("op1")], [make_span("op2")], large, [make_span("op3")]])
+
+      expect(responses.map(&:trace_count)).to eq([2, 1, 1])
+      expect(responses).to all(be_ok)
+    end
+
+    it "splits TraceChunks converted ahead of the send as well" do
+      chunks = Array.new(2) do |i|
+        native_module::TraceChunk._native_from_spans([make_span("op#{i}", meta: {"padding" => "x" * 1500})])
+      end
+
+      expect(exporter._native_send_traces(chunks).map(&:trace_count)).to eq([1, 1])
+    end
+
+    context "when the agent returns an error" do
+      let(:mock_agent) { MockAgent.new(status: 500, body: '{"error":"server overloaded"}') }
+
+      it "returns an error response per payload" do
+        chunks = Array.new(2) { |i| [make_span("op#{i}", meta: {"padding" => "x" * 1500})] }
+
+        responses = exporter._native_send_traces(chunks)
+
+        expect(responses.size).to eq(2)
+        expect(responses).to all(have_attributes(ok?: false, trace_count: 1))
+      end
+    end
+
+    context "when it is not positive" do
+      let(:max_payload_size) { 0 }
+
+      it "raises ArgumentError" do
+        expect { exporter }.to raise_error(ArgumentError, "max_payload_size must be positive")
+      end
+    end
+  end
+
   describe "with spans containing meta and metrics" do
     it "does not raise" do
       span = make_span
@@ -182,6 +260,47 @@ RSpec.describe "Datadog::Tracing::Transport::Native::TraceExporter#_native_send_
     end
   end
 
+  describe "duplicate string accounting" do
+    # name, service, resource and type of a span made by make_span("op")
+    let(:span_strings_bytes) { "op".bytesize + "test-svc".bytesize + "GET /test".bytesize + "web".bytesize }
+
+    it "reports the bytes of strings repeated across spans of the payload" do
+      chunk1 = [make_span("op"), make_span("op")]
+      chunk2 = [make_span("op")]
+      chunk1.each { |span| span.set_tag("http.method", "GET") }
+
+      resp = exporter._native_send_traces([chunk1, chunk2]).first
+
+      # The strings of the 2nd and 3rd spans, plus the meta key and value of the 2nd span
+      expect(resp.duplicate_string_bytes).to eq((2 * span_strings_bytes) + "http.method".bytesize + "GET".bytesize)
+    end
+
+    it "counts strings repeated across TraceChunks converted ahead of the send" do
+      chunks = Array.new(2) { native_module::TraceChunk._native_from_spans([make_span("op")]) }
+
+      resp = exporter._native_send_traces(chunks + [[make_span("op")]]).first
+
+      expect(resp.duplicate_string_bytes).to eq(2 * span_strings_bytes)
+    end
+
+    it "compares strings by content, whatever they are used for" do
+      span = make_span("op", resource: "GET /other")
+      span.set_tag("a", "b")
+      span.set_tag("b", "a")
+
+      resp = exporter._native_send_traces([[span]]).first
+
+      # The "a" and "b" of the 2nd tag
+      expect(resp.duplicate_string_bytes).to eq(2)
+    end
+
+    it "reports no duplicate bytes when every string is unique" do
+      resp = exporter._native_send_traces([[make_span]]).first
+
+      expect(resp.duplicate_string_bytes).to eq(0)
+    end
+  end
+
   describe "when the agent returns an error" do
     let(:mock_agent) { MockAgent.new(status: 500, body: '{"error":"server overloaded"}') }
 
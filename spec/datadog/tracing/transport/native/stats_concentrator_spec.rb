@@ -0,0 +1,172 @@
+# frozen_string_literal: true
+
+require "datadog/tracing/span"
+require "datadog/tracing/trace_segment"
+require "datadog/tracing/transport/native/stats_concentrator"
+
+RSpec.describe Datadog::Tracing::Transport::Native::StatsConcentrator do
+  before do
+    skip_if_libdatadog_not_supported
+  end
+
+  subject(:concentrator) do
+    described_class.new(env: "test-env", service: "test-svc", version: "1.2.3", hostname: "test-host", tracer_version: "9.9.9")
+  end
+
+  let(:start_time) { Time.now - 60 }
+
+  def make_span(name, parent_id: 1, status: 0, service: "test-svc", resource: "GET /test", tags: {}, metrics: {},
+    start: start_time)
+    Datadog::Tracing::Span.new(
+      name,
+      service: service,
+      resource: resource,
+      parent_id: parent_id,
+      start_time: start,
+      duration: 0.25,
+      status: status,
+      meta: tags.dup,
+      metrics: metrics.dup,
+    )
+  end
+
+  def make_trace(spans, sampling_priority: 1, origin: nil)
+    Datadog::Tracing::TraceSegment.new(spans, sampling_priority: sampling_priority, origin: origin)
+  end
+
+  def flushed_stats
+    concentrator.flush(force: true).fetch("Stats").flat_map { |bucket| bucket.fetch("Stats") }
+  end
+
+  describe "#add" do
+    it "returns the traces kept by sampling" do
+      kept = make_trace([make_span("root", parent_id: 0)], sampling_priority: 1)
+      no_decision = make_trace([make_span("root", parent_id: 0)], sampling_priority: nil)
+      dropped = make_trace([make_span("root", parent_id: 0)], sampling_priority: 0)
+      rejected = make_trace([make_span("root", parent_id: 0)], sampling_priority: -1)
+
+      expect(concentrator.add([kept, no_decision, dropped, rejected])).to eq([kept, no_decision])
+    end
+
+    it "keeps the single span sampled spans of dropped traces" do
+      root = make_span("root", parent_id: 0)
+      single_span = make_span("child", metrics: {"_dd.span_sampling.mechanism" => 8.0})
+      trace = make_trace([root, single_span, make_span("other")], sampling_priority: 0, origin: "rum")
+
+      kept = concentrator.add([trace])
+
+      expect(kept.size).to eq(1)
+      expect(kept.first.spans).to eq([single_span])
+      expect(kept.first.origin).to eq("rum")
+      expect(trace.spans.size).to eq(3)
+    end
+
+    it "records the stats of dropped traces" do
+      concentrator.add([make_trace([make_span("root", parent_id: 0)], sampling_priority: 0)])
+
+      expect(flushed_stats).to contain_exactly(hash_including("Name" => "root", "Hits" => 1))
+    end
+
+    it "only records top-level, measured, and server/client/producer/consumer spans" do
+      spans = [
+        make_span("root", parent_id: 0),
+        make_span("entry", metrics: {"_dd.top_level" => 1.0}),
+        make_span("measured", metrics: {"_dd.measured" => 1.0}),
+        make_span("client", tags: {"span.kind" => "client"}),
+        make_span("internal", tags: {"span.kind" => "internal"}),
+        make_span("other"),
+      ]
+      concentrator.add([make_trace(spans)])
+
+      expect(flushed_stats.map { |stats| [stats["Name"], stats["TopLevelHits"]] }).to contain_exactly(
+        ["root", 1], ["entry", 1], ["measured", 0], ["client", 0]
+      )
+    end
+
+    it "aggregates hits, errors and durations per service, name, resource, and status code" do
+      spans = [
+        make_span("root", parent_id: 0, tags: {"http.status_code" => "200"}),
+        make_span("root", parent_id: 0, tags: {"http.status_code" => "200"}),
+        make_span("root", parent_id: 0, status: 1, tags: {"http.status_code" => "500"}),
+      ]
+      concentrator.add([make_trace(spans, origin: "synthetics-browser")])
+
+      expect(flushed_stats).to contain_exactly(
+        hash_including(
+          "Service" => "test-svc",
+          "Name" => "root",
+          "Resource" => "GET /test",
+          "HTTPStatusCode" => 200,
+          "Synthetics" => true,
+          "IsTraceRoot" => 1,
+          "Hits" => 2,
+          "Errors" => 0,
+          "Duration" => 500_000_000,
+        ),
+        hash_including("HTTPStatusCode" => 500, "Hits" => 1, "Errors" => 1, "Duration" => 250_000_000),
+      )
+      expect(concentrator).to be_empty
+    end
+
+    it "encodes the duration distributions as DDSketches" do
+      concentrator.add([make_trace([make_span("root", parent_id: 0)])])
+
+      stats = flushed_stats.first
+      expect(stats["OkSummary"]).to be_a(String).and(satisfy { |summary| !summary.empty? })
+      expect(stats["ErrorSummary"]).to eq(Datadog::Core::DDSketch.new.encode)
+    end
+
+    it "ignores unfinished spans" do
+      span = make_span("root", parent_id: 0)
+      span.duration = nil
+      span.end_time = nil
+      concentrator.add([make_trace([span])])
+
+      expect(concentrator).to be_empty
+    end
+  end
+
+  describe "#flush" do
+    it "returns nil when there are no stats" do
+      expect(concentrator.flush(force: true)).to be nil
+    end
+
+    it "only flushes complete buckets unless forced" do
+      concentrator.add([make_trace([make_span("root", parent_id: 0)])])
+      concentrator.add([make_trace([make_span("current", parent_id: 0, start: Time.now)])])
+
+      expect(concentrator.flush.fetch("Stats").flat_map { |bucket| bucket["Stats"].map { |stats| stats["Name"] } })
+        .to eq(["root"])
+      expect(concentrator).to_not be_empty
+      expect(concentrator.flush(force: true)).to_not be nil
+      expect(concentrator).to be_empty
+    end
+
+    it "returns a /v0.6/stats payload" do
+      concentrator.add([make_trace([make_span("root", parent_id: 0)])])
+
+      payload = concentrator.flush(force: true)
+
+      expect(payload).to include(
+        "Hostname" => "test-host",
+        "Env" => "test-env",
+        "Version" => "1.2.3",
+        "Service" => "test-svc",
+        "Lang" => "ruby",
+        "TracerVersion" => "9.9.9",
+        "RuntimeID" => Datadog::Core::Environment::Identity.id,
+        "Sequence" => 1,
+      )
+      bucket = payload["Stats"].first
+      expect(bucket["Duration"]).to eq(10_000_000_000)
+      expect(bucket["Start"] % 10_000_000_000).to eq(0)
+    end
+
+    it "discards the stats recorded before a fork" do
+      concentrator.add([make_trace([make_span("root", parent_id: 0)])])
+      allow(Process).to receive(:pid).and_return(Process.pid + 1)
+
+      expect(concentrator.flush(force: true)).to be nil
+    end
+  end
+end
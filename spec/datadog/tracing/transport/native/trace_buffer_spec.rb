@@ -0,0 +1,131 @@
+# frozen_string_literal: true
+
+require "datadog/core"
+require "datadog/tracing/span"
+require "datadog/tracing/trace_segment"
+
+RSpec.describe "Datadog::Tracing::Transport::Native::TraceBuffer" do
+  before do
+    skip_if_libdatadog_not_supported
+  end
+
+  subject(:buffer) { Datadog::Tracing::Transport::Native::TraceBuffer._native_new(max_size) }
+
+  let(:max_size) { 3 }
+
+  def make_trace(span_count)
+    Datadog::Tracing::TraceSegment.new(Array.new(span_count) { |i| Datadog::Tracing::Span.new("op#{i}") })
+  end
+
+  describe "._native_new" do
+    it "raises when the max size is not an Integer" do
+      expect { Datadog::Tracing::Transport::Native::TraceBuffer._native_new(nil) }.to raise_error(TypeError)
+    end
+  end
+
+  describe "#push" do
+    it "stores the trace and returns it" do
+      trace = make_trace(1)
+
+      expect(buffer.push(trace)).to be(trace)
+      expect(buffer.length).to eq(1)
+      expect(buffer).to_not be_empty
+    end
+
+    context "when full" do
+      let(:traces) { Array.new(max_size) { make_trace(1) } }
+      let(:trace) { make_trace(1) }
+
+      before { traces.each { |t| buffer.push(t) } }
+
+      it "replaces a random trace" do
+        buffer.push(trace)
+
+        popped = buffer.pop
+        expect(popped.size).to eq(max_size)
+        expect(popped).to include(trace)
+        expect((traces - popped).size).to eq(1)
+      end
+    end
+
+    context "with an unbounded buffer" do
+      let(:max_size) { 0 }
+
+      it "keeps every trace, in order" do
+        traces = Array.new(100) { make_trace(1) }
+        traces.each { |t| buffer.push(t) }
+        GC.start
+
+        expect(buffer.pop).to eq(traces)
+      end
+    end
+
+    context "when closed" do
+      before { buffer.close }
+
+      it "discards the trace" do
+        expect(buffer.push(make_trace(1))).to be_nil
+        expect(buffer).to be_empty
+        expect(buffer).to be_closed
+      end
+    end
+  end
+
+  describe "#concat" do
+    let(:max_size) { 4 }
+
+    it "stores the traces up to the max size" do
+      buffer.concat(Array.new(10) { make_trace(1) })
+
+      expect(buffer.length).to eq(4)
+    end
+
+    it "raises when not given an Array" do
+      expect { buffer.concat(nil) }.to raise_error(TypeError)
+    end
+  end
+
+  describe "#pop" do
+    let(:health_metrics) { spy("health_metrics") }
+
+    before { allow(Datadog).to receive(:health_metrics).and_return(health_metrics) }
+
+    it "returns the stored traces and empties the buffer" do
+      traces = [make_trace(1), make_trace(2)]
+      buffer.concat(traces)
+
+      expect(buffer.pop).to eq(traces)
+      expect(buffer).to be_empty
+      expect(buffer.pop).to eq([])
+    end
+
+    it "reports the same health metrics as the Ruby buffer" do
+      buffer.concat([make_trace(2), make_trace(1), make_trace(4), make_trace(5)])
+      buffer.pop
+
+      expect(health_metrics).to have_received(:queue_accepted).with(4)
+      expect(health_metrics).to have_received(:queue_accepted_lengths).with(12)
+      expect(health_metrics).to have_received(:queue_dropped).with(1)
+      expect(health_metrics).to have_received(:queue_max_length).with(max_size)
+      # 12 spans minus those of the trace that got replaced, picked at random among the first three
+      expect(health_metrics).to have_received(:queue_spans).with(satisfy { |spans| [8, 10, 11].include?(spans) })
+      expect(health_metrics).to have_received(:queue_length).with(3)
+    end
+
+    it "resets the health metrics" do
+      buffer.push(make_trace(1))
+      buffer.pop
+      buffer.pop
+
+      expect(health_metrics).to have_received(:queue_accepted).with(0)
+    end
+
+    it "still returns the traces when reporting metrics fails" do
+      allow(health_metrics).to receive(:queue_accepted).and_raise("boom")
+      trace = make_trace(1)
+      buffer.push(trace)
+
+      expect(buffer.pop).to eq([trace])
+    end
+  end
+end
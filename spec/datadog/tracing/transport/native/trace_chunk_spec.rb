@@ -0,0 +1,49 @@
+# frozen_string_literal: true
+
+require "datadog/core"
+require "datadog/tracing/span"
+
+RSpec.describe "Datadog::Tracing::Transport::Native::TraceChunk" do
+  before do
+    skip_if_libdatadog_not_supported
+  end
+
+  let(:native_module) { Datadog::Tracing::Transport::Native }
+  let(:trace_chunk_class) { native_module::TraceChunk }
+
+  describe "._native_from_spans" do
+    it "returns a TraceChunk" do
+      spans = [Datadog::Tracing::Span.new("op1"), Datadog::Tracing::Span.new("op2")]
+
+      expect(trace_chunk_class._native_from_spans(spans)).to be_a(trace_chunk_class)
+    end
+
+    it "accepts an empty array" do
+      expect(trace_chunk_class._native_from_spans([])).to be_a(trace_chunk_class)
+    end
+
+    it "raises when given something other than an array" do
+      expect { trace_chunk_class._native_from_spans(nil) }.to raise_error(TypeError)
+    end
+
+    it "raises when a span cannot be converted" do
+      span = Datadog::Tracing::Span.new("op1")
+      span.instance_variable_set(:@name, 1234)
+
+      expect { trace_chunk_class._native_from_spans([Datadog::Tracing::Span.new("op0"), span]) }
+        .to raise_error(TypeError)
+    end
+
+    context "GC safety" do
+      it "frees chunks that were never sent" do
+        20.times { trace_chunk_class._native_from_spans([Datadog::Tracing::Span.new("op1")]) }
+        GC.start
+        GC.start
+      end
+    end
+
+    it "cannot be allocated directly" do
+      expect { trace_chunk_class.new }.to raise_error(TypeError)
+    end
+  end
+end
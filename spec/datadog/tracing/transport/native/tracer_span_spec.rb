@@ -103,6 +103,36 @@ RSpec.describe "Datadog::Tracing::Transport::Native::TracerSpan" do
       end
     end
 
+    context "with many meta and metrics entries" do
+      it "sets all of them and counts skipped entries" do
+        meta = 150.times.map { |i| ["meta.#{i}", "value-#{i}"] }.to_h
+        meta["bad"] = 123
+        metrics = 150.times.map { |i| ["metric.#{i}", i * 1.5] }.to_h
+        metrics["bignum"] = 1 << 70
+        span = make_ruby_span(meta: meta, metrics: metrics)
+
+        expect(Datadog.logger).to receive(:warn).with(/skipped 1 non-string meta entries/)
+        expect(Datadog.logger).to_not receive(:warn).with(/metrics/)
+
+        expect(tracer_span_class._native_from_span(span)).to be_a(tracer_span_class)
+      end
+    end
+
+    context "with more meta and metrics entries than fit in one batch" do
+      it "sets all of them and counts skipped entries across batches" do
+        meta = 150.times.map { |i| ["meta.#{i}", "value-#{i}"] }.to_h
+        meta["bad"] = 123
+        metrics = 150.times.map { |i| ["metric.#{i}", i * 1.5] }.to_h
+        metrics["bignum"] = 1 << 70
+        span = make_ruby_span(meta: meta, metrics: metrics)
+
+        expect(Datadog.logger).to receive(:warn).with(/skipped 1 non-string meta entries/)
+        expect(Datadog.logger).to_not receive(:warn).with(/metrics/)
+
+        expect(tracer_span_class._native_from_span(span)).to be_a(tracer_span_class)
+      end
+    end
+
     context "with a nil meta" do
       it "does not iterate or warn" do
         span = make_ruby_span(meta: nil)
@@ -3,6 +3,9 @@
 require "datadog/tracing/transport/native"
 require "datadog/tracing/writer"
 require "datadog/tracing/span"
+require "datadog/tracing/span_event"
+require "datadog/tracing/span_link"
+require "datadog/tracing/trace_digest"
 require "datadog/tracing/trace_segment"
 require "datadog/tracing/transport/trace_formatter"
 require "datadog/core/utils/at_fork_monkey_patch"
@@ -146,6 +149,21 @@ RSpec.describe Datadog::Tracing::Transport::Native::Transport do
         transport_class.new(agent_settings: agent_settings, logger: logger)
       }.to raise_error(RuntimeError, /not supported/)
     end
+
+    it "gives the git tags to the exporter, to be set on the first span of every trace" do
+      allow(Datadog::Core::Environment::Git).to receive(:git_repository_url).and_return("https://example.com/repo.git")
+      allow(Datadog::Core::Environment::Git).to receive(:git_commit_sha).and_return("abc123")
+      expect(native_module::TraceExporter).to receive(:_native_new).with(
+        hash_including(
+          first_span_tags: hash_including(
+            "_dd.git.repository_url" => "https://example.com/repo.git",
+            "_dd.git.commit.sha" => "abc123",
+          )
+        )
+      ).and_call_original
+
+      transport
+    end
   end
 
   describe "fork-hook lifecycle" do
@@ -453,6 +471,20 @@ RSpec.describe Datadog::Tracing::Transport::Native::Transport do
       end
     end
 
+    context "when the process tags changed since the previous send" do
+      it "gives the new ones to the exporter" do
+        exporter = transport.instance_variable_get(:@exporter)
+        allow(Datadog::Core::Environment::Process).to receive(:serialized).and_return("entrypoint.name:changed")
+
+        expect(exporter).to receive(:_native_set_first_span_tags)
+          .with(hash_including("_dd.tags.process" => "entrypoint.name:changed")).and_call_original
+        expect(transport.send_traces([make_trace_segment("web.request")]).first).to be_ok
+
+        expect(exporter).to_not receive(:_native_set_first_span_tags)
+        transport.send_traces([make_trace_segment("web.request")])
+      end
+    end
+
     context "with multiple traces" do
       it "returns a success response" do
         traces = [
@@ -473,7 +505,6 @@ RSpec.describe Datadog::Tracing::Transport::Native::Transport do
 
         # Force an error by passing something that will fail conversion
         bad_traces = [double("bad_trace", spans: nil)]
-        allow(Datadog::Tracing::Transport::TraceFormatter).to receive(:format!)
 
         responses = transport.send_traces(bad_traces)
 
@@ -485,7 +516,6 @@ RSpec.describe Datadog::Tracing::Transport::Native::Transport do
 
       it "updates stats on exception" do
         bad_traces = [double("bad_trace", spans: nil)]
-        allow(Datadog::Tracing::Transport::TraceFormatter).to receive(:format!)
 
         expect { transport.send_traces(bad_traces) }
           .to change { transport.stats.internal_error }.from(0).to(1)
@@ -496,7 +526,6 @@ RSpec.describe Datadog::Tracing::Transport::Native::Transport do
       # fails the entire call rather than being sent partially. These document
       # that all-or-nothing behaviour for mixed batches.
       it "fails the whole batch when a good and a bad trace are mixed" do
-        allow(Datadog::Tracing::Transport::TraceFormatter).to receive(:format!)
         mixed = [make_trace_segment("web.request"), double("bad_trace", spans: nil)]
 
         responses = transport.send_traces(mixed)
@@ -507,7 +536,6 @@ RSpec.describe Datadog::Tracing::Transport::Native::Transport do
       end
 
       it "fails the whole batch for a good-bad-good ordering" do
-        allow(Datadog::Tracing::Transport::TraceFormatter).to receive(:format!)
         mixed = [
           make_trace_segment("op1"),
           double("bad_trace", spans: nil),
@@ -522,55 +550,276 @@ RSpec.describe Datadog::Tracing::Transport::Native::Transport do
       end
     end
 
-    context "with span fields the native exporter does not yet support" do
+    context "with span events and span links" do
       def trace_with(&block)
         trace = make_trace_segment("web.request")
         block.call(trace.spans.first)
         trace
       end
 
-      it "warns when a span carries span events" do
-        trace = trace_with { |span| span.events << double("span event") }
+      let(:span_link) do
+        Datadog::Tracing::SpanLink.new(
+          Datadog::Tracing::TraceDigest.new(span_id: 1, trace_id: 2),
+          attributes: {"link.kind" => "parent"},
+        )
+      end
+
+      it "sends a span carrying span events without warning" do
+        trace = trace_with do |span|
+          span.events << Datadog::Tracing::SpanEvent.new("exception", attributes: {"message" => "boom"})
+        end
 
-        expect(logger).to receive(:warn).once
+        expect(logger).to_not receive(:warn)
 
         expect(transport.send_traces([trace]).first.ok?).to be true
       end
 
-      it "warns when a span carries span links" do
-        trace = trace_with { |span| span.links << double("span link") }
+      it "sends a span carrying span links without warning" do
+        trace = trace_with { |span| span.links << span_link }
 
-        expect(logger).to receive(:warn).once
+        expect(logger).to_not receive(:warn)
 
         expect(transport.send_traces([trace]).first.ok?).to be true
       end
+    end
+  end
 
-      it "does not warn for a span with only scalar fields, meta, and metrics" do
-        trace = make_trace_segment("web.request")
+  describe "#prepare_trace" do
+    let(:transport) do
+      transport_class.new(agent_settings: agent_settings, logger: logger, eager_conversion: eager_conversion).tap do |t|
+        built_transports << t
+      end
+    end
+    let(:eager_conversion) { true }
+    let(:trace) { make_trace_segment("op1", "op2") }
 
-        expect(logger).to_not receive(:warn)
+    after { Datadog::Tracing::Pipeline.processors = [] }
+
+    it "converts the trace into a native TraceChunk" do
+      transport.prepare_trace(trace)
+
+      expect(trace.native_chunk).to be_a(native_module::TraceChunk)
+    end
+
+    it "does not tag the Ruby spans" do
+      transport.prepare_trace(trace)
 
-        transport.send_traces([trace])
+      expect(trace.spans.first.get_tag("language")).to be nil
+    end
+
+    it "sends the prepared chunk instead of converting the spans again" do
+      transport.prepare_trace(trace)
+      expect(native_module::TraceChunk).to_not receive(:_native_from_spans)
+
+      responses = transport.send_traces([trace])
+
+      expect(responses.first).to be_ok
+      expect(responses.first.trace_count).to eq(1)
+      expect(trace.native_chunk).to be nil
+    end
+
+    it "supports batches mixing prepared and unprepared traces" do
+      transport.prepare_trace(trace)
+
+      responses = transport.send_traces([trace, make_trace_segment("op3")])
+
+      expect(responses.first).to be_ok
+      expect(responses.first.trace_count).to eq(2)
+    end
+
+    context "when eager_conversion is disabled" do
+      let(:eager_conversion) { false }
+
+      it "does nothing" do
+        transport.prepare_trace(trace)
+
+        expect(trace.native_chunk).to be nil
       end
+    end
 
-      it "does not warn when a span carries meta_struct" do
-        trace = trace_with { |span| span.metastruct["_dd.stack"] = {} }
+    context "when Pipeline processors are configured" do
+      before { Datadog::Tracing::Pipeline.before_flush { |it| it } }
 
-        expect(logger).to_not receive(:warn)
+      it "does nothing" do
+        transport.prepare_trace(trace)
+
+        expect(trace.native_chunk).to be nil
+      end
+    end
+
+    context "when Pipeline processors are configured after the trace was prepared" do
+      it "converts the spans again when sending" do
+        transport.prepare_trace(trace)
+        Datadog::Tracing::Pipeline.before_flush { |it| it }
+
+        exporter = transport.instance_variable_get(:@exporter)
+        expect(exporter).to receive(:_native_send_traces).with([trace]).and_call_original
+        expect(transport.send_traces([trace]).first).to be_ok
+      end
+    end
+  end
+
+  describe "#send_traces with async_send" do
+    let(:transport) do
+      transport_class.new(
+        agent_settings: agent_settings,
+        logger: logger,
+        async_send: true,
+        max_in_flight_sends: max_in_flight_sends,
+      ).tap { |t| built_transports << t }
+    end
+    let(:max_in_flight_sends) { 4 }
 
-        transport.send_traces([trace])
+    def wait_for_completed_sends(count)
+      Timeout.timeout(5) do
+        sleep 0.01 until transport.async_stats.fetch(:completed) >= count
       end
+    end
+
+    it "returns without waiting for the agent, and reports the responses on a later call" do
+      # The send may only complete after the call returns, so its response comes with a later call
+      responses = transport.send_traces([make_trace_segment("op1")])
+      wait_for_completed_sends(1)
+      responses += transport.send_traces([make_trace_segment("op2")])
+
+      expect(responses.first).to have_attributes(ok?: true, trace_count: 1)
+      expect(responses.first.service_rates).to eq("service:,env:" => 1.0)
+    end
+
+    it "reports every batch exactly once, including those still queued when closed" do
+      3.times { |i| transport.send_traces([make_trace_segment("op#{i}")]) }
+      transport.close
+
+      expect(transport.stats.success).to eq(3)
+    end
+
+    it "stops the sender thread when closed" do
+      exporter = transport.instance_variable_get(:@exporter)
+      transport.send_traces([make_trace_segment("op")])
+
+      transport.close
+
+      expect { exporter._native_poll_async_sends }.to raise_error(RuntimeError, /was stopped/)
+    end
+
+    context "when the agent does not respond" do
+      let(:silent_agent) { TCPServer.new("127.0.0.1", 0) }
+      let(:agent_settings) { double("agent_settings", url: "http://127.0.0.1:#{silent_agent.addr[1]}") }
+      let(:max_in_flight_sends) { 1 }
+
+      after { silent_agent.close }
 
-      it "warns only once across multiple sends" do
-        expect(logger).to receive(:warn).once
+      it "drops batches beyond max_in_flight_sends instead of blocking" do
+        transport.send_traces([make_trace_segment("op1")])
+        transport.send_traces([make_trace_segment("op2"), make_trace_segment("op3")])
 
-        2.times do
-          transport.send_traces([trace_with { |span| span.events << double("span event") }])
+        expect(transport.async_stats).to include(in_flight: 1, enqueued: 1, dropped: 1, traces_dropped: 2)
+      end
+
+      context "with batches split into several payloads" do
+        let(:transport) do
+          transport_class.new(
+            agent_settings: agent_settings,
+            logger: logger,
+            async_send: true,
+            max_in_flight_sends: max_in_flight_sends,
+            max_payload_size: 1,
+          ).tap { |t| built_transports << t }
+        end
+
+        it "queues each payload separately, dropping those beyond max_in_flight_sends" do
+          transport.send_traces([make_trace_segment("op1"), make_trace_segment("op2"), make_trace_segment("op3")])
+
+          expect(transport.async_stats).to include(enqueued: 1, dropped: 2, traces_dropped: 2)
         end
       end
     end
   end
 
+  describe "#send_traces with max_payload_size" do
+    let(:transport) do
+      transport_class.new(agent_settings: agent_settings, logger: logger, max_payload_size: 1)
+        .tap { |t| built_transports << t }
+    end
+
+    it "returns one response per payload, and counts each of them in the stats" do
+      responses = transport.send_traces([make_trace_segment("op1"), make_trace_segment("op2", "op3")])
+
+      expect(responses.map(&:trace_count)).to eq([1, 1])
+      expect(responses).to all(be_ok)
+      expect(transport.stats.success).to eq(2)
+    end
+  end
+
+  describe "#send_traces with stats_computation" do
+    let(:transport) do
+      transport_class.new(agent_settings: agent_settings, logger: logger, stats_computation: true)
+        .tap { |t| built_transports << t }
+    end
+    let(:exporter) { transport.instance_variable_get(:@exporter) }
+    let(:stats_transport) { transport.instance_variable_get(:@stats_transport) }
+
+    def make_finished_trace(sampling_priority:, start_time: Time.now - 60)
+      make_trace_segment("op").tap do |trace|
+        trace.spans.each do |span|
+          span.start_time = start_time
+          span.duration = 0.1
+        end
+        trace.send(:sampling_priority=, sampling_priority)
+      end
+    end
+
+    it "tells the exporter that stats are computed by the tracer" do
+      expect(native_module::TraceExporter).to receive(:_native_new)
+        .with(hash_including(client_computed_stats: true)).and_call_original
+
+      transport
+    end
+
+    it "only sends the traces kept by sampling" do
+      kept = make_finished_trace(sampling_priority: 1)
+      allow(stats_transport).to receive(:send_stats)
+      expect(exporter).to receive(:_native_send_traces).with([kept]).and_call_original
+
+      transport.send_traces([kept, make_finished_trace(sampling_priority: 0)])
+    end
+
+    it "does not send anything but stats when every trace is dropped" do
+      expect(exporter).to_not receive(:_native_send_traces)
+      expect(stats_transport).to receive(:send_stats) do |payload|
+        expect(payload["Stats"].first["Stats"]).to contain_exactly(hash_including("Name" => "op", "Hits" => 2))
+        double("response", ok?: true)
+      end
+
+      expect(transport.send_traces([make_finished_trace(sampling_priority: 0), make_finished_trace(sampling_priority: -1)]))
+        .to eq([])
+    end
+
+    it "sends the stats of the current bucket when closed" do
+      allow(stats_transport).to receive(:send_stats).and_return(double("response", ok?: true))
+      transport.send_traces([make_finished_trace(sampling_priority: 1, start_time: Time.now)])
+
+      transport.close
+
+      expect(stats_transport).to have_received(:send_stats).once
+    end
+  end
+
+  describe "#build_trace_buffer" do
+    it "returns a native trace buffer of the given size" do
+      buffer = transport.build_trace_buffer(42)
+
+      expect(buffer).to be_a(Datadog::Tracing::Transport::Native::TraceBuffer)
+      expect(buffer.max_size).to eq(42)
+    end
+  end
+
+  describe "#async_stats" do
+    it "is nil without async_send" do
+      expect(transport.async_stats).to be nil
+    end
+  end
+
   describe "#stats" do
     it "returns a Statistics::Counts object" do
       counts = transport.stats
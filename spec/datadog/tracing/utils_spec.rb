@@ -87,6 +87,60 @@ RSpec.describe Datadog::Tracing::Utils::TraceId do
     end
   end
 
+  describe ".next_id" do
+    context "when 128 bit trace id generation is enabled" do
+      before { allow(Datadog.configuration.tracing).to receive(:trace_id_128_bit_generation_enabled).and_return(true) }
+
+      it "puts the current time in the high order part" do
+        allow(Datadog::Core::Utils::Time).to receive(:now).and_return(Time.at(0x12345678))
+
+        expect(described_class.to_high_order(described_class.next_id)).to eq(0x1234567800000000)
+      end
+
+      it "picks up a new second" do
+        allow(Datadog::Core::Utils::Time).to receive(:now).and_return(Time.at(1), Time.at(2))
+
+        expect([described_class.next_id, described_class.next_id].map { |id| described_class.to_high_order(id) })
+          .to eq([1 << 32, 2 << 32])
+      end
+    end
+  end
+
+  describe ".to_high_order_hex" do
+    {
+      0xaaaaaaaaaaaaaaaa => nil,
+      0xffffffffffffffffaaaaaaaaaaaaaaaa => "ffffffffffffffff",
+      0x00000000aaaaaaaaffffffffffffffff => "00000000aaaaaaaa",
+      0x0000000000000001ffffffffffffffff => "0000000000000001",
+    }.each do |input, result|
+      context "when given `0x#{input.to_s(16)}`" do
+        it "returns #{result.inspect}" do
+          expect(described_class.to_high_order_hex(input)).to eq(result)
+        end
+      end
+    end
+
+    it "formats the high order part of the next trace id" do
+      described_class.to_high_order_hex(0xaaaaaaaaaaaaaaaa0000000000000000)
+
+      expect(described_class.to_high_order_hex(0xaaaaaaaaaaaaaaab0000000000000000)).to eq("aaaaaaaaaaaaaaab")
+    end
+  end
+
+  describe ".concatenate_hex" do
+    {
+      ["aaaaaaaaaaaaaaaa", 0xffffffffffffffff] => 0xaaaaaaaaaaaaaaaaffffffffffffffff,
+      ["AAAAAAAAAAAAAAAB", 0xffffffffffffffff] => 0xaaaaaaaaaaaaaaabffffffffffffffff,
+      ["0000000000000000", 0xffffffff] => 0xffffffff,
+    }.each do |(high_order, low_order), result|
+      context "when given `#{high_order}` and `#{low_order}`" do
+        it "returns `0x#{result.to_s(16)}`" do
+          expect(described_class.concatenate_hex(high_order, low_order)).to eq(result)
+        end
+      end
+    end
+  end
+
   describe ".concatenate" do
     {
       [0xaaaaaaaaaaaaaaaa, 0xffffffffffffffff] => 0xaaaaaaaaaaaaaaaaffffffffffffffff,
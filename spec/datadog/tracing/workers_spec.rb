@@ -62,6 +62,32 @@ RSpec.describe Datadog::Tracing::Workers::AsyncTransport do
     end
   end
 
+  describe "#trace_buffer" do
+    it "is a Ruby trace buffer of the given size" do
+      expect(worker.trace_buffer).to be_a(Datadog::Tracing::TraceBuffer)
+      expect(worker.trace_buffer.instance_variable_get(:@max_size)).to eq(100)
+    end
+
+    context "when the transport provides a trace buffer" do
+      let(:transport) { double("transport", build_trace_buffer: trace_buffer) }
+      let(:trace_buffer) { double("trace buffer") }
+      let(:worker) do
+        described_class.new(
+          logger: logger,
+          transport: transport,
+          buffer_size: 100,
+          on_trace: task,
+          interval: 0.5
+        )
+      end
+
+      it "uses it" do
+        expect(worker.trace_buffer).to be(trace_buffer)
+        expect(transport).to have_received(:build_trace_buffer).with(100)
+      end
+    end
+  end
+
   describe "#start" do
     it "returns nil" do
       expect(worker.start).to be nil
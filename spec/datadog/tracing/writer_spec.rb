@@ -309,6 +309,21 @@ RSpec.describe Datadog::Tracing::Writer do
           end
         end
 
+        context "when the transport supports preparing traces ahead of sending" do
+          let(:transport) { double("transport", prepare_trace: nil) }
+
+          before do
+            allow_any_instance_of(Datadog::Tracing::Workers::AsyncTransport).to receive(:start)
+            allow_any_instance_of(Datadog::Tracing::Workers::AsyncTransport).to receive(:enqueue_trace)
+          end
+
+          it "prepares the trace when it gets written" do
+            write
+
+            expect(transport).to have_received(:prepare_trace).with(trace)
+          end
+        end
+
         context "when tracer has been stopped" do
           before { writer.stop }
 